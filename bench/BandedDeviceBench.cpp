@@ -0,0 +1,83 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+#include "SkBenchmark.h"
+#include "SkBandedDevice.h"
+#include "SkBitmap.h"
+#include "SkCanvas.h"
+#include "SkGradientShader.h"
+#include "SkPaint.h"
+#include "SkPath.h"
+#include "SkString.h"
+#include "SkThreadPool.h"
+
+// Draws one antialiased, gradient-filled path that covers a large bitmap, either on a plain
+// raster device or split into bands on a thread per core.
+
+enum {
+    kSize = 2048,
+};
+
+class BandedDeviceBench : public SkBenchmark {
+public:
+    BandedDeviceBench(void* param, bool banded)
+        : INHERITED(param)
+        , fBanded(banded)
+        , fPool(SkThreadPool::kThreadPerCore) {
+        fName.printf("banded_device_path_%s", banded ? "banded" : "inline");
+        fIsRendering = false;
+
+        fBitmap.setConfig(SkBitmap::kARGB_8888_Config, kSize, kSize);
+        fBitmap.allocPixels();
+
+        const SkScalar size = SkIntToScalar(kSize);
+        fPath.moveTo(0, 0);
+        fPath.cubicTo(size * 2, 0, -size, size, size, size);
+        fPath.quadTo(0, size * 2, size / 8, size / 2);
+        fPath.close();
+        fPath.addCircle(size / 2, size / 2, size * 3 / 8);
+
+        SkPoint pts[] = { { 0, 0 }, { size, size } };
+        SkColor colors[] = { SK_ColorRED, 0x8000FF00, SK_ColorBLUE };
+        fPaint.setAntiAlias(true);
+        fPaint.setShader(SkGradientShader::CreateLinear(pts, colors, NULL,
+                                                        SK_ARRAY_COUNT(colors),
+                                                        SkShader::kMirror_TileMode))->unref();
+    }
+
+protected:
+    virtual const char* onGetName() SK_OVERRIDE {
+        return fName.c_str();
+    }
+
+    virtual void onDraw(SkCanvas*) SK_OVERRIDE {
+        SkDevice* device = fBanded ? SkNEW_ARGS(SkBandedDevice, (fBitmap, &fPool))
+                                   : SkNEW_ARGS(SkDevice, (fBitmap));
+        SkCanvas canvas(device);
+        device->unref();
+        for (int i = 0; i < SkBENCHLOOP(2); ++i) {
+            canvas.drawPath(fPath, fPaint);
+        }
+    }
+
+private:
+    bool            fBanded;
+    SkString        fName;
+    SkThreadPool    fPool;
+    SkBitmap        fBitmap;
+    SkPath          fPath;
+    SkPaint         fPaint;
+
+    typedef SkBenchmark INHERITED;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+static SkBenchmark* Fact0(void* p) { return SkNEW_ARGS(BandedDeviceBench, (p, false)); }
+static SkBenchmark* Fact1(void* p) { return SkNEW_ARGS(BandedDeviceBench, (p, true)); }
+
+static BenchRegistry gReg0(Fact0);
+static BenchRegistry gReg1(Fact1);
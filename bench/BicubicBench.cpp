@@ -11,6 +11,7 @@
 #include "SkShader.h"
 #include "SkString.h"
 #include "SkBicubicImageFilter.h"
+#include "SkColorPriv.h"
 
 // This bench exercises SkBicubicImageFilter, upsampling a 40x40 input to
 // 100x100, 400x100, 100x400, and 400x400.
@@ -60,3 +61,61 @@ static BenchRegistry gReg00(Fact00);
 static BenchRegistry gReg01(Fact01);
 static BenchRegistry gReg02(Fact02);
 static BenchRegistry gReg03(Fact03);
+
+// This bench exercises drawBitmapRect() with a high quality filter, scaling a
+// square bitmap by the given factors.
+
+class BicubicBitmapRectBench : public SkBenchmark {
+    SkBitmap       fBitmap;
+    int            fSize;
+    SkSize         fScale;
+    SkString       fName;
+
+public:
+    BicubicBitmapRectBench(void* param, int size, float x, float y)
+        :  INHERITED(param), fSize(size)
+        ,  fScale(SkSize::Make(SkFloatToScalar(x), SkFloatToScalar(y))) {
+        fName.printf("bicubic_bitmaprect_%d_%gx%g", size,
+            SkScalarToFloat(fScale.fWidth), SkScalarToFloat(fScale.fHeight));
+    }
+
+protected:
+    virtual const char* onGetName() {
+        return fName.c_str();
+    }
+
+    virtual void onPreDraw() {
+        fBitmap.setConfig(SkBitmap::kARGB_8888_Config, fSize, fSize);
+        fBitmap.allocPixels();
+        fBitmap.setIsOpaque(true);
+
+        SkRandom rand;
+        SkAutoLockPixels alp(fBitmap);
+        for (int y = 0; y < fSize; ++y) {
+            for (int x = 0; x < fSize; ++x) {
+                *fBitmap.getAddr32(x, y) = rand.nextU() | (0xFF << SK_A32_SHIFT);
+            }
+        }
+    }
+
+    virtual void onDraw(SkCanvas* canvas) {
+        SkPaint paint;
+        this->setupPaint(&paint);
+
+        paint.setFilterBitmap(true);
+        paint.setHighQualityFilterBitmap(true);
+
+        SkRect r = SkRect::MakeWH(SkScalarMul(SkIntToScalar(fSize), fScale.fWidth),
+                                  SkScalarMul(SkIntToScalar(fSize), fScale.fHeight));
+        canvas->drawBitmapRect(fBitmap, NULL, r, &paint);
+    }
+
+private:
+    typedef SkBenchmark INHERITED;
+};
+
+DEF_BENCH( return new BicubicBitmapRectBench(p, 40, 10.0f, 10.0f); )
+DEF_BENCH( return new BicubicBitmapRectBench(p, 40, 2.5f, 10.0f); )
+DEF_BENCH( return new BicubicBitmapRectBench(p, 40, 10.0f, 2.5f); )
+DEF_BENCH( return new BicubicBitmapRectBench(p, 40, 2.5f, 2.5f); )
+DEF_BENCH( return new BicubicBitmapRectBench(p, 1024, 0.25f, 0.25f); )
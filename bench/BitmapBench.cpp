@@ -342,6 +342,62 @@ protected:
 private:
     typedef BitmapBench INHERITED;
 };
+/** Draw a large photo-sized bitmap as a thumbnail, filtered from its full size
+    or from cached mip levels (SkPaint::kMipMapBitmap_Flag). */
+
+class DownscaleBitmapBench : public SkBenchmark {
+    SkBitmap    fBitmap;
+    int         fDownscale;
+    bool        fMipMap;
+    SkString    fName;
+    enum { N = SkBENCHLOOP(20) };
+    enum { W = 1024 };
+    enum { H = 768 };
+public:
+    DownscaleBitmapBench(void* param, int downscale, bool mipMap)
+        : INHERITED(param)
+        , fDownscale(downscale)
+        , fMipMap(mipMap) {
+        fName.printf("bitmap_8888_downscale_%dx%s", downscale, mipMap ? "_mipmap" : "");
+    }
+
+protected:
+    virtual const char* onGetName() SK_OVERRIDE {
+        return fName.c_str();
+    }
+
+    virtual void onPreDraw() SK_OVERRIDE {
+        fBitmap.setConfig(SkBitmap::kARGB_8888_Config, W, H);
+        fBitmap.allocPixels();
+        fBitmap.setIsOpaque(true);
+
+        SkRandom rand;
+        SkAutoLockPixels alp(fBitmap);
+        for (int y = 0; y < H; y++) {
+            SkPMColor* row = fBitmap.getAddr32(0, y);
+            for (int x = 0; x < W; x++) {
+                row[x] = rand.nextU() | (0xFF << SK_A32_SHIFT);
+            }
+        }
+    }
+
+    virtual void onDraw(SkCanvas* canvas) SK_OVERRIDE {
+        SkPaint paint;
+        this->setupPaint(&paint);
+        paint.setFilterBitmap(true);
+        paint.setMipMapBitmap(fMipMap);
+
+        const SkScalar scale = SK_Scalar1 / fDownscale;
+        canvas->scale(scale, scale);
+        for (int i = 0; i < N; i++) {
+            canvas->drawBitmap(fBitmap, SkIntToScalar(i % 4 * W / 4), 0, &paint);
+        }
+    }
+
+private:
+    typedef SkBenchmark INHERITED;
+};
+
 static SkBenchmark* Fact0(void* p) { return new BitmapBench(p, false, SkBitmap::kARGB_8888_Config); }
 static SkBenchmark* Fact1(void* p) { return new BitmapBench(p, true, SkBitmap::kARGB_8888_Config); }
 static SkBenchmark* Fact2(void* p) { return new BitmapBench(p, true, SkBitmap::kRGB_565_Config); }
@@ -394,3 +450,8 @@ static BenchRegistry gReg17(Fact17);
 static BenchRegistry gReg18(Fact18);
 static BenchRegistry gReg19(Fact19);
 static BenchRegistry gReg20(Fact20);
+
+DEF_BENCH( return SkNEW_ARGS(DownscaleBitmapBench, (p, 4, false)); )
+DEF_BENCH( return SkNEW_ARGS(DownscaleBitmapBench, (p, 4, true)); )
+DEF_BENCH( return SkNEW_ARGS(DownscaleBitmapBench, (p, 8, false)); )
+DEF_BENCH( return SkNEW_ARGS(DownscaleBitmapBench, (p, 8, true)); )
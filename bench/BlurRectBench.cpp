@@ -9,9 +9,11 @@
 #include "SkCanvas.h"
 #include "SkPaint.h"
 #include "SkRandom.h"
+#include "SkRRect.h"
 #include "SkShader.h"
 #include "SkString.h"
 #include "SkBlurMask.h"
+#include "SkBlurMaskFilter.h"
 
 #define SMALL   SkIntToScalar(2)
 #define REAL    SkFloatToScalar(1.5f)
@@ -174,6 +176,67 @@ private:
     typedef BlurRectSeparableBench INHERITED;
 };
 
+// Draws blurred rrects (or ovals) through a canvas, the way UI shadows are drawn.
+class BlurRRectBench: public SkBenchmark {
+    SkScalar    fRadius;
+    SkScalar    fWidth;
+    SkScalar    fHeight;
+    SkScalar    fCorner;    // < 0 for an oval
+    SkString    fName;
+
+public:
+    BlurRRectBench(void *param, SkScalar rad, SkScalar w, SkScalar h, SkScalar corner)
+        : INHERITED(param), fRadius(rad), fWidth(w), fHeight(h), fCorner(corner) {
+        if (fCorner < 0) {
+            fName.printf("blurrrect_oval_%dx%d_%d", SkScalarRoundToInt(w),
+                         SkScalarRoundToInt(h), SkScalarRoundToInt(rad));
+        } else {
+            fName.printf("blurrrect_%dx%d_%d_%d", SkScalarRoundToInt(w),
+                         SkScalarRoundToInt(h), SkScalarRoundToInt(corner),
+                         SkScalarRoundToInt(rad));
+        }
+    }
+
+protected:
+    virtual const char* onGetName() {
+        return fName.c_str();
+    }
+
+    virtual void onDraw(SkCanvas* canvas) {
+        SkPaint paint;
+        this->setupPaint(&paint);
+        paint.setAntiAlias(true);
+        paint.setMaskFilter(SkBlurMaskFilter::Create(fRadius,
+                                SkBlurMaskFilter::kNormal_BlurStyle,
+                                SkBlurMaskFilter::kHighQuality_BlurFlag))->unref();
+
+        for (int i = 0; i < SkBENCHLOOP(10); i++) {
+            const SkScalar d = SkIntToScalar(i % 8);
+            SkRRect rrect;
+            if (fCorner < 0) {
+                // ovals of one size, in a few places
+                rrect.setOval(SkRect::MakeXYWH(d, d, fWidth, fHeight));
+            } else {
+                // rrects with the same corners, in a few sizes
+                rrect.setRectXY(SkRect::MakeWH(fWidth + d, fHeight + d), fCorner, fCorner);
+            }
+            canvas->drawRRect(rrect, paint);
+        }
+    }
+
+private:
+    typedef SkBenchmark INHERITED;
+};
+
+DEF_BENCH(return new BlurRRectBench(p, SkIntToScalar(4), SkIntToScalar(200), SkIntToScalar(120),
+                                    SkIntToScalar(16));)
+DEF_BENCH(return new BlurRRectBench(p, SkIntToScalar(10), SkIntToScalar(200), SkIntToScalar(120),
+                                    SkIntToScalar(16));)
+DEF_BENCH(return new BlurRRectBench(p, SkIntToScalar(10), SkIntToScalar(400), SkIntToScalar(300),
+                                    SkIntToScalar(4));)
+DEF_BENCH(return new BlurRRectBench(p, SkIntToScalar(10), SkIntToScalar(40), SkIntToScalar(40),
+                                    -SK_Scalar1);)
+
 DEF_BENCH(return new BlurRectBoxFilterBench(p, SMALL);)
 DEF_BENCH(return new BlurRectBoxFilterBench(p, BIG);)
 DEF_BENCH(return new BlurRectBoxFilterBench(p, REALBIG);)
@@ -7,7 +7,9 @@
 #include "SkBenchmark.h"
 #include "SkDeferredCanvas.h"
 #include "SkDevice.h"
+#include "SkGradientShader.h"
 #include "SkString.h"
+#include "SkThreadPool.h"
 
 class DeferredCanvasBench : public SkBenchmark {
 public:
@@ -108,8 +110,73 @@ private:
 };
 
 
+// Records a frame of large antialiased, gradient-filled circles into a big
+// raster device, and flushes it either on the calling thread or in bands on
+// a thread per core. This captures the flush latency rather than the
+// recording overhead.
+class DeferredFlushBench : public SkBenchmark {
+public:
+    DeferredFlushBench(void* param, bool banded)
+        : INHERITED(param)
+        , fBanded(banded)
+        , fPool(SkThreadPool::kThreadPerCore) {
+        fName.printf("deferred_canvas_flush_%s", banded ? "banded" : "serial");
+        fIsRendering = false;
+
+        fBitmap.setConfig(SkBitmap::kARGB_8888_Config, kSize, kSize);
+        fBitmap.allocPixels();
+
+        const SkScalar size = SkIntToScalar(kSize);
+        SkPoint pts[] = { { 0, 0 }, { size, size } };
+        SkColor colors[] = { SK_ColorRED, 0x8000FF00, SK_ColorBLUE };
+        fPaint.setAntiAlias(true);
+        fPaint.setShader(SkGradientShader::CreateLinear(pts, colors, NULL,
+                                                        SK_ARRAY_COUNT(colors),
+                                                        SkShader::kMirror_TileMode))->unref();
+    }
+
+    enum {
+        kSize = 1024,
+        kCirclesPerFrame = 20,
+    };
+
+protected:
+    virtual const char* onGetName() SK_OVERRIDE {
+        return fName.c_str();
+    }
+
+    virtual void onDraw(SkCanvas*) SK_OVERRIDE {
+        SkDevice device(fBitmap);
+        SkDeferredCanvas canvas(&device);
+        if (fBanded) {
+            canvas.setFlushThreadPool(&fPool);
+        }
+        const SkScalar size = SkIntToScalar(kSize);
+        for (int frame = 0; frame < SkBENCHLOOP(2); ++frame) {
+            for (int i = 0; i < kCirclesPerFrame; ++i) {
+                canvas.drawCircle(size * (i + frame) / kCirclesPerFrame, size / 2, size / 3,
+                                  fPaint);
+            }
+            canvas.flush();
+        }
+    }
+
+private:
+    bool            fBanded;
+    SkString        fName;
+    SkThreadPool    fPool;
+    SkBitmap        fBitmap;
+    SkPaint         fPaint;
+
+    typedef SkBenchmark INHERITED;
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 
 static SkBenchmark* Fact0(void* p) { return new DeferredRecordBench(p); }
+static SkBenchmark* Fact1(void* p) { return SkNEW_ARGS(DeferredFlushBench, (p, false)); }
+static SkBenchmark* Fact2(void* p) { return SkNEW_ARGS(DeferredFlushBench, (p, true)); }
 
 static BenchRegistry gReg0(Fact0);
+static BenchRegistry gReg1(Fact1);
+static BenchRegistry gReg2(Fact2);
@@ -223,11 +223,16 @@ private:
 class Gradient2Bench : public SkBenchmark {
     SkString fName;
     bool     fHasAlpha;
+    bool     fSameColors;
 
 public:
-    Gradient2Bench(void* param, bool hasAlpha) : INHERITED(param) {
-        fName.printf("gradient_create_%s", hasAlpha ? "alpha" : "opaque");
+    // If sameColors, every shader is made with the same colors, and so can
+    // share its color table with the ones before it.
+    Gradient2Bench(void* param, bool hasAlpha, bool sameColors = false) : INHERITED(param) {
+        fName.printf("gradient_create_%s%s", hasAlpha ? "alpha" : "opaque",
+                     sameColors ? "_same" : "");
         fHasAlpha = hasAlpha;
+        fSameColors = sameColors;
     }
 
 protected:
@@ -246,7 +251,7 @@ protected:
         };
 
         for (int i = 0; i < SkBENCHLOOP(1000); i++) {
-            const int gray = i % 256;
+            const int gray = fSameColors ? 0x80 : i % 256;
             const int alpha = fHasAlpha ? gray : 0xFF;
             SkColor colors[] = {
                 SK_ColorBLACK,
@@ -283,3 +288,5 @@ DEF_BENCH( return new GradientBench(p, kConical_GradType); )
 
 DEF_BENCH( return new Gradient2Bench(p, false); )
 DEF_BENCH( return new Gradient2Bench(p, true); )
+DEF_BENCH( return new Gradient2Bench(p, false, true); )
+DEF_BENCH( return new Gradient2Bench(p, true, true); )
@@ -11,6 +11,7 @@
 #include "SkColorPriv.h"
 #include "SkPaint.h"
 #include "SkRandom.h"
+#include "SkScan.h"
 #include "SkShader.h"
 #include "SkString.h"
 #include "SkTArray.h"
@@ -786,6 +787,87 @@ private:
     typedef SkBenchmark INHERITED;
 };
 
+// Fills the same antialiased paths with the supersampling scan converter and with the
+// analytic coverage accumulator.
+class AAFillPathBench : public SkBenchmark {
+public:
+    enum Shape {
+        kSmallCircles_Shape,
+        kRoundRects_Shape,
+        kCurves_Shape,
+        kBigOval_Shape,
+    };
+
+    AAFillPathBench(void* param, Shape shape, bool analytic)
+        : INHERITED(param)
+        , fAnalytic(analytic) {
+        static const char* gShapeNames[] = { "smallcircles", "roundrects", "curves", "bigoval" };
+        fName.printf("path_aa_fill_%s_%s", gShapeNames[shape],
+                     analytic ? "analytic" : "supersample");
+
+        SkRandom rand;
+        switch (shape) {
+            case kSmallCircles_Shape:
+                for (int i = 0; i < 100; ++i) {
+                    fPaths.push_back().addCircle(rand.nextRangeScalar(10, 630),
+                                                 rand.nextRangeScalar(10, 470),
+                                                 rand.nextRangeScalar(2, 10));
+                }
+                break;
+            case kRoundRects_Shape:
+                for (int i = 0; i < 20; ++i) {
+                    SkScalar x = rand.nextRangeScalar(0, 440);
+                    SkScalar y = rand.nextRangeScalar(0, 280);
+                    fPaths.push_back().addRoundRect(SkRect::MakeXYWH(x, y, 200, 200),
+                                                    rand.nextRangeScalar(4, 40),
+                                                    rand.nextRangeScalar(4, 40));
+                }
+                break;
+            case kCurves_Shape:
+                for (int i = 0; i < 10; ++i) {
+                    SkPath& path = fPaths.push_back();
+                    path.moveTo(rand.nextRangeScalar(0, 640), rand.nextRangeScalar(0, 480));
+                    for (int j = 0; j < 4; ++j) {
+                        path.quadTo(rand.nextRangeScalar(0, 640), rand.nextRangeScalar(0, 480),
+                                    rand.nextRangeScalar(0, 640), rand.nextRangeScalar(0, 480));
+                    }
+                    path.close();
+                }
+                break;
+            case kBigOval_Shape:
+                fPaths.push_back().addOval(SkRect::MakeXYWH(20, 20, 600, 440));
+                break;
+        }
+    }
+
+protected:
+    virtual const char* onGetName() SK_OVERRIDE {
+        return fName.c_str();
+    }
+
+    virtual void onDraw(SkCanvas* canvas) SK_OVERRIDE {
+        SkPaint paint;
+        this->setupPaint(&paint);
+        paint.setAntiAlias(true);
+
+        bool wasAnalytic = SkScan::IsAnalyticAA();
+        SkScan::SetAnalyticAA(fAnalytic);
+        for (int i = 0; i < SkBENCHLOOP(10); ++i) {
+            for (int j = 0; j < fPaths.count(); ++j) {
+                canvas->drawPath(fPaths[j], paint);
+            }
+        }
+        SkScan::SetAnalyticAA(wasAnalytic);
+    }
+
+private:
+    bool            fAnalytic;
+    SkString        fName;
+    SkTArray<SkPath> fPaths;
+
+    typedef SkBenchmark INHERITED;
+};
+
 class ConservativelyContainsBench : public SkBenchmark {
 public:
     enum Type {
@@ -977,6 +1059,14 @@ DEF_BENCH( return new CirclesBench(p, FLAGS00); )
 DEF_BENCH( return new CirclesBench(p, FLAGS01); )
 DEF_BENCH( return new ArbRoundRectBench(p, false); )
 DEF_BENCH( return new ArbRoundRectBench(p, true); )
+DEF_BENCH( return new AAFillPathBench(p, AAFillPathBench::kSmallCircles_Shape, false); )
+DEF_BENCH( return new AAFillPathBench(p, AAFillPathBench::kSmallCircles_Shape, true); )
+DEF_BENCH( return new AAFillPathBench(p, AAFillPathBench::kRoundRects_Shape, false); )
+DEF_BENCH( return new AAFillPathBench(p, AAFillPathBench::kRoundRects_Shape, true); )
+DEF_BENCH( return new AAFillPathBench(p, AAFillPathBench::kCurves_Shape, false); )
+DEF_BENCH( return new AAFillPathBench(p, AAFillPathBench::kCurves_Shape, true); )
+DEF_BENCH( return new AAFillPathBench(p, AAFillPathBench::kBigOval_Shape, false); )
+DEF_BENCH( return new AAFillPathBench(p, AAFillPathBench::kBigOval_Shape, true); )
 DEF_BENCH( return new ConservativelyContainsBench(p, ConservativelyContainsBench::kRect_Type); )
 DEF_BENCH( return new ConservativelyContainsBench(p, ConservativelyContainsBench::kRoundRect_Type); )
 DEF_BENCH( return new ConservativelyContainsBench(p, ConservativelyContainsBench::kOval_Type); )
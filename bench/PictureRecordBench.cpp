@@ -154,6 +154,65 @@ private:
     typedef PictureRecordBench INHERITED;
 };
 
+/*
+ *  Populates the SkPaint dictionary with as many unique paints as a large web
+ *  page, varying the stroke as well as the color, so that the dictionary's
+ *  cost per insertion shows up.
+ */
+class ManyUniquePaintDictionaryRecordBench : public PictureRecordBench {
+public:
+    ManyUniquePaintDictionaryRecordBench(void* param)
+        : INHERITED(param, "many_unique_paint_dictionary") { }
+
+    enum {
+        M = SkBENCHLOOP(50000),   // number of unique paint objects
+    };
+protected:
+    virtual float innerLoopScale() const SK_OVERRIDE { return 0.02f; }
+    virtual void recordCanvas(SkCanvas* canvas) {
+        SkRandom rand;
+        const SkRect rect = SkRect::MakeWH(SkIntToScalar(100), SkIntToScalar(100));
+        for (int i = 0; i < M; i++) {
+            SkPaint paint;
+            paint.setColor(rand.nextU());
+            paint.setStyle(SkPaint::kStroke_Style);
+            paint.setStrokeWidth(SkIntToScalar(i % 16));
+            canvas->drawRect(rect, paint);
+        }
+    }
+
+private:
+    typedef PictureRecordBench INHERITED;
+};
+
+/*
+ *  Populates the SkMatrix dictionary with a large number of unique matrices
+ */
+class UniqueMatrixDictionaryRecordBench : public PictureRecordBench {
+public:
+    UniqueMatrixDictionaryRecordBench(void* param)
+        : INHERITED(param, "unique_matrix_dictionary") { }
+
+    enum {
+        M = SkBENCHLOOP(15000),   // number of unique matrices
+    };
+protected:
+    virtual float innerLoopScale() const SK_OVERRIDE { return 0.1f; }
+    virtual void recordCanvas(SkCanvas* canvas) {
+        SkPaint paint;
+        const SkRect rect = SkRect::MakeWH(SkIntToScalar(10), SkIntToScalar(10));
+        for (int i = 0; i < M; i++) {
+            SkMatrix matrix;
+            matrix.setTranslate(SkIntToScalar(i % 1000), SkIntToScalar(i / 1000));
+            canvas->setMatrix(matrix);
+            canvas->drawRect(rect, paint);
+        }
+    }
+
+private:
+    typedef PictureRecordBench INHERITED;
+};
+
 /*
  *  Populates the SkPaint dictionary with a number of unique paint
  *  objects that get reused repeatedly
@@ -182,12 +241,44 @@ private:
     typedef PictureRecordBench INHERITED;
 };
 
+/*
+ *  Draws with the same paint over and over, as text-heavy content does
+ */
+class RepeatedPaintRecordBench : public PictureRecordBench {
+public:
+    RepeatedPaintRecordBench(void* param)
+        : INHERITED(param, "repeated_paint") { }
+
+    enum {
+        M = SkBENCHLOOP(50000),   // number of draw iterations
+    };
+protected:
+    virtual float innerLoopScale() const SK_OVERRIDE { return 0.1f; }
+    virtual void recordCanvas(SkCanvas* canvas) {
+        SkPaint paint;
+        paint.setAntiAlias(true);
+        paint.setTextSize(SkIntToScalar(12));
+        for (int i = 0; i < M; i++) {
+            canvas->drawText("x", 1, SkIntToScalar(i % 1000), SkIntToScalar(i / 1000), paint);
+        }
+    }
+
+private:
+    typedef PictureRecordBench INHERITED;
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 
 static SkBenchmark* Fact0(void* p) { return new DictionaryRecordBench(p); }
 static SkBenchmark* Fact1(void* p) { return new UniquePaintDictionaryRecordBench(p); }
 static SkBenchmark* Fact2(void* p) { return new RecurringPaintDictionaryRecordBench(p); }
+static SkBenchmark* Fact3(void* p) { return new ManyUniquePaintDictionaryRecordBench(p); }
+static SkBenchmark* Fact4(void* p) { return new UniqueMatrixDictionaryRecordBench(p); }
+static SkBenchmark* Fact5(void* p) { return new RepeatedPaintRecordBench(p); }
 
 static BenchRegistry gReg0(Fact0);
 static BenchRegistry gReg1(Fact1);
 static BenchRegistry gReg2(Fact2);
+static BenchRegistry gReg3(Fact3);
+static BenchRegistry gReg4(Fact4);
+static BenchRegistry gReg5(Fact5);
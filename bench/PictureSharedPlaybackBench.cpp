@@ -0,0 +1,120 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+#include "SkBenchmark.h"
+#include "SkBitmap.h"
+#include "SkCanvas.h"
+#include "SkGradientShader.h"
+#include "SkPaint.h"
+#include "SkPicture.h"
+#include "SkRunnable.h"
+#include "SkString.h"
+#include "SkTemplates.h"
+#include "SkThreadPool.h"
+
+// Compares two ways of drawing one picture on several threads: giving each thread its own
+// SkPicture::clone(), or having every thread draw the picture itself. The picture uses lots of
+// distinct shader paints, which are what clone() has to deep-copy.
+
+namespace {
+
+enum {
+    kThreadCount = 4,
+    kPictureSize = 512,
+    kTileSize = kPictureSize / 2,
+    kPaintCount = 256,
+};
+
+// Draws one quarter of a picture into its own bitmap
+class TileDrawer : public SkRunnable {
+public:
+    TileDrawer() : fPicture(NULL), fIndex(0) {
+        fBitmap.setConfig(SkBitmap::kARGB_8888_Config, kTileSize, kTileSize);
+        fBitmap.allocPixels();
+    }
+
+    virtual void run() SK_OVERRIDE {
+        SkCanvas canvas(fBitmap);
+        canvas.translate(-SkIntToScalar((fIndex % 2) * kTileSize),
+                         -SkIntToScalar((fIndex / 2) * kTileSize));
+        fPicture->draw(&canvas);
+    }
+
+    SkPicture*  fPicture;
+    int         fIndex;
+    SkBitmap    fBitmap;
+};
+
+}
+
+class PictureSharedPlaybackBench : public SkBenchmark {
+public:
+    PictureSharedPlaybackBench(void* param, bool clone)
+        : INHERITED(param)
+        , fClone(clone)
+        , fPool(kThreadCount) {
+        fName.printf("picture_playback_threads_%s", clone ? "clone" : "shared");
+        fIsRendering = false;
+
+        SkCanvas* canvas = fPicture.beginRecording(kPictureSize, kPictureSize);
+        for (int i = 0; i < kPaintCount; ++i) {
+            SkScalar x = SkIntToScalar((i * 37) % kPictureSize);
+            SkScalar y = SkIntToScalar((i * 71) % kPictureSize);
+            SkPoint pts[] = { { x, y }, { x + SkIntToScalar(64), y + SkIntToScalar(64) } };
+            SkColor colors[] = { SK_ColorRED, SkColorSetRGB(i, 255 - i, 128), SK_ColorBLUE };
+            SkPaint paint;
+            paint.setShader(SkGradientShader::CreateLinear(pts, colors, NULL,
+                                                           SK_ARRAY_COUNT(colors),
+                                                           SkShader::kClamp_TileMode))->unref();
+            canvas->drawRect(SkRect::MakeXYWH(x, y, SkIntToScalar(64), SkIntToScalar(64)),
+                             paint);
+        }
+        fPicture.endRecording();
+
+        for (int i = 0; i < kThreadCount; ++i) {
+            fDrawers[i].fIndex = i;
+            fRunnables[i] = &fDrawers[i];
+        }
+    }
+
+protected:
+    virtual const char* onGetName() SK_OVERRIDE {
+        return fName.c_str();
+    }
+
+    virtual void onDraw(SkCanvas*) SK_OVERRIDE {
+        for (int i = 0; i < SkBENCHLOOP(10); ++i) {
+            SkAutoTArray<SkPicture> clones(fClone ? kThreadCount : 0);
+            if (fClone) {
+                fPicture.clone(clones.get(), kThreadCount);
+            }
+            for (int j = 0; j < kThreadCount; ++j) {
+                fDrawers[j].fPicture = fClone ? &clones[j] : &fPicture;
+            }
+            SkThreadPool::Group group(&fPool);
+            group.add(fRunnables, kThreadCount);
+            group.wait();
+        }
+    }
+
+private:
+    bool            fClone;
+    SkString        fName;
+    SkPicture       fPicture;
+    SkThreadPool    fPool;
+    TileDrawer      fDrawers[kThreadCount];
+    SkRunnable*     fRunnables[kThreadCount];
+
+    typedef SkBenchmark INHERITED;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+static SkBenchmark* Fact0(void* p) { return SkNEW_ARGS(PictureSharedPlaybackBench, (p, true)); }
+static SkBenchmark* Fact1(void* p) { return SkNEW_ARGS(PictureSharedPlaybackBench, (p, false)); }
+
+static BenchRegistry gReg0(Fact0);
+static BenchRegistry gReg1(Fact1);
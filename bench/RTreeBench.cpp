@@ -145,6 +145,66 @@ private:
     typedef SkBenchmark INHERITED;
 };
 
+// Time how long it takes to find the contents of every tile in a grid covering the R-Tree, either
+// one tile at a time (as SkPicturePlayback does) or with a single batched query
+class BBoxTileQueryBench : public SkBenchmark {
+public:
+    BBoxTileQueryBench(void* param, const char* name, MakeRectProc proc, bool batch,
+                       SkBBoxHierarchy* tree)
+        : INHERITED(param)
+        , fTree(tree)
+        , fBatch(batch) {
+        fName.append("rtree_");
+        fName.append(name);
+        fName.append("_tiles");
+        if (fBatch) {
+            fName.append("_batch");
+        }
+        SkRandom rand;
+        for (int j = 0; j < SkBENCHLOOP(NUM_QUERY_RECTS); ++j) {
+            fTree->insert(reinterpret_cast<void*>(j), proc(rand, j,
+                           SkBENCHLOOP(NUM_QUERY_RECTS)), true);
+        }
+        fTree->flushDeferredInserts();
+        for (int y = 0; y < kTilesPerSide; ++y) {
+            for (int x = 0; x < kTilesPerSide; ++x) {
+                fTiles[y * kTilesPerSide + x].setXYWH(x * kTileSize, y * kTileSize,
+                                                      kTileSize, kTileSize);
+            }
+        }
+        fIsRendering = false;
+    }
+    virtual ~BBoxTileQueryBench() {
+        fTree->unref();
+    }
+protected:
+    virtual const char* onGetName() {
+        return fName.c_str();
+    }
+    virtual void onDraw(SkCanvas* canvas) {
+        for (int i = 0; i < SkBENCHLOOP(NUM_QUERIES / kTileCount); ++i) {
+            SkTDArray<void*> hits[kTileCount];
+            if (fBatch) {
+                fTree->searchBatch(fTiles, kTileCount, hits);
+            } else {
+                for (int j = 0; j < kTileCount; ++j) {
+                    fTree->search(fTiles[j], &hits[j]);
+                }
+            }
+        }
+    }
+private:
+    static const int kTileSize = 100;
+    static const int kTilesPerSide = GENERATE_EXTENTS / kTileSize;
+    static const int kTileCount = kTilesPerSide * kTilesPerSide;
+
+    SkBBoxHierarchy* fTree;
+    SkString fName;
+    bool fBatch;
+    SkIRect fTiles[kTileCount];
+    typedef SkBenchmark INHERITED;
+};
+
 static inline SkIRect make_simple_rect(SkRandom&, int index, int numRects) {
     SkIRect out = {0, 0, GENERATE_EXTENTS, GENERATE_EXTENTS};
     return out;
@@ -210,8 +270,46 @@ static inline SkBenchmark* Fact4(void* p) {
                       BBoxQueryBench::kRandom_QueryType, SkRTree::Create(5, 16)));
 }
 
+// The same R-Tree, but queried through the nodes built on insertion rather than the packed layout
+static inline SkRTree* create_unpacked_rtree() {
+    SkRTree* tree = SkRTree::Create(5, 16);
+    tree->setUsePackedLayout(false);
+    return tree;
+}
+
+static inline SkBenchmark* Fact5(void* p) {
+    return SkNEW_ARGS(BBoxQueryBench, (p, "random_unpacked", &make_random_rects, true,
+                      BBoxQueryBench::kRandom_QueryType, create_unpacked_rtree()));
+}
+static inline SkBenchmark* Fact6(void* p) {
+    return SkNEW_ARGS(BBoxQueryBench, (p, "random_small", &make_random_rects, true,
+                      BBoxQueryBench::kSmall_QueryType, SkRTree::Create(5, 16)));
+}
+static inline SkBenchmark* Fact7(void* p) {
+    return SkNEW_ARGS(BBoxQueryBench, (p, "random_small_unpacked", &make_random_rects, true,
+                      BBoxQueryBench::kSmall_QueryType, create_unpacked_rtree()));
+}
+static inline SkBenchmark* Fact8(void* p) {
+    return SkNEW_ARGS(BBoxTileQueryBench, (p, "random", &make_random_rects, false,
+                      SkRTree::Create(5, 16)));
+}
+static inline SkBenchmark* Fact9(void* p) {
+    return SkNEW_ARGS(BBoxTileQueryBench, (p, "random", &make_random_rects, true,
+                      SkRTree::Create(5, 16)));
+}
+static inline SkBenchmark* Fact10(void* p) {
+    return SkNEW_ARGS(BBoxTileQueryBench, (p, "random_unpacked", &make_random_rects, false,
+                      create_unpacked_rtree()));
+}
+
 static BenchRegistry gReg0(Fact0);
 static BenchRegistry gReg1(Fact1);
 static BenchRegistry gReg2(Fact2);
 static BenchRegistry gReg3(Fact3);
 static BenchRegistry gReg4(Fact4);
+static BenchRegistry gReg5(Fact5);
+static BenchRegistry gReg6(Fact6);
+static BenchRegistry gReg7(Fact7);
+static BenchRegistry gReg8(Fact8);
+static BenchRegistry gReg9(Fact9);
+static BenchRegistry gReg10(Fact10);
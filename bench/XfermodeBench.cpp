@@ -59,12 +59,34 @@ private:
 //////////////////////////////////////////////////////////////////////////////
 
 
-// These modes were chosen because they are expected to be successively harder for the GPU.
-// kSrc can disable blending, kSrcOver cannot, kDarken requires reading the dst pixel in the shader.
-static SkBenchmark* Fact0(void* p) { return new XfermodeBench(p, SkXfermode::kSrc_Mode); }
-static SkBenchmark* Fact1(void* p) { return new XfermodeBench(p, SkXfermode::kSrcOver_Mode); }
-static SkBenchmark* Fact2(void* p) { return new XfermodeBench(p, SkXfermode::kDarken_Mode); }
-
-static BenchRegistry gReg0(Fact0);
-static BenchRegistry gReg1(Fact1);
-static BenchRegistry gReg2(Fact2);
+// Every mode, in SkXfermode::Mode order. On the GPU kSrc can disable blending, kSrcOver cannot,
+// and the advanced modes (kOverlay and up) require reading the dst pixel in the shader.
+DEF_BENCH( return SkNEW_ARGS(XfermodeBench, (p, SkXfermode::kClear_Mode)); )
+DEF_BENCH( return SkNEW_ARGS(XfermodeBench, (p, SkXfermode::kSrc_Mode)); )
+DEF_BENCH( return SkNEW_ARGS(XfermodeBench, (p, SkXfermode::kDst_Mode)); )
+DEF_BENCH( return SkNEW_ARGS(XfermodeBench, (p, SkXfermode::kSrcOver_Mode)); )
+DEF_BENCH( return SkNEW_ARGS(XfermodeBench, (p, SkXfermode::kDstOver_Mode)); )
+DEF_BENCH( return SkNEW_ARGS(XfermodeBench, (p, SkXfermode::kSrcIn_Mode)); )
+DEF_BENCH( return SkNEW_ARGS(XfermodeBench, (p, SkXfermode::kDstIn_Mode)); )
+DEF_BENCH( return SkNEW_ARGS(XfermodeBench, (p, SkXfermode::kSrcOut_Mode)); )
+DEF_BENCH( return SkNEW_ARGS(XfermodeBench, (p, SkXfermode::kDstOut_Mode)); )
+DEF_BENCH( return SkNEW_ARGS(XfermodeBench, (p, SkXfermode::kSrcATop_Mode)); )
+DEF_BENCH( return SkNEW_ARGS(XfermodeBench, (p, SkXfermode::kDstATop_Mode)); )
+DEF_BENCH( return SkNEW_ARGS(XfermodeBench, (p, SkXfermode::kXor_Mode)); )
+DEF_BENCH( return SkNEW_ARGS(XfermodeBench, (p, SkXfermode::kPlus_Mode)); )
+DEF_BENCH( return SkNEW_ARGS(XfermodeBench, (p, SkXfermode::kModulate_Mode)); )
+DEF_BENCH( return SkNEW_ARGS(XfermodeBench, (p, SkXfermode::kScreen_Mode)); )
+DEF_BENCH( return SkNEW_ARGS(XfermodeBench, (p, SkXfermode::kOverlay_Mode)); )
+DEF_BENCH( return SkNEW_ARGS(XfermodeBench, (p, SkXfermode::kDarken_Mode)); )
+DEF_BENCH( return SkNEW_ARGS(XfermodeBench, (p, SkXfermode::kLighten_Mode)); )
+DEF_BENCH( return SkNEW_ARGS(XfermodeBench, (p, SkXfermode::kColorDodge_Mode)); )
+DEF_BENCH( return SkNEW_ARGS(XfermodeBench, (p, SkXfermode::kColorBurn_Mode)); )
+DEF_BENCH( return SkNEW_ARGS(XfermodeBench, (p, SkXfermode::kHardLight_Mode)); )
+DEF_BENCH( return SkNEW_ARGS(XfermodeBench, (p, SkXfermode::kSoftLight_Mode)); )
+DEF_BENCH( return SkNEW_ARGS(XfermodeBench, (p, SkXfermode::kDifference_Mode)); )
+DEF_BENCH( return SkNEW_ARGS(XfermodeBench, (p, SkXfermode::kExclusion_Mode)); )
+DEF_BENCH( return SkNEW_ARGS(XfermodeBench, (p, SkXfermode::kMultiply_Mode)); )
+DEF_BENCH( return SkNEW_ARGS(XfermodeBench, (p, SkXfermode::kHue_Mode)); )
+DEF_BENCH( return SkNEW_ARGS(XfermodeBench, (p, SkXfermode::kSaturation_Mode)); )
+DEF_BENCH( return SkNEW_ARGS(XfermodeBench, (p, SkXfermode::kColor_Mode)); )
+DEF_BENCH( return SkNEW_ARGS(XfermodeBench, (p, SkXfermode::kLuminosity_Mode)); )
@@ -252,34 +252,10 @@ class SkTimedPicture : public SkPicture {
 public:
     explicit SkTimedPicture(SkStream* stream, bool* success, SkPicture::InstallPixelRefProc proc,
                             const SkTDArray<size_t>& offsets,
-                            const SkTDArray<bool>& deletedCommands) {
-        if (success) {
-            *success = false;
-        }
-        fRecord = NULL;
-        fPlayback = NULL;
-        fWidth = fHeight = 0;
-
-        SkPictInfo info;
-
-        if (!stream->read(&info, sizeof(info))) {
-            return;
-        }
-        if (SkPicture::PICTURE_VERSION != info.fVersion) {
-            return;
-        }
-
-        if (stream->readBool()) {
-            fPlayback = SkNEW_ARGS(SkTimedPicturePlayback,
-                                   (stream, info, proc, offsets, deletedCommands));
-        }
-
-        // do this at the end, so that they will be zero if we hit an error.
-        fWidth = info.fWidth;
-        fHeight = info.fHeight;
-        if (success) {
-            *success = true;
-        }
+                            const SkTDArray<bool>& deletedCommands)
+        : fOffsets(offsets)
+        , fDeletedCommands(deletedCommands) {
+        this->initFromStream(stream, success, proc);
     }
 
     void resetTimes() { ((SkTimedPicturePlayback*) fPlayback)->resetTimes(); }
@@ -293,12 +269,23 @@ public:
 
     double totTime() const { return ((SkTimedPicturePlayback*) fPlayback)->totTime(); }
 
+protected:
+    virtual SkPicturePlayback* createPlayback(SkStream* stream, const SkPictInfo& info,
+                                              SkPicture::InstallPixelRefProc proc) SK_OVERRIDE {
+        return SkNEW_ARGS(SkTimedPicturePlayback,
+                          (stream, info, proc, fOffsets, fDeletedCommands));
+    }
+
 private:
     // disallow default ctor b.c. we don't have a good way to setup the fPlayback ptr
     SkTimedPicture();
     // disallow the copy ctor - enabling would require copying code from SkPicture
     SkTimedPicture(const SkTimedPicture& src);
 
+    // Only used while the playback is read, by createPlayback()
+    const SkTDArray<size_t>& fOffsets;
+    const SkTDArray<bool>& fDeletedCommands;
+
     typedef SkPicture INHERITED;
 };
 
@@ -941,38 +928,19 @@ private:
 class SkOffsetPicture : public SkPicture {
 public:
     SkOffsetPicture(SkStream* stream, bool* success, SkPicture::InstallPixelRefProc proc) {
-        if (success) {
-            *success = false;
-        }
-        fRecord = NULL;
-        fPlayback = NULL;
-        fWidth = fHeight = 0;
-
-        SkPictInfo info;
-
-        if (!stream->read(&info, sizeof(info))) {
-            return;
-        }
-        if (PICTURE_VERSION != info.fVersion) {
-            return;
-        }
-
-        if (stream->readBool()) {
-            fPlayback = SkNEW_ARGS(SkOffsetPicturePlayback, (stream, info, proc));
-        }
-
-        // do this at the end, so that they will be zero if we hit an error.
-        fWidth = info.fWidth;
-        fHeight = info.fHeight;
-        if (success) {
-            *success = true;
-        }
+        this->initFromStream(stream, success, proc);
     }
 
     const SkTDArray<size_t>& offsets() const {
         return ((SkOffsetPicturePlayback*) fPlayback)->offsets();
     }
 
+protected:
+    virtual SkPicturePlayback* createPlayback(SkStream* stream, const SkPictInfo& info,
+                                              SkPicture::InstallPixelRefProc proc) SK_OVERRIDE {
+        return SkNEW_ARGS(SkOffsetPicturePlayback, (stream, info, proc));
+    }
+
 private:
     // disallow default ctor b.c. we don't have a good way to setup the fPlayback ptr
     SkOffsetPicture();
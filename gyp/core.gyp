@@ -118,7 +118,8 @@
         ],
       },
       'dependencies': [
-        'opts.gyp:opts'
+        'opts.gyp:opts',
+        'zlib.gyp:zlib',
       ],
     },
   ],
@@ -27,6 +27,8 @@
         '../include/config',
         '../include/core',
         '../src/core',
+        '../src/effects',
+        '../src/effects/gradients',
         '../src/opts',
       ],
       'conditions': [
@@ -40,6 +42,7 @@
             [ 'skia_os != "android"', {
               'dependencies': [
                 'opts_ssse3',
+                'opts_avx2',
               ],
             }],
           ],
@@ -48,7 +51,12 @@
             '../src/opts/SkBitmapProcState_opts_SSE2.cpp',
             '../src/opts/SkBlitRow_opts_SSE2.cpp',
             '../src/opts/SkBlitRect_opts_SSE2.cpp',
+            '../src/opts/SkBlurMask_opts_SSE2.cpp',
+            '../src/opts/SkConvolver_opts_SSE2.cpp',
+            '../src/opts/SkGradient_opts_SSE2.cpp',
+            '../src/opts/SkMipMap_opts_SSE2.cpp',
             '../src/opts/SkUtils_opts_SSE2.cpp',
+            '../src/opts/SkXfermode_opts_SSE2.cpp',
           ],
         }],
         [ 'skia_arch_type == "arm" and armv7 == 1', {
@@ -93,7 +101,12 @@
           'sources': [
             '../src/opts/SkBitmapProcState_opts_none.cpp',
             '../src/opts/SkBlitRow_opts_none.cpp',
+            '../src/opts/SkBlurMask_opts_none.cpp',
+            '../src/opts/SkConvolver_opts_none.cpp',
+            '../src/opts/SkGradient_opts_none.cpp',
+            '../src/opts/SkMipMap_opts_none.cpp',
             '../src/opts/SkUtils_opts_none.cpp',
+            '../src/opts/SkXfermode_opts_none.cpp',
           ],
         }],
       ],
@@ -133,6 +146,40 @@
         }],
       ],
     },
+    # Likewise the AVX2 code gets its own target, so that -mavx2 only
+    # reaches the *_AVX2.cpp files. opts_check_SSE2.cpp only calls into
+    # them once cpuid says the CPU and OS support AVX2.
+    {
+      'target_name': 'opts_avx2',
+      'product_name': 'skia_opts_avx2',
+      'type': 'static_library',
+      'standalone_static_library': 1,
+      'include_dirs': [
+        '../include/config',
+        '../include/core',
+        '../src/core',
+      ],
+      'conditions': [
+        [ 'skia_os in ["linux", "freebsd", "openbsd", "solaris", "nacl"]', {
+          'cflags': [
+            '-mavx2',
+          ],
+        }],
+        # Same caveat as for opts_ssse3 about OTHER_CFLAGS.
+        [ 'skia_os in ["mac"]', {
+          'xcode_settings': {
+            'OTHER_CFLAGS': ['-mavx2',],
+          },
+        }],
+        [ 'skia_arch_type == "x86"', {
+          'sources': [
+            '../src/opts/SkBitmapProcState_opts_AVX2.cpp',
+            '../src/opts/SkBlitRow_opts_AVX2.cpp',
+            '../src/opts/SkUtils_opts_AVX2.cpp',
+          ],
+        }],
+      ],
+    },
     # NEON code must be compiled with -mfpu=neon which also affects scalar
     # code. To support dynamic NEON code paths, we need to build all
     # NEON-specific sources in a separate static library. The situation
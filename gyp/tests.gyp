@@ -22,14 +22,17 @@
       ],
       'sources': [
         '../tests/AAClipTest.cpp',
+        '../tests/AnalyticAATest.cpp',
         '../tests/AnnotationTest.cpp',
         '../tests/ARGBImageEncoderTest.cpp',
         '../tests/AtomicTest.cpp',
+        '../tests/BandedDeviceTest.cpp',
         '../tests/BitmapCopyTest.cpp',
         '../tests/BitmapFactoryTest.cpp',
         '../tests/BitmapGetColorTest.cpp',
         '../tests/BitmapHasherTest.cpp',
         '../tests/BitmapHeapTest.cpp',
+        '../tests/BitmapScalerTest.cpp',
         '../tests/BitSetTest.cpp',
         '../tests/BlitRowTest.cpp',
         '../tests/BlurTest.cpp',
@@ -68,12 +71,15 @@
         '../tests/HashCacheTest.cpp',
         '../tests/InfRectTest.cpp',
         '../tests/LListTest.cpp',
+        '../tests/LRUCacheTest.cpp',
         '../tests/MD5Test.cpp',
+        '../tests/MaskCacheTest.cpp',
         '../tests/MathTest.cpp',
         '../tests/MatrixTest.cpp',
         '../tests/Matrix44Test.cpp',
         '../tests/MemsetTest.cpp',
         '../tests/MetaDataTest.cpp',
+        '../tests/MipMapCacheTest.cpp',
         '../tests/PackBitsTest.cpp',
         '../tests/PaintTest.cpp',
         '../tests/ParsePathTest.cpp',
@@ -111,7 +117,9 @@
         '../tests/Test.cpp',
         '../tests/Test.h',
         '../tests/TestSize.cpp',
+        '../tests/ThreadPoolTest.cpp',
         '../tests/TileGridTest.cpp',
+        '../tests/TileSchedulerTest.cpp',
         '../tests/TLSTest.cpp',
         '../tests/TSetTest.cpp',
         '../tests/ToUnicode.cpp',
@@ -32,6 +32,16 @@
         '../src/utils/SkCountdown.cpp',
         '../src/utils/SkThreadPool.cpp',
 
+        # Work-stealing tile scheduling on top of the threadpool.
+        '../include/utils/SkPictureTileRenderer.h',
+        '../include/utils/SkTileScheduler.h',
+        '../src/utils/SkPictureTileRenderer.cpp',
+        '../src/utils/SkTileScheduler.cpp',
+
+        # Splitting large raster draws into bands on the threadpool.
+        '../include/utils/SkBandedDevice.h',
+        '../src/utils/SkBandedDevice.cpp',
+
         '../include/utils/SkBoundaryPatch.h',
         '../include/utils/SkCamera.h',
         '../include/utils/SkCubicInterval.h',
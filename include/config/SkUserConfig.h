@@ -122,6 +122,19 @@
  */
 //#define SK_DEFAULT_FONT_CACHE_LIMIT   (1024 * 1024)
 
+/*
+ *  To turn on the cache of antialiased and blurred path masks by default,
+ *  define this to its budget in bytes. If this is undefined, the cache is off
+ *  until SkGraphics::SetMaskCacheLimit() is called.
+ */
+//#define SK_DEFAULT_MASK_CACHE_LIMIT   (2 * 1024 * 1024)
+
+/*
+ *  The budget in bytes of the cache of bitmap mip levels that are built for
+ *  SkPaint::kMipMapBitmap_Flag. If this is undefined, it is 16MB.
+ */
+//#define SK_DEFAULT_MIPMAP_CACHE_LIMIT (16 * 1024 * 1024)
+
 /* If defined, use CoreText instead of ATSUI on OS X.
 */
 //#define SK_USE_MAC_CORE_TEXT
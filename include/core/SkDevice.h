@@ -22,6 +22,7 @@ struct SkIRect;
 class SkMatrix;
 class SkMetaData;
 class SkRegion;
+class SkRRect;
 
 // This is an opaque class, not interpreted by skia
 class SkGpuRenderTarget;
@@ -259,6 +260,13 @@ protected:
                           const SkPaint& paint);
     virtual void drawOval(const SkDraw&, const SkRect& oval,
                           const SkPaint& paint);
+    /**
+     *  The default impl. lets the SkDraw draw the rrect from a mask filter's
+     *  nine-patch if it can, and otherwise converts it to a path and calls
+     *  drawPath(). Subclasses that override drawPath() need not override this.
+     */
+    virtual void drawRRect(const SkDraw&, const SkRRect& rr,
+                           const SkPaint& paint);
     /**
      *  If pathIsMutable, then the implementation is allowed to cast path to a
      *  non-const pointer and modify it in place (as an optimization). Canvas
@@ -22,6 +22,7 @@ class SkMatrix;
 class SkPath;
 class SkRegion;
 class SkRasterClip;
+class SkRRect;
 struct SkDrawProcs;
 struct SkRect;
 
@@ -34,6 +35,15 @@ public:
     void    drawPoints(SkCanvas::PointMode, size_t count, const SkPoint[],
                        const SkPaint&, bool forceUseDevice = false) const;
     void    drawRect(const SkRect&, const SkPaint&) const;
+    void    drawRRect(const SkRRect&, const SkPaint&) const;
+    /**
+     *  If the paint's mask filter can draw the rrect without it being
+     *  rasterized as a path first (see SkMaskFilter::filterRRect), draws it
+     *  and returns true. Also returns true if the clip is empty. Otherwise
+     *  draws nothing and returns false, and the caller should draw the rrect
+     *  as a path.
+     */
+    bool    drawRRectWithMaskFilter(const SkRRect&, const SkPaint&) const;
     /**
      *  To save on mallocs, we allow a flag that tells us that srcPath is
      *  mutable, so that we don't have to make copies of it as we transform it.
@@ -45,6 +55,14 @@ public:
      */
     void    drawPath(const SkPath& srcPath, const SkPaint&,
                      const SkMatrix* prePathMatrix, bool pathIsMutable) const;
+    /**
+     *  If drawPath() (with no prePathMatrix) would draw the path by blitting
+     *  a mask from the mask cache, returns that mask, first building and
+     *  caching it if it is not cached, and sets owner to what keeps it alive,
+     *  which the caller must unref(). Otherwise returns NULL. See fPathMask.
+     */
+    const SkMask* findOrCreatePathMask(const SkPath&, const SkPaint&,
+                                       SkRefCnt** owner) const;
     void    drawBitmap(const SkBitmap&, const SkMatrix&, const SkPaint&) const;
     void    drawSprite(const SkBitmap&, int x, int y, const SkPaint&) const;
     void    drawText(const char text[], size_t byteLength, SkScalar x,
@@ -125,6 +143,22 @@ public:
     SkBounder*      fBounder;       // optional
     SkDrawProcs*    fProcs;         // optional
 
+    /**
+     *  Optional. If set, only the pixels in these rows (and inside the clip)
+     *  are written. Unlike intersecting the clip with the band, this leaves
+     *  scan conversion untouched, so a draw split into bands produces exactly
+     *  the pixels it would have produced in one piece.
+     */
+    const SkIRect*  fBand;
+
+    /**
+     *  Optional. If set, drawPath() blits this mask instead of drawing the
+     *  path. It must be what findOrCreatePathMask() returned for the same
+     *  path, paint and matrix. Lets the bands of a split draw share one mask
+     *  that the caller looked up, rather than each going to the mask cache.
+     */
+    const SkMask*   fPathMask;
+
 #ifdef SK_DEBUG
     void validate() const;
 #else
@@ -10,11 +10,9 @@
 #ifndef SkFlate_DEFINED
 #define SkFlate_DEFINED
 
-#include "SkTypes.h"
+#include "SkStream.h"
 
 class SkData;
-class SkWStream;
-class SkStream;
 
 /** \class SkFlate
     A class to provide access to the flate compression algorithm.
@@ -49,4 +47,73 @@ public:
     static bool Inflate(SkStream* src, SkWStream* dst);
 };
 
+/** \class SkDeflateWStream
+    A stream that compresses what is written to it with the flate algorithm,
+    and passes the compressed data on to another stream as it goes, so that
+    neither all of the input nor all of the output is ever held in memory.
+
+    The compressed data is written in blocks, each preceded by its length as a
+    32-bit int, and ended by a zero length. So unlike the output of
+    SkFlate::Deflate(), it can be read back only by SkInflateStream, but the
+    reader knows where it ends, and so never reads past it into whatever
+    follows it in the stream.
+*/
+class SkDeflateWStream : public SkWStream {
+public:
+    /** dst must outlive this stream. */
+    explicit SkDeflateWStream(SkWStream* dst);
+
+    /** Calls finalize() if it has not been called. */
+    virtual ~SkDeflateWStream();
+
+    /** Compresses and writes out whatever has not been written yet, and ends
+        the compressed data. Nothing can be written after this. Returns false
+        if an error occurs, here or in an earlier call to write().
+     */
+    bool finalize();
+
+    /** Returns false if an error occurs, or if flate is not available. */
+    virtual bool write(const void* buffer, size_t size) SK_OVERRIDE;
+
+    /** The number of bytes written to this stream, before compression. */
+    size_t bytesWritten() const { return fBytesWritten; }
+
+private:
+    struct Impl;
+
+    Impl*   fImpl;
+    size_t  fBytesWritten;
+
+    typedef SkWStream INHERITED;
+};
+
+/** \class SkInflateStream
+    A stream that reads data written by SkDeflateWStream from another stream,
+    and decompresses it as it is read, one block at a time. It never reads
+    past the end of the compressed data.
+
+    Its length is not known up front, so read(NULL, 0) returns 0. It returns
+    short reads once the compressed data ends, or if it is corrupt.
+*/
+class SkInflateStream : public SkStream {
+public:
+    /** src is ref'd. */
+    explicit SkInflateStream(SkStream* src);
+    virtual ~SkInflateStream();
+
+    /** Returns false if the compressed data was corrupt or cut short. */
+    bool isValid() const;
+
+    virtual bool rewind() SK_OVERRIDE;
+    virtual size_t read(void* buffer, size_t size) SK_OVERRIDE;
+
+private:
+    struct Impl;
+
+    SkStream*   fSrc;
+    Impl*       fImpl;
+
+    typedef SkStream INHERITED;
+};
+
 #endif
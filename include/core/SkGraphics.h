@@ -60,10 +60,66 @@ public:
      */
     static void PurgeFontCache();
 
+    /**
+     *  Return the max number of bytes that should be used by the cache of
+     *  antialiased and blurred path masks. A limit of 0 (the default, unless
+     *  SK_DEFAULT_MASK_CACHE_LIMIT is defined) turns the cache off.
+     */
+    static size_t GetMaskCacheLimit();
+
+    /**
+     *  Specify the max number of bytes that should be used by the mask cache.
+     *  Drawing a path whose mask is in the cache only blits the mask, instead
+     *  of scan converting (and blurring) the path again. If the cache needs to
+     *  allocate more, it will purge the least recently used masks.
+     *
+     *  This function returns the previous setting, as if GetMaskCacheLimit()
+     *  had be called before the new limit was set.
+     */
+    static size_t SetMaskCacheLimit(size_t bytes);
+
+    /**
+     *  Return the number of bytes currently used by the mask cache.
+     */
+    static size_t GetMaskCacheUsed();
+
+    /**
+     *  Purge the mask cache, without changing its limit.
+     */
+    static void PurgeMaskCache();
+
+    /**
+     *  Return the max number of bytes that should be used by the cache of
+     *  bitmap mip levels built for SkPaint::kMipMapBitmap_Flag. A limit of 0
+     *  turns the cache, and so those mip levels, off.
+     */
+    static size_t GetMipMapCacheLimit();
+
+    /**
+     *  Specify the max number of bytes that should be used by the mip level
+     *  cache. If the cache needs to allocate more, it will purge the levels of
+     *  the least recently used bitmaps. A bitmap whose levels need more than
+     *  half the limit is drawn from its full size instead.
+     *
+     *  This function returns the previous setting, as if GetMipMapCacheLimit()
+     *  had be called before the new limit was set.
+     */
+    static size_t SetMipMapCacheLimit(size_t bytes);
+
+    /**
+     *  Return the number of bytes currently used by the mip level cache.
+     */
+    static size_t GetMipMapCacheUsed();
+
+    /**
+     *  Purge the mip level cache, without changing its limit.
+     */
+    static void PurgeMipMapCache();
+
     /**
      *  Applications with command line options may pass optional state, such
      *  as cache sizes, here, for instance:
-     *  font-cache-limit=12345678
+     *  font-cache-limit=12345678;mask-cache-limit=4194304;mipmap-cache-limit=0
      *
      *  The flags format is name=value[;name=value...] with no spaces.
      *  This format is subject to change.
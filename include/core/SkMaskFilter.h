@@ -19,6 +19,7 @@ class SkBounder;
 class SkMatrix;
 class SkPath;
 class SkRasterClip;
+class SkRRect;
 
 /** \class SkMaskFilter
 
@@ -131,6 +132,17 @@ protected:
                                            const SkIRect& clipBounds,
                                            NinePatch*) const;
 
+    /**
+     *  Like filterRectsToNine, for a filled rrect (or oval) in device space.
+     *  The center of the returned ninepatch is filled solid. If the returned
+     *  mask is as big as outerRect there is nothing to stretch, and the mask
+     *  is drawn as is, so a subclass may also return the whole filtered mask
+     *  of a shape too round to stretch.
+     */
+    virtual FilterReturn filterRRectToNine(const SkRRect&, const SkMatrix&,
+                                           const SkIRect& clipBounds,
+                                           NinePatch*) const;
+
 private:
     friend class SkDraw;
 
@@ -143,6 +155,13 @@ private:
                     const SkRasterClip&, SkBounder*, SkBlitter* blitter,
                     SkPaint::Style style) const;
 
+    /** Helper method that, given a filled rrect in device space, will draw it
+     through filterRRectToNine(). Returns false, having drawn nothing, if that
+     did not produce a ninepatch.
+     */
+    bool filterRRect(const SkRRect& devRRect, const SkMatrix& devMatrix,
+                     const SkRasterClip&, SkBounder*, SkBlitter* blitter) const;
+
     typedef SkFlattenable INHERITED;
 };
 
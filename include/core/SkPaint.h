@@ -105,11 +105,13 @@ public:
         kAutoHinting_Flag     = 0x800,  //!< mask to force Freetype's autohinter
         kVerticalText_Flag    = 0x1000,
         kGenA8FromLCD_Flag    = 0x2000, // hack for GDI -- do not use if you can help it
+        kMipMapBitmap_Flag    = 0x4000, //!< mask to filter downscaled bitmaps from cached mip levels
+        kHighQualityFilterBitmap_Flag = 0x8000, //!< mask to resample scaled bitmaps with a bicubic filter
 
         // when adding extra flags, note that the fFlags member is specified
         // with a bit-width and you'll have to expand it.
 
-        kAllFlags = 0x3FFF
+        kAllFlags = 0xFFFF
     };
 
     /** Return the paint's flags. Use the Flag enum to test flag values.
@@ -278,6 +280,46 @@ public:
 
     void setFilterBitmap(bool filterBitmap);
 
+    /** Helper for getFlags(), returning true if kMipMapBitmap_Flag bit is set
+        @return true if filtered bitmaps that are drawn at less than half
+                their size are sampled from mip levels
+    */
+    bool isMipMapBitmap() const {
+        return SkToBool(this->getFlags() & kMipMapBitmap_Flag);
+    }
+
+    /** Helper for setFlags(), setting or clearing the kMipMapBitmap_Flag bit.
+        When set along with kFilterBitmap_Flag, a bitmap drawn at less than
+        half its size is filtered from a mip level of it, which is built on
+        first use and kept in a global cache (see
+        SkGraphics::SetMipMapCacheLimit()). Bitmaps that already have mip
+        levels (see SkBitmap::buildMipMap()) use those instead.
+        @param mipMapBitmap true to set the kMipMapBitmap_Flag bit in the
+                            paint's flags, false to clear it.
+    */
+    void setMipMapBitmap(bool mipMapBitmap);
+
+    /** Helper for getFlags(), returning true if kHighQualityFilterBitmap_Flag
+        bit is set
+        @return true if filtered bitmaps that are only scaled are resampled
+                with a bicubic filter
+    */
+    bool isHighQualityFilterBitmap() const {
+        return SkToBool(this->getFlags() & kHighQualityFilterBitmap_Flag);
+    }
+
+    /** Helper for setFlags(), setting or clearing the
+        kHighQualityFilterBitmap_Flag bit. When set along with
+        kFilterBitmap_Flag, an 8888 bitmap drawn with only scale and translate
+        (e.g. by drawBitmapRect()) is first resampled to its size on the
+        device with a separable bicubic filter, instead of being filtered
+        bilinearly. Other draws ignore it.
+        @param highQualityFilterBitmap true to set the
+                            kHighQualityFilterBitmap_Flag bit in the paint's
+                            flags, false to clear it.
+    */
+    void setHighQualityFilterBitmap(bool highQualityFilterBitmap);
+
     /** Styles apply to rect, oval, path, and text.
         Bitmaps are always drawn in "fill", and lines are always drawn in
         "stroke".
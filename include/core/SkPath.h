@@ -15,14 +15,6 @@
 #include "SkTDArray.h"
 #include "SkRefCnt.h"
 
-#ifdef SK_BUILD_FOR_ANDROID
-#define GEN_ID_INC              fGenerationID++
-#define GEN_ID_PTR_INC(ptr)     ptr->fGenerationID++
-#else
-#define GEN_ID_INC
-#define GEN_ID_PTR_INC(ptr)
-#endif
-
 class SkReader32;
 class SkWriter32;
 class SkAutoPathBoundsUpdate;
@@ -85,7 +77,6 @@ public:
     */
     void setFillType(FillType ft) {
         fFillType = SkToU8(ft);
-        GEN_ID_INC;
     }
 
     /** Returns true if the filltype is one of the Inverse variants */
@@ -97,7 +88,6 @@ public:
      */
     void toggleInverseFillType() {
         fFillType ^= 2;
-        GEN_ID_INC;
      }
 
     enum Convexity {
@@ -904,8 +894,14 @@ public:
      */
     uint32_t readFromMemory(const void* buffer);
 
-#ifdef SK_BUILD_FOR_ANDROID
+    /**
+     *  Returns an ID that identifies the points, verbs and fill type of the path. Paths with
+     *  the same ID draw the same; paths that draw the same may still have different IDs. The
+     *  ID changes whenever the path is edited.
+     */
     uint32_t getGenerationID() const;
+
+#ifdef SK_BUILD_FOR_ANDROID
     const SkPath* getSourcePath() const;
     void setSourcePath(const SkPath* path);
 #endif
@@ -957,7 +953,6 @@ private:
     mutable SkBool8     fIsFinite;    // only meaningful if bounds are valid
     mutable SkBool8     fIsOval;
 #ifdef SK_BUILD_FOR_ANDROID
-    uint32_t            fGenerationID;
     const SkPath*       fSourcePath;
 #endif
 
@@ -17,6 +17,7 @@ class SkBBoxHierarchy;
 class SkCanvas;
 class SkPicturePlayback;
 class SkPictureRecord;
+struct SkPictInfo;
 class SkStream;
 class SkWStream;
 
@@ -78,6 +79,9 @@ public:
 
     /**
      *  Creates a thread-safe clone of the picture that is ready for playback.
+     *  Note that a finished picture can be drawn from several threads at once
+     *  as is, so a clone is only needed to get a copy that is fully
+     *  independent of this one.
      */
     SkPicture* clone() const;
 
@@ -118,13 +122,29 @@ public:
         kOptimizeForClippedPlayback_RecordingFlag = 0x02,
         /*
             This flag disables all the picture recording optimizations (i.e.,
-            those in SkPictureRecord). It is mainly intended for testing the
+            those in SkPictureRecord, and the pass over the finished op stream
+            that endRecording() runs). It is mainly intended for testing the
             existing optimizations (i.e., to actually have the pattern
             appear in an .skp we have to disable the optimization). This
             option doesn't affect the optimizations controlled by
-            'kOptimizeForClippedPlayback_RecordingFlag'.
+            'kOptimizeForClippedPlayback_RecordingFlag'. (Pictures recorded
+            with that flag never get the op stream pass, since it would
+            invalidate their bounding box data.)
          */
-        kDisableRecordOptimizations_RecordingFlag = 0x04
+        kDisableRecordOptimizations_RecordingFlag = 0x04,
+        /*  This flag makes the bounding box hierarchy also note, for each
+            draw that is known to cover its area with opaque pixels (e.g. an
+            opaque fill of a rect, or an opaque bitmap, under a rect-preserving
+            matrix and a rect clip), the device area it
+            covers. Playback then skips draws that a later opaque draw
+            completely hides within the area being drawn. This saves
+            redrawing backgrounds that are painted over, at the cost of a
+            little extra recording time and memory. It only has an effect
+            together with 'kOptimizeForClippedPlayback_RecordingFlag', and
+            only when the picture is drawn with an integer translate and a
+            rect clip.
+        */
+        kCullOccludedDraws_RecordingFlag = 0x08
     };
 
     /** Returns the canvas that records the drawing commands.
@@ -150,6 +170,9 @@ public:
 
     /** Replays the drawing commands on the specified canvas. This internally
         calls endRecording() if that has not already been called.
+
+        Once endRecording() has been called, draw() may be called on the same
+        picture from several threads at once, without cloning it.
         @param surface the canvas receiving the drawing commands.
     */
     void draw(SkCanvas* surface);
@@ -177,11 +200,22 @@ public:
      */
     typedef bool (*EncodeBitmap)(SkWStream*, const SkBitmap&);
 
+    enum SerializeFlags {
+        /*  Deflate everything after the picture's header (see SkFlate), as it
+            is written. It is inflated again as it is read back, so neither
+            side holds the whole uncompressed picture. Ignored if flate is not
+            available.
+        */
+        kCompress_SerializeFlag = 0x01,
+    };
+
     /**
      *  Serialize to a stream. If non NULL, encoder will be used to encode
-     *  any bitmaps in the picture.
+     *  any bitmaps in the picture. serializeFlags is a bitmask of
+     *  SerializeFlags.
      */
-    void serialize(SkWStream*, EncodeBitmap encoder = NULL) const;
+    void serialize(SkWStream*, EncodeBitmap encoder = NULL,
+                   uint32_t serializeFlags = 0) const;
 
 #ifdef SK_BUILD_FOR_ANDROID
     /** Signals that the caller is prematurely done replaying the drawing
@@ -203,7 +237,11 @@ protected:
     // V9 : Allow the reader and writer of an SKP disagree on whether to support
     //      SK_SUPPORT_HINTING_SCALE_FACTOR
     // V10: add drawRRect, drawOval, clipRRect
-    static const uint32_t PICTURE_VERSION = 10;
+    // V11: add DRAW_RECTS, written by the post-record op optimizer
+    // V12: align the op data and the flattened arrays to 4 bytes, so that they can be used in
+    //      place from a mapped file, and index the arrays' entries
+    // V13: optionally deflate everything after the SkPictInfo
+    static const uint32_t PICTURE_VERSION = 13;
 
     // fPlayback, fRecord, fWidth & fHeight are protected to allow derived classes to
     // install their own SkPicturePlayback-derived players,SkPictureRecord-derived
@@ -216,8 +254,14 @@ protected:
     // SkBBoxHierarchy implementation
     virtual SkBBoxHierarchy* createBBoxHierarchy() const;
 
-private:
+    // Reads what serialize() wrote into this (empty) picture: the header, then the playback,
+    // inflating it first if it was compressed. Derived classes that install their own
+    // SkPicturePlayback-derived players call this from their constructors, and override
+    // createPlayback() to read the playback with them.
     void initFromStream(SkStream*, bool* success, InstallPixelRefProc);
+    virtual SkPicturePlayback* createPlayback(SkStream*, const SkPictInfo&, InstallPixelRefProc);
+
+private:
 
     friend class SkFlatPicture;
     friend class SkPicturePlayback;
@@ -60,6 +60,15 @@ public:
     */
     virtual const void* getMemoryBase();
 
+    /** If the stream reads from memory that outlives it, e.g. a file mapped by
+        NewFromFile(), returns the next length bytes as an SkData that refers to
+        that memory rather than a copy of it, and skips past them. Otherwise
+        returns NULL and leaves the stream where it was.
+        The caller must call unref() on the returned data.
+        The default implementation returns NULL.
+    */
+    virtual SkData* readSharedData(size_t length);
+
     int8_t   readS8();
     int16_t  readS16();
     int32_t  readS32();
@@ -241,6 +250,7 @@ public:
     virtual bool rewind() SK_OVERRIDE;
     virtual size_t read(void* buffer, size_t size) SK_OVERRIDE;
     virtual const void* getMemoryBase() SK_OVERRIDE;
+    virtual SkData* readSharedData(size_t length) SK_OVERRIDE;
     const void* getAtPos();
     size_t seek(size_t offset);
     size_t peek() const { return fOffset; }
@@ -248,6 +258,9 @@ public:
 private:
     SkData* fData;
     size_t  fOffset;
+    // False if fData wraps memory that the caller owns (copyData == false),
+    // which may go away with the stream.
+    bool    fCanShareData;
 
     typedef SkStream INHERITED;
 };
@@ -129,6 +129,30 @@ public:
                                  const SkColor colors[], const SkScalar pos[],
                                  int count, SkUnitMapper* mapper = NULL);
 
+    /** Gradients with the same colors and positions share the color tables
+        they draw from through a process-wide cache. Return the max number of
+        bytes it may use. A limit of 0 turns the sharing off.
+    */
+    static size_t GetCacheLimit();
+
+    /** Specify the max number of bytes the color table cache may use. If it
+        needs more, it purges the least recently used tables.
+        Returns the previous limit.
+    */
+    static size_t SetCacheLimit(size_t bytes);
+
+    /** Return the number of bytes currently used by the color table cache. */
+    static size_t GetCacheUsed();
+
+    /** Purge the color table cache, without changing its limit. */
+    static void PurgeCache();
+
+    /** Return the number of times a gradient did (or did not) find its color
+        table in the cache, e.g. to check the cache's hit rate.
+    */
+    static int GetCacheHitCount();
+    static int GetCacheMissCount();
+
     SK_DECLARE_FLATTENABLE_REGISTRAR_GROUP()
 };
 
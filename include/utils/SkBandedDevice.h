@@ -0,0 +1,114 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkBandedDevice_DEFINED
+#define SkBandedDevice_DEFINED
+
+#include "SkDevice.h"
+
+class SkThreadPool;
+
+/**
+ * A raster device that splits large draws into horizontal bands and draws
+ * the bands on the threads of an SkThreadPool. It is meant for very large
+ * bitmaps, e.g. when printing, where a single drawPath() or drawBitmapRect()
+ * can cover millions of pixels.
+ *
+ * Every band runs the whole draw against the full clip, with SkDraw::fBand
+ * keeping it from writing outside its rows. So only the blitting is split
+ * up, but the result is identical to drawing on one thread. Clipping each
+ * band's scan conversion to the band would be cheaper, but chops edges
+ * differently and so does not give the same pixels. A path that is drawn
+ * from the mask cache is looked up (or drawn into the cache) once, before
+ * the draw is split, and the bands only blit the mask.
+ *
+ * Draws that cover too few pixels to be worth splitting, and draws whose
+ * paints need expensive per-draw setup (mask filters, rasterizers and path
+ * effects, which every band would repeat), are drawn inline.
+ */
+class SkBandedDevice : public SkDevice {
+public:
+    enum {
+        /** Default for minBandArea. */
+        kDefaultMinBandArea = 256 * 256,
+    };
+
+    /**
+     * Draws into bitmap, whose pixels must already be allocated. A draw is
+     * split so that each band covers at least minBandArea pixels, into at
+     * most one band per thread in pool, plus one for the calling thread,
+     * which helps out while it waits. The pool must outlive the device. If it
+     * is NULL, everything is drawn inline.
+     */
+    SkBandedDevice(const SkBitmap& bitmap, SkThreadPool* pool,
+                   int minBandArea = kDefaultMinBandArea);
+
+    /**
+     * Returns the number of bands the last draw was split into, or 1 if it
+     * was drawn inline.
+     */
+    int getLastBandCount() const { return fLastBandCount; }
+
+protected:
+    virtual void drawPaint(const SkDraw&, const SkPaint& paint) SK_OVERRIDE;
+    virtual void drawRect(const SkDraw&, const SkRect& r,
+                          const SkPaint& paint) SK_OVERRIDE;
+    virtual void drawPath(const SkDraw&, const SkPath& path,
+                          const SkPaint& paint,
+                          const SkMatrix* prePathMatrix = NULL,
+                          bool pathIsMutable = false) SK_OVERRIDE;
+    virtual void drawBitmap(const SkDraw&, const SkBitmap& bitmap,
+                            const SkIRect* srcRectOrNull,
+                            const SkMatrix& matrix, const SkPaint& paint) SK_OVERRIDE;
+    virtual void drawSprite(const SkDraw&, const SkBitmap& bitmap,
+                            int x, int y, const SkPaint& paint) SK_OVERRIDE;
+    virtual void drawBitmapRect(const SkDraw&, const SkBitmap&,
+                                const SkRect* srcOrNull, const SkRect& dst,
+                                const SkPaint& paint) SK_OVERRIDE;
+
+private:
+    class Band;
+
+    enum Op {
+        kPaint_Op,
+        kRect_Op,
+        kPath_Op,
+        kBitmap_Op,
+        kSprite_Op,
+        kBitmapRect_Op,
+    };
+
+    // The arguments of one draw call, which every band replays. Only the
+    // fields that the op uses are set.
+    struct Args {
+        Op              fOp;
+        const SkRect*   fRect;      // kRect_Op's rect, kBitmapRect_Op's dst
+        const SkRect*   fSrcRect;   // kBitmapRect_Op
+        const SkIRect*  fSrcIRect;  // kBitmap_Op
+        const SkPath*   fPath;
+        const SkMatrix* fMatrix;    // kPath_Op's prePathMatrix, kBitmap_Op's matrix
+        const SkBitmap* fBitmap;
+        int             fX, fY;     // kSprite_Op
+
+        explicit Args(Op op) {
+            sk_bzero(this, sizeof(*this));
+            fOp = op;
+        }
+    };
+
+    bool drawInBands(const SkDraw&, const SkIRect& devBounds,
+                     const SkPaint&, const Args&);
+    void drawBand(const SkDraw&, const Args&, const SkPaint&);
+
+    SkThreadPool*   fPool;
+    int             fMinBandArea;
+    int             fLastBandCount;
+
+    typedef SkDevice INHERITED;
+};
+
+#endif
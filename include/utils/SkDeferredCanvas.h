@@ -14,6 +14,7 @@
 class DeferredDevice;
 class SkImage;
 class SkSurface;
+class SkThreadPool;
 
 /** \class SkDeferredCanvas
     Subclass of SkCanvas that encapsulates an SkPicture or SkGPipe for deferred
@@ -143,6 +144,25 @@ public:
      */
     void silentFlush();
 
+    /**
+     *  Play flushed commands back on the threads of a pool, each thread
+     *  drawing one horizontal band of the device. Every band plays back all
+     *  of the commands but only writes its own rows, so the result is the
+     *  same as playing them back on one thread.
+     *  Flushes are played back on the calling thread as usual when the
+     *  device is not a raster device, when the canvas is drawing to a layer,
+     *  or when the commands being flushed could use layers (saveLayer and
+     *  drawPicture). Pending commands are flushed before the change takes
+     *  effect. This method must not be called while the save/restore stack
+     *  is in use.
+     *  @param pool The threads to play back on, or NULL to go back to
+     *      playing back on the calling thread. The pool must outlive the
+     *      canvas, or be replaced first.
+     *  @param bandCount The number of bands, or 0 for one band per thread
+     *      in the pool, plus one for the calling thread.
+     */
+    void setFlushThreadPool(SkThreadPool* pool, int bandCount = 0);
+
     // Overrides of the SkCanvas interface
     virtual int save(SaveFlags flags) SK_OVERRIDE;
     virtual int saveLayer(const SkRect* bounds, const SkPaint* paint,
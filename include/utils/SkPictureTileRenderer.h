@@ -0,0 +1,65 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkPictureTileRenderer_DEFINED
+#define SkPictureTileRenderer_DEFINED
+
+#include "SkRect.h"
+#include "SkTileScheduler.h"
+
+class SkBitmap;
+class SkPicture;
+class SkThreadPool;
+
+/**
+ * Draws an SkPicture into a bitmap by splitting it into a grid of tiles and
+ * drawing the tiles on the threads of an SkThreadPool. The tiles are handed
+ * out by an SkTileScheduler, so workers that finish early steal tiles from
+ * the ones that are still busy.
+ */
+class SkPictureTileRenderer : SkNoncopyable {
+public:
+    /**
+     * All workers play back the same picture, so its recording is ended here.
+     * The picture must stay alive for as long as the renderer.
+     */
+    SkPictureTileRenderer(SkPicture* picture, int tileWidth, int tileHeight, int workerCount);
+
+    /**
+     * Draws the picture into dst, whose pixels must already be allocated, and
+     * returns once every tile has been drawn. Tiles that fall outside of dst
+     * are clipped. If pool is NULL, all of the workers run on this thread.
+     */
+    void draw(SkBitmap* dst, SkThreadPool* pool);
+
+    int tileCount() const { return fScheduler.tileCount(); }
+
+    /**
+     * Returns the bounds of a tile, in picture coordinates.
+     */
+    SkIRect getTileRect(int tile) const;
+
+    /**
+     * Returns who drew a tile and how long it took in the last call to draw().
+     */
+    const SkTileScheduler::TileStats& getTileStats(int tile) const {
+        return fScheduler.getStats(tile);
+    }
+
+    const SkTileScheduler& scheduler() const { return fScheduler; }
+
+private:
+    class Worker;
+
+    SkPicture*      fPicture;
+    int             fTileWidth;
+    int             fTileHeight;
+    int             fTilesX;
+    SkTileScheduler fScheduler;
+};
+
+#endif
@@ -10,11 +10,16 @@
 
 #include "SkCondVar.h"
 #include "SkTDArray.h"
-#include "SkTInternalLList.h"
+#include "SkThread.h"
 
 class SkRunnable;
 class SkThread;
 
+/**
+ * Each thread in the pool has its own queue of runnables. Runnables are spread across the queues
+ * as they are added, and a thread whose queue is empty steals from the others before going to
+ * sleep, so threads only contend with each other when they run out of work.
+ */
 class SkThreadPool {
 
 public:
@@ -31,16 +36,74 @@ public:
      */
     void add(SkRunnable*);
 
- private:
-    struct LinkedRunnable {
-        // Unowned pointer.
-        SkRunnable* fRunnable;
+    /**
+     * Queues up count SkRunnables, waking the sleeping threads only once, or runs them
+     * immediately if count is 0. NULL entries are skipped. Does not take ownership.
+     */
+    void add(SkRunnable* runnables[], int count);
+
+    /**
+     * Returns the number of threads in the pool.
+     */
+    int count() const { return fThreads.count(); }
+
+    /**
+     * Tracks a set of runnables added to a pool, so that the caller can wait for all of them
+     * to finish without building its own countdown. While waiting, the calling thread helps
+     * by running queued runnables, so a runnable may itself add to a group and wait for it.
+     * The destructor waits for any runnables still outstanding.
+     */
+    class Group : SkNoncopyable {
+    public:
+        explicit Group(SkThreadPool* pool);
+        ~Group();
+
+        /**
+         * Like SkThreadPool::add(), but counted as part of this group.
+         */
+        void add(SkRunnable*);
+        void add(SkRunnable* runnables[], int count);
+
+        /**
+         * Blocks until every runnable added to this group so far has run.
+         */
+        void wait();
 
     private:
-        SK_DECLARE_INTERNAL_LLIST_INTERFACE(LinkedRunnable);
+        void finished();
+
+        SkThreadPool*   fPool;
+        SkCondVar       fDone;
+        int32_t         fPending;
+
+        friend class SkThreadPool;
+    };
+
+ private:
+    struct Task {
+        SkRunnable* fRunnable;  // Unowned.
+        Group*      fGroup;     // Group to notify once fRunnable has run, or NULL.
     };
 
-    SkTInternalLList<LinkedRunnable>    fQueue;
+    // A queue owned by one thread. The owner takes from the front, thieves take from the back.
+    struct Queue {
+        SkMutex         fMutex;
+        SkTDArray<Task> fTasks;
+        int             fHead;  // fTasks[fHead...] are still to be run.
+
+        void push(const Task* tasks, int count);
+        bool popFront(Task*);
+        bool popBack(Task*);
+    };
+
+    void push(SkRunnable* runnables[], int count, Group*);
+    bool pop(int index, Task*);
+    static void Run(const Task&);
+
+    Queue*                              fQueues;
+    int32_t                             fPending;   // Number of queued tasks, across all queues.
+    int32_t                             fNextQueue; // Where to start spreading the next tasks.
+    int32_t                             fNextIndex; // Queue to give to the next thread to start.
     SkCondVar                           fReady;
     SkTDArray<SkThread*>                fThreads;
     bool                            fDone;
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkTileScheduler_DEFINED
+#define SkTileScheduler_DEFINED
+
+#include "SkThread.h"
+#include "SkTypes.h"
+
+/**
+ * Hands out the indices of a fixed set of tiles to a fixed set of workers.
+ *
+ * The tiles are first split into contiguous runs, one per worker, so each
+ * worker starts on neighbouring tiles. A worker that runs out of tiles steals
+ * the back half of the run of whichever worker has the most tiles left, so a
+ * few expensive tiles do not leave the other workers idle.
+ *
+ * nextTile() and recordTime() may be called concurrently by all of the workers.
+ */
+class SkTileScheduler : SkNoncopyable {
+public:
+    struct TileStats {
+        int     fWorker;    // Worker that drew the tile, or -1 if it has not been handed out.
+        bool    fStolen;    // True if the tile was not in the worker's initial run.
+        SkMSec  fDuration;  // Time spent on the tile, as reported by recordTime().
+    };
+
+    SkTileScheduler(int tileCount, int workerCount);
+    ~SkTileScheduler();
+
+    /**
+     * Puts every tile back into its initial run and clears the stats.
+     * Must not be called while any worker is calling nextTile().
+     */
+    void reset();
+
+    /**
+     * Claims the next tile for worker, first from its own run and then by
+     * stealing from the others. Returns false once every tile has been claimed.
+     */
+    bool nextTile(int worker, int* tile);
+
+    /**
+     * Records how long the worker that claimed tile took to draw it.
+     */
+    void recordTime(int tile, SkMSec duration) {
+        SkASSERT((unsigned)tile < (unsigned)fTileCount);
+        fStats[tile].fDuration = duration;
+    }
+
+    int tileCount() const { return fTileCount; }
+    int workerCount() const { return fWorkerCount; }
+
+    const TileStats& getStats(int tile) const {
+        SkASSERT((unsigned)tile < (unsigned)fTileCount);
+        return fStats[tile];
+    }
+
+    /**
+     * Returns the number of tiles that were drawn by a worker other than the
+     * one they were initially assigned to.
+     */
+    int countStolen() const;
+
+private:
+    struct Run {
+        SkMutex fMutex;
+        int     fStart;     // Tiles [fStart, fStop) are still to be handed out.
+        int     fStop;
+    };
+
+    int initialStart(int worker) const;
+    bool steal(int thief, int* tile);
+
+    const int   fTileCount;
+    const int   fWorkerCount;
+    Run*        fRuns;
+    TileStats*  fStats;
+};
+
+#endif
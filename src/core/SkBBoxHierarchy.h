@@ -61,6 +61,17 @@ public:
      */
     virtual void search(const SkIRect& query, SkTDArray<void*>* results) = 0;
 
+    /**
+     * Batched form of search(): populates results[i] with the data pointers whose bounding boxes
+     * intersect queries[i], for each of the 'count' queries. Subclasses may override this to
+     * share work between queries; the default simply runs each query in turn.
+     */
+    virtual void searchBatch(const SkIRect queries[], int count, SkTDArray<void*> results[]) {
+        for (int i = 0; i < count; ++i) {
+            this->search(queries[i], &results[i]);
+        }
+    }
+
     virtual void clear() = 0;
 
     /**
@@ -7,7 +7,10 @@
  */
 
 #include "SkBBoxHierarchyRecord.h"
+#include "SkPicture.h"
 #include "SkPictureStateTree.h"
+#include "SkShader.h"
+#include "SkXfermode.h"
 
 SkBBoxHierarchyRecord::SkBBoxHierarchyRecord(uint32_t recordFlags,
                                              SkBBoxHierarchy* h,
@@ -17,27 +20,158 @@ SkBBoxHierarchyRecord::SkBBoxHierarchyRecord(uint32_t recordFlags,
     fBoundingHierarchy = h;
     fBoundingHierarchy->ref();
     fBoundingHierarchy->setClient(this);
+
+    fCullOccludedDraws = SkToBool(recordFlags & SkPicture::kCullOccludedDraws_RecordingFlag);
+    fUsePathBoundsForClip =
+        SkToBool(recordFlags & SkPicture::kUsePathBoundsForClip_RecordingFlag);
+    fPendingOpaqueBounds.setEmpty();
+    fPendingDrawIsCullable = true;
+    fClipIsApproximate = false;
 }
 
 void SkBBoxHierarchyRecord::handleBBox(const SkRect& bounds) {
     SkIRect r;
     bounds.roundOut(&r);
     SkPictureStateTree::Draw* draw = fStateTree->appendDraw(this->writeStream().size());
+    if (fCullOccludedDraws && fPendingDrawIsCullable && !this->isDrawingToLayer()) {
+        // Antialiased hairlines may touch the pixels just outside their geometry's bounds
+        draw->fBounds = r;
+        draw->fBounds.outset(1, 1);
+        draw->fOpaqueBounds = fPendingOpaqueBounds;
+    }
     fBoundingHierarchy->insert(draw, r, true);
 }
 
+bool SkBBoxHierarchyRecord::isOpaquePaint(const SkPaint* paint, const SkBitmap* bitmap) const {
+    if (NULL != bitmap && !bitmap->isOpaque()) {
+        return false;
+    }
+    if (NULL == paint) {
+        return true;
+    }
+    if (0xFF != paint->getAlpha() ||
+        NULL != paint->getColorFilter() ||
+        NULL != paint->getMaskFilter() ||
+        NULL != paint->getPathEffect() ||
+        NULL != paint->getLooper() ||
+        NULL != paint->getImageFilter() ||
+        NULL != paint->getRasterizer()) {
+        return false;
+    }
+    // A bitmap draw ignores the paint's style and shader
+    if (NULL == bitmap) {
+        if (SkPaint::kFill_Style != paint->getStyle()) {
+            return false;
+        }
+        if (NULL != paint->getShader() && !paint->getShader()->isOpaque()) {
+            return false;
+        }
+    }
+    SkXfermode::Mode mode;
+    if (!SkXfermode::AsMode(paint->getXfermode(), &mode)) {
+        return false;
+    }
+    return SkXfermode::kSrcOver_Mode == mode || SkXfermode::kSrc_Mode == mode;
+}
+
+bool SkBBoxHierarchyRecord::canComputeOpaqueBounds() const {
+    return fCullOccludedDraws &&
+           !fClipIsApproximate &&
+           !this->isDrawingToLayer() &&
+           kRect_ClipType == this->getClipType();
+}
+
+void SkBBoxHierarchyRecord::setPendingOpaqueRect(const SkRect& rect, const SkPaint* paint,
+                                                 const SkBitmap* bitmap) {
+    fPendingOpaqueBounds.setEmpty();
+    if (!this->canComputeOpaqueBounds() || !this->isOpaquePaint(paint, bitmap)) {
+        return;
+    }
+    const SkMatrix& matrix = this->getTotalMatrix();
+    if (!matrix.rectStaysRect()) {
+        return;
+    }
+    SkRect devRect;
+    matrix.mapRect(&devRect, rect);
+    SkIRect clipBounds;
+    if (!this->getClipDeviceBounds(&clipBounds) || !devRect.intersect(SkRect::Make(clipBounds))) {
+        return;
+    }
+    // Only the pixels the draw covers completely, in case its edges are antialiased
+    devRect.roundIn(&fPendingOpaqueBounds);
+}
+
+void SkBBoxHierarchyRecord::drawRect(const SkRect& rect, const SkPaint& paint) {
+    this->setPendingOpaqueRect(rect, &paint, NULL);
+    INHERITED::drawRect(rect, paint);
+    fPendingOpaqueBounds.setEmpty();
+}
+
+void SkBBoxHierarchyRecord::drawPaint(const SkPaint& paint) {
+    fPendingOpaqueBounds.setEmpty();
+    if (this->canComputeOpaqueBounds() && this->isOpaquePaint(&paint, NULL)) {
+        this->getClipDeviceBounds(&fPendingOpaqueBounds);
+    }
+    INHERITED::drawPaint(paint);
+    fPendingOpaqueBounds.setEmpty();
+}
+
+void SkBBoxHierarchyRecord::drawBitmap(const SkBitmap& bitmap, SkScalar left, SkScalar top,
+                                       const SkPaint* paint) {
+    SkRect rect = SkRect::MakeXYWH(left, top, SkIntToScalar(bitmap.width()),
+                                   SkIntToScalar(bitmap.height()));
+    this->setPendingOpaqueRect(rect, paint, &bitmap);
+    INHERITED::drawBitmap(bitmap, left, top, paint);
+    fPendingOpaqueBounds.setEmpty();
+}
+
+void SkBBoxHierarchyRecord::drawBitmapRectToRect(const SkBitmap& bitmap, const SkRect* src,
+                                                 const SkRect& dst, const SkPaint* paint) {
+    this->setPendingOpaqueRect(dst, paint, &bitmap);
+    INHERITED::drawBitmapRectToRect(bitmap, src, dst, paint);
+    fPendingOpaqueBounds.setEmpty();
+}
+
+void SkBBoxHierarchyRecord::clear(SkColor color) {
+    fPendingDrawIsCullable = false;
+    INHERITED::clear(color);
+    fPendingDrawIsCullable = true;
+}
+
+void SkBBoxHierarchyRecord::drawSprite(const SkBitmap& bitmap, int left, int top,
+                                       const SkPaint* paint) {
+    fPendingDrawIsCullable = false;
+    INHERITED::drawSprite(bitmap, left, top, paint);
+    fPendingDrawIsCullable = true;
+}
+
+void SkBBoxHierarchyRecord::pushClipState(SaveFlags flags) {
+    ClipState* state = fClipStateStack.append();
+    state->fIsApproximate = fClipIsApproximate;
+    state->fRestoresClip = SkToBool(flags & kClip_SaveFlag);
+}
+
 int SkBBoxHierarchyRecord::save(SaveFlags flags) {
+    this->pushClipState(flags);
     fStateTree->appendSave();
     return INHERITED::save(flags);
 }
 
 int SkBBoxHierarchyRecord::saveLayer(const SkRect* bounds, const SkPaint* paint,
                                      SaveFlags flags) {
+    this->pushClipState(flags);
     fStateTree->appendSaveLayer(this->writeStream().size());
     return INHERITED::saveLayer(bounds, paint, flags);
 }
 
 void SkBBoxHierarchyRecord::restore() {
+    if (!fClipStateStack.isEmpty()) {
+        // A save without kClip_SaveFlag leaves any clip made since in place
+        if (fClipStateStack.top().fRestoresClip) {
+            fClipIsApproximate = fClipStateStack.top().fIsApproximate;
+        }
+        fClipStateStack.pop();
+    }
     fStateTree->appendRestore();
     INHERITED::restore();
 }
@@ -94,6 +228,7 @@ bool SkBBoxHierarchyRecord::clipPath(const SkPath& path,
                                      SkRegion::Op op,
                                      bool doAntiAlias) {
     fStateTree->appendClip(this->writeStream().size());
+    fClipIsApproximate = fClipIsApproximate || fUsePathBoundsForClip;
     return INHERITED::clipPath(path, op, doAntiAlias);
 }
 
@@ -101,6 +236,7 @@ bool SkBBoxHierarchyRecord::clipRRect(const SkRRect& rrect,
                                       SkRegion::Op op,
                                       bool doAntiAlias) {
     fStateTree->appendClip(this->writeStream().size());
+    fClipIsApproximate = fClipIsApproximate || fUsePathBoundsForClip;
     return INHERITED::clipRRect(rrect, op, doAntiAlias);
 }
 
@@ -11,6 +11,7 @@
 
 #include "SkBBoxHierarchy.h"
 #include "SkBBoxRecord.h"
+#include "SkTDArray.h"
 
 /**
  * This records bounding box information into an SkBBoxHierarchy, and clip/transform information
@@ -24,6 +25,18 @@ public:
 
     virtual void handleBBox(const SkRect& bounds) SK_OVERRIDE;
 
+    // These note the area that an opaque draw covers, when culling occluded draws
+    virtual void drawRect(const SkRect& rect, const SkPaint& paint) SK_OVERRIDE;
+    virtual void drawPaint(const SkPaint& paint) SK_OVERRIDE;
+    virtual void drawBitmap(const SkBitmap& bitmap, SkScalar left, SkScalar top,
+                            const SkPaint* paint = NULL) SK_OVERRIDE;
+    virtual void drawBitmapRectToRect(const SkBitmap& bitmap, const SkRect* src,
+                                      const SkRect& dst, const SkPaint* paint) SK_OVERRIDE;
+    // These write pixels outside the playback clip, so are never skipped
+    virtual void clear(SkColor) SK_OVERRIDE;
+    virtual void drawSprite(const SkBitmap& bitmap, int left, int top,
+                            const SkPaint* paint) SK_OVERRIDE;
+
     virtual int save(SaveFlags flags = kMatrixClip_SaveFlag) SK_OVERRIDE;
     virtual int saveLayer(const SkRect* bounds, const SkPaint* paint,
                           SaveFlags flags = kARGB_ClipLayer_SaveFlag) SK_OVERRIDE;
@@ -52,6 +65,32 @@ public:
     virtual bool shouldRewind(void* data) SK_OVERRIDE;
 
 private:
+    /**
+     * Sets fPendingOpaqueBounds to the device area that drawing 'rect' (in local coordinates)
+     * with 'paint' will cover with opaque pixels, if there is one we can be sure of.
+     */
+    void setPendingOpaqueRect(const SkRect& rect, const SkPaint* paint, const SkBitmap* bitmap);
+    bool isOpaquePaint(const SkPaint* paint, const SkBitmap* bitmap) const;
+    // Whether fPendingOpaqueBounds can be trusted to cover what the clip lets through
+    bool canComputeOpaqueBounds() const;
+    void pushClipState(SaveFlags flags);
+
+    bool fCullOccludedDraws;
+    bool fUsePathBoundsForClip;
+
+    // Set by the draw calls above for handleBBox() to pick up
+    SkIRect fPendingOpaqueBounds;
+    bool fPendingDrawIsCullable;
+
+    // Whether the recording canvas' clip is a superset of the one that will be played back,
+    // which is the case after clipPath() or clipRRect() with kUsePathBoundsForClip_RecordingFlag
+    bool fClipIsApproximate;
+    struct ClipState {
+        bool fIsApproximate;    // fClipIsApproximate when the save was made
+        bool fRestoresClip;     // whether the save's flags include kClip_SaveFlag
+    };
+    SkTDArray<ClipState> fClipStateStack;
+
     typedef SkBBoxRecord INHERITED;
 };
 
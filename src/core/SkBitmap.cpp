@@ -13,6 +13,7 @@
 #include "SkFlattenable.h"
 #include "SkMallocPixelRef.h"
 #include "SkMask.h"
+#include "SkMipMap_opts.h"
 #include "SkOrderedReadBuffer.h"
 #include "SkOrderedWriteBuffer.h"
 #include "SkPixelRef.h"
@@ -1167,32 +1168,25 @@ bool SkBitmap::deepCopyTo(SkBitmap* dst, Config dstConfig) const {
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
-static void downsampleby2_proc32(SkBitmap* dst, int x, int y,
-                                 const SkBitmap& src) {
-    x <<= 1;
-    y <<= 1;
-    const SkPMColor* p = src.getAddr32(x, y);
-    const SkPMColor* baseP = p;
-    SkPMColor c, ag, rb;
+static void downsample_row32_portable(SkPMColor dst[], const SkPMColor row0[],
+                                      const SkPMColor row1[], int count) {
+    for (int i = 0; i < count; i++) {
+        SkPMColor c, ag, rb;
 
-    c = *p; ag = (c >> 8) & 0xFF00FF; rb = c & 0xFF00FF;
-    if (x < src.width() - 1) {
-        p += 1;
-    }
-    c = *p; ag += (c >> 8) & 0xFF00FF; rb += c & 0xFF00FF;
+        c = row0[0]; ag = (c >> 8) & 0xFF00FF; rb = c & 0xFF00FF;
+        c = row0[1]; ag += (c >> 8) & 0xFF00FF; rb += c & 0xFF00FF;
+        c = row1[0]; ag += (c >> 8) & 0xFF00FF; rb += c & 0xFF00FF;
+        c = row1[1]; ag += (c >> 8) & 0xFF00FF; rb += c & 0xFF00FF;
 
-    p = baseP;
-    if (y < src.height() - 1) {
-        p += src.rowBytes() >> 2;
+        dst[i] = ((rb >> 2) & 0xFF00FF) | ((ag << 6) & 0xFF00FF00);
+        row0 += 2;
+        row1 += 2;
     }
-    c = *p; ag += (c >> 8) & 0xFF00FF; rb += c & 0xFF00FF;
-    if (x < src.width() - 1) {
-        p += 1;
-    }
-    c = *p; ag += (c >> 8) & 0xFF00FF; rb += c & 0xFF00FF;
+}
 
-    *dst->getAddr32(x >> 1, y >> 1) =
-        ((rb >> 2) & 0xFF00FF) | ((ag << 6) & 0xFF00FF00);
+SkDownsampleRow32Proc SkGetDownsampleRow32Proc() {
+    SkDownsampleRow32Proc proc = SkPlatformDownsampleRow32Proc();
+    return proc ? proc : downsample_row32_portable;
 }
 
 static inline uint32_t expand16(U16CPU c) {
@@ -1281,7 +1275,7 @@ void SkBitmap::buildMipMap(bool forceRebuild) {
 
     switch (config) {
         case kARGB_8888_Config:
-            proc = downsampleby2_proc32;
+            proc = NULL;    // whole rows are averaged by SkDownsampleRow32Proc
             break;
         case kRGB_565_Config:
             proc = downsampleby2_proc16;
@@ -1354,9 +1348,19 @@ void SkBitmap::buildMipMap(bool forceRebuild) {
         dstBM.setPixels(addr);
 
         srcBM.lockPixels();
-        for (int y = 0; y < height; y++) {
-            for (int x = 0; x < width; x++) {
-                proc(&dstBM, x, y, srcBM);
+        if (NULL == proc) {
+            // Each level is half the size of the one before (rounded down),
+            // so whole rows can be averaged without clamping at the edges.
+            SkDownsampleRow32Proc rowProc = SkGetDownsampleRow32Proc();
+            for (int y = 0; y < height; y++) {
+                rowProc(dstBM.getAddr32(0, y), srcBM.getAddr32(0, y << 1),
+                        srcBM.getAddr32(0, (y << 1) + 1), width);
+            }
+        } else {
+            for (int y = 0; y < height; y++) {
+                for (int x = 0; x < width; x++) {
+                    proc(&dstBM, x, y, srcBM);
+                }
             }
         }
         srcBM.unlockPixels();
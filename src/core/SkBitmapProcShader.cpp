@@ -142,6 +142,9 @@ bool SkBitmapProcShader::setContext(const SkBitmap& device,
 
 void SkBitmapProcShader::endContext() {
     fState.fOrigBitmap.unlockPixels();
+    // let go of any cached mip level, so the cache can free it
+    fState.fMipBitmap.reset();
+    fState.fScaledBitmap.reset();
     this->INHERITED::endContext();
 }
 
@@ -6,8 +6,10 @@
  * found in the LICENSE file.
  */
 #include "SkBitmapProcState.h"
+#include "SkBitmapScaler.h"
 #include "SkColorPriv.h"
 #include "SkFilterProc.h"
+#include "SkMipMapCache.h"
 #include "SkPaint.h"
 #include "SkShader.h"   // for tilemodes
 #include "SkUtilsArm.h"
@@ -90,6 +92,41 @@ static bool valid_for_filtering(unsigned dimension) {
     return (dimension & ~0x3FFF) == 0;
 }
 
+// Don't let a large scale allocate (and fill) an arbitrarily large bitmap.
+static const int64_t kMaxResampledPixels = 2048 * 2048;
+
+/**
+ *  If the scale/translate inverse matrix draws bitmap at some size other than
+ *  its own, resample it to that size into dst and return true. The resampled
+ *  bitmap is shared through SkMipMapCache when the bitmap can be cached, so
+ *  drawing it at the same size again does not resample it again.
+ */
+static bool resample_bitmap(const SkBitmap& bitmap, const SkMatrix& inv,
+                            SkBitmap* dst) {
+    if (SkBitmap::kARGB_8888_Config != bitmap.config() ||
+        bitmap.getTexture() || !matrix_only_scale_translate(inv)) {
+        return false;
+    }
+
+    const SkScalar sx = SkScalarAbs(inv.getScaleX());
+    const SkScalar sy = SkScalarAbs(inv.getScaleY());
+    if (0 == sx || 0 == sy) {
+        return false;
+    }
+    const int width = SkScalarRoundToInt(SkScalarDiv(SkIntToScalar(bitmap.width()), sx));
+    const int height = SkScalarRoundToInt(SkScalarDiv(SkIntToScalar(bitmap.height()), sy));
+    if (width <= 0 || height <= 0 ||
+        (width == bitmap.width() && height == bitmap.height()) ||
+        static_cast<int64_t>(width) * height > kMaxResampledPixels) {
+        return false;
+    }
+    if (SkMipMapCache::ExtractResampled(bitmap, width, height, dst)) {
+        return true;
+    }
+    return SkBitmapScaler::Resize(dst, bitmap, width, height,
+                                  SkBitmapScaler::kMitchell_ResizeMethod);
+}
+
 bool SkBitmapProcState::chooseProcs(const SkMatrix& inv, const SkPaint& paint) {
     if (fOrigBitmap.width() == 0 || fOrigBitmap.height() == 0) {
         return false;
@@ -109,23 +146,41 @@ bool SkBitmapProcState::chooseProcs(const SkMatrix& inv, const SkPaint& paint) {
     }
 
     fBitmap = &fOrigBitmap;
-    if (fOrigBitmap.hasMipMap()) {
-        int shift = fOrigBitmap.extractMipLevel(&fMipBitmap,
-                                                SkScalarToFixed(m->getScaleX()),
-                                                SkScalarToFixed(m->getSkewY()));
-
-        if (shift > 0) {
-            if (m != &fUnitInvMatrix) {
-                fUnitInvMatrix = *m;
-                m = &fUnitInvMatrix;
-            }
+    int shift = 0;
+    if (paint.isFilterBitmap() && paint.isHighQualityFilterBitmap() &&
+        clamp_clamp && resample_bitmap(fOrigBitmap, *m, &fScaledBitmap)) {
+        // fScaledBitmap is already the size we draw at, so map onto it
+        // instead, which leaves (nearly) no scale to filter
+        fUnitInvMatrix = *m;
+        m = &fUnitInvMatrix;
+        fUnitInvMatrix.postScale(
+                SkScalarDiv(SkIntToScalar(fScaledBitmap.width()),
+                            SkIntToScalar(fOrigBitmap.width())),
+                SkScalarDiv(SkIntToScalar(fScaledBitmap.height()),
+                            SkIntToScalar(fOrigBitmap.height())));
+        fBitmap = &fScaledBitmap;
+    } else if (fOrigBitmap.hasMipMap()) {
+        shift = fOrigBitmap.extractMipLevel(&fMipBitmap,
+                                            SkScalarToFixed(m->getScaleX()),
+                                            SkScalarToFixed(m->getSkewY()));
+    } else if (paint.isFilterBitmap() && paint.isMipMapBitmap()) {
+        // build (or reuse) shared levels for bitmaps that have none of their own
+        shift = SkMipMapCache::ExtractMipLevel(fOrigBitmap,
+                                               SkScalarToFixed(m->getScaleX()),
+                                               SkScalarToFixed(m->getSkewY()),
+                                               &fMipBitmap);
+    }
+    if (shift > 0) {
+        if (m != &fUnitInvMatrix) {
+            fUnitInvMatrix = *m;
+            m = &fUnitInvMatrix;
+        }
 
-            SkScalar scale = SkFixedToScalar(SK_Fixed1 >> shift);
-            fUnitInvMatrix.postScale(scale, scale);
+        SkScalar scale = SkFixedToScalar(SK_Fixed1 >> shift);
+        fUnitInvMatrix.postScale(scale, scale);
 
-            // now point here instead of fOrigBitmap
-            fBitmap = &fMipBitmap;
-        }
+        // now point here instead of fOrigBitmap
+        fBitmap = &fMipBitmap;
     }
 
     // wack our matrix to exactly no-scale, if we're really close to begin with
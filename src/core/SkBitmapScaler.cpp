@@ -0,0 +1,86 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkBitmapScaler.h"
+#include "SkConvolver.h"
+#include "SkFloatingPoint.h"
+#include "SkTemplates.h"
+
+static const float kPI = 3.14159265f;
+
+// Mitchell-Netravali with B = C = 1/3, which is nonzero on (-2, 2).
+static float mitchell(float x) {
+    x = sk_float_abs(x);
+    if (x < 1) {
+        return ((7.0f * x - 12.0f) * x * x + 16.0f / 3.0f) / 6.0f;
+    }
+    if (x < 2) {
+        return (((-7.0f / 3.0f * x + 12.0f) * x - 20.0f) * x + 32.0f / 3.0f) / 6.0f;
+    }
+    return 0;
+}
+
+// sinc(x) * sinc(x / 3), which is nonzero on (-3, 3).
+static float lanczos3(float x) {
+    if (x <= -3 || x >= 3) {
+        return 0;
+    }
+    if (sk_float_abs(x) < 1e-6f) {
+        return 1;
+    }
+    const float px = x * kPI;
+    return 3 * sk_float_sin(px) * sk_float_sin(px / 3) / (px * px);
+}
+
+static void compute_filters(int srcLength, int destLength, SkBitmapScaler::ResizeMethod method,
+                            SkConvolutionFilter1D* filter) {
+    float (*kernel)(float) = mitchell;
+    float radius = 2;
+    if (SkBitmapScaler::kLanczos3_ResizeMethod == method) {
+        kernel = lanczos3;
+        radius = 3;
+    }
+
+    // When shrinking, stretch the kernel so that it covers every source pixel that lands in a
+    // destination pixel, which keeps the result from aliasing.
+    const float scale = static_cast<float>(destLength) / srcLength;
+    const float filterScale = scale < 1 ? scale : 1;
+    const float support = radius / filterScale;
+
+    SkAutoSTMalloc<32, float> weights(2 * sk_float_ceil2int(support) + 1);
+    for (int i = 0; i < destLength; i++) {
+        // The destination pixel center, in source pixel coordinates.
+        const float center = (i + 0.5f) / scale - 0.5f;
+        const int first = sk_float_ceil2int(center - support);
+        const int last = sk_float_floor2int(center + support);
+        const int length = last - first + 1;
+
+        float sum = 0;
+        for (int j = 0; j < length; j++) {
+            weights[j] = kernel((first + j - center) * filterScale);
+            sum += weights[j];
+        }
+        if (sum != 0) {
+            for (int j = 0; j < length; j++) {
+                weights[j] /= sum;
+            }
+        }
+        filter->addFilter(first, weights.get(), length, srcLength);
+    }
+}
+
+bool SkBitmapScaler::Resize(SkBitmap* result, const SkBitmap& src, int destWidth, int destHeight,
+                            ResizeMethod method) {
+    if (destWidth <= 0 || destHeight <= 0 || src.width() <= 0 || src.height() <= 0) {
+        return false;
+    }
+
+    SkConvolutionFilter1D xFilter, yFilter;
+    compute_filters(src.width(), destWidth, method, &xFilter);
+    compute_filters(src.height(), destHeight, method, &yFilter);
+    return SkConvolve2D(src, xFilter, yFilter, result);
+}
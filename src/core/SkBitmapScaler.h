@@ -0,0 +1,34 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkBitmapScaler_DEFINED
+#define SkBitmapScaler_DEFINED
+
+#include "SkBitmap.h"
+
+/**
+ *  Resamples 8888 bitmaps to a new size with a separable filter, in two passes. The weight
+ *  tables for each axis are computed once per call, from the ratio of the sizes.
+ */
+class SkBitmapScaler {
+public:
+    enum ResizeMethod {
+        kMitchell_ResizeMethod,     //!< cubic, B = C = 1/3
+        kLanczos3_ResizeMethod,     //!< windowed sinc with 3 lobes, sharper but rings more
+    };
+
+    /**
+     *  Allocates result as an 8888 bitmap of destWidth by destHeight pixels and fills it with
+     *  src resampled to that size. When shrinking, the filter is widened to cover the source
+     *  pixels that map to each result pixel. Returns false if src is not 8888, has no pixels,
+     *  or either size is not positive.
+     */
+    static bool Resize(SkBitmap* result, const SkBitmap& src, int destWidth, int destHeight,
+                       ResizeMethod method);
+};
+
+#endif
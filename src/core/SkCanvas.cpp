@@ -1581,12 +1581,21 @@ void SkCanvas::drawRRect(const SkRRect& rrect, const SkPaint& paint) {
     if (rrect.isRect()) {
         // call the non-virtual version
         this->SkCanvas::drawRect(rrect.getBounds(), paint);
-    } else {
-        SkPath  path;
-        path.addRRect(rrect);
-        // call the non-virtual version
-        this->SkCanvas::drawPath(path, paint);
+        return;
+    }
+    if (rrect.isEmpty() || !rrect.getBounds().isFinite()) {
+        return;
     }
+
+    // Draw filters saw rrects as paths before devices could draw them, so
+    // keep telling them that.
+    LOOPER_BEGIN(paint, SkDrawFilter::kPath_Type)
+
+    while (iter.next()) {
+        iter.fDevice->drawRRect(iter, rrect, looper.paint());
+    }
+
+    LOOPER_END
 }
 
 
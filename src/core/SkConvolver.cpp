@@ -0,0 +1,170 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkConvolver.h"
+#include "SkColorPriv.h"
+#include "SkTemplates.h"
+
+void SkConvolutionFilter1D::addFilter(int offset, const float weights[], int length,
+                                      int srcLength) {
+    SkASSERT(length > 0 && srcLength > 0);
+
+    // Fold the taps that hang off either edge into the edge pixels.
+    const int first = SkPin32(offset, 0, srcLength - 1);
+    const int last = SkPin32(offset + length - 1, 0, srcLength - 1);
+    const int count = last - first + 1;
+    SkAutoSTMalloc<32, float> folded(count);
+    sk_bzero(folded.get(), count * sizeof(float));
+    float sum = 0;
+    for (int i = 0; i < length; i++) {
+        folded[SkPin32(offset + i, 0, srcLength - 1) - first] += weights[i];
+        sum += weights[i];
+    }
+
+    SkAutoSTMalloc<32, Fixed> fixed(count);
+    int fixedSum = 0;
+    int largest = 0;
+    for (int i = 0; i < count; i++) {
+        fixed[i] = FloatToFixed(folded[i]);
+        fixedSum += fixed[i];
+        if (SkAbs32(fixed[i]) > SkAbs32(fixed[largest])) {
+            largest = i;
+        }
+    }
+    fixed[largest] += FloatToFixed(sum) - fixedSum;
+
+    // Trim taps that have rounded to nothing.
+    int start = 0;
+    int stop = count;
+    while (start < stop - 1 && 0 == fixed[start]) {
+        start++;
+    }
+    while (stop > start + 1 && 0 == fixed[stop - 1]) {
+        stop--;
+    }
+
+    Instance* instance = fFilters.append();
+    instance->fWeightIndex = fWeights.count();
+    instance->fOffset = first + start;
+    instance->fLength = stop - start;
+    fWeights.append(stop - start, fixed.get() + start);
+    fMaxFilter = SkMax32(fMaxFilter, stop - start);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static inline unsigned round_and_clamp(int accum) {
+    accum = (accum + (1 << (SkConvolutionFilter1D::kShiftBits - 1))) >>
+            SkConvolutionFilter1D::kShiftBits;
+    return SkClampMax(SkMax32(accum, 0), 255);
+}
+
+static void convolve_horizontally_portable(const SkPMColor src[],
+                                           const SkConvolutionFilter1D& filter,
+                                           SkPMColor dst[]) {
+    for (int i = 0; i < filter.numValues(); i++) {
+        int offset, length;
+        const SkConvolutionFilter1D::Fixed* weights = filter.filterForValue(i, &offset, &length);
+        const SkPMColor* row = src + offset;
+
+        int accum[4] = { 0, 0, 0, 0 };
+        for (int j = 0; j < length; j++) {
+            const int w = weights[j];
+            const SkPMColor c = row[j];
+            accum[0] += w * (int)((c >>  0) & 0xFF);
+            accum[1] += w * (int)((c >>  8) & 0xFF);
+            accum[2] += w * (int)((c >> 16) & 0xFF);
+            accum[3] += w * (int)((c >> 24) & 0xFF);
+        }
+        dst[i] = (round_and_clamp(accum[0]) <<  0) | (round_and_clamp(accum[1]) <<  8) |
+                 (round_and_clamp(accum[2]) << 16) | (round_and_clamp(accum[3]) << 24);
+    }
+}
+
+static void convolve_vertically_portable(const SkConvolutionFilter1D::Fixed filter[], int length,
+                                         const SkPMColor* const rows[], int width,
+                                         SkPMColor dst[]) {
+    for (int x = 0; x < width; x++) {
+        int accum[4] = { 0, 0, 0, 0 };
+        for (int j = 0; j < length; j++) {
+            const int w = filter[j];
+            const SkPMColor c = rows[j][x];
+            accum[0] += w * (int)((c >>  0) & 0xFF);
+            accum[1] += w * (int)((c >>  8) & 0xFF);
+            accum[2] += w * (int)((c >> 16) & 0xFF);
+            accum[3] += w * (int)((c >> 24) & 0xFF);
+        }
+        const SkPMColor c = (round_and_clamp(accum[0]) <<  0) |
+                            (round_and_clamp(accum[1]) <<  8) |
+                            (round_and_clamp(accum[2]) << 16) |
+                            (round_and_clamp(accum[3]) << 24);
+
+        // Negative lobes can leave a color above its alpha.
+        const unsigned a = SkGetPackedA32(c);
+        dst[x] = SkPackARGB32(a, SkMin32(SkGetPackedR32(c), a),
+                              SkMin32(SkGetPackedG32(c), a),
+                              SkMin32(SkGetPackedB32(c), a));
+    }
+}
+
+bool SkConvolve2D(const SkBitmap& src, const SkConvolutionFilter1D& xFilter,
+                  const SkConvolutionFilter1D& yFilter, SkBitmap* dst) {
+    if (SkBitmap::kARGB_8888_Config != src.config() ||
+        0 == xFilter.numValues() || 0 == yFilter.numValues()) {
+        return false;
+    }
+
+    SkAutoLockPixels alp(src);
+    if (!src.readyToDraw()) {
+        return false;
+    }
+
+    const int width = xFilter.numValues();
+    const int height = yFilter.numValues();
+    dst->setConfig(SkBitmap::kARGB_8888_Config, width, height);
+    if (!dst->allocPixels()) {
+        return false;
+    }
+
+    SkConvolveHorizontallyProc convolveHorizontally = SkPlatformConvolveHorizontallyProc();
+    if (NULL == convolveHorizontally) {
+        convolveHorizontally = convolve_horizontally_portable;
+    }
+    SkConvolveVerticallyProc convolveVertically = SkPlatformConvolveVerticallyProc();
+    if (NULL == convolveVertically) {
+        convolveVertically = convolve_vertically_portable;
+    }
+
+    // Only the rows some output row reads from need filtering horizontally.
+    int firstRow = src.height();
+    int lastRow = -1;
+    for (int y = 0; y < height; y++) {
+        int offset, length;
+        yFilter.filterForValue(y, &offset, &length);
+        firstRow = SkMin32(firstRow, offset);
+        lastRow = SkMax32(lastRow, offset + length - 1);
+    }
+    SkASSERT(firstRow >= 0 && lastRow < src.height());
+
+    SkAutoTMalloc<SkPMColor> temp(width * (lastRow - firstRow + 1));
+    for (int y = firstRow; y <= lastRow; y++) {
+        convolveHorizontally(src.getAddr32(0, y), xFilter, temp.get() + (y - firstRow) * width);
+    }
+
+    SkAutoSTMalloc<32, const SkPMColor*> rows(yFilter.maxFilter());
+    for (int y = 0; y < height; y++) {
+        int offset, length;
+        const SkConvolutionFilter1D::Fixed* weights = yFilter.filterForValue(y, &offset, &length);
+        for (int j = 0; j < length; j++) {
+            rows[j] = temp.get() + (offset + j - firstRow) * width;
+        }
+        convolveVertically(weights, length, rows.get(), width, dst->getAddr32(0, y));
+    }
+
+    dst->setIsOpaque(src.isOpaque());
+    return true;
+}
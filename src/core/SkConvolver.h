@@ -0,0 +1,102 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkConvolver_DEFINED
+#define SkConvolver_DEFINED
+
+#include "SkBitmap.h"
+#include "SkTDArray.h"
+
+/**
+ *  For each output pixel along one axis, the run of input pixels that contribute to it and their
+ *  weights. Weights are stored in 2.14 fixed point.
+ */
+class SkConvolutionFilter1D {
+public:
+    typedef int16_t Fixed;
+
+    enum {
+        kShiftBits = 14,
+    };
+
+    SkConvolutionFilter1D() : fMaxFilter(0) {}
+
+    static Fixed FloatToFixed(float f) {
+        return static_cast<Fixed>(f * (1 << kShiftBits) + (f < 0 ? -0.5f : 0.5f));
+    }
+
+    /**
+     *  Appends the filter for the next output pixel: weights[i] applies to input pixel
+     *  offset + i. Taps that fall outside [0, srcLength) are folded into the nearest edge pixel,
+     *  so the input is clamped rather than read out of bounds. After rounding to fixed point the
+     *  largest tap is adjusted so the weights still sum to what they did as floats.
+     */
+    void addFilter(int offset, const float weights[], int length, int srcLength);
+
+    /** Returns the number of output pixels. */
+    int numValues() const { return fFilters.count(); }
+
+    /** Returns the length of the longest filter. */
+    int maxFilter() const { return fMaxFilter; }
+
+    /**
+     *  Returns the weights for output pixel 'value', and the first input pixel and number of
+     *  input pixels they apply to.
+     */
+    const Fixed* filterForValue(int value, int* offset, int* length) const {
+        const Instance& filter = fFilters[value];
+        *offset = filter.fOffset;
+        *length = filter.fLength;
+        return &fWeights[filter.fWeightIndex];
+    }
+
+private:
+    struct Instance {
+        int fWeightIndex;
+        int fOffset;
+        int fLength;
+    };
+
+    SkTDArray<Instance> fFilters;
+    SkTDArray<Fixed>    fWeights;
+    int                 fMaxFilter;
+};
+
+/**
+ *  Convolves one row of src with each of filter's filters, writing filter.numValues() pixels to
+ *  dst. Each channel is rounded and clamped to [0, 255].
+ */
+typedef void (*SkConvolveHorizontallyProc)(const SkPMColor src[],
+                                           const SkConvolutionFilter1D& filter,
+                                           SkPMColor dst[]);
+
+/**
+ *  Convolves 'length' rows of width pixels with the weights in filter, writing one row to dst.
+ *  Each channel is rounded and clamped to [0, 255], and the color channels are then clamped to
+ *  alpha so the result is a valid premultiplied color.
+ */
+typedef void (*SkConvolveVerticallyProc)(const SkConvolutionFilter1D::Fixed filter[], int length,
+                                         const SkPMColor* const rows[], int width,
+                                         SkPMColor dst[]);
+
+/**
+ *  Return the platform's convolve procs, or NULL if it has none. Implemented in src/opts for
+ *  each platform. They must match the portable procs bit for bit.
+ */
+SkConvolveHorizontallyProc SkPlatformConvolveHorizontallyProc();
+SkConvolveVerticallyProc SkPlatformConvolveVerticallyProc();
+
+/**
+ *  Resamples the 8888 bitmap src into dst, which is allocated as an 8888 bitmap of
+ *  xFilter.numValues() by yFilter.numValues() pixels. Each row of src is filtered with xFilter,
+ *  and then each column of that with yFilter. Returns false if src is not 8888, has no pixels,
+ *  or dst could not be allocated.
+ */
+bool SkConvolve2D(const SkBitmap& src, const SkConvolutionFilter1D& xFilter,
+                  const SkConvolutionFilter1D& yFilter, SkBitmap* dst);
+
+#endif
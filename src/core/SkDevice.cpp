@@ -12,6 +12,7 @@
 #include "SkMetaData.h"
 #include "SkRasterClip.h"
 #include "SkRect.h"
+#include "SkRRect.h"
 #include "SkShader.h"
 
 SK_DEFINE_INST_COUNT(SkDevice)
@@ -360,6 +361,14 @@ void SkDevice::drawRect(const SkDraw& draw, const SkRect& r, const SkPaint& pain
 void SkDevice::drawOval(const SkDraw& draw, const SkRect& oval, const SkPaint& paint) {
     CHECK_FOR_NODRAW_ANNOTATION(paint);
 
+    if (paint.getMaskFilter()) {
+        // drawRRect can blur the oval without rasterizing it as a path first.
+        SkRRect rrect;
+        rrect.setOval(oval);
+        this->drawRRect(draw, rrect, paint);
+        return;
+    }
+
     SkPath path;
     path.addOval(oval);
     // call the VIRTUAL version, so any subclasses who do handle drawPath aren't
@@ -367,6 +376,20 @@ void SkDevice::drawOval(const SkDraw& draw, const SkRect& oval, const SkPaint& p
     this->drawPath(draw, path, paint, NULL, true);
 }
 
+void SkDevice::drawRRect(const SkDraw& draw, const SkRRect& rrect, const SkPaint& paint) {
+    CHECK_FOR_NODRAW_ANNOTATION(paint);
+
+    if (draw.drawRRectWithMaskFilter(rrect, paint)) {
+        return;
+    }
+
+    SkPath path;
+    path.addRRect(rrect);
+    // call the VIRTUAL version, so any subclasses who do handle drawPath aren't
+    // required to override drawRRect.
+    this->drawPath(draw, path, paint, NULL, true);
+}
+
 void SkDevice::drawPath(const SkDraw& draw, const SkPath& path,
                         const SkPaint& paint, const SkMatrix* prePathMatrix,
                         bool pathIsMutable) {
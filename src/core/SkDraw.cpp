@@ -13,11 +13,13 @@
 #include "SkColorPriv.h"
 #include "SkDevice.h"
 #include "SkFixed.h"
+#include "SkMaskCache.h"
 #include "SkMaskFilter.h"
 #include "SkPaint.h"
 #include "SkPathEffect.h"
 #include "SkRasterClip.h"
 #include "SkRasterizer.h"
+#include "SkRRect.h"
 #include "SkScan.h"
 #include "SkShader.h"
 #include "SkString.h"
@@ -35,34 +37,68 @@
 
 #define kBlitterStorageLongCount    (sizeof(SkBitmapProcShader) >> 2)
 
+/** Restricts a blitter to SkDraw::fBand. Unlike a plain SkRectClipBlitter it
+    never hands out the device, since callers that write to the device
+    directly would not respect the band.
+ */
+class SkBandBlitter : public SkRectClipBlitter {
+public:
+    SkBandBlitter() : fReal(NULL) {}
+
+    void init(SkBlitter* blitter, const SkIRect& band) {
+        INHERITED::init(blitter, band);
+        fReal = blitter;
+    }
+
+    virtual const SkBitmap* justAnOpaqueColor(uint32_t*) SK_OVERRIDE {
+        return NULL;
+    }
+    virtual bool isNullBlitter() const SK_OVERRIDE {
+        return fReal->isNullBlitter();
+    }
+
+private:
+    SkBlitter*  fReal;
+
+    typedef SkRectClipBlitter INHERITED;
+};
+
 /** Helper for allocating small blitters on the stack.
  */
 class SkAutoBlitterChoose : SkNoncopyable {
 public:
     SkAutoBlitterChoose() {
         fBlitter = NULL;
+        fResult = NULL;
     }
-    SkAutoBlitterChoose(const SkBitmap& device, const SkMatrix& matrix,
+    SkAutoBlitterChoose(const SkDraw& draw, const SkMatrix& matrix,
                         const SkPaint& paint) {
-        fBlitter = SkBlitter::Choose(device, matrix, paint,
-                                     fStorage, sizeof(fStorage));
+        fBlitter = NULL;
+        this->choose(draw, matrix, paint);
     }
 
     ~SkAutoBlitterChoose();
 
-    SkBlitter*  operator->() { return fBlitter; }
-    SkBlitter*  get() const { return fBlitter; }
+    SkBlitter*  operator->() { return fResult; }
+    SkBlitter*  get() const { return fResult; }
 
-    void choose(const SkBitmap& device, const SkMatrix& matrix,
+    void choose(const SkDraw& draw, const SkMatrix& matrix,
                 const SkPaint& paint) {
         SkASSERT(!fBlitter);
-        fBlitter = SkBlitter::Choose(device, matrix, paint,
+        fBlitter = SkBlitter::Choose(*draw.fBitmap, matrix, paint,
                                      fStorage, sizeof(fStorage));
+        fResult = fBlitter;
+        if (draw.fBand) {
+            fBandBlitter.init(fBlitter, *draw.fBand);
+            fResult = &fBandBlitter;
+        }
     }
 
 private:
-    SkBlitter*  fBlitter;
-    uint32_t    fStorage[kBlitterStorageLongCount];
+    SkBlitter*      fBlitter;
+    SkBlitter*      fResult;    // fBlitter, or fBandBlitter wrapping it
+    SkBandBlitter   fBandBlitter;
+    uint32_t        fStorage[kBlitterStorageLongCount];
 };
 
 SkAutoBlitterChoose::~SkAutoBlitterChoose() {
@@ -296,7 +332,10 @@ void SkDraw::drawPaint(const SkPaint& paint) const {
 
             SkRegion::Iterator iter(fRC->bwRgn());
             while (!iter.done()) {
-                CallBitmapXferProc(*fBitmap, iter.rect(), proc, procData);
+                SkIRect r = iter.rect();
+                if (NULL == fBand || r.intersect(*fBand)) {
+                    CallBitmapXferProc(*fBitmap, r, proc, procData);
+                }
                 iter.next();
             }
             return;
@@ -304,7 +343,7 @@ void SkDraw::drawPaint(const SkPaint& paint) const {
     }
 
     // normal case: use a blitter
-    SkAutoBlitterChoose blitter(*fBitmap, *fMatrix, paint);
+    SkAutoBlitterChoose blitter(*this, *fMatrix, paint);
     SkScan::FillIRect(devRect, *fRC, blitter.get());
 }
 
@@ -606,7 +645,7 @@ void SkDraw::drawPoints(SkCanvas::PointMode mode, size_t count,
 
     PtProcRec rec;
     if (!forceUseDevice && rec.init(mode, paint, fMatrix, fRC)) {
-        SkAutoBlitterChoose blitter(*fBitmap, *fMatrix, paint);
+        SkAutoBlitterChoose blitter(*this, *fMatrix, paint);
 
         SkPoint             devPts[MAX_DEV_PTS];
         const SkMatrix*     matrix = fMatrix;
@@ -875,7 +914,7 @@ void SkDraw::drawRect(const SkRect& rect, const SkPaint& paint) const {
             return;
     }
 
-    SkAutoBlitterChoose blitterStorage(*fBitmap, matrix, paint);
+    SkAutoBlitterChoose blitterStorage(*this, matrix, paint);
     const SkRasterClip& clip = *fRC;
     SkBlitter*          blitter = blitterStorage.get();
 
@@ -909,6 +948,73 @@ void SkDraw::drawRect(const SkRect& rect, const SkPaint& paint) const {
     }
 }
 
+// Maps rrect through a scale+translate matrix, swapping the corners' radii
+// if the matrix flips it.
+static void map_rrect(const SkMatrix& matrix, const SkRRect& src, SkRRect* dst) {
+    SkASSERT(!(matrix.getType() & ~(SkMatrix::kScale_Mask | SkMatrix::kTranslate_Mask)));
+
+    SkRect rect;
+    matrix.mapRect(&rect, src.getBounds());
+
+    const SkScalar sx = SkScalarAbs(matrix.getScaleX());
+    const SkScalar sy = SkScalarAbs(matrix.getScaleY());
+    const bool flipX = matrix.getScaleX() < 0;
+    const bool flipY = matrix.getScaleY() < 0;
+
+    // The corners are in UL, UR, LR, LL order.
+    static const int kFlipX[] = { 1, 0, 3, 2 };
+    static const int kFlipY[] = { 3, 2, 1, 0 };
+    SkVector radii[4];
+    for (int i = 0; i < 4; ++i) {
+        int corner = i;
+        if (flipX) {
+            corner = kFlipX[corner];
+        }
+        if (flipY) {
+            corner = kFlipY[corner];
+        }
+        const SkVector& r = src.radii((SkRRect::Corner)corner);
+        radii[i].set(SkScalarMul(r.fX, sx), SkScalarMul(r.fY, sy));
+    }
+    dst->setRectRadii(rect, radii);
+}
+
+bool SkDraw::drawRRectWithMaskFilter(const SkRRect& rrect, const SkPaint& paint) const {
+    SkDEBUGCODE(this->validate();)
+
+    // nothing to draw
+    if (fRC->isEmpty()) {
+        return true;
+    }
+
+    // A blurred rrect can be drawn by stretching a blurred copy of its corners,
+    // as long as nothing else changes its shape or coverage first.
+    if (paint.getMaskFilter() && SkPaint::kFill_Style == paint.getStyle() &&
+            NULL == paint.getPathEffect() && NULL == paint.getRasterizer() &&
+            !(fMatrix->getType() & ~(SkMatrix::kScale_Mask | SkMatrix::kTranslate_Mask))) {
+        SkRRect devRRect;
+        map_rrect(*fMatrix, rrect, &devRRect);
+        if (!devRRect.isEmpty()) {
+            SkAutoBlitterChoose blitter(*this, *fMatrix, paint);
+            if (paint.getMaskFilter()->filterRRect(devRRect, *fMatrix, *fRC,
+                                                   fBounder, blitter.get())) {
+                return true; // filterRRect() called the blitter, so we're done
+            }
+        }
+    }
+    return false;
+}
+
+void SkDraw::drawRRect(const SkRRect& rrect, const SkPaint& paint) const {
+    if (this->drawRRectWithMaskFilter(rrect, paint)) {
+        return;
+    }
+
+    SkPath path;
+    path.addRRect(rrect);
+    this->drawPath(path, paint, NULL, true);
+}
+
 void SkDraw::drawDevMask(const SkMask& srcM, const SkPaint& paint) const {
     if (srcM.fBounds.isEmpty()) {
         return;
@@ -929,7 +1035,7 @@ void SkDraw::drawDevMask(const SkMask& srcM, const SkPaint& paint) const {
         return;
     }
 
-    SkAutoBlitterChoose blitterChooser(*fBitmap, *fMatrix, paint);
+    SkAutoBlitterChoose blitterChooser(*this, *fMatrix, paint);
     SkBlitter* blitter = blitterChooser.get();
 
     SkAAClipBlitterWrapper wrapper;
@@ -1005,6 +1111,181 @@ bool SkDrawTreatAsHairline(const SkPaint& paint, const SkMatrix& matrix,
     return false;
 }
 
+/**
+ *  Fills in the mask cache key for drawing 'path' with 'paint' through 'matrix'. Returns false
+ *  if the draw cannot use the cache: it must be antialiased or blurred, and not otherwise
+ *  depend on anything the key leaves out.
+ */
+static bool compute_mask_cache_key(const SkPath& path, const SkMatrix& matrix,
+                                   const SkPaint& paint, SkMaskCache::Key* key) {
+    if (0 == SkMaskCache::GetLimit() || matrix.hasPerspective() || path.isInverseFillType() ||
+        paint.getPathEffect() || paint.getRasterizer()) {
+        return false;
+    }
+
+    SkMaskFilter::BlurInfo info;
+    SkMaskFilter::BlurType blurType = SkMaskFilter::kNone_BlurType;
+    if (paint.getMaskFilter()) {
+        blurType = paint.getMaskFilter()->asABlur(&info);
+        if (SkMaskFilter::kNone_BlurType == blurType) {
+            return false;
+        }
+        // Blurred rects are stretched from a nine-patch, which beats caching them
+        if (SkPaint::kFill_Style == paint.getStyle() &&
+            (path.isRect(NULL) || path.isNestedRects(NULL))) {
+            return false;
+        }
+    } else if (!paint.isAntiAlias()) {
+        return false;
+    }
+
+    sk_bzero(key, sizeof(*key));
+    key->fPathGenID = path.getGenerationID();
+    key->fScaleX = matrix.getScaleX();
+    key->fSkewX = matrix.getSkewX();
+    key->fSkewY = matrix.getSkewY();
+    key->fScaleY = matrix.getScaleY();
+    key->fSubpixelX = matrix.getTranslateX() - SkScalarFloorToScalar(matrix.getTranslateX());
+    key->fSubpixelY = matrix.getTranslateY() - SkScalarFloorToScalar(matrix.getTranslateY());
+    key->fStyle = paint.getStyle();
+    if (SkPaint::kFill_Style != paint.getStyle()) {
+        key->fStrokeWidth = paint.getStrokeWidth();
+        key->fMiterLimit = paint.getStrokeMiter();
+        key->fStyle |= (paint.getStrokeCap() << 8) | (paint.getStrokeJoin() << 16);
+    }
+    if (SkMaskFilter::kNone_BlurType != blurType) {
+        key->fBlurRadius = info.fRadius;
+        key->fBlurFlags = blurType | (info.fIgnoreTransform << 8) | (info.fHighQuality << 9);
+    }
+    return true;
+}
+
+/**
+ *  Draws all of 'devPath' into a mask, blurs it if there is a mask filter, and adds the mask
+ *  to the cache. Returns the entry holding the mask, or NULL if the path was too big for the
+ *  cache or the filter failed.
+ */
+static SkMaskCache::Entry* create_cached_mask(const SkMaskCache::Key& key,
+                                              const SkPath& devPath, const SkMatrix& matrix,
+                                              const SkMaskFilter* filter,
+                                              SkPaint::Style style) {
+    SkMask srcM;
+    if (!SkDraw::DrawToMask(devPath, NULL, filter, &matrix, &srcM,
+                            SkMask::kJustComputeBounds_CreateMode, style)) {
+        return NULL;
+    }
+    srcM.fFormat = SkMask::kA8_Format;
+    srcM.fRowBytes = srcM.fBounds.width();
+    // Check before drawing, since unlike an uncached draw this ignores the clip
+    const size_t size = srcM.computeImageSize();
+    if (!SkMaskCache::CanCache(size)) {
+        return NULL;
+    }
+    srcM.fImage = SkMask::AllocImage(size);
+    memset(srcM.fImage, 0, size);
+    SkDraw::DrawToMask(devPath, NULL, filter, &matrix, &srcM,
+                       SkMask::kJustRenderImage_CreateMode, style);
+
+    SkMask dstM = srcM;
+    if (filter) {
+        SkAutoMaskFreeImage autoSrc(srcM.fImage);
+        if (!filter->filterMask(&dstM, srcM, matrix, NULL)) {
+            return NULL;
+        }
+    }
+    dstM.fBounds.offset(-SkScalarFloorToInt(matrix.getTranslateX()),
+                        -SkScalarFloorToInt(matrix.getTranslateY()));
+    return SkMaskCache::Add(key, dstM);
+}
+
+/**
+ *  Returns the cached mask for drawing 'path' with 'paint' through 'matrix', first drawing and
+ *  adding it if it is not cached, or NULL if it cannot be cached.
+ */
+static SkMaskCache::Entry* find_or_create_cached_mask(const SkMaskCache::Key& key,
+                                                      const SkPath& path, const SkMatrix& matrix,
+                                                      const SkPaint& paint) {
+    SkMaskCache::Entry* entry = SkMaskCache::Find(key);
+    if (entry) {
+        return entry;
+    }
+
+    // The key rules out path effects, so stroking needs no cull rect
+    SkPath fillPath;
+    const SkPath* srcPath = &path;
+    bool doFill = true;
+    if (SkPaint::kFill_Style != paint.getStyle()) {
+        doFill = paint.getFillPath(path, &fillPath);
+        srcPath = &fillPath;
+    }
+    SkPath devPath;
+    srcPath->transform(matrix, &devPath);
+    return create_cached_mask(key, devPath, matrix, paint.getMaskFilter(),
+                              doFill ? SkPaint::kFill_Style : SkPaint::kStroke_Style);
+}
+
+static void blit_cached_mask(const SkMask& cachedMask, const SkMatrix& matrix,
+                             const SkRasterClip& clip, SkBlitter* blitter) {
+    SkMask mask = cachedMask;
+    mask.fBounds.offset(SkScalarFloorToInt(matrix.getTranslateX()),
+                        SkScalarFloorToInt(matrix.getTranslateY()));
+
+    SkAAClipBlitterWrapper wrapper(clip, blitter);
+    blitter = wrapper.getBlitter();
+    SkRegion::Cliperator clipper(wrapper.getRgn(), mask.fBounds);
+    while (!clipper.done()) {
+        blitter->blitMask(mask, clipper.rect());
+        clipper.next();
+    }
+}
+
+// Draws strokes that are thinner than a pixel as hairlines, with their coverage taken as alpha
+static void apply_hairline_coverage(const SkMatrix& matrix, SkTCopyOnFirstWrite<SkPaint>* paint) {
+    const SkPaint& origPaint = **paint;
+    SkScalar coverage;
+    if (SkDrawTreatAsHairline(origPaint, matrix, &coverage)) {
+        if (SK_Scalar1 == coverage) {
+            paint->writable()->setStrokeWidth(0);
+        } else if (xfermodeSupportsCoverageAsAlpha(origPaint.getXfermode())) {
+            U8CPU newAlpha;
+#if 0
+            newAlpha = SkToU8(SkScalarRoundToInt(coverage *
+                                                 origPaint.getAlpha()));
+#else
+            // this is the old technique, which we preserve for now so
+            // we don't change previous results (testing)
+            // the new way seems fine, its just (a tiny bit) different
+            int scale = (int)SkScalarMul(coverage, 256);
+            newAlpha = origPaint.getAlpha() * scale >> 8;
+#endif
+            SkPaint* writablePaint = paint->writable();
+            writablePaint->setStrokeWidth(0);
+            writablePaint->setAlpha(newAlpha);
+        }
+    }
+}
+
+const SkMask* SkDraw::findOrCreatePathMask(const SkPath& path, const SkPaint& origPaint,
+                                           SkRefCnt** owner) const {
+    *owner = NULL;
+    if (fRC->isEmpty()) {
+        return NULL;
+    }
+    SkTCopyOnFirstWrite<SkPaint> paint(origPaint);
+    apply_hairline_coverage(*fMatrix, &paint);
+
+    SkMaskCache::Key key;
+    if (NULL == fDevice || fBounder || !compute_mask_cache_key(path, *fMatrix, *paint, &key)) {
+        return NULL;
+    }
+    SkMaskCache::Entry* entry = find_or_create_cached_mask(key, path, *fMatrix, *paint);
+    if (NULL == entry) {
+        return NULL;
+    }
+    *owner = entry;
+    return &entry->mask();
+}
+
 void SkDraw::drawPath(const SkPath& origSrcPath, const SkPaint& origPaint,
                       const SkMatrix* prePathMatrix, bool pathIsMutable) const {
     SkDEBUGCODE(this->validate();)
@@ -1043,28 +1324,28 @@ void SkDraw::drawPath(const SkPath& origSrcPath, const SkPaint& origPaint,
     SkDEBUGCODE(prePathMatrix = (const SkMatrix*)0x50FF8001;)
 
     SkTCopyOnFirstWrite<SkPaint> paint(origPaint);
+    apply_hairline_coverage(*matrix, &paint);
 
-    {
-        SkScalar coverage;
-        if (SkDrawTreatAsHairline(origPaint, *matrix, &coverage)) {
-            if (SK_Scalar1 == coverage) {
-                paint.writable()->setStrokeWidth(0);
-            } else if (xfermodeSupportsCoverageAsAlpha(origPaint.getXfermode())) {
-                U8CPU newAlpha;
-#if 0
-                newAlpha = SkToU8(SkScalarRoundToInt(coverage *
-                                                     origPaint.getAlpha()));
-#else
-                // this is the old technique, which we preserve for now so
-                // we don't change previous results (testing)
-                // the new way seems fine, its just (a tiny bit) different
-                int scale = (int)SkScalarMul(coverage, 256);
-                newAlpha = origPaint.getAlpha() * scale >> 8;
-#endif
-                SkPaint* writablePaint = paint.writable();
-                writablePaint->setStrokeWidth(0);
-                writablePaint->setAlpha(newAlpha);
-            }
+    if (fPathMask) {
+        SkASSERT(pathPtr == &origSrcPath && matrix == fMatrix);
+        SkAutoBlitterChoose blitter(*this, *fMatrix, *paint);
+        blit_cached_mask(*fPathMask, *matrix, *fRC, blitter.get());
+        return;
+    }
+
+    // Only draws made by a device go through the mask cache, not the ones that render masks.
+    // They must also keep the original path and matrix, so that the key can identify them.
+    // The bands of a split draw leave the cache to the thread that split it (see fPathMask).
+    SkMaskCache::Key maskKey;
+    if (fDevice && NULL == fBounder && NULL == fBand &&
+        pathPtr == &origSrcPath && matrix == fMatrix &&
+        compute_mask_cache_key(*pathPtr, *matrix, *paint, &maskKey)) {
+        SkAutoTUnref<SkMaskCache::Entry> entry(find_or_create_cached_mask(maskKey, *pathPtr,
+                                                                          *matrix, *paint));
+        if (entry.get()) {
+            SkAutoBlitterChoose blitter(*this, *fMatrix, *paint);
+            blit_cached_mask(entry->mask(), *matrix, *fRC, blitter.get());
+            return;
         }
     }
 
@@ -1095,7 +1376,7 @@ void SkDraw::drawPath(const SkPath& origSrcPath, const SkPaint& origPaint,
     // transform the path into device space
     pathPtr->transform(*matrix, devPathPtr);
 
-    SkAutoBlitterChoose blitter(*fBitmap, *fMatrix, *paint);
+    SkAutoBlitterChoose blitter(*this, *fMatrix, *paint);
 
     if (paint->getMaskFilter()) {
         SkPaint::Style style = doFill ? SkPaint::kFill_Style :
@@ -1302,7 +1583,9 @@ void SkDraw::drawBitmap(const SkBitmap& bitmap, const SkMatrix& prematrix,
                 SkIRect    ir;
                 ir.set(ix, iy, ix + bitmap.width(), iy + bitmap.height());
 
-                SkScan::FillIRect(ir, *fRC, blitter);
+                if (NULL == fBand || ir.intersect(*fBand)) {
+                    SkScan::FillIRect(ir, *fRC, blitter);
+                }
                 return;
             }
         }
@@ -1359,7 +1642,9 @@ void SkDraw::drawSprite(const SkBitmap& bitmap, int x, int y,
                 return;
             }
 
-            SkScan::FillIRect(bounds, *fRC, blitter);
+            if (NULL == fBand || bounds.intersect(*fBand)) {
+                SkScan::FillIRect(bounds, *fRC, blitter);
+            }
             return;
         }
     }
@@ -1694,7 +1979,7 @@ void SkDraw::drawText(const char text[], size_t byteLength,
     SkAutoBlitterChoose blitterChooser;
     SkBlitter*          blitter = NULL;
     if (needsRasterTextBlit(*this)) {
-        blitterChooser.choose(*fBitmap, *fMatrix, paint);
+        blitterChooser.choose(*this, *fMatrix, paint);
         blitter = blitterChooser.get();
         if (fRC->isAA()) {
             aaBlitter.init(blitter, &fRC->aaRgn());
@@ -1855,7 +2140,7 @@ void SkDraw::drawPosText(const char text[], size_t byteLength,
     SkAutoBlitterChoose blitterChooser;
     SkBlitter* blitter = NULL;
     if (needsRasterTextBlit(*this)) {
-        blitterChooser.choose(*fBitmap, *fMatrix, paint);
+        blitterChooser.choose(*this, *fMatrix, paint);
         blitter = blitterChooser.get();
         if (fRC->isAA()) {
             wrapper.init(*fRC, blitter);
@@ -2477,7 +2762,7 @@ void SkDraw::drawVertices(SkCanvas::VertexMode vmode, int count,
         }
     }
 
-    SkAutoBlitterChoose blitter(*fBitmap, *fMatrix, p);
+    SkAutoBlitterChoose blitter(*this, *fMatrix, p);
     // important that we abort early, as below we may manipulate the shader
     // and that is only valid if the shader returned true from setContext.
     // If it returned false, then our blitter will be the NullBlitter.
@@ -17,6 +17,17 @@ bool SkFlate::Deflate(SkStream*, SkWStream*) { return false; }
 bool SkFlate::Deflate(const void*, size_t, SkWStream*) { return false; }
 bool SkFlate::Deflate(const SkData*, SkWStream*) { return false; }
 bool SkFlate::Inflate(SkStream*, SkWStream*) { return false; }
+
+SkDeflateWStream::SkDeflateWStream(SkWStream*) : fImpl(NULL), fBytesWritten(0) {}
+SkDeflateWStream::~SkDeflateWStream() {}
+bool SkDeflateWStream::finalize() { return false; }
+bool SkDeflateWStream::write(const void*, size_t) { return false; }
+
+SkInflateStream::SkInflateStream(SkStream* src) : fSrc(SkRef(src)), fImpl(NULL) {}
+SkInflateStream::~SkInflateStream() { fSrc->unref(); }
+bool SkInflateStream::isValid() const { return false; }
+bool SkInflateStream::rewind() { return false; }
+size_t SkInflateStream::read(void*, size_t) { return 0; }
 #else
 
 // static
@@ -137,4 +148,197 @@ bool SkFlate::Inflate(SkStream* src, SkWStream* dst) {
     return doFlate(false, src, dst);
 }
 
+///////////////////////////////////////////////////////////////////////////////
+
+// The largest block of compressed data written by SkDeflateWStream, and so
+// the most that SkInflateStream buffers.
+static const size_t kBlockSize = 16 * 1024;
+
+struct SkDeflateWStream::Impl {
+    SkWStream*  fDst;
+    z_stream    fZStream;
+    bool        fInitialized;
+    bool        fOK;
+    bool        fFinished;
+    uint8_t     fBlock[kBlockSize];
+
+    // Writes out what has been compressed into fBlock, if anything, as one block.
+    bool writeBlock() {
+        size_t length = kBlockSize - fZStream.avail_out;
+        if (0 == length) {
+            return true;
+        }
+        fZStream.next_out = fBlock;
+        fZStream.avail_out = kBlockSize;
+        return fDst->write32(length) && fDst->write(fBlock, length);
+    }
+};
+
+SkDeflateWStream::SkDeflateWStream(SkWStream* dst)
+    : fImpl(SkNEW(Impl))
+    , fBytesWritten(0) {
+    fImpl->fDst = dst;
+    fImpl->fZStream.zalloc = NULL;
+    fImpl->fZStream.zfree = NULL;
+    fImpl->fZStream.opaque = NULL;
+    fImpl->fZStream.next_in = NULL;
+    fImpl->fZStream.avail_in = 0;
+    fImpl->fZStream.next_out = fImpl->fBlock;
+    fImpl->fZStream.avail_out = kBlockSize;
+    fImpl->fInitialized = Z_OK == deflateInit(&fImpl->fZStream, Z_DEFAULT_COMPRESSION);
+    fImpl->fOK = fImpl->fInitialized;
+    fImpl->fFinished = false;
+}
+
+SkDeflateWStream::~SkDeflateWStream() {
+    this->finalize();
+    if (fImpl->fInitialized) {
+        deflateEnd(&fImpl->fZStream);
+    }
+    SkDELETE(fImpl);
+}
+
+bool SkDeflateWStream::write(const void* buffer, size_t size) {
+    if (!fImpl->fOK || fImpl->fFinished) {
+        return false;
+    }
+    z_stream& zStream = fImpl->fZStream;
+    zStream.next_in = (Bytef*)buffer;
+    zStream.avail_in = size;
+    while (fImpl->fOK && zStream.avail_in > 0) {
+        if (Z_OK != deflate(&zStream, Z_NO_FLUSH)) {
+            fImpl->fOK = false;
+        } else if (0 == zStream.avail_out) {
+            fImpl->fOK = fImpl->writeBlock();
+        }
+    }
+    fBytesWritten += size;
+    return fImpl->fOK;
+}
+
+bool SkDeflateWStream::finalize() {
+    if (fImpl->fFinished) {
+        return fImpl->fOK;
+    }
+    fImpl->fFinished = true;
+    if (!fImpl->fOK) {
+        return false;
+    }
+
+    int rc;
+    do {
+        rc = deflate(&fImpl->fZStream, Z_FINISH);
+        if ((Z_OK != rc && Z_STREAM_END != rc) || !fImpl->writeBlock()) {
+            fImpl->fOK = false;
+            return false;
+        }
+    } while (Z_STREAM_END != rc);
+
+    // the zero length that ends the blocks
+    fImpl->fOK = fImpl->fDst->write32(0);
+    return fImpl->fOK;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+struct SkInflateStream::Impl {
+    z_stream    fZStream;
+    bool        fInitialized;
+    bool        fValid;
+    bool        fEnded;     // all of the compressed data has been read, or it was corrupt
+    uint8_t     fBlock[kBlockSize];
+
+    void init() {
+        fZStream.zalloc = NULL;
+        fZStream.zfree = NULL;
+        fZStream.opaque = NULL;
+        fZStream.next_in = fBlock;
+        fZStream.avail_in = 0;
+        fInitialized = Z_OK == inflateInit(&fZStream);
+        fValid = fInitialized;
+        fEnded = !fInitialized;
+    }
+};
+
+SkInflateStream::SkInflateStream(SkStream* src)
+    : fSrc(SkRef(src))
+    , fImpl(SkNEW(Impl)) {
+    fImpl->init();
+}
+
+SkInflateStream::~SkInflateStream() {
+    if (fImpl->fInitialized) {
+        inflateEnd(&fImpl->fZStream);
+    }
+    SkDELETE(fImpl);
+    fSrc->unref();
+}
+
+bool SkInflateStream::isValid() const {
+    return fImpl->fValid;
+}
+
+bool SkInflateStream::rewind() {
+    if (!fSrc->rewind()) {
+        return false;
+    }
+    if (fImpl->fInitialized) {
+        inflateEnd(&fImpl->fZStream);
+    }
+    fImpl->init();
+    return fImpl->fValid;
+}
+
+size_t SkInflateStream::read(void* buffer, size_t size) {
+    if (NULL == buffer) {
+        if (0 == size) {
+            // the length is not known until all of it has been inflated
+            return 0;
+        }
+        uint8_t scratch[1024];
+        size_t skipped = 0;
+        while (skipped < size) {
+            size_t bytes = this->read(scratch, SkTMin(size - skipped, sizeof(scratch)));
+            if (0 == bytes) {
+                break;
+            }
+            skipped += bytes;
+        }
+        return skipped;
+    }
+
+    z_stream& zStream = fImpl->fZStream;
+    zStream.next_out = (Bytef*)buffer;
+    zStream.avail_out = size;
+    while (zStream.avail_out > 0 && !fImpl->fEnded) {
+        if (0 == zStream.avail_in) {
+            uint32_t length;
+            if (sizeof(length) != fSrc->read(&length, sizeof(length)) ||
+                0 == length || length > kBlockSize ||
+                length != fSrc->read(fImpl->fBlock, length)) {
+                fImpl->fValid = false;
+                fImpl->fEnded = true;
+                break;
+            }
+            zStream.next_in = fImpl->fBlock;
+            zStream.avail_in = length;
+        }
+
+        int rc = inflate(&zStream, Z_NO_FLUSH);
+        if (Z_STREAM_END == rc) {
+            // Read the zero length that ends the blocks, so that src is left just past them.
+            uint32_t length;
+            if (zStream.avail_in > 0 ||
+                sizeof(length) != fSrc->read(&length, sizeof(length)) || 0 != length) {
+                fImpl->fValid = false;
+            }
+            fImpl->fEnded = true;
+        } else if (Z_OK != rc) {
+            fImpl->fValid = false;
+            fImpl->fEnded = true;
+        }
+    }
+    return size - zStream.avail_out;
+}
+
 #endif
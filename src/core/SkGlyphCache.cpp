@@ -16,7 +16,6 @@
 #include "SkTypeface.h"
 
 //#define SPEW_PURGE_STATUS
-//#define USE_CACHE_HASH
 //#define RECORD_HASH_EFFICIENCY
 
 bool gSkSuppressFontCachePurgeSpew;
@@ -378,27 +377,15 @@ void SkGlyphCache::invokeAndRemoveAuxProcs() {
     #define SK_DEFAULT_FONT_CACHE_LIMIT     (2 * 1024 * 1024)
 #endif
 
-#ifdef USE_CACHE_HASH
-    #define HASH_BITCOUNT   6
-    #define HASH_COUNT      (1 << HASH_BITCOUNT)
-    #define HASH_MASK       (HASH_COUNT - 1)
-
-    static unsigned desc_to_hashindex(const SkDescriptor* desc)
-    {
-        SkASSERT(HASH_MASK < 256);  // since our munging reduces to 8 bits
-
-        uint32_t n = *(const uint32_t*)desc;    //desc->getChecksum();
-        SkASSERT(n == desc->getChecksum());
-
-        // don't trust that the low bits of checksum vary enough, so...
-        n ^= (n >> 24) ^ (n >> 16) ^ (n >> 8) ^ (n >> 30);
-
-        return n & HASH_MASK;
-    }
-#endif
-
 #include "SkThread.h"
 
+/*  The strikes are partitioned into shards by the checksum of their
+    descriptor. Each shard has its own mutex and its own LRU list, so threads
+    looking up unrelated strikes never contend on the same lock. The memory
+    budget is split evenly between the shards: when a shard goes over its
+    slice, it gives up its own least recently used strikes, so attaching a
+    strike only ever takes that strike's shard mutex.
+*/
 class SkGlyphCache_Globals {
 public:
     enum UseMutex {
@@ -406,45 +393,77 @@ public:
         kYes_UseMutex  // shared cache
     };
 
+    enum {
+        kShardBits  = 3,
+        kShardCount = 1 << kShardBits,
+        kShardMask  = kShardCount - 1
+    };
+
+    struct Shard {
+        SkMutex*        fMutex;
+        SkGlyphCache*   fHead;
+        size_t          fMemoryUsed;
+    };
+
     SkGlyphCache_Globals(UseMutex um) {
-        fHead = NULL;
-        fTotalMemoryUsed = 0;
+        for (int i = 0; i < kShardCount; ++i) {
+            fShards[i].fMutex = (kYes_UseMutex == um) ? SkNEW(SkMutex) : NULL;
+            fShards[i].fHead = NULL;
+            fShards[i].fMemoryUsed = 0;
+        }
         fFontCacheLimit = SK_DEFAULT_FONT_CACHE_LIMIT;
-        fMutex = (kYes_UseMutex == um) ? SkNEW(SkMutex) : NULL;
-
-#ifdef USE_CACHE_HASH
-        sk_bzero(fHash, sizeof(fHash));
-#endif
     }
 
     ~SkGlyphCache_Globals() {
-        SkGlyphCache* cache = fHead;
-        while (cache) {
-            SkGlyphCache* next = cache->fNext;
-            SkDELETE(cache);
-            cache = next;
+        for (int i = 0; i < kShardCount; ++i) {
+            SkGlyphCache* cache = fShards[i].fHead;
+            while (cache) {
+                SkGlyphCache* next = cache->fNext;
+                SkDELETE(cache);
+                cache = next;
+            }
+            SkDELETE(fShards[i].fMutex);
         }
+    }
 
-        SkDELETE(fMutex);
+    Shard& shardFor(const SkDescriptor* desc) {
+        uint32_t n = desc->getChecksum();
+        // don't trust that the low bits of checksum vary enough, so...
+        n ^= (n >> 24) ^ (n >> 16) ^ (n >> 8);
+        return fShards[n & kShardMask];
     }
 
-    SkMutex*        fMutex;
-    SkGlyphCache*   fHead;
-    size_t          fTotalMemoryUsed;
-#ifdef USE_CACHE_HASH
-    SkGlyphCache*   fHash[HASH_COUNT];
-#endif
+    Shard& shard(int index) {
+        SkASSERT((unsigned)index < kShardCount);
+        return fShards[index];
+    }
 
-#ifdef SK_DEBUG
-    void validate() const;
-#else
-    void validate() const {}
-#endif
+    /** Sums the shards' memory, taking each one's mutex in turn. The caller
+        must not hold any shard's mutex.
+    */
+    size_t totalMemoryUsed() const;
 
     size_t  getFontCacheLimit() const { return fFontCacheLimit; }
     size_t  setFontCacheLimit(size_t limit);
     void    purgeAll(); // does not change budget
 
+    // Each shard's slice of the budget
+    size_t  getShardLimit() const { return fFontCacheLimit >> kShardBits; }
+
+    /** Free at least bytesNeeded from the shard. This relies on the caller to
+        have already acquired the shard's mutex.
+    */
+    size_t  purgeShard(Shard*, size_t bytesNeeded);
+
+    // This relies on the caller to have already acquired the shard's mutex
+    size_t  internalFreeShard(Shard*, size_t bytesNeeded, int* count);
+
+#ifdef SK_DEBUG
+    void validate(const Shard&) const;
+#else
+    void validate(const Shard&) const {}
+#endif
+
     // can return NULL
     static SkGlyphCache_Globals* FindTLS() {
         return (SkGlyphCache_Globals*)SkTLS::Find(CreateTLS);
@@ -457,6 +476,7 @@ public:
     static void DeleteTLS() { SkTLS::Delete(CreateTLS); }
 
 private:
+    Shard   fShards[kShardCount];
     size_t  fFontCacheLimit;
 
     static void* CreateTLS() {
@@ -468,6 +488,15 @@ private:
     }
 };
 
+size_t SkGlyphCache_Globals::totalMemoryUsed() const {
+    size_t total = 0;
+    for (int i = 0; i < kShardCount; ++i) {
+        SkAutoMutexAcquire ac(fShards[i].fMutex);
+        total += fShards[i].fMemoryUsed;
+    }
+    return total;
+}
+
 size_t SkGlyphCache_Globals::setFontCacheLimit(size_t newLimit) {
     static const size_t minLimit = 256 * 1024;
     if (newLimit < minLimit) {
@@ -477,17 +506,44 @@ size_t SkGlyphCache_Globals::setFontCacheLimit(size_t newLimit) {
     size_t prevLimit = fFontCacheLimit;
     fFontCacheLimit = newLimit;
 
-    size_t currUsed = fTotalMemoryUsed;
-    if (currUsed > newLimit) {
-        SkAutoMutexAcquire    ac(fMutex);
-        SkGlyphCache::InternalFreeCache(this, currUsed - newLimit);
+    const size_t shardLimit = this->getShardLimit();
+    for (int i = 0; i < kShardCount; ++i) {
+        Shard& shard = fShards[i];
+        SkAutoMutexAcquire ac(shard.fMutex);
+        if (shard.fMemoryUsed > shardLimit) {
+            (void)this->purgeShard(&shard, shard.fMemoryUsed - shardLimit);
+        }
     }
     return prevLimit;
 }
 
 void SkGlyphCache_Globals::purgeAll() {
-    SkAutoMutexAcquire    ac(fMutex);
-    SkGlyphCache::InternalFreeCache(this, fTotalMemoryUsed);
+    for (int i = 0; i < kShardCount; ++i) {
+        Shard& shard = fShards[i];
+        SkAutoMutexAcquire ac(shard.fMutex);
+        int count;
+        (void)this->internalFreeShard(&shard, shard.fMemoryUsed, &count);
+    }
+}
+
+size_t SkGlyphCache_Globals::purgeShard(Shard* shard, size_t bytesNeeded) {
+    // don't do any "small" purges
+    size_t minToPurge = shard->fMemoryUsed >> 2;
+    if (bytesNeeded < minToPurge) {
+        bytesNeeded = minToPurge;
+    }
+
+    int count;
+    size_t bytesFreed = this->internalFreeShard(shard, bytesNeeded, &count);
+
+#ifdef SPEW_PURGE_STATUS
+    if (count && !gSkSuppressFontCachePurgeSpew) {
+        SkDebugf("purging %dK from font cache [%d entries]\n",
+                 (int)(bytesFreed >> 10), count);
+    }
+#endif
+
+    return bytesFreed;
 }
 
 // Returns the shared globals
@@ -507,18 +563,21 @@ static SkGlyphCache_Globals& getGlobals() {
 void SkGlyphCache::VisitAllCaches(bool (*proc)(SkGlyphCache*, void*),
                                   void* context) {
     SkGlyphCache_Globals& globals = getGlobals();
-    SkAutoMutexAcquire    ac(globals.fMutex);
-    SkGlyphCache*         cache;
 
-    globals.validate();
+    for (int i = 0; i < SkGlyphCache_Globals::kShardCount; ++i) {
+        SkGlyphCache_Globals::Shard& shard = globals.shard(i);
+        SkAutoMutexAcquire ac(shard.fMutex);
 
-    for (cache = globals.fHead; cache != NULL; cache = cache->fNext) {
-        if (proc(cache, context)) {
-            break;
+        globals.validate(shard);
+
+        for (SkGlyphCache* cache = shard.fHead; cache; cache = cache->fNext) {
+            if (proc(cache, context)) {
+                return;
+            }
         }
-    }
 
-    globals.validate();
+        globals.validate(shard);
+    }
 }
 
 /*  This guy calls the visitor from within the mutext lock, so the visitor
@@ -537,25 +596,18 @@ SkGlyphCache* SkGlyphCache::VisitCache(SkTypeface* typeface,
     SkASSERT(desc);
 
     SkGlyphCache_Globals& globals = getGlobals();
-    SkAutoMutexAcquire    ac(globals.fMutex);
+    SkGlyphCache_Globals::Shard& shard = globals.shardFor(desc);
+    SkAutoMutexAcquire    ac(shard.fMutex);
     SkGlyphCache*         cache;
     bool                  insideMutex = true;
 
-    globals.validate();
-
-#ifdef USE_CACHE_HASH
-    SkGlyphCache** hash = globals.fHash;
-    unsigned index = desc_to_hashindex(desc);
-    cache = hash[index];
-    if (cache && *cache->fDesc == *desc) {
-        cache->detach(&globals.fHead);
-        goto FOUND_IT;
-    }
-#endif
+    globals.validate(shard);
 
-    for (cache = globals.fHead; cache != NULL; cache = cache->fNext) {
-        if (cache->fDesc->equals(*desc)) {
-            cache->detach(&globals.fHead);
+    const uint32_t checksum = desc->getChecksum();
+    for (cache = shard.fHead; cache != NULL; cache = cache->fNext) {
+        if (cache->fDesc->getChecksum() == checksum &&
+            cache->fDesc->equals(*desc)) {
+            cache->detach(&shard.fHead);
             goto FOUND_IT;
         }
     }
@@ -574,18 +626,12 @@ FOUND_IT:
 
     if (proc(cache, context)) {   // stay detached
         if (insideMutex) {
-            SkASSERT(globals.fTotalMemoryUsed >= cache->fMemoryUsed);
-            globals.fTotalMemoryUsed -= cache->fMemoryUsed;
-#ifdef USE_CACHE_HASH
-            hash[index] = NULL;
-#endif
+            SkASSERT(shard.fMemoryUsed >= cache->fMemoryUsed);
+            shard.fMemoryUsed -= cache->fMemoryUsed;
         }
     } else {                        // reattach
         if (insideMutex) {
-            cache->attachToHead(&globals.fHead);
-#ifdef USE_CACHE_HASH
-            hash[index] = cache;
-#endif
+            cache->attachToHead(&shard.fHead);
         } else {
             AttachCache(cache);
         }
@@ -598,31 +644,27 @@ void SkGlyphCache::AttachCache(SkGlyphCache* cache) {
     SkASSERT(cache);
     SkASSERT(cache->fNext == NULL);
 
+    cache->validate();
+
     SkGlyphCache_Globals& globals = getGlobals();
-    SkAutoMutexAcquire    ac(globals.fMutex);
+    SkGlyphCache_Globals::Shard& shard = globals.shardFor(cache->fDesc);
+    SkAutoMutexAcquire ac(shard.fMutex);
 
-    globals.validate();
-    cache->validate();
+    globals.validate(shard);
 
     // if we have a fixed budget for our cache, do a purge here
     {
-        size_t allocated = globals.fTotalMemoryUsed + cache->fMemoryUsed;
-        size_t budgeted = globals.getFontCacheLimit();
+        size_t allocated = shard.fMemoryUsed + cache->fMemoryUsed;
+        size_t budgeted = globals.getShardLimit();
         if (allocated > budgeted) {
-            (void)InternalFreeCache(&globals, allocated - budgeted);
+            (void)globals.purgeShard(&shard, allocated - budgeted);
         }
     }
 
-    cache->attachToHead(&globals.fHead);
-    globals.fTotalMemoryUsed += cache->fMemoryUsed;
+    cache->attachToHead(&shard.fHead);
+    shard.fMemoryUsed += cache->fMemoryUsed;
 
-#ifdef USE_CACHE_HASH
-    unsigned index = desc_to_hashindex(cache->fDesc);
-    SkASSERT(globals.fHash[index] != cache);
-    globals.fHash[index] = cache;
-#endif
-
-    globals.validate();
+    globals.validate(shard);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -637,63 +679,46 @@ SkGlyphCache* SkGlyphCache::FindTail(SkGlyphCache* cache) {
 }
 
 #ifdef SK_DEBUG
-void SkGlyphCache_Globals::validate() const {
+void SkGlyphCache_Globals::validate(const Shard& shard) const {
     size_t computed = 0;
 
-    const SkGlyphCache* head = fHead;
+    const SkGlyphCache* head = shard.fHead;
     while (head != NULL) {
         computed += head->fMemoryUsed;
         head = head->fNext;
     }
 
-    if (fTotalMemoryUsed != computed) {
-        printf("total %d, computed %d\n", (int)fTotalMemoryUsed, (int)computed);
+    if (shard.fMemoryUsed != computed) {
+        printf("total %d, computed %d\n", (int)shard.fMemoryUsed, (int)computed);
     }
-    SkASSERT(fTotalMemoryUsed == computed);
+    SkASSERT(shard.fMemoryUsed == computed);
 }
 #endif
 
-size_t SkGlyphCache::InternalFreeCache(SkGlyphCache_Globals* globals,
-                                       size_t bytesNeeded) {
-    globals->validate();
+size_t SkGlyphCache_Globals::internalFreeShard(Shard* shard,
+                                               size_t bytesNeeded,
+                                               int* countPtr) {
+    this->validate(*shard);
 
     size_t  bytesFreed = 0;
     int     count = 0;
 
-    // don't do any "small" purges
-    size_t minToPurge = globals->fTotalMemoryUsed >> 2;
-    if (bytesNeeded < minToPurge)
-        bytesNeeded = minToPurge;
-
-    SkGlyphCache* cache = FindTail(globals->fHead);
+    SkGlyphCache* cache = SkGlyphCache::FindTail(shard->fHead);
     while (cache != NULL && bytesFreed < bytesNeeded) {
         SkGlyphCache* prev = cache->fPrev;
         bytesFreed += cache->fMemoryUsed;
 
-#ifdef USE_CACHE_HASH
-        unsigned index = desc_to_hashindex(cache->fDesc);
-        if (cache == globals->fHash[index]) {
-            globals->fHash[index] = NULL;
-        }
-#endif
-
-        cache->detach(&globals->fHead);
+        cache->detach(&shard->fHead);
         SkDELETE(cache);
         cache = prev;
         count += 1;
     }
 
-    SkASSERT(bytesFreed <= globals->fTotalMemoryUsed);
-    globals->fTotalMemoryUsed -= bytesFreed;
-    globals->validate();
-
-#ifdef SPEW_PURGE_STATUS
-    if (count && !gSkSuppressFontCachePurgeSpew) {
-        SkDebugf("purging %dK from font cache [%d entries]\n",
-                 (int)(bytesFreed >> 10), count);
-    }
-#endif
+    SkASSERT(bytesFreed <= shard->fMemoryUsed);
+    shard->fMemoryUsed -= bytesFreed;
+    this->validate(*shard);
 
+    *countPtr = count;
     return bytesFreed;
 }
 
@@ -729,7 +754,7 @@ size_t SkGraphics::SetFontCacheLimit(size_t bytes) {
 }
 
 size_t SkGraphics::GetFontCacheUsed() {
-    return getSharedGlobals().fTotalMemoryUsed;
+    return getSharedGlobals().totalMemoryUsed();
 }
 
 void SkGraphics::PurgeFontCache() {
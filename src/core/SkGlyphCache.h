@@ -31,8 +31,10 @@ class SkGlyphCache_Globals;
     either instantly if it is already cahced, or by first generating it and then
     adding it to the strike.
 
-    The strikes are held in a global list, available to all threads. To interact
-    with one, call either VisitCache() or DetachCache().
+    The strikes are held in a global cache, available to all threads. The cache
+    is split into shards by descriptor, so threads working with different
+    strikes do not contend for the same lock. To interact with one, call either
+    VisitCache() or DetachCache().
 */
 class SkGlyphCache {
 public:
@@ -263,9 +265,6 @@ private:
     AuxProcRec* fAuxProcList;
     void invokeAndRemoveAuxProcs();
 
-    // This relies on the caller to have already acquired the mutex to access the global cache
-    static size_t InternalFreeCache(SkGlyphCache_Globals*, size_t bytesNeeded);
-
     inline static SkGlyphCache* FindTail(SkGlyphCache* head);
 
     friend class SkGlyphCache_Globals;
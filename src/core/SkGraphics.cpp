@@ -128,6 +128,8 @@ void SkGraphics::Init() {
 
 void SkGraphics::Term() {
     PurgeFontCache();
+    PurgeMaskCache();
+    PurgeMipMapCache();
     SkPaint::Term();
 }
 
@@ -135,13 +137,19 @@ void SkGraphics::Term() {
 
 static const char kFontCacheLimitStr[] = "font-cache-limit";
 static const size_t kFontCacheLimitLen = sizeof(kFontCacheLimitStr) - 1;
+static const char kMaskCacheLimitStr[] = "mask-cache-limit";
+static const size_t kMaskCacheLimitLen = sizeof(kMaskCacheLimitStr) - 1;
+static const char kMipMapCacheLimitStr[] = "mipmap-cache-limit";
+static const size_t kMipMapCacheLimitLen = sizeof(kMipMapCacheLimitStr) - 1;
 
 static const struct {
     const char* fStr;
     size_t fLen;
     size_t (*fFunc)(size_t);
 } gFlags[] = {
-    { kFontCacheLimitStr, kFontCacheLimitLen, SkGraphics::SetFontCacheLimit }
+    { kFontCacheLimitStr, kFontCacheLimitLen, SkGraphics::SetFontCacheLimit },
+    { kMaskCacheLimitStr, kMaskCacheLimitLen, SkGraphics::SetMaskCacheLimit },
+    { kMipMapCacheLimitStr, kMipMapCacheLimitLen, SkGraphics::SetMipMapCacheLimit }
 };
 
 /* flags are of the form param; or param=value; */
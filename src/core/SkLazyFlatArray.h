@@ -0,0 +1,211 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkLazyFlatArray_DEFINED
+#define SkLazyFlatArray_DEFINED
+
+#include "SkChunkAlloc.h"
+#include "SkData.h"
+#include "SkOrderedReadBuffer.h"
+#include "SkPictureFlat.h"
+#include "SkRefCnt.h"
+#include "SkTDArray.h"
+#include "SkTRefArray.h"
+#include "SkThread.h"
+#include <new>
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+/**
+ * sk_release_store() publishes a pointer so that a thread that reads it with
+ * sk_acquire_load() also sees everything written before it was stored. On x86
+ * the hardware keeps loads and stores in order and only the compiler needs
+ * stopping; elsewhere a full barrier is used.
+ */
+#if defined(_MSC_VER)
+    #define SK_LAZY_FLAT_BARRIER()  _ReadWriteBarrier()
+#elif defined(__i386__) || defined(__x86_64__)
+    #define SK_LAZY_FLAT_BARRIER()  __asm__ __volatile__("" : : : "memory")
+#else
+    #define SK_LAZY_FLAT_BARRIER()  __sync_synchronize()
+#endif
+
+template <typename T> static inline T* sk_acquire_load(T* const* addr) {
+    T* value = *(T* const volatile*)addr;
+    SK_LAZY_FLAT_BARRIER();
+    return value;
+}
+
+template <typename T> static inline void sk_release_store(T** addr, T* value) {
+    SK_LAZY_FLAT_BARRIER();
+    *(T* volatile*)addr = value;
+}
+
+/**
+ * What a read buffer needs to unflatten the objects of one picture: its
+ * flags, factories and typefaces, and how to decode (or where to find) its
+ * bitmaps. It is shared by the picture's SkLazyFlatArrays, which may outlive
+ * the SkPicturePlayback that read them.
+ */
+class SkFlatReadContext : public SkRefCnt {
+public:
+    SkFlatReadContext()
+        : fFlags(0)
+        , fFactoryPlayback(NULL)
+        , fBitmapDecoder(NULL)
+        , fBitmapStorage(NULL) {}
+
+    virtual ~SkFlatReadContext() {
+        SkDELETE(fFactoryPlayback);
+        SkSafeUnref(fBitmapStorage);
+    }
+
+    void setupBuffer(SkOrderedReadBuffer* buffer) const {
+        buffer->setFlags(fFlags);
+        if (fFactoryPlayback) {
+            fFactoryPlayback->setupBuffer(*buffer);
+        }
+        fTFPlayback.setupBuffer(*buffer);
+        buffer->setBitmapDecoder(fBitmapDecoder);
+        buffer->setBitmapStorage(fBitmapStorage);
+    }
+
+    uint32_t                        fFlags;             // SkFlattenableReadBuffer flags
+    SkFactoryPlayback*              fFactoryPlayback;   // owned, may be NULL
+    SkTypefacePlayback              fTFPlayback;
+    SkPicture::InstallPixelRefProc  fBitmapDecoder;
+    SkBitmapHeapReader*             fBitmapStorage;     // ref'd, may be NULL
+
+private:
+    typedef SkRefCnt INHERITED;
+};
+
+/**
+ * A read-only array of objects that are unflattened from a block of
+ * flattened data the first time each of them is asked for, so that a picture
+ * only pays for the paints, paths, etc. that it actually draws with. Any
+ * number of threads may read from it at once.
+ *
+ * It can also wrap objects that already exist, so that its users need not
+ * care where the objects came from.
+ */
+template <typename T> class SkLazyFlatArray : public SkRefCnt {
+public:
+    typedef void (*UnflattenProc)(SkOrderedReadBuffer&, T*);
+
+    /**
+     * Entry i will be unflattened by proc from the bytes of data between
+     * offsets[i] and offsets[i + 1], which must be multiples of 4. The offsets
+     * are copied; data and context are ref'd.
+     */
+    SkLazyFlatArray(SkData* data, const uint32_t offsets[], int count,
+                    SkFlatReadContext* context, UnflattenProc proc)
+        : fStorage(kEntriesPerBlock * sizeof(T))
+        , fData(SkRef(data))
+        , fContext(SkRef(context))
+        , fProc(proc)
+        , fOwner(NULL)
+        , fLoadedCount(0) {
+        SkASSERT(count >= 0);
+        fOffsets.append(count + 1, offsets);
+        fEntries.setCount(count);
+        sk_bzero(fEntries.begin(), count * sizeof(const T*));
+    }
+
+    /**
+     * Wraps entries that already exist, and keeps their owner alive.
+     */
+    SkLazyFlatArray(const T* const entries[], int count, SkRefCnt* owner)
+        : fStorage(sizeof(T))
+        , fData(NULL)
+        , fContext(NULL)
+        , fProc(NULL)
+        , fOwner(SkSafeRef(owner))
+        , fLoadedCount(count) {
+        fEntries.append(count, entries);
+    }
+
+    /**
+     * Wraps the entries of an SkTRefArray.
+     */
+    static SkLazyFlatArray* Wrap(SkTRefArray<T>* array) {
+        if (NULL == array) {
+            return NULL;
+        }
+        SkAutoTMalloc<const T*> entries(array->count());
+        for (int i = 0; i < array->count(); ++i) {
+            entries[i] = &array->at(i);
+        }
+        return SkNEW_ARGS(SkLazyFlatArray, (entries.get(), array->count(), array));
+    }
+
+    virtual ~SkLazyFlatArray() {
+        if (fData) {
+            for (int i = 0; i < fEntries.count(); ++i) {
+                if (fEntries[i]) {
+                    fEntries[i]->~T();
+                }
+            }
+            fData->unref();
+            fContext->unref();
+        }
+        SkSafeUnref(fOwner);
+    }
+
+    int count() const { return fEntries.count(); }
+
+    const T& operator[](int index) const {
+        SkASSERT((unsigned)index < (unsigned)fEntries.count());
+        const T* entry = sk_acquire_load(&fEntries[index]);
+        return entry ? *entry : *this->load(index);
+    }
+
+    const T& at(int index) const { return (*this)[index]; }
+
+    /** Returns how many entries have been unflattened (or wrapped) so far. */
+    int loadedCount() const { return fLoadedCount; }
+
+private:
+    enum {
+        kEntriesPerBlock = 32,
+    };
+
+    const T* load(int index) const {
+        SkAutoMutexAcquire lock(fMutex);
+        if (NULL == fEntries[index]) {
+            T* entry = new (fStorage.allocThrow(sizeof(T))) T;
+            SkOrderedReadBuffer buffer(fData->bytes() + fOffsets[index],
+                                       fOffsets[index + 1] - fOffsets[index]);
+            fContext->setupBuffer(&buffer);
+            fProc(buffer, entry);
+            sk_atomic_inc(&fLoadedCount);
+            // operator[] reads the entry without the lock, so it must not see the pointer
+            // before the entry it points to is complete
+            sk_release_store(&fEntries[index], (const T*)entry);
+        }
+        return fEntries[index];
+    }
+
+    // Guards fStorage and the loading of fEntries, which are published with sk_release_store()
+    mutable SkMutex             fMutex;
+    mutable SkChunkAlloc        fStorage;
+    // NULL until the entry is unflattened
+    mutable SkTDArray<const T*> fEntries;
+    SkTDArray<uint32_t>         fOffsets;
+
+    SkData*                     fData;      // NULL if the entries were wrapped
+    SkFlatReadContext*          fContext;
+    UnflattenProc               fProc;
+    SkRefCnt*                   fOwner;     // of wrapped entries
+    mutable int32_t             fLoadedCount;
+
+    typedef SkRefCnt INHERITED;
+};
+
+#endif
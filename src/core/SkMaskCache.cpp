@@ -0,0 +1,141 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkMaskCache.h"
+#include "SkChecksum.h"
+#include "SkGraphics.h"
+#include "SkTLRUCache.h"
+#include "SkThread.h"
+
+// Masks are blitted a little differently than paths are scan converted, so the cache is off
+// unless a budget is given, either here or with SkGraphics::SetMaskCacheLimit().
+#ifndef SK_DEFAULT_MASK_CACHE_LIMIT
+    #define SK_DEFAULT_MASK_CACHE_LIMIT     0
+#endif
+
+// A single mask may use at most this fraction of the budget, so that one big mask cannot push
+// out everything else.
+static const int kMaxEntryFractionShift = 3;
+
+static uint32_t hash_key(const SkMaskCache::Key& key) {
+    return SkChecksum::Compute(reinterpret_cast<const uint32_t*>(&key), sizeof(key));
+}
+
+SkMaskCache::Entry::Entry(const Key& key, uint32_t hash, const SkMask& mask)
+    : fKey(key)
+    , fHash(hash)
+    , fMask(mask)
+    , fHashNext(NULL)
+    , fPrev(NULL)
+    , fNext(NULL) {
+}
+
+SkMaskCache::Entry::~Entry() {
+    SkMask::FreeImage(fMask.fImage);
+}
+
+typedef SkTLRUCache<SkMaskCache::Entry, SkMaskCache::Key> SkMaskCacheImpl;
+
+SK_DECLARE_STATIC_MUTEX(gMaskCacheMutex);
+static SkMaskCacheImpl* gMaskCache;
+
+// The caller must hold gMaskCacheMutex.
+static SkMaskCacheImpl& get_cache() {
+    if (NULL == gMaskCache) {
+        // we leak this, so we don't incur any shutdown cost of the destructor
+        gMaskCache = SkNEW_ARGS(SkMaskCacheImpl, (SK_DEFAULT_MASK_CACHE_LIMIT));
+    }
+    return *gMaskCache;
+}
+
+// The caller must hold gMaskCacheMutex.
+static bool can_cache(const SkMaskCacheImpl& cache, size_t bytes) {
+    return bytes > 0 && bytes <= (cache.getLimit() >> kMaxEntryFractionShift);
+}
+
+SkMaskCache::Entry* SkMaskCache::Find(const Key& key) {
+    const uint32_t hash = hash_key(key);
+    SkAutoMutexAcquire ac(gMaskCacheMutex);
+    Entry* entry = get_cache().find(key, hash);
+    SkSafeRef(entry);
+    return entry;
+}
+
+SkMaskCache::Entry* SkMaskCache::Add(const Key& key, const SkMask& mask) {
+    const uint32_t hash = hash_key(key);
+    SkAutoMutexAcquire ac(gMaskCacheMutex);
+    SkMaskCacheImpl& cache = get_cache();
+    if (!can_cache(cache, mask.computeTotalImageSize())) {
+        return SkNEW_ARGS(Entry, (key, hash, mask));
+    }
+
+    Entry* entry = cache.lookup(key, hash);
+    if (entry) {
+        // Another thread drew the same mask first
+        SkMask::FreeImage(mask.fImage);
+        entry->ref();
+        return entry;
+    }
+    // The entry's first reference is the cache's, the second the caller's
+    entry = SkNEW_ARGS(Entry, (key, hash, mask));
+    entry->ref();
+    cache.add(entry);
+    return entry;
+}
+
+bool SkMaskCache::CanCache(size_t bytes) {
+    SkAutoMutexAcquire ac(gMaskCacheMutex);
+    return can_cache(get_cache(), bytes);
+}
+
+size_t SkMaskCache::GetLimit() {
+    SkAutoMutexAcquire ac(gMaskCacheMutex);
+    return get_cache().getLimit();
+}
+
+size_t SkMaskCache::SetLimit(size_t bytes) {
+    SkAutoMutexAcquire ac(gMaskCacheMutex);
+    return get_cache().setLimit(bytes);
+}
+
+size_t SkMaskCache::GetBytesUsed() {
+    SkAutoMutexAcquire ac(gMaskCacheMutex);
+    return get_cache().getBytesUsed();
+}
+
+void SkMaskCache::PurgeAll() {
+    SkAutoMutexAcquire ac(gMaskCacheMutex);
+    get_cache().purgeAll();
+}
+
+int SkMaskCache::GetHitCount() {
+    SkAutoMutexAcquire ac(gMaskCacheMutex);
+    return get_cache().getHitCount();
+}
+
+int SkMaskCache::GetMissCount() {
+    SkAutoMutexAcquire ac(gMaskCacheMutex);
+    return get_cache().getMissCount();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+size_t SkGraphics::GetMaskCacheLimit() {
+    return SkMaskCache::GetLimit();
+}
+
+size_t SkGraphics::SetMaskCacheLimit(size_t bytes) {
+    return SkMaskCache::SetLimit(bytes);
+}
+
+size_t SkGraphics::GetMaskCacheUsed() {
+    return SkMaskCache::GetBytesUsed();
+}
+
+void SkGraphics::PurgeMaskCache() {
+    SkMaskCache::PurgeAll();
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkMaskCache_DEFINED
+#define SkMaskCache_DEFINED
+
+#include "SkMask.h"
+#include "SkRefCnt.h"
+#include "SkScalar.h"
+
+template <typename T, typename Key> class SkTLRUCache;
+
+/**
+ *  A process-wide cache of the A8 masks that SkDraw rasterizes for antialiased and blurred
+ *  paths, so that drawing the same path again only has to blit the mask.
+ *
+ *  Masks are cached without their integer translation: a mask found for one draw can be blitted
+ *  at any whole-pixel offset from where it was first drawn. The cache is bounded by a byte
+ *  budget (see SkGraphics::SetMaskCacheLimit()) and evicts the least recently used masks. It is
+ *  safe to use from several threads.
+ */
+class SkMaskCache {
+public:
+    /**
+     *  Everything that the pixels of a cached mask depend on. Keys are compared bitwise, so all
+     *  of the fields, including ones that do not apply, must be set.
+     */
+    struct Key {
+        uint32_t    fPathGenID;         // SkPath::getGenerationID()
+        SkScalar    fScaleX, fSkewX, fSkewY, fScaleY;
+        SkScalar    fSubpixelX;         // the translation, less its integer part
+        SkScalar    fSubpixelY;
+        SkScalar    fStrokeWidth;
+        SkScalar    fMiterLimit;
+        uint32_t    fStyle;             // style, cap and join
+        SkScalar    fBlurRadius;        // 0 when there is no blur
+        uint32_t    fBlurFlags;         // blur type, and whether it ignores the CTM or is HQ
+
+        bool operator==(const Key& other) const {
+            return 0 == memcmp(this, &other, sizeof(Key));
+        }
+    };
+
+    class Entry : public SkRefCnt {
+    public:
+        /** The mask, with bounds relative to the integer translation it was drawn with. */
+        const SkMask& mask() const { return fMask; }
+
+        virtual ~Entry();
+
+    private:
+        Entry(const Key&, uint32_t hash, const SkMask&);
+
+        bool equals(const Key& key) const { return fKey == key; }
+        size_t bytes() const { return fMask.computeTotalImageSize(); }
+        // Threads still blitting the mask keep it alive until they are done
+        static void Free(Entry* entry) { entry->unref(); }
+
+        Key         fKey;
+        uint32_t    fHash;
+        SkMask      fMask;
+        Entry*      fHashNext;
+        Entry*      fPrev;      // more recently used
+        Entry*      fNext;      // less recently used
+
+        friend class SkMaskCache;
+        friend class SkTLRUCache<Entry, Key>;
+
+        typedef SkRefCnt INHERITED;
+    };
+
+    /**
+     *  Returns the mask cached for 'key', or NULL if there is none. The caller must unref() the
+     *  returned entry when done with it.
+     */
+    static Entry* Find(const Key& key);
+
+    /**
+     *  Adds 'mask' to the cache under 'key', taking ownership of its image. The returned entry
+     *  holds the mask, and must be unref()ed by the caller. A mask too big for the cache is
+     *  returned without being cached.
+     */
+    static Entry* Add(const Key& key, const SkMask& mask);
+
+    /** Returns true if a mask of this many bytes could be cached. */
+    static bool CanCache(size_t bytes);
+
+    static size_t GetLimit();
+    static size_t SetLimit(size_t bytes);
+    static size_t GetBytesUsed();
+    static void PurgeAll();
+
+    /** The number of Find() calls that did and did not find a mask. */
+    static int GetHitCount();
+    static int GetMissCount();
+};
+
+#endif
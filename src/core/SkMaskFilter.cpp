@@ -183,6 +183,24 @@ static void draw_nine(const SkMask& mask, const SkIRect& outerR,
     }
 }
 
+// Blits mask, which is in device space, through the clip.
+static void draw_mask(const SkMask& mask, const SkRasterClip& clip,
+                      SkBounder* bounder, SkBlitter* blitter) {
+    // if we get here, we need to (possibly) resolve the clip and blitter
+    SkAAClipBlitterWrapper wrapper(clip, blitter);
+    blitter = wrapper.getBlitter();
+
+    SkRegion::Cliperator clipper(wrapper.getRgn(), mask.fBounds);
+
+    if (!clipper.done() && (bounder == NULL || bounder->doIRect(mask.fBounds))) {
+        const SkIRect& cr = clipper.rect();
+        do {
+            blitter->blitMask(mask, cr);
+            clipper.next();
+        } while (!clipper.done());
+    }
+}
+
 static int countNestedRects(const SkPath& path, SkRect rects[2]) {
     if (path.isNestedRects(rects)) {
         return 2;
@@ -235,20 +253,30 @@ bool SkMaskFilter::filterPath(const SkPath& devPath, const SkMatrix& matrix,
     }
     SkAutoMaskFreeImage autoDst(dstM.fImage);
 
-    // if we get here, we need to (possibly) resolve the clip and blitter
-    SkAAClipBlitterWrapper wrapper(clip, blitter);
-    blitter = wrapper.getBlitter();
-
-    SkRegion::Cliperator clipper(wrapper.getRgn(), dstM.fBounds);
+    draw_mask(dstM, clip, bounder, blitter);
+    return true;
+}
 
-    if (!clipper.done() && (bounder == NULL || bounder->doIRect(dstM.fBounds))) {
-        const SkIRect& cr = clipper.rect();
-        do {
-            blitter->blitMask(dstM, cr);
-            clipper.next();
-        } while (!clipper.done());
+bool SkMaskFilter::filterRRect(const SkRRect& devRRect, const SkMatrix& matrix,
+                               const SkRasterClip& clip, SkBounder* bounder,
+                               SkBlitter* blitter) const {
+    NinePatch patch;
+    patch.fMask.fImage = NULL;
+    if (kTrue_FilterReturn != this->filterRRectToNine(devRRect, matrix, clip.getBounds(),
+                                                      &patch)) {
+        SkASSERT(NULL == patch.fMask.fImage);
+        return false;
     }
+    SkAutoMaskFreeImage autoPatch(patch.fMask.fImage);
 
+    if (patch.fMask.fBounds.width() == patch.fOuterRect.width() &&
+            patch.fMask.fBounds.height() == patch.fOuterRect.height()) {
+        // nothing to stretch, so the patch is the whole mask
+        patch.fMask.fBounds = patch.fOuterRect;
+        draw_mask(patch.fMask, clip, bounder, blitter);
+    } else {
+        draw_nine(patch.fMask, patch.fOuterRect, patch.fCenter, true, clip, bounder, blitter);
+    }
     return true;
 }
 
@@ -258,6 +286,12 @@ SkMaskFilter::filterRectsToNine(const SkRect[], int count, const SkMatrix&,
     return kUnimplemented_FilterReturn;
 }
 
+SkMaskFilter::FilterReturn
+SkMaskFilter::filterRRectToNine(const SkRRect&, const SkMatrix&,
+                                const SkIRect& clipBounds, NinePatch*) const {
+    return kUnimplemented_FilterReturn;
+}
+
 SkMaskFilter::BlurType SkMaskFilter::asABlur(BlurInfo*) const {
     return kNone_BlurType;
 }
@@ -0,0 +1,302 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkMipMapCache.h"
+#include "SkBitmapScaler.h"
+#include "SkChecksum.h"
+#include "SkGraphics.h"
+#include "SkMipMap_opts.h"
+#include "SkTArray.h"
+#include "SkTLRUCache.h"
+#include "SkThread.h"
+
+#ifndef SK_DEFAULT_MIPMAP_CACHE_LIMIT
+    #define SK_DEFAULT_MIPMAP_CACHE_LIMIT   (16 * 1024 * 1024)
+#endif
+
+// A single bitmap's levels (or resampled copy) may use at most this fraction of the budget.
+static const int kMaxEntryFractionShift = 1;
+
+namespace {
+
+// Everything that identifies the pixels of a bitmap. Compared bitwise.
+struct Key {
+    uint32_t    fGenID;             // SkBitmap::getGenerationID()
+    uint32_t    fPixelRefOffset;
+    uint32_t    fRowBytes;
+    uint32_t    fWidth;
+    uint32_t    fHeight;
+    // The size the bitmap was resampled to, or 0 x 0 for its mip levels
+    uint32_t    fScaledWidth;
+    uint32_t    fScaledHeight;
+
+    bool operator==(const Key& other) const {
+        return 0 == memcmp(this, &other, sizeof(Key));
+    }
+};
+
+struct Entry {
+    Entry(const Key& key, uint32_t hash)
+        : fKey(key)
+        , fHash(hash)
+        , fBytes(0)
+        , fHashNext(NULL)
+        , fPrev(NULL)
+        , fNext(NULL) {
+    }
+
+    bool equals(const Key& key) const { return fKey == key; }
+    size_t bytes() const { return fBytes; }
+    // Bitmaps handed out keep their level's pixels alive until they are done with them
+    static void Free(Entry* entry) { SkDELETE(entry); }
+
+    Key                 fKey;
+    uint32_t            fHash;
+    size_t              fBytes;
+    // fLevels[0] is half the size of the bitmap, or the resampled bitmap
+    SkTArray<SkBitmap>  fLevels;
+    Entry*              fHashNext;
+    Entry*              fPrev;      // more recently used
+    Entry*              fNext;      // less recently used
+};
+
+}
+
+static uint32_t hash_key(const Key& key) {
+    return SkChecksum::Compute(reinterpret_cast<const uint32_t*>(&key), sizeof(key));
+}
+
+// The level that SkBitmap::extractMipLevel() would pick for this inverse scale.
+static int compute_level(SkFixed sx, SkFixed sy) {
+    const SkFixed scale = SkMax32(SkAbs32(sx), SkAbs32(sy));
+    if (scale < SK_Fixed1) {
+        return 0;
+    }
+    return 15 - SkCLZ(scale);
+}
+
+// Returns the number of levels of 'src', and the bytes they need.
+static int count_levels(const SkBitmap& src, size_t* bytes) {
+    int count = 0;
+    *bytes = 0;
+    int width = src.width() >> 1;
+    int height = src.height() >> 1;
+    while (width > 0 && height > 0) {
+        *bytes += SkBitmap::ComputeRowBytes(SkBitmap::kARGB_8888_Config, width) * height;
+        count += 1;
+        width >>= 1;
+        height >>= 1;
+    }
+    return count;
+}
+
+// Fills in entry->fLevels from 'src', whose pixels must be locked.
+static bool build_levels(const SkBitmap& src, int count, Entry* entry) {
+    SkASSERT(0 == entry->fKey.fScaledWidth);
+    SkDownsampleRow32Proc proc = SkGetDownsampleRow32Proc();
+    entry->fLevels.push_back_n(count);
+
+    const SkBitmap* prev = &src;
+    for (int i = 0; i < count; i++) {
+        SkBitmap& level = entry->fLevels[i];
+        const int width = prev->width() >> 1;
+        const int height = prev->height() >> 1;
+        level.setConfig(SkBitmap::kARGB_8888_Config, width, height);
+        if (!level.allocPixels()) {
+            return false;
+        }
+        level.setIsOpaque(src.isOpaque());
+
+        // Each level is half the size of the one before (rounded down), so
+        // whole rows can be averaged without clamping at the edges.
+        for (int y = 0; y < height; y++) {
+            proc(level.getAddr32(0, y), prev->getAddr32(0, y << 1),
+                 prev->getAddr32(0, (y << 1) + 1), width);
+        }
+        level.setImmutable();
+        entry->fBytes += level.getSize();
+        prev = &level;
+    }
+    return true;
+}
+
+// Sets entry->fLevels[0] to 'src', whose pixels must be locked, resampled to the key's size.
+static bool build_resampled(const SkBitmap& src, int count, Entry* entry) {
+    SkASSERT(1 == count);
+    SkBitmap& resampled = entry->fLevels.push_back();
+    if (!SkBitmapScaler::Resize(&resampled, src, entry->fKey.fScaledWidth,
+                                entry->fKey.fScaledHeight,
+                                SkBitmapScaler::kMitchell_ResizeMethod)) {
+        return false;
+    }
+    resampled.setImmutable();
+    entry->fBytes += resampled.getSize();
+    return true;
+}
+
+typedef SkTLRUCache<Entry, Key> SkMipMapCacheImpl;
+
+// Copies the requested level (or the smallest there is) into dst, and returns its number
+static int extract(const Entry& entry, int level, SkBitmap* dst) {
+    level = SkMin32(level, entry.fLevels.count());
+    *dst = entry.fLevels[level - 1];
+    return level;
+}
+
+SK_DECLARE_STATIC_MUTEX(gMipMapCacheMutex);
+static SkMipMapCacheImpl* gMipMapCache;
+
+// The caller must hold gMipMapCacheMutex.
+static SkMipMapCacheImpl& get_cache() {
+    if (NULL == gMipMapCache) {
+        // we leak this, so we don't incur any shutdown cost of the destructor
+        gMipMapCache = SkNEW_ARGS(SkMipMapCacheImpl, (SK_DEFAULT_MIPMAP_CACHE_LIMIT));
+    }
+    return *gMipMapCache;
+}
+
+// Fills in everything that identifies the pixels of 'src', or returns false if they should
+// not be cached.
+static bool init_key(const SkBitmap& src, int scaledWidth, int scaledHeight, Key* key) {
+    if (SkBitmap::kARGB_8888_Config != src.config() || src.isVolatile() || src.getTexture() ||
+        0 == src.getGenerationID()) {
+        return false;
+    }
+    key->fGenID = src.getGenerationID();
+    key->fPixelRefOffset = SkToU32(src.pixelRefOffset());
+    key->fRowBytes = SkToU32(src.rowBytes());
+    key->fWidth = src.width();
+    key->fHeight = src.height();
+    key->fScaledWidth = scaledWidth;
+    key->fScaledHeight = scaledHeight;
+    return true;
+}
+
+typedef bool (*BuildProc)(const SkBitmap& src, int count, Entry* entry);
+
+// Copies the requested level of the key's entry into dst (with its pixels locked), first
+// building the entry's 'count' levels with 'build' if it is not cached. Returns the level
+// copied, or 0 if there is none.
+static int find_or_build(const SkBitmap& src, const Key& key, int count, size_t bytes,
+                         BuildProc build, int level, SkBitmap* dst) {
+    const uint32_t hash = hash_key(key);
+
+    bool found = false;
+    {
+        SkAutoMutexAcquire ac(gMipMapCacheMutex);
+        SkMipMapCacheImpl& cache = get_cache();
+        if (0 == bytes || bytes > (cache.getLimit() >> kMaxEntryFractionShift)) {
+            return 0;
+        }
+        const Entry* entry = cache.find(key, hash);
+        if (entry) {
+            level = extract(*entry, level, dst);
+            found = true;
+        }
+    }
+
+    if (!found) {
+        // The entry is built without holding the lock, so that other threads can draw
+        SkAutoLockPixels alp(src);
+        if (!src.readyToDraw()) {
+            return 0;
+        }
+        Entry* entry = SkNEW_ARGS(Entry, (key, hash));
+        if (!build(src, count, entry)) {
+            SkDELETE(entry);
+            return 0;
+        }
+        SkAutoMutexAcquire ac(gMipMapCacheMutex);
+        SkMipMapCacheImpl& cache = get_cache();
+        const Entry* existing = cache.lookup(key, hash);
+        if (existing) {
+            // Another thread built the same levels first
+            SkDELETE(entry);
+            level = extract(*existing, level, dst);
+        } else {
+            level = extract(*entry, level, dst);
+            cache.add(entry);
+        }
+    }
+    dst->lockPixels();
+    return level;
+}
+
+int SkMipMapCache::ExtractMipLevel(const SkBitmap& src, SkFixed sx, SkFixed sy,
+                                   SkBitmap* dst) {
+    int level = compute_level(sx, sy);
+    Key key;
+    if (level <= 0 || !init_key(src, 0, 0, &key)) {
+        return 0;
+    }
+
+    size_t bytes;
+    const int count = count_levels(src, &bytes);
+    if (0 == count) {
+        return 0;
+    }
+    return find_or_build(src, key, count, bytes, build_levels, level, dst);
+}
+
+bool SkMipMapCache::ExtractResampled(const SkBitmap& src, int width, int height,
+                                     SkBitmap* dst) {
+    Key key;
+    if (width <= 0 || height <= 0 || !init_key(src, width, height, &key)) {
+        return false;
+    }
+
+    const size_t bytes = SkBitmap::ComputeRowBytes(SkBitmap::kARGB_8888_Config, width) * height;
+    return 1 == find_or_build(src, key, 1, bytes, build_resampled, 1, dst);
+}
+
+size_t SkMipMapCache::GetLimit() {
+    SkAutoMutexAcquire ac(gMipMapCacheMutex);
+    return get_cache().getLimit();
+}
+
+size_t SkMipMapCache::SetLimit(size_t bytes) {
+    SkAutoMutexAcquire ac(gMipMapCacheMutex);
+    return get_cache().setLimit(bytes);
+}
+
+size_t SkMipMapCache::GetBytesUsed() {
+    SkAutoMutexAcquire ac(gMipMapCacheMutex);
+    return get_cache().getBytesUsed();
+}
+
+void SkMipMapCache::PurgeAll() {
+    SkAutoMutexAcquire ac(gMipMapCacheMutex);
+    get_cache().purgeAll();
+}
+
+int SkMipMapCache::GetHitCount() {
+    SkAutoMutexAcquire ac(gMipMapCacheMutex);
+    return get_cache().getHitCount();
+}
+
+int SkMipMapCache::GetMissCount() {
+    SkAutoMutexAcquire ac(gMipMapCacheMutex);
+    return get_cache().getMissCount();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+size_t SkGraphics::GetMipMapCacheLimit() {
+    return SkMipMapCache::GetLimit();
+}
+
+size_t SkGraphics::SetMipMapCacheLimit(size_t bytes) {
+    return SkMipMapCache::SetLimit(bytes);
+}
+
+size_t SkGraphics::GetMipMapCacheUsed() {
+    return SkMipMapCache::GetBytesUsed();
+}
+
+void SkGraphics::PurgeMipMapCache() {
+    SkMipMapCache::PurgeAll();
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkMipMapCache_DEFINED
+#define SkMipMapCache_DEFINED
+
+#include "SkBitmap.h"
+
+/**
+ *  A process-wide cache of the mip levels of bitmaps that are drawn filtered at less than half
+ *  their size with SkPaint::kMipMapBitmap_Flag, so that callers do not have to build (and keep)
+ *  the levels on each SkBitmap themselves. It also keeps the copies of bitmaps that
+ *  SkPaint::kHighQualityFilterBitmap_Flag resamples to the size they are drawn at, so that
+ *  drawing a bitmap at the same size again does not resample it again.
+ *
+ *  Levels are keyed by the generation ID of the bitmap's pixels, so every SkBitmap that shares
+ *  the same pixels shares their levels, and changing the pixels stops the old levels from
+ *  being found. The cache is bounded by a byte budget (see SkGraphics::SetMipMapCacheLimit())
+ *  and evicts the least recently used bitmaps' levels. It is safe to use from several threads.
+ */
+class SkMipMapCache {
+public:
+    /**
+     *  If a filtered draw of 'src' with the inverse scale (sx, sy) should sample from a mip
+     *  level, sets 'dst' to that level (with its pixels locked), building and caching the
+     *  levels of 'src' first if needed, and returns the level (1 is half size, 2 a quarter,
+     *  and so on). Otherwise returns 0 and leaves 'dst' alone.
+     *
+     *  Only ARGB_8888 bitmaps with non-volatile pixels in memory are mipped. 'dst' holds its own
+     *  reference to the level's pixels, so it stays valid after the cache evicts them.
+     */
+    static int ExtractMipLevel(const SkBitmap& src, SkFixed sx, SkFixed sy, SkBitmap* dst);
+
+    /**
+     *  Sets 'dst' to 'src' resampled to width x height by SkBitmapScaler's Mitchell filter
+     *  (with its pixels locked), resampling and caching it first if needed, and returns true.
+     *  Returns false and leaves 'dst' alone if 'src' can not be cached (under the same rules as
+     *  ExtractMipLevel(), or because the copy would take too much of the budget) or resampled.
+     */
+    static bool ExtractResampled(const SkBitmap& src, int width, int height, SkBitmap* dst);
+
+    static size_t GetLimit();
+    static size_t SetLimit(size_t bytes);
+    static size_t GetBytesUsed();
+    static void PurgeAll();
+
+    /** The number of lookups that did and did not find a bitmap's levels or resampled copy. */
+    static int GetHitCount();
+    static int GetMissCount();
+};
+
+#endif
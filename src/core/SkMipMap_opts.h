@@ -0,0 +1,31 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkMipMap_opts_DEFINED
+#define SkMipMap_opts_DEFINED
+
+#include "SkColor.h"
+
+/**
+ *  Averages each 2x2 block of pixels from row0 and row1 into one pixel of dst, truncating each
+ *  channel as SkBitmap::buildMipMap() does. row0 and row1 each hold 2 * count pixels.
+ */
+typedef void (*SkDownsampleRow32Proc)(SkPMColor dst[], const SkPMColor row0[],
+                                      const SkPMColor row1[], int count);
+
+/**
+ *  Returns the platform's row proc, or NULL if it has none. Implemented in src/opts for each
+ *  platform.
+ */
+SkDownsampleRow32Proc SkPlatformDownsampleRow32Proc();
+
+/**
+ *  Returns the platform's row proc if there is one, otherwise the portable one.
+ */
+SkDownsampleRow32Proc SkGetDownsampleRow32Proc();
+
+#endif
@@ -252,6 +252,14 @@ void SkPaint::setFilterBitmap(bool doFilter) {
     this->setFlags(SkSetClearMask(fFlags, doFilter, kFilterBitmap_Flag));
 }
 
+void SkPaint::setMipMapBitmap(bool doMipMap) {
+    this->setFlags(SkSetClearMask(fFlags, doMipMap, kMipMapBitmap_Flag));
+}
+
+void SkPaint::setHighQualityFilterBitmap(bool doHighQuality) {
+    this->setFlags(SkSetClearMask(fFlags, doHighQuality, kHighQualityFilterBitmap_Flag));
+}
+
 void SkPaint::setStyle(Style style) {
     if ((unsigned)style < kStyleCount) {
         GEN_ID_INC_EVAL((unsigned)style != fStyle);
@@ -2350,6 +2358,9 @@ void SkPaint::toString(SkString* str) const {
         bool needSeparator = false;
         SkAddFlagToString(str, this->isAntiAlias(), "AntiAlias", &needSeparator);
         SkAddFlagToString(str, this->isFilterBitmap(), "FilterBitmap", &needSeparator);
+        SkAddFlagToString(str, this->isMipMapBitmap(), "MipMapBitmap", &needSeparator);
+        SkAddFlagToString(str, this->isHighQualityFilterBitmap(), "HighQualityFilterBitmap",
+                          &needSeparator);
         SkAddFlagToString(str, this->isDither(), "Dither", &needSeparator);
         SkAddFlagToString(str, this->isUnderlineText(), "UnderlineText", &needSeparator);
         SkAddFlagToString(str, this->isStrikeThruText(), "StrikeThruText", &needSeparator);
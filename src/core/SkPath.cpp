@@ -228,7 +228,6 @@ SkPath::SkPath()
     fIsOval = false;
     fIsFinite = false;  // gets computed when we know our bounds
 #ifdef SK_BUILD_FOR_ANDROID
-    fGenerationID = 0;
     fSourcePath = NULL;
 #endif
 }
@@ -251,7 +250,6 @@ SkPath::SkPath(const SkPath& src)
     fLastMoveToIndex = src.fLastMoveToIndex;
     fIsOval         = src.fIsOval;
 #ifdef SK_BUILD_FOR_ANDROID
-    fGenerationID = src.fGenerationID;
     fSourcePath = NULL;
 #endif
 }
@@ -275,7 +273,6 @@ SkPath& SkPath::operator=(const SkPath& src) {
         fSegmentMask    = src.fSegmentMask;
         fLastMoveToIndex = src.fLastMoveToIndex;
         fIsOval         = src.fIsOval;
-        GEN_ID_INC;
     }
     SkDEBUGCODE(this->validate();)
     return *this;
@@ -308,7 +305,6 @@ void SkPath::swap(SkPath& other) {
         SkTSwap<int>(fLastMoveToIndex, other.fLastMoveToIndex);
         SkTSwap<SkBool8>(fIsOval, other.fIsOval);
         SkTSwap<SkBool8>(fIsFinite, other.fIsFinite);
-        GEN_ID_INC;
     }
 }
 
@@ -392,11 +388,13 @@ bool SkPath::conservativelyContainsRect(const SkRect& rect) const {
     return check_edge_against_rect(prevPt, firstPt, rect, direction);
 }
 
-#ifdef SK_BUILD_FOR_ANDROID
 uint32_t SkPath::getGenerationID() const {
-    return fGenerationID;
+    uint32_t genID = fPathRef->genID();
+    SkASSERT((unsigned)fFillType < (1 << (32 - SkPathRef::kGenIDBitCount)));
+    return genID | (static_cast<uint32_t>(fFillType) << SkPathRef::kGenIDBitCount);
 }
 
+#ifdef SK_BUILD_FOR_ANDROID
 const SkPath* SkPath::getSourcePath() const {
     return fSourcePath;
 }
@@ -410,7 +408,6 @@ void SkPath::reset() {
     SkDEBUGCODE(this->validate();)
 
     fPathRef.reset(SkPathRef::CreateEmpty());
-    GEN_ID_INC;
     fBoundsIsDirty = true;
     fConvexity = kUnknown_Convexity;
     fDirection = kUnknown_Direction;
@@ -423,7 +420,6 @@ void SkPath::rewind() {
     SkDEBUGCODE(this->validate();)
 
     SkPathRef::Rewind(&fPathRef);
-    GEN_ID_INC;
     fConvexity = kUnknown_Convexity;
     fBoundsIsDirty = true;
     fSegmentMask = 0;
@@ -700,7 +696,6 @@ void SkPath::setLastPt(SkScalar x, SkScalar y) {
         fIsOval = false;
         SkPathRef::Editor ed(&fPathRef);
         ed.atPoint(count-1)->set(x, y);
-        GEN_ID_INC;
     }
 }
 
@@ -715,7 +710,6 @@ void SkPath::computeBounds() const {
 void SkPath::setConvexity(Convexity c) {
     if (fConvexity != c) {
         fConvexity = c;
-        GEN_ID_INC;
     }
 }
 
@@ -751,7 +745,6 @@ void SkPath::moveTo(SkScalar x, SkScalar y) {
 
     ed.growForVerb(kMove_Verb)->set(x, y);
 
-    GEN_ID_INC;
     DIRTY_AFTER_EDIT_NO_CONVEXITY_OR_DIRECTION_CHANGE;
 }
 
@@ -784,7 +777,6 @@ void SkPath::lineTo(SkScalar x, SkScalar y) {
     ed.growForVerb(kLine_Verb)->set(x, y);
     fSegmentMask |= kLine_SegmentMask;
 
-    GEN_ID_INC;
     DIRTY_AFTER_EDIT;
 }
 
@@ -805,7 +797,6 @@ void SkPath::quadTo(SkScalar x1, SkScalar y1, SkScalar x2, SkScalar y2) {
     pts[1].set(x2, y2);
     fSegmentMask |= kQuad_SegmentMask;
 
-    GEN_ID_INC;
     DIRTY_AFTER_EDIT;
 }
 
@@ -828,7 +819,6 @@ void SkPath::cubicTo(SkScalar x1, SkScalar y1, SkScalar x2, SkScalar y2,
     pts[2].set(x3, y3);
     fSegmentMask |= kCubic_SegmentMask;
 
-    GEN_ID_INC;
     DIRTY_AFTER_EDIT;
 }
 
@@ -852,7 +842,6 @@ void SkPath::close() {
             case kMove_Verb: {
                 SkPathRef::Editor ed(&fPathRef);
                 ed.growForVerb(kClose_Verb);
-                GEN_ID_INC;
                 break;
             }
             default:
@@ -935,7 +924,6 @@ void SkPath::addPoly(const SkPoint pts[], int count, bool close) {
         vb[~count] = kClose_Verb;
     }
 
-    GEN_ID_INC;
     DIRTY_AFTER_EDIT;
     SkDEBUGCODE(this->validate();)
 }
@@ -1677,7 +1665,6 @@ void SkPath::transform(const SkMatrix& matrix, SkPath* dst) const {
                 dst->fBounds.setEmpty();
             }
         } else {
-            GEN_ID_PTR_INC(dst);
             dst->fBoundsIsDirty = true;
         }
 
@@ -1689,12 +1676,6 @@ void SkPath::transform(const SkMatrix& matrix, SkPath* dst) const {
             dst->fConvexity = fConvexity;
         }
 
-#ifdef SK_BUILD_FOR_ANDROID
-        if (!matrix.isIdentity()) {
-            GEN_ID_PTR_INC(dst);
-        }
-#endif
-
         if (kUnknown_Direction == fDirection) {
             dst->fDirection = kUnknown_Direction;
         } else {
@@ -2113,8 +2094,6 @@ uint32_t SkPath::readFromMemory(const void* storage) {
 
     buffer.skipToAlign4();
 
-    GEN_ID_INC;
-
     SkDEBUGCODE(this->validate();)
     return buffer.pos();
 }
@@ -198,6 +198,7 @@ public:
         int32_t rcnt = dst->get()->getRefCnt();
         if (&src == dst->get() && 1 == rcnt) {
             matrix.mapPoints((*dst)->fPoints, (*dst)->fPointCnt);
+            (*dst)->fGenerationID = 0;
             return;
         } else if (rcnt > 1) {
             dst->reset(SkNEW(SkPathRef));
@@ -311,6 +312,35 @@ public:
         return this->points()[index];
     }
 
+    enum {
+        // The number of low bits genID() uses, leaving the rest for owners to extend it with.
+        kGenIDBitCount = 30,
+    };
+
+    /**
+     * Gets an ID that uniquely identifies the contents of the path ref. If two path refs have the
+     * same ID then they have the same verbs and points. However, two path refs may have the same
+     * contents but different genIDs. Zero is reserved and means an ID has not yet been determined
+     * for the path ref.
+     */
+    int32_t genID() const {
+        SkASSERT_X(!fEditorsAttached);
+        if (!fGenerationID) {
+            if (0 == fPointCnt && 0 == fVerbCnt) {
+                fGenerationID = kEmptyGenID;
+            } else {
+                static int32_t  gPathRefGenerationID;
+                // do a loop in case our global wraps around, as we never want to return a 0 or the
+                // empty ID
+                do {
+                    fGenerationID = (sk_atomic_inc(&gPathRefGenerationID) + 1) &
+                                    ((1 << kGenIDBitCount) - 1);
+                } while (fGenerationID <= kEmptyGenID);
+            }
+        }
+        return fGenerationID;
+    }
+
     bool operator== (const SkPathRef& ref) const {
         this->validate();
         ref.validate();
@@ -544,29 +574,6 @@ private:
         return reinterpret_cast<intptr_t>(fVerbs) - reinterpret_cast<intptr_t>(fPoints);
     }
 
-    /**
-     * Gets an ID that uniquely identifies the contents of the path ref. If two path refs have the
-     * same ID then they have the same verbs and points. However, two path refs may have the same
-     * contents but different genIDs. Zero is reserved and means an ID has not yet been determined
-     * for the path ref.
-     */
-    int32_t genID() const {
-        SkASSERT_X(!fEditorsAttached);
-        if (!fGenerationID) {
-            if (0 == fPointCnt && 0 == fVerbCnt) {
-                fGenerationID = kEmptyGenID;
-            } else {
-                static int32_t  gPathRefGenerationID;
-                // do a loop in case our global wraps around, as we never want to return a 0 or the
-                // empty ID
-                do {
-                    fGenerationID = sk_atomic_inc(&gPathRefGenerationID) + 1;
-                } while (fGenerationID <= kEmptyGenID);
-            }
-        }
-        return fGenerationID;
-    }
-
     void validate() const {
         SkASSERT(static_cast<ptrdiff_t>(fFreeSpace) >= 0);
         SkASSERT(reinterpret_cast<intptr_t>(fVerbs) - reinterpret_cast<intptr_t>(fPoints) >= 0);
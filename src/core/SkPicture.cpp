@@ -85,6 +85,7 @@ const char* DrawTypeToString(DrawType drawType) {
         case SKEW: return "SKEW";
         case TRANSLATE: return "TRANSLATE";
         case NOOP: return "NOOP";
+        case DRAW_RECTS: return "DRAW_RECTS";
         default:
             SkDebugf("DrawType error 0x%08x\n", drawType);
             SkASSERT(0);
@@ -262,6 +263,7 @@ void SkPicture::draw(SkCanvas* surface) {
 
 ///////////////////////////////////////////////////////////////////////////////
 
+#include "SkFlate.h"
 #include "SkStream.h"
 
 SkPicture::SkPicture(SkStream* stream) {
@@ -289,8 +291,28 @@ void SkPicture::initFromStream(SkStream* stream, bool* success, InstallPixelRefP
         return;
     }
 
-    if (stream->readBool()) {
-        fPlayback = SkNEW_ARGS(SkPicturePlayback, (stream, info, proc));
+    SkAutoTUnref<SkInflateStream> inflater;
+    if (info.fFlags & SkPictInfo::kCompressed_Flag) {
+        if (!SkFlate::HaveFlate()) {
+            return;
+        }
+        inflater.reset(SkNEW_ARGS(SkInflateStream, (stream)));
+        stream = inflater.get();
+    }
+
+    // A whole word, which keeps the op data that follows 4-byte aligned
+    if (stream->readU32()) {
+        fPlayback = this->createPlayback(stream, info, proc);
+    }
+
+    if (inflater.get()) {
+        // Read on to the end of the compressed data, which leaves the caller's stream just past
+        // it, and checks that none of it was missing.
+        if (0 != inflater->skip(1) || !inflater->isValid()) {
+            SkDELETE(fPlayback);
+            fPlayback = NULL;
+            return;
+        }
     }
 
     // do this at the end, so that they will be zero if we hit an error.
@@ -301,7 +323,24 @@ void SkPicture::initFromStream(SkStream* stream, bool* success, InstallPixelRefP
     }
 }
 
-void SkPicture::serialize(SkWStream* stream, EncodeBitmap encoder) const {
+SkPicturePlayback* SkPicture::createPlayback(SkStream* stream, const SkPictInfo& info,
+                                             InstallPixelRefProc proc) {
+    return SkNEW_ARGS(SkPicturePlayback, (stream, info, proc));
+}
+
+static void serialize_playback(SkWStream* stream, const SkPicturePlayback* playback,
+                               SkPicture::EncodeBitmap encoder) {
+    // A whole word, which keeps the op data that follows 4-byte aligned
+    if (playback) {
+        stream->write32(true);
+        playback->serialize(stream, encoder);
+    } else {
+        stream->write32(false);
+    }
+}
+
+void SkPicture::serialize(SkWStream* stream, EncodeBitmap encoder,
+                          uint32_t serializeFlags) const {
     SkPicturePlayback* playback = fPlayback;
 
     if (NULL == playback && fRecord) {
@@ -320,17 +359,23 @@ void SkPicture::serialize(SkWStream* stream, EncodeBitmap encoder) const {
     if (8 == sizeof(void*)) {
         info.fFlags |= SkPictInfo::kPtrIs64Bit_Flag;
     }
+    // Without flate, write it uncompressed, which any reader can read
+    if ((serializeFlags & kCompress_SerializeFlag) && SkFlate::HaveFlate()) {
+        info.fFlags |= SkPictInfo::kCompressed_Flag;
+    }
 
     stream->write(&info, sizeof(info));
-    if (playback) {
-        stream->writeBool(true);
-        playback->serialize(stream, encoder);
-        // delete playback if it is a local version (i.e. cons'd up just now)
-        if (playback != fPlayback) {
-            SkDELETE(playback);
-        }
+    if (info.fFlags & SkPictInfo::kCompressed_Flag) {
+        SkDeflateWStream deflater(stream);
+        serialize_playback(&deflater, playback, encoder);
+        deflater.finalize();
     } else {
-        stream->writeBool(false);
+        serialize_playback(stream, playback, encoder);
+    }
+
+    // delete playback if it is a local version (i.e. cons'd up just now)
+    if (playback != fPlayback) {
+        SkDELETE(playback);
     }
 }
 
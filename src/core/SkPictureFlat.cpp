@@ -94,6 +94,92 @@ SkNamedFactorySet* SkFlatController::setNamedFactorySet(SkNamedFactorySet* set)
 
 ///////////////////////////////////////////////////////////////////////////////
 
+void SkFlatDataHash::reset() {
+    fSlots.reset();
+    fCount = 0;
+}
+
+int SkFlatDataHash::homeSlot(const SkFlatData* flat) const {
+    // SkChecksum::Compute() does not mix its low bits well, so finish it off
+    // as Murmur3 does before masking.
+    uint32_t hash = flat->checksum();
+    hash ^= hash >> 16;
+    hash *= 0x85EBCA6B;
+    hash ^= hash >> 13;
+    hash *= 0xC2B2AE35;
+    hash ^= hash >> 16;
+    return hash & (fSlots.count() - 1);
+}
+
+const SkFlatData** SkFlatDataHash::find(const SkFlatData* candidate) {
+    if (fSlots.isEmpty()) {
+        fSlots.setCount(kInitialSlotCount);
+        sk_bzero(fSlots.begin(), fSlots.count() * sizeof(const SkFlatData*));
+    }
+    const int mask = fSlots.count() - 1;
+    int slot = this->homeSlot(candidate);
+    // The table is never full, so this finds an empty slot at the latest.
+    while (NULL != fSlots[slot] && 0 != SkFlatData::Compare(candidate, fSlots[slot])) {
+        slot = (slot + 1) & mask;
+    }
+    return &fSlots[slot];
+}
+
+void SkFlatDataHash::add(const SkFlatData** slot, const SkFlatData* flat) {
+    SkASSERT(slot >= fSlots.begin() && slot < fSlots.end() && NULL == *slot);
+    *slot = flat;
+    if (++fCount * 2 > fSlots.count()) {
+        this->grow();
+    }
+}
+
+bool SkFlatDataHash::remove(const SkFlatData* flat) {
+    if (fSlots.isEmpty()) {
+        return false;
+    }
+    const int mask = fSlots.count() - 1;
+    int hole = this->homeSlot(flat);
+    while (fSlots[hole] != flat) {
+        if (NULL == fSlots[hole]) {
+            return false;
+        }
+        hole = (hole + 1) & mask;
+    }
+
+    // Shift later entries of the same run back into the hole, unless that
+    // would move them in front of their home slot, so no tombstones are needed.
+    for (int slot = (hole + 1) & mask; NULL != fSlots[slot]; slot = (slot + 1) & mask) {
+        const int home = this->homeSlot(fSlots[slot]);
+        // The distance from the entry's home slot to where it is now, and to the hole.
+        if (((slot - home) & mask) >= ((slot - hole) & mask)) {
+            fSlots[hole] = fSlots[slot];
+            hole = slot;
+        }
+    }
+    fSlots[hole] = NULL;
+    --fCount;
+    return true;
+}
+
+void SkFlatDataHash::grow() {
+    SkTDArray<const SkFlatData*> old;
+    old.swap(fSlots);
+    fSlots.setCount(old.count() * 2);
+    sk_bzero(fSlots.begin(), fSlots.count() * sizeof(const SkFlatData*));
+    const int mask = fSlots.count() - 1;
+    for (int i = 0; i < old.count(); ++i) {
+        if (NULL != old[i]) {
+            int slot = this->homeSlot(old[i]);
+            while (NULL != fSlots[slot]) {
+                slot = (slot + 1) & mask;
+            }
+            fSlots[slot] = old[i];
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 SkFlatData* SkFlatData::Create(SkFlatController* controller, const void* obj,
         int index, void (*flattenProc)(SkOrderedWriteBuffer&, const void*)) {
     // a buffer of 256 bytes should be sufficient for most paints, regions,
@@ -22,7 +22,6 @@
 #include "SkPath.h"
 #include "SkRegion.h"
 #include "SkTRefArray.h"
-#include "SkTSearch.h"
 
 enum DrawType {
     UNUSED,
@@ -62,8 +61,9 @@ enum DrawType {
     SKEW,
     TRANSLATE,
     NOOP,
+    DRAW_RECTS,     // only written by SkPictureOptimizer
 
-    LAST_DRAWTYPE_ENUM = NOOP
+    LAST_DRAWTYPE_ENUM = DRAW_RECTS
 };
 
 // In the 'match' method, this constant will match any flavor of DRAW_BITMAP*
@@ -394,6 +394,51 @@ private:
     }
 };
 
+/**
+ * The hash table SkFlatDictionary finds its entries with: open addressing with
+ * linear probing, keyed on the SkFlatData's checksum, and grown to keep it at
+ * most half full. Entries are compared with SkFlatData::Compare, so the
+ * candidates looked up must have their sentinel set as a candidate.
+ */
+class SkFlatDataHash : SkNoncopyable {
+public:
+    SkFlatDataHash() : fCount(0) {}
+
+    int count() const { return fCount; }
+
+    void reset();
+
+    /**
+     * Returns the slot holding the entry equal to candidate, or the empty slot
+     * where candidate belongs if there is none. The slot is only valid until
+     * the table is next changed.
+     */
+    const SkFlatData** find(const SkFlatData* candidate);
+
+    /**
+     * Stores flat in the empty slot that find() returned for it.
+     */
+    void add(const SkFlatData** slot, const SkFlatData* flat);
+
+    /**
+     * Removes flat itself (not merely an equal entry) from the table. Returns
+     * false if it was not there.
+     */
+    bool remove(const SkFlatData* flat);
+
+private:
+    enum {
+        kInitialSlotCount = 64,     // must be a power of 2
+    };
+
+    int homeSlot(const SkFlatData* flat) const;
+    void grow();
+
+    // Empty slots are NULL. The count is 0 or a power of 2.
+    SkTDArray<const SkFlatData*> fSlots;
+    int fCount;
+};
+
 template <class T>
 class SkFlatDictionary {
 public:
@@ -405,7 +450,6 @@ public:
         fController->ref();
         // set to 1 since returning a zero from find() indicates failure
         fNextIndex = 1;
-        sk_bzero(fHash, sizeof(fHash));
         // index 0 is always empty since it is used as a signal that find failed
         fIndexedData.push(NULL);
     }
@@ -415,13 +459,17 @@ public:
     }
 
     int count() const {
-        SkASSERT(fIndexedData.count() == fSortedData.count()+1);
-        return fSortedData.count();
+        SkASSERT(fIndexedData.count() == fHash.count() + 1);
+        return fHash.count();
     }
 
+    /**
+     * Returns the entries in the order they were added, i.e. operator[](i) is
+     * the entry whose 1-based index is i + 1.
+     */
     const SkFlatData*  operator[](int index) const {
-        SkASSERT(index >= 0 && index < fSortedData.count());
-        return fSortedData[index];
+        SkASSERT(index >= 0 && index < this->count());
+        return fIndexedData[index + 1];
     }
 
     /**
@@ -429,12 +477,11 @@ public:
      * memory that was allocated for each entry.
      */
     void reset() {
-        fSortedData.reset();
+        fHash.reset();
         fIndexedData.rewind();
         // index 0 is always empty since it is used as a signal that find failed
         fIndexedData.push(NULL);
         fNextIndex = 1;
-        sk_bzero(fHash, sizeof(fHash));
     }
 
     /**
@@ -448,14 +495,13 @@ public:
                                      const SkFlatData* toReplace, bool* added,
                                      bool* replaced) {
         SkASSERT(added != NULL && replaced != NULL);
-        int oldCount = fSortedData.count();
+        int oldCount = this->count();
         const SkFlatData* flat = this->findAndReturnFlat(element);
-        *added = fSortedData.count() == oldCount + 1;
+        *added = this->count() == oldCount + 1;
         *replaced = false;
         if (*added && toReplace != NULL) {
-            // First, find the index of the one to replace
-            int indexToReplace = fSortedData.find(toReplace);
-            if (indexToReplace >= 0) {
+            // Remove the one to replace from the hash table, if it is there.
+            if (fHash.remove(toReplace)) {
                 // findAndReturnFlat set the index to fNextIndex and increased
                 // fNextIndex by one. Reuse the index from the one being
                 // replaced and reset fNextIndex to the proper value.
@@ -463,18 +509,11 @@ public:
                 const_cast<SkFlatData*>(flat)->setIndex(toReplace->index());
                 fIndexedData[toReplace->index()] = flat;
                 fNextIndex--;
-                // Remove from the arrays.
-                fSortedData.remove(indexToReplace);
                 fIndexedData.remove(oldIndex);
-                // Remove from the hash table.
-                int oldHash = ChecksumToHashIndex(toReplace->checksum());
-                if (fHash[oldHash] == toReplace) {
-                    fHash[oldHash] = NULL;
-                }
                 // Delete the actual object.
                 fController->unalloc((void*)toReplace);
                 *replaced = true;
-                SkASSERT(fIndexedData.count() == fSortedData.count()+1);
+                SkASSERT(fIndexedData.count() == fHash.count() + 1);
             }
         }
         return flat;
@@ -483,10 +522,10 @@ public:
     /**
      * Given an element of type T return its 1-based index in the dictionary. If
      * the element wasn't previously in the dictionary it is automatically
-     * added.
+     * added. Indices are handed out in the order elements are first added.
      *
      * To make the Compare function fast, we write a sentinel value at the end
-     * of each block. The blocks in our fSortedData[] all have a 0 sentinel. The
+     * of each block. The blocks in our fHash all have a 0 sentinel. The
      * newly created block we're comparing against has a -1 in the sentinel.
      *
      * This trick allows Compare to always loop until failure. If it fails on
@@ -501,7 +540,7 @@ public:
      *  if there no objects (instead of an empty array).
      */
     SkTRefArray<T>* unflattenToArray() const {
-        int count = fSortedData.count();
+        int count = this->count();
         SkTRefArray<T>* array = NULL;
         if (count > 0) {
             array = SkTRefArray<T>::Create(count);
@@ -514,7 +553,7 @@ public:
      * Unflatten the specific object at the given index
      */
     T* unflatten(int index) const {
-        SkASSERT(fIndexedData.count() == fSortedData.count()+1);
+        SkASSERT(fIndexedData.count() == fHash.count() + 1);
         const SkFlatData* element = fIndexedData[index];
         SkASSERT(index == element->index());
 
@@ -526,30 +565,18 @@ public:
     const SkFlatData* findAndReturnFlat(const T& element) {
         SkFlatData* flat = SkFlatData::Create(fController, &element, fNextIndex, fFlattenProc);
 
-        int hashIndex = ChecksumToHashIndex(flat->checksum());
-        const SkFlatData* candidate = fHash[hashIndex];
-        if (candidate && !SkFlatData::Compare(flat, candidate)) {
-            fController->unalloc(flat);
-            return candidate;
-        }
-
-        int index = SkTSearch<SkFlatData>((const SkFlatData**) fSortedData.begin(),
-                                          fSortedData.count(), flat, sizeof(flat),
-                                          &SkFlatData::Compare);
-        if (index >= 0) {
+        const SkFlatData** slot = fHash.find(flat);
+        if (*slot) {
             fController->unalloc(flat);
-            fHash[hashIndex] = fSortedData[index];
-            return fSortedData[index];
+            return *slot;
         }
 
-        index = ~index;
-        *fSortedData.insert(index) = flat;
         *fIndexedData.insert(flat->index()) = flat;
-        SkASSERT(fSortedData.count() == fNextIndex);
         fNextIndex++;
         flat->setSentinelInCache();
-        fHash[hashIndex] = flat;
-        SkASSERT(fIndexedData.count() == fSortedData.count()+1);
+        fHash.add(slot, flat);
+        SkASSERT(fHash.count() + 1 == fNextIndex);
+        SkASSERT(fIndexedData.count() == fHash.count() + 1);
         return flat;
     }
 
@@ -565,14 +592,12 @@ private:
     }
 
     void unflattenIntoArray(T* array) const {
-        const int count = fSortedData.count();
-        SkASSERT(fIndexedData.count() == fSortedData.count()+1);
-        const SkFlatData* const* iter = fSortedData.begin();
+        const int count = this->count();
+        SkASSERT(fIndexedData.count() == fHash.count() + 1);
         for (int i = 0; i < count; ++i) {
-            const SkFlatData* element = iter[i];
-            int index = element->index() - 1;
-            SkASSERT((unsigned)index < (unsigned)count);
-            unflatten(&array[index], element);
+            const SkFlatData* element = fIndexedData[i + 1];
+            SkASSERT(element->index() == i + 1);
+            unflatten(&array[i], element);
         }
     }
 
@@ -580,38 +605,12 @@ private:
     int                          fNextIndex;
 
     // SkFlatDictionary has two copies of the data one indexed by the
-    // SkFlatData's index and the other sorted. The sorted data is used
+    // SkFlatData's index and the other hashed. The hashed data is used
     // for finding and uniquification while the indexed copy is used
     // for standard array-style lookups based on the SkFlatData's index
     // (as in 'unflatten').
     SkTDArray<const SkFlatData*> fIndexedData;
-    // fSortedData is sorted by checksum/size/data.
-    SkTDArray<const SkFlatData*> fSortedData;
-
-    enum {
-        // Determined by trying diff values on picture-recording benchmarks
-        // (e.g. PictureRecordBench.cpp), choosing the smallest value that
-        // showed a big improvement. Even better would be to benchmark diff
-        // values on recording representative web-pages or other "real" content.
-        HASH_BITS   = 7,
-        HASH_MASK   = (1 << HASH_BITS) - 1,
-        HASH_COUNT  = 1 << HASH_BITS
-    };
-    const SkFlatData* fHash[HASH_COUNT];
-
-    static int ChecksumToHashIndex(uint32_t checksum) {
-        int n = checksum;
-        if (HASH_BITS < 32) {
-            n ^= n >> 16;
-        }
-        if (HASH_BITS < 16) {
-            n ^= n >> 8;
-        }
-        if (HASH_BITS < 8) {
-            n ^= n >> 4;
-        }
-        return n & HASH_MASK;
-    }
+    SkFlatDataHash fHash;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -653,6 +652,9 @@ public:
         fTypefacePlayback.reset(fTypefaceSet);
     }
 
+    // For readers of the flattened data that outlive the controller
+    const SkRefCntSet* typefaceSet() const { return fTypefaceSet; }
+
     void setBitmapStorage(SkBitmapHeap* heap) {
         this->setBitmapHeap(heap);
     }
@@ -0,0 +1,536 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkPictureOptimizer.h"
+#include "SkCanvas.h"
+#include "SkPictureRecord.h"
+#include "SkXfermode.h"
+
+// Draws are only compared against this many earlier draws when looking for occlusion, which
+// keeps the pass linear on long runs of draws that never get covered.
+static const int kMaxOcclusionCandidates = 32;
+
+// Keeps a DRAW_RECTS op's size well inside the op code's 24 bit size field
+static const int kMaxBatchedRects = 1 << 16;
+
+int SkPictureOptimizer::Stats::removedOps() const {
+    // Each batch of rects replaces fBatchedRects ops with a single one
+    return fFoldedTranslates + 2 * fRemovedSaves + fCulledDraws + fBatchedRects - fRectBatches;
+}
+
+SkPictureOptimizer::SkPictureOptimizer(void* ops, size_t size,
+                                       const SkLazyFlatArray<SkPaint>* paints,
+                                       const SkLazyFlatArray<SkBitmap>* bitmaps,
+                                       const SkLazyFlatArray<SkPath>* paths)
+    : fOps(static_cast<char*>(ops))
+    , fSize(size)
+    , fPaints(paints)
+    , fBitmaps(bitmaps)
+    , fPaths(paths) {
+    SkASSERT(SkAlign4(size) == size);
+
+    uint32_t offset = 0;
+    SkTDArray<int> saveStack;
+    while (offset < fSize) {
+        Op* op = fOpList.append();
+        uint32_t packed = *this->at<uint32_t>(offset);
+        uint32_t type;
+        UNPACK_8_24(packed, type, op->fSize);
+        op->fType = (DrawType) type;
+        op->fOffset = offset;
+        op->fArgs = offset + sizeof(uint32_t);
+        if (MASK_24 == op->fSize) {
+            // size required its own slot right after the op code
+            op->fSize = *this->at<uint32_t>(op->fArgs);
+            op->fArgs += sizeof(uint32_t);
+        }
+        if (op->fSize < op->fArgs - offset || op->fSize > fSize - offset ||
+            type > LAST_DRAWTYPE_ENUM) {
+            // Not a stream we understand, so leave it alone
+            SkDEBUGFAIL("Malformed picture op stream");
+            fOpList.reset();
+            fMatchingSave.reset();
+            return;
+        }
+        offset += op->fSize;
+
+        int* matchingSave = fMatchingSave.append();
+        *matchingSave = -1;
+        if (SAVE == op->fType || SAVE_LAYER == op->fType) {
+            *saveStack.append() = fOpList.count() - 1;
+        } else if (RESTORE == op->fType && saveStack.count() > 0) {
+            saveStack.pop(matchingSave);
+        }
+    }
+}
+
+void SkPictureOptimizer::optimize(Stats* stats) {
+    Stats localStats;
+    if (NULL == stats) {
+        stats = &localStats;
+    }
+    for (int i = 0; i < fOpList.count(); ++i) {
+        if (NOOP != fOpList[i].fType) {
+            ++stats->fOpCount;
+        }
+    }
+
+    // Folding translates first leaves more saves empty, and removing those leaves longer runs
+    // of draws in one clip/matrix state for the occlusion and batching passes to work on.
+    this->foldTranslates(stats);
+    this->removeDeadSaves(stats);
+    this->cullOccludedDraws(stats);
+    this->batchRects(stats);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Convert the op at 'index' to a NOOP. Leave the size field alone so the NOOP can be skipped
+ * later.
+ */
+void SkPictureOptimizer::convertToNoop(int index) {
+    Op& op = fOpList[index];
+    uint32_t* ptr = this->at<uint32_t>(op.fOffset);
+    *ptr = (*ptr & MASK_24) | (NOOP << 24);
+    op.fType = NOOP;
+}
+
+void SkPictureOptimizer::writeOpHeader(uint32_t offset, DrawType type, uint32_t size) {
+    if (size >= MASK_24) {
+        *this->at<uint32_t>(offset) = PACK_8_24(type, MASK_24);
+        *this->at<uint32_t>(offset + sizeof(uint32_t)) = size;
+    } else {
+        *this->at<uint32_t>(offset) = PACK_8_24(type, size);
+    }
+}
+
+const SkPaint* SkPictureOptimizer::getPaint(const Op& op) const {
+    // Every op this pass looks at stores its paint index right after the op code
+    uint32_t index = *this->at<uint32_t>(op.fArgs);
+    if (0 == index || NULL == fPaints || index > (uint32_t)fPaints->count()) {
+        return NULL;
+    }
+    return &(*fPaints)[index - 1];
+}
+
+uint32_t SkPictureOptimizer::getSaveFlags(const Op& op) const {
+    if (SAVE == op.fType) {
+        return *this->at<uint32_t>(op.fArgs);
+    }
+    // SAVE_LAYER's flags follow its optional bounds and its paint, so they are the last field
+    SkASSERT(SAVE_LAYER == op.fType);
+    return *this->at<uint32_t>(op.fOffset + op.fSize - sizeof(uint32_t));
+}
+
+// Can the paint be used with its geometry moved, instead of with the canvas translated?
+static bool is_translation_invariant(const SkPaint* paint) {
+    if (NULL == paint) {
+        return true;
+    }
+    // Shaders and 2D path effects are positioned in local coordinates, and loopers and image
+    // filters are free to look at the matrix.
+    intptr_t orAccum = (intptr_t)paint->getShader()      |
+                       (intptr_t)paint->getPathEffect()  |
+                       (intptr_t)paint->getLooper()      |
+                       (intptr_t)paint->getImageFilter() |
+                       (intptr_t)paint->getRasterizer();
+    return 0 == orAccum;
+}
+
+bool SkPictureOptimizer::canOffsetDraw(const Op& op) const {
+    switch (op.fType) {
+        case DRAW_BITMAP:
+        case DRAW_BITMAP_RECT_TO_RECT:
+        case DRAW_OVAL:
+        case DRAW_RECT:
+        case DRAW_RRECT:
+        case DRAW_TEXT:
+        case DRAW_TEXT_TOP_BOTTOM:
+            return is_translation_invariant(this->getPaint(op));
+        default:
+            return false;
+    }
+}
+
+void SkPictureOptimizer::offsetDraw(const Op& op, SkScalar dx, SkScalar dy) {
+    // skip the paint index
+    uint32_t offset = op.fArgs + sizeof(uint32_t);
+    switch (op.fType) {
+        case DRAW_BITMAP: {
+            // bitmap index, then left and top
+            SkPoint* loc = this->at<SkPoint>(offset + sizeof(uint32_t));
+            loc->offset(dx, dy);
+        } break;
+        case DRAW_BITMAP_RECT_TO_RECT: {
+            // bitmap index, then the optional src rect, then dst
+            offset += sizeof(uint32_t);
+            if (*this->at<uint32_t>(offset)) {
+                offset += sizeof(SkRect);
+            }
+            this->at<SkRect>(offset + sizeof(uint32_t))->offset(dx, dy);
+        } break;
+        case DRAW_OVAL:
+        case DRAW_RECT:
+        case DRAW_RRECT:
+            // An rrect is stored as its rect followed by its radii
+            this->at<SkRect>(offset)->offset(dx, dy);
+            break;
+        case DRAW_TEXT:
+        case DRAW_TEXT_TOP_BOTTOM: {
+            // byte length, then the padded text, then x and y (and top and bottom)
+            offset += sizeof(uint32_t) + SkAlign4(*this->at<uint32_t>(offset));
+            SkScalar* ptr = this->at<SkScalar>(offset);
+            ptr[0] += dx;
+            ptr[1] += dy;
+            if (DRAW_TEXT_TOP_BOTTOM == op.fType) {
+                ptr[2] += dy;
+                ptr[3] += dy;
+            }
+        } break;
+        default:
+            SkASSERT(0);
+    }
+}
+
+/*
+ * Look for a translate that is undone, either by the restore that closes its save level or by
+ * translates that sum back to zero, with nothing but draws that can be moved in between:
+ *   SAVE
+ *       TRANSLATE
+ *       DRAW_RECT|DRAW_OVAL|DRAW_RRECT|DRAW_BITMAP|DRAW_BITMAP_RECT_TO_RECT|DRAW_TEXT*
+ *       ...
+ *   RESTORE
+ * and move those draws instead. Returns the index of the last op that was looked at.
+ */
+int SkPictureOptimizer::foldTranslateAt(int index, Stats* stats) {
+    SkScalar dx = 0;
+    SkScalar dy = 0;
+    SkTDArray<int> translates;
+    SkTDArray<int> draws;
+    SkTDArray<SkPoint> drawOffsets;
+
+    int i;
+    for (i = index; i < fOpList.count(); ++i) {
+        const Op& op = fOpList[i];
+        if (NOOP == op.fType) {
+            continue;
+        }
+        if (TRANSLATE == op.fType) {
+            const SkScalar* args = this->at<SkScalar>(op.fArgs);
+            dx += args[0];
+            dy += args[1];
+            *translates.append() = i;
+            if (0 == dx && 0 == dy) {
+                break;
+            }
+        } else if (RESTORE == op.fType) {
+            int save = fMatchingSave[i];
+            if (save < 0 || !(this->getSaveFlags(fOpList[save]) & SkCanvas::kMatrix_SaveFlag)) {
+                return i;
+            }
+            break;
+        } else if (this->canOffsetDraw(op)) {
+            *draws.append() = i;
+            drawOffsets.append()->set(dx, dy);
+        } else {
+            return i;
+        }
+    }
+    if (i == fOpList.count()) {
+        // The translate is still in effect at the end of the picture
+        return i;
+    }
+
+    for (int j = 0; j < draws.count(); ++j) {
+        this->offsetDraw(fOpList[draws[j]], drawOffsets[j].fX, drawOffsets[j].fY);
+    }
+    for (int j = 0; j < translates.count(); ++j) {
+        this->convertToNoop(translates[j]);
+    }
+    stats->fFoldedTranslates += translates.count();
+    return i;
+}
+
+void SkPictureOptimizer::foldTranslates(Stats* stats) {
+    for (int i = 0; i < fOpList.count(); ++i) {
+        if (TRANSLATE == fOpList[i].fType) {
+            i = this->foldTranslateAt(i, stats);
+        }
+    }
+}
+
+/*
+ * Remove SAVE/RESTORE pairs that enclose no clip or matrix change. Nested pairs restore
+ * their own changes, so they only dirty the enclosing save if their flags let the changes
+ * through. saveLayers are never removed, since their restore composites the layer.
+ */
+namespace {
+struct SaveRec {
+    int fIndex;
+    bool fDirty;
+};
+}
+
+void SkPictureOptimizer::removeDeadSaves(Stats* stats) {
+    SkTDArray<SaveRec> stack;
+
+    for (int i = 0; i < fOpList.count(); ++i) {
+        switch (fOpList[i].fType) {
+            case SAVE:
+            case SAVE_LAYER: {
+                SaveRec* rec = stack.append();
+                rec->fIndex = i;
+                rec->fDirty = false;
+            } break;
+            case CLIP_PATH:
+            case CLIP_REGION:
+            case CLIP_RECT:
+            case CLIP_RRECT:
+            case CONCAT:
+            case ROTATE:
+            case SCALE:
+            case SET_MATRIX:
+            case SKEW:
+            case TRANSLATE:
+                if (stack.count() > 0) {
+                    stack.top().fDirty = true;
+                }
+                break;
+            case RESTORE: {
+                if (stack.count() == 0 || fMatchingSave[i] != stack.top().fIndex) {
+                    break;
+                }
+                SaveRec rec;
+                stack.pop(&rec);
+                const Op& save = fOpList[rec.fIndex];
+                if (!rec.fDirty) {
+                    if (SAVE == save.fType) {
+                        this->convertToNoop(rec.fIndex);
+                        this->convertToNoop(i);
+                        ++stats->fRemovedSaves;
+                    }
+                } else if (stack.count() > 0 &&
+                           (this->getSaveFlags(save) & SkCanvas::kMatrixClip_SaveFlag) !=
+                           SkCanvas::kMatrixClip_SaveFlag) {
+                    stack.top().fDirty = true;
+                }
+            } break;
+            default:
+                break;
+        }
+    }
+}
+
+// Does drawing a rect with this paint replace every pixel the rect's (non-AA) coverage hits?
+static bool is_opaque_fill(const SkPaint* paint) {
+    if (NULL == paint || paint->isAntiAlias() || paint->getAlpha() != 0xFF ||
+        SkPaint::kFill_Style != paint->getStyle()) {
+        return false;
+    }
+    intptr_t orAccum = (intptr_t)paint->getShader()      |
+                       (intptr_t)paint->getColorFilter() |
+                       (intptr_t)paint->getMaskFilter()  |
+                       (intptr_t)paint->getPathEffect()  |
+                       (intptr_t)paint->getLooper()      |
+                       (intptr_t)paint->getImageFilter() |
+                       (intptr_t)paint->getRasterizer();
+    if (0 != orAccum) {
+        return false;
+    }
+    SkXfermode::Mode mode;
+    return SkXfermode::AsMode(paint->getXfermode(), &mode) &&
+           (SkXfermode::kSrcOver_Mode == mode || SkXfermode::kSrc_Mode == mode);
+}
+
+/*
+ * Compute the local bounds of everything 'op' may touch, for ops that may be dropped when
+ * covered. Anti-aliased and hairline draws touch pixels outside their geometry in a way that
+ * depends on the device matrix, so they are never considered.
+ */
+bool SkPictureOptimizer::getDrawBounds(const Op& op, SkRect* bounds) const {
+    uint32_t offset = op.fArgs + sizeof(uint32_t);
+    switch (op.fType) {
+        case DRAW_OVAL:
+        case DRAW_RECT:
+        case DRAW_RRECT:
+            *bounds = *this->at<SkRect>(offset);
+            break;
+        case DRAW_PATH: {
+            uint32_t index = *this->at<uint32_t>(offset);
+            if (NULL == fPaths || 0 == index || index > (uint32_t)fPaths->count()) {
+                return false;
+            }
+            const SkPath& path = (*fPaths)[index - 1];
+            if (path.isInverseFillType()) {
+                return false;
+            }
+            *bounds = path.getBounds();
+        } break;
+        case DRAW_BITMAP:
+        case DRAW_BITMAP_RECT_TO_RECT: {
+            int index = *this->at<int32_t>(offset);
+            if (NULL == fBitmaps || index < 0 || index >= fBitmaps->count()) {
+                return false;
+            }
+            offset += sizeof(uint32_t);
+            if (DRAW_BITMAP == op.fType) {
+                const SkBitmap& bitmap = (*fBitmaps)[index];
+                const SkPoint& loc = *this->at<SkPoint>(offset);
+                bounds->setXYWH(loc.fX, loc.fY,
+                                SkIntToScalar(bitmap.width()), SkIntToScalar(bitmap.height()));
+            } else {
+                if (*this->at<uint32_t>(offset)) {
+                    offset += sizeof(SkRect);
+                }
+                *bounds = *this->at<SkRect>(offset + sizeof(uint32_t));
+            }
+        } break;
+        default:
+            return false;
+    }
+
+    const SkPaint* paint = this->getPaint(op);
+    if (NULL == paint) {
+        // only the bitmap draws allow a NULL paint
+        return DRAW_BITMAP == op.fType || DRAW_BITMAP_RECT_TO_RECT == op.fType;
+    }
+    if (paint->isAntiAlias() || NULL != paint->getLooper() || NULL != paint->getImageFilter() ||
+        !paint->canComputeFastBounds()) {
+        return false;
+    }
+    if (SkPaint::kFill_Style != paint->getStyle() && 0 == paint->getStrokeWidth()) {
+        return false;
+    }
+    *bounds = paint->computeFastBounds(*bounds, bounds);
+    return true;
+}
+
+/*
+ * Within a run of draws that share one clip/matrix state, drop any draw whose bounds lie inside
+ * a later, non-AA, opaque rect (or under a later opaque drawPaint): that rect overwrites every
+ * pixel the draw could have touched, whatever was drawn in between.
+ */
+namespace {
+struct OcclusionCandidate {
+    int fIndex;
+    SkRect fBounds;
+};
+}
+
+void SkPictureOptimizer::cullOccludedDraws(Stats* stats) {
+    SkTDArray<OcclusionCandidate> candidates;
+
+    for (int i = 0; i < fOpList.count(); ++i) {
+        const Op& op = fOpList[i];
+        switch (op.fType) {
+            case CLIP_PATH:
+            case CLIP_REGION:
+            case CLIP_RECT:
+            case CLIP_RRECT:
+            case CONCAT:
+            case RESTORE:
+            case ROTATE:
+            case SAVE:
+            case SAVE_LAYER:
+            case SCALE:
+            case SET_MATRIX:
+            case SKEW:
+            case TRANSLATE:
+                candidates.rewind();
+                continue;
+            case DRAW_PAINT:
+                if (is_opaque_fill(this->getPaint(op))) {
+                    for (int j = 0; j < candidates.count(); ++j) {
+                        this->convertToNoop(candidates[j].fIndex);
+                    }
+                    stats->fCulledDraws += candidates.count();
+                    candidates.rewind();
+                }
+                continue;
+            case DRAW_RECT:
+                if (is_opaque_fill(this->getPaint(op))) {
+                    const SkRect& rect = *this->at<SkRect>(op.fArgs + sizeof(uint32_t));
+                    for (int j = candidates.count() - 1; j >= 0; --j) {
+                        if (rect.contains(candidates[j].fBounds)) {
+                            this->convertToNoop(candidates[j].fIndex);
+                            ++stats->fCulledDraws;
+                            candidates.remove(j);
+                        }
+                    }
+                }
+                break;
+            default:
+                break;
+        }
+
+        SkRect bounds;
+        if (this->getDrawBounds(op, &bounds)) {
+            if (candidates.count() == kMaxOcclusionCandidates) {
+                candidates.remove(0);
+            }
+            OcclusionCandidate* candidate = candidates.append();
+            candidate->fIndex = i;
+            candidate->fBounds = bounds;
+        }
+    }
+}
+
+/*
+ * Rewrite each run of two or more DRAW_RECTs that use the same paint (ignoring NOOPs in between)
+ * as a single DRAW_RECTS, followed by a NOOP that pads it out to the run's original size. This
+ * is the last pass, since it leaves fOpList out of step with the stream.
+ */
+void SkPictureOptimizer::batchRects(Stats* stats) {
+    SkTDArray<int> run;
+    for (int i = 0; i < fOpList.count(); ++i) {
+        if (DRAW_RECT != fOpList[i].fType) {
+            continue;
+        }
+        const uint32_t paintIndex = *this->at<uint32_t>(fOpList[i].fArgs);
+        run.rewind();
+        *run.append() = i;
+        for (int j = i + 1; j < fOpList.count() && run.count() < kMaxBatchedRects; ++j) {
+            const Op& op = fOpList[j];
+            if (DRAW_RECT == op.fType && *this->at<uint32_t>(op.fArgs) == paintIndex) {
+                *run.append() = j;
+            } else if (NOOP != op.fType) {
+                break;
+            }
+        }
+        if (run.count() < 2) {
+            continue;
+        }
+
+        // op + paint index + count + rects
+        const uint32_t start = fOpList[i].fOffset;
+        const Op& last = fOpList[run.top()];
+        const uint32_t end = last.fOffset + last.fSize;
+        const uint32_t size = 3 * sizeof(uint32_t) + run.count() * sizeof(SkRect);
+        SkASSERT(size < MASK_24 && start + size <= end);
+
+        // Each rect moves toward the start of the run, and never past the rect after it, so
+        // moving them in order never overwrites one that is still to be read.
+        for (int k = 0; k < run.count(); ++k) {
+            memmove(fOps + start + 3 * sizeof(uint32_t) + k * sizeof(SkRect),
+                    fOps + fOpList[run[k]].fArgs + sizeof(uint32_t), sizeof(SkRect));
+        }
+        this->writeOpHeader(start, DRAW_RECTS, size);
+        *this->at<uint32_t>(start + sizeof(uint32_t)) = paintIndex;
+        *this->at<uint32_t>(start + 2 * sizeof(uint32_t)) = run.count();
+        if (end > start + size) {
+            this->writeOpHeader(start + size, NOOP, end - (start + size));
+        }
+
+        for (int k = 0; k < run.count(); ++k) {
+            fOpList[run[k]].fType = NOOP;
+        }
+        stats->fBatchedRects += run.count();
+        ++stats->fRectBatches;
+        i = run.top();
+    }
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkPictureOptimizer_DEFINED
+#define SkPictureOptimizer_DEFINED
+
+#include "SkLazyFlatArray.h"
+#include "SkPictureFlat.h"
+#include "SkTDArray.h"
+
+/**
+ * A peephole pass over the complete op stream of a finished picture. SkPictureRecord already
+ * rewrites a few patterns as it records, but it can only look back from the current restore();
+ * this pass sees the whole stream, and so can also look ahead. It:
+ *
+ *   - folds translates into the coordinates of the draws they apply to, when the translate is
+ *     undone by a restore or by the opposite translate,
+ *   - removes save/restore pairs that no longer enclose any clip or matrix change,
+ *   - removes draws that are completely covered by a later opaque rect drawn in the same
+ *     clip/matrix state,
+ *   - merges runs of drawRects that share a paint into a single DRAW_RECTS op.
+ *
+ * Every rewrite happens in place: removed ops become NOOPs of the same size and merged ops are
+ * followed by NOOP padding, so the offsets that clip ops store to their restores stay valid.
+ * The offsets held by an SkPictureStateTree do not survive the rewrites, so the pass must not
+ * be run on pictures recorded with a bounding box hierarchy.
+ */
+class SkPictureOptimizer {
+public:
+    struct Stats {
+        Stats() { sk_bzero(this, sizeof(*this)); }
+
+        int fOpCount;           // ops in the stream before optimizing, excluding NOOPs
+        int fFoldedTranslates;
+        int fRemovedSaves;      // save/restore pairs
+        int fCulledDraws;
+        int fBatchedRects;      // drawRects merged into a DRAW_RECTS
+        int fRectBatches;       // DRAW_RECTS ops written
+
+        // Total number of ops the pass removed from the stream
+        int removedOps() const;
+    };
+
+    /**
+     * 'ops' is the writable op stream of 'size' bytes. 'paints', 'bitmaps' and 'paths' are the
+     * playback's arrays that the stream's indices refer to; any of them may be NULL if the stream
+     * does not reference them.
+     */
+    SkPictureOptimizer(void* ops, size_t size,
+                       const SkLazyFlatArray<SkPaint>* paints,
+                       const SkLazyFlatArray<SkBitmap>* bitmaps,
+                       const SkLazyFlatArray<SkPath>* paths);
+
+    /**
+     * Runs all the passes over the stream. If 'stats' is not NULL it is filled in with what
+     * was changed.
+     */
+    void optimize(Stats* stats = NULL);
+
+private:
+    struct Op {
+        DrawType fType;
+        uint32_t fOffset;   // of the op code
+        uint32_t fSize;     // of the whole op, including the op code
+        uint32_t fArgs;     // offset of the first argument
+    };
+
+    void foldTranslates(Stats*);
+    void removeDeadSaves(Stats*);
+    void cullOccludedDraws(Stats*);
+    void batchRects(Stats*);
+
+    int foldTranslateAt(int index, Stats*);
+
+    void convertToNoop(int index);
+    void writeOpHeader(uint32_t offset, DrawType type, uint32_t size);
+
+    const SkPaint* getPaint(const Op& op) const;
+    bool getDrawBounds(const Op& op, SkRect* bounds) const;
+    bool canOffsetDraw(const Op& op) const;
+    void offsetDraw(const Op& op, SkScalar dx, SkScalar dy);
+    uint32_t getSaveFlags(const Op& op) const;
+
+    template <typename T> T* at(uint32_t offset) const {
+        SkASSERT(SkAlign4(offset) == offset && offset + sizeof(T) <= fSize);
+        return reinterpret_cast<T*>(fOps + offset);
+    }
+
+    char*                               fOps;
+    size_t                              fSize;
+    const SkLazyFlatArray<SkPaint>*     fPaints;
+    const SkLazyFlatArray<SkBitmap>*    fBitmaps;
+    const SkLazyFlatArray<SkPath>*      fPaths;
+
+    SkTDArray<Op>                       fOpList;
+    // For each RESTORE in fOpList, the index of its matching SAVE or SAVE_LAYER (-1 if none)
+    SkTDArray<int>                      fMatchingSave;
+};
+
+#endif
@@ -12,6 +12,7 @@
 #include "SkOrderedWriteBuffer.h"
 #include <new>
 #include "SkBBoxHierarchy.h"
+#include "SkPictureOptimizer.h"
 #include "SkPictureStateTree.h"
 #include "SkTSort.h"
 
@@ -24,10 +25,82 @@ template <typename T> int SafeCount(const T* obj) {
  */
 #define SPEW_CLIP_SKIPPINGx
 
+/*  Define this to spew out what the SkPictureOptimizer pass did to each recorded picture.
+ */
+#define SPEW_OPTIMIZER_STATSx
+
 SkPicturePlayback::SkPicturePlayback() {
     this->init();
 }
 
+/*  Wraps the paths of a recording. Their cached bounds and convexity are computed now, as
+    read_path() does for paths read from a stream, so that concurrent draws only read them.
+ */
+static SkLazyFlatArray<SkPath>* wrap_paths(SkPathHeap* heap) {
+    if (NULL == heap) {
+        return NULL;
+    }
+    SkAutoTMalloc<const SkPath*> paths(heap->count());
+    for (int i = 0; i < heap->count(); i++) {
+        const SkPath& path = (*heap)[i];
+        path.updateBoundsCache();
+        path.getConvexity();
+        paths[i] = &path;
+    }
+    return SkNEW_ARGS(SkLazyFlatArray<SkPath>, (paths.get(), heap->count(), heap));
+}
+
+// The lazy arrays' unflatten procs. Those that fill in cached values (matrix types, path
+// bounds, etc.) do so now, while the array is locked, so that concurrent draws only read them.
+
+static void read_bitmap(SkOrderedReadBuffer& buffer, SkBitmap* bitmap) {
+    buffer.readBitmap(bitmap);
+    bitmap->setImmutable();
+}
+
+static void read_matrix(SkOrderedReadBuffer& buffer, SkMatrix* matrix) {
+    buffer.readMatrix(matrix);
+    matrix->getType();
+}
+
+static void read_paint(SkOrderedReadBuffer& buffer, SkPaint* paint) {
+    buffer.readPaint(paint);
+}
+
+static void read_path(SkOrderedReadBuffer& buffer, SkPath* path) {
+    buffer.readPath(path);
+    path->updateBoundsCache();
+    path->getConvexity();
+}
+
+/*  Copies the flattened entries of one of a recording's dictionaries into a block of their own,
+    from which each entry is unflattened the first time it is used. The recording, which owns
+    the dictionary, goes away as soon as the playback is made.
+ */
+template <typename T>
+static SkLazyFlatArray<T>* copy_flattened(const SkFlatDictionary<T>& dictionary,
+                                          SkFlatReadContext* context,
+                                          typename SkLazyFlatArray<T>::UnflattenProc proc) {
+    const int count = dictionary.count();
+    if (0 == count) {
+        return NULL;
+    }
+    SkAutoTMalloc<uint32_t> offsets(count + 1);
+    size_t size = 0;
+    for (int i = 0; i < count; i++) {
+        offsets[i] = size;
+        size += dictionary[i]->flatSize();
+    }
+    offsets[count] = size;
+
+    char* storage = (char*)sk_malloc_throw(size);
+    for (int i = 0; i < count; i++) {
+        memcpy(storage + offsets[i], dictionary[i]->data(), dictionary[i]->flatSize());
+    }
+    SkAutoTUnref<SkData> data(SkData::NewFromMalloc(storage, size));
+    return SkNEW_ARGS(SkLazyFlatArray<T>, (data, offsets.get(), count, context, proc));
+}
+
 SkPicturePlayback::SkPicturePlayback(const SkPictureRecord& record, bool deepCopy) {
 #ifdef SK_DEBUG_SIZE
     size_t overallBytes, bitmapBytes, matricesBytes,
@@ -82,33 +155,48 @@ SkPicturePlayback::SkPicturePlayback(const SkPictureRecord& record, bool deepCop
 
     if (NULL != fBoundingHierarchy) {
         fBoundingHierarchy->flushDeferredInserts();
+        fCullOccludedDraws =
+            SkToBool(record.fRecordFlags & SkPicture::kCullOccludedDraws_RecordingFlag);
     }
 
-    {
-        size_t size = writer.size();
-        void* buffer = sk_malloc_throw(size);
-        writer.flatten(buffer);
-        SkASSERT(!fOpData);
-        fOpData = SkData::NewFromMalloc(buffer, size);
-    }
+    size_t opSize = writer.size();
+    void* opBuffer = sk_malloc_throw(opSize);
+    writer.flatten(opBuffer);
 
     // copy over the refcnt dictionary to our reader
     record.fFlattenableHeap.setupPlaybacks();
 
-    fBitmaps = record.fBitmapHeap->extractBitmaps();
-    fMatrices = record.fMatrices.unflattenToArray();
-    fPaints = record.fPaints.unflattenToArray();
+    // The bitmaps and paths are kept by the recording as they are, so are only wrapped
+    SkAutoTUnref<SkTRefArray<SkBitmap> > bitmaps(record.fBitmapHeap->extractBitmaps());
+    fBitmaps = SkLazyFlatArray<SkBitmap>::Wrap(bitmaps);
+    fPaths = wrap_paths(record.fPathHeap);
     fRegions = record.fRegions.unflattenToArray();
 
     fBitmapHeap.reset(SkSafeRef(record.fBitmapHeap));
-    fPathHeap.reset(SkSafeRef(record.fPathHeap));
-
-    // ensure that the paths bounds are pre-computed
-    if (fPathHeap.get()) {
-        for (int i = 0; i < fPathHeap->count(); i++) {
-            (*fPathHeap)[i].updateBoundsCache();
-        }
+    fReadContext.reset(SkNEW(SkFlatReadContext));
+    fReadContext->fTFPlayback.reset(record.fFlattenableHeap.typefaceSet());
+    fReadContext->fBitmapStorage = SkSafeRef(record.fBitmapHeap);
+    fMatrices = copy_flattened(record.fMatrices, fReadContext, &read_matrix);
+    fPaints = copy_flattened(record.fPaints, fReadContext, &read_paint);
+
+    // The state tree holds offsets of individual ops, which the optimizer's rewrites would
+    // leave pointing at the wrong thing.
+    if (NULL == fStateTree &&
+        !(record.fRecordFlags & SkPicture::kDisableRecordOptimizations_RecordingFlag)) {
+        SkPictureOptimizer optimizer(opBuffer, opSize, fPaints, fBitmaps, fPaths);
+#ifdef SPEW_OPTIMIZER_STATS
+        SkPictureOptimizer::Stats stats;
+        optimizer.optimize(&stats);
+        SkDebugf("--- Optimized %d of %d ops away: translates:%d saves:%d culled:%d "
+                 "rects:%d (in %d batches)\n", stats.removedOps(), stats.fOpCount,
+                 stats.fFoldedTranslates, stats.fRemovedSaves, stats.fCulledDraws,
+                 stats.fBatchedRects, stats.fRectBatches);
+#else
+        optimizer.optimize();
+#endif
     }
+    SkASSERT(!fOpData);
+    fOpData = SkData::NewFromMalloc(opBuffer, opSize);
 
     const SkTDArray<SkPicture* >& pictures = record.getPictureRefs();
     fPictureCount = pictures.count();
@@ -164,11 +252,56 @@ static bool needs_deep_copy(const SkPaint& paint) {
            paint.getImageFilter();
 }
 
+/*  Readies 'info' to hold the flattened paints that need_deep_copy(), from which any number of
+    private copies can then be unflattened. See copy_data().
+ */
+static void init_copy_info(SkPictCopyInfo* info, int paintCount, SkBitmapHeap* bitmapHeap) {
+    SkASSERT(!info->initialized);
+
+    /* The alternative to doing this is to have a clone method on the paint and have it make
+     * the deep copy of its internal structures as needed. The holdup to doing that is at
+     * this point we would need to pass the SkBitmapHeap so that we don't unnecessarily
+     * flatten the pixels in a bitmap shader.
+     */
+    info->paintData.setCount(paintCount);
+    sk_bzero(info->paintData.begin(), paintCount * sizeof(SkFlatData*));
+
+    /* Use an SkBitmapHeap to avoid flattening bitmaps in shaders. If there already is one,
+     * use it. If this SkPicturePlayback was created from a stream, fBitmapHeap will be
+     * NULL, so create a new one.
+     */
+    if (NULL == bitmapHeap) {
+        // FIXME: Put this on the stack inside SkPicture::clone. Further, is it possible to
+        // do the rest of this initialization in SkPicture::clone as well?
+        SkBitmapHeap* heap = SkNEW(SkBitmapHeap);
+        info->controller.setBitmapStorage(heap);
+        heap->unref();
+    } else {
+        info->controller.setBitmapStorage(bitmapHeap);
+    }
+
+    info->initialized = true;
+}
+
+/*  Returns the flattened copy of paint, which is the index'th of the picture and
+    needs_deep_copy(), flattening it into 'info' if this is the first time it is asked for.
+ */
+static const SkFlatData* copy_data(SkPictCopyInfo* info, int index, const SkPaint& paint) {
+    SkASSERT(info->initialized && needs_deep_copy(paint));
+    if (NULL == info->paintData[index]) {
+        info->paintData[index] = SkFlatData::Create(&info->controller, &paint, 0,
+                                                    &SkFlattenObjectProc<SkPaint>);
+        // needed to create typeface playback
+        info->controller.setupPlaybacks();
+    }
+    return info->paintData[index];
+}
+
 SkPicturePlayback::SkPicturePlayback(const SkPicturePlayback& src, SkPictCopyInfo* deepCopyInfo) {
     this->init();
 
     fBitmapHeap.reset(SkSafeRef(src.fBitmapHeap.get()));
-    fPathHeap.reset(SkSafeRef(src.fPathHeap.get()));
+    fPaths = SkSafeRef(src.fPaths);
 
     fMatrices = SkSafeRef(src.fMatrices);
     fRegions = SkSafeRef(src.fRegions);
@@ -176,6 +309,7 @@ SkPicturePlayback::SkPicturePlayback(const SkPicturePlayback& src, SkPictCopyInf
 
     fBoundingHierarchy = src.fBoundingHierarchy;
     fStateTree = src.fStateTree;
+    fCullOccludedDraws = src.fCullOccludedDraws;
 
     SkSafeRef(fBoundingHierarchy);
     SkSafeRef(fStateTree);
@@ -183,64 +317,37 @@ SkPicturePlayback::SkPicturePlayback(const SkPicturePlayback& src, SkPictCopyInf
     if (deepCopyInfo) {
         int paintCount = SafeCount(src.fPaints);
 
-        if (src.fBitmaps) {
-            fBitmaps = SkTRefArray<SkBitmap>::Create(src.fBitmaps->begin(), src.fBitmaps->count());
+        // Locking a bitmap's pixels writes to it, so the clone needs bitmaps of its own
+        const int bitmapCount = SafeCount(src.fBitmaps);
+        if (bitmapCount > 0) {
+            SkAutoTUnref<SkTRefArray<SkBitmap> > bitmaps(
+                SkTRefArray<SkBitmap>::Create(bitmapCount));
+            for (int i = 0; i < bitmapCount; i++) {
+                bitmaps->writableAt(i) = src.fBitmaps->at(i);
+            }
+            fBitmaps = SkLazyFlatArray<SkBitmap>::Wrap(bitmaps);
         }
 
         if (!deepCopyInfo->initialized) {
-            /* The alternative to doing this is to have a clone method on the paint and have it make
-             * the deep copy of its internal structures as needed. The holdup to doing that is at
-             * this point we would need to pass the SkBitmapHeap so that we don't unnecessarily
-             * flatten the pixels in a bitmap shader.
-             */
-            deepCopyInfo->paintData.setCount(paintCount);
-
-            /* Use an SkBitmapHeap to avoid flattening bitmaps in shaders. If there already is one,
-             * use it. If this SkPicturePlayback was created from a stream, fBitmapHeap will be
-             * NULL, so create a new one.
-             */
-            if (fBitmapHeap.get() == NULL) {
-                // FIXME: Put this on the stack inside SkPicture::clone. Further, is it possible to
-                // do the rest of this initialization in SkPicture::clone as well?
-                SkBitmapHeap* heap = SkNEW(SkBitmapHeap);
-                deepCopyInfo->controller.setBitmapStorage(heap);
-                heap->unref();
-            } else {
-                deepCopyInfo->controller.setBitmapStorage(fBitmapHeap);
-            }
-
-            SkDEBUGCODE(int heapSize = SafeCount(fBitmapHeap.get());)
-            for (int i = 0; i < paintCount; i++) {
-                if (needs_deep_copy(src.fPaints->at(i))) {
-                    deepCopyInfo->paintData[i] = SkFlatData::Create(&deepCopyInfo->controller,
-                                                                    &src.fPaints->at(i), 0,
-                                                                    &SkFlattenObjectProc<SkPaint>);
-                } else {
-                    // this is our sentinel, which we use in the unflatten loop
-                    deepCopyInfo->paintData[i] = NULL;
-                }
-            }
-            SkASSERT(SafeCount(fBitmapHeap.get()) == heapSize);
-
-            // needed to create typeface playback
-            deepCopyInfo->controller.setupPlaybacks();
-            deepCopyInfo->initialized = true;
+            init_copy_info(deepCopyInfo, paintCount, fBitmapHeap);
         }
 
-        fPaints = SkTRefArray<SkPaint>::Create(paintCount);
+        SkAutoTUnref<SkTRefArray<SkPaint> > paints(SkTRefArray<SkPaint>::Create(paintCount));
         SkASSERT(deepCopyInfo->paintData.count() == paintCount);
         SkBitmapHeap* bmHeap = deepCopyInfo->controller.getBitmapHeap();
         SkTypefacePlayback* tfPlayback = deepCopyInfo->controller.getTypefacePlayback();
         for (int i = 0; i < paintCount; i++) {
-            if (deepCopyInfo->paintData[i]) {
-                deepCopyInfo->paintData[i]->unflatten(&fPaints->writableAt(i),
-                                                      &SkUnflattenObjectProc<SkPaint>,
-                                                      bmHeap, tfPlayback);
+            const SkPaint& paint = src.fPaints->at(i);
+            if (needs_deep_copy(paint)) {
+                copy_data(deepCopyInfo, i, paint)->unflatten(&paints->writableAt(i),
+                                                             &SkUnflattenObjectProc<SkPaint>,
+                                                             bmHeap, tfPlayback);
             } else {
-                // needs_deep_copy was false, so just need to assign
-                fPaints->writableAt(i) = src.fPaints->at(i);
+                // Immutable, so just need to assign
+                paints->writableAt(i) = paint;
             }
         }
+        fPaints = SkLazyFlatArray<SkPaint>::Wrap(paints);
 
     } else {
         fBitmaps = SkSafeRef(src.fBitmaps);
@@ -263,13 +370,15 @@ void SkPicturePlayback::init() {
     fBitmaps = NULL;
     fMatrices = NULL;
     fPaints = NULL;
+    fPaths = NULL;
     fPictureRefs = NULL;
     fRegions = NULL;
     fPictureCount = 0;
     fOpData = NULL;
-    fFactoryPlayback = NULL;
     fBoundingHierarchy = NULL;
     fStateTree = NULL;
+    fCullOccludedDraws = false;
+    fPrimaryStateInUse = false;
 }
 
 SkPicturePlayback::~SkPicturePlayback() {
@@ -278,6 +387,7 @@ SkPicturePlayback::~SkPicturePlayback() {
     SkSafeUnref(fBitmaps);
     SkSafeUnref(fMatrices);
     SkSafeUnref(fPaints);
+    SkSafeUnref(fPaths);
     SkSafeUnref(fRegions);
     SkSafeUnref(fBoundingHierarchy);
     SkSafeUnref(fStateTree);
@@ -287,7 +397,122 @@ SkPicturePlayback::~SkPicturePlayback() {
     }
     SkDELETE_ARRAY(fPictureRefs);
 
-    SkDELETE(fFactoryPlayback);
+    for (int i = 0; i < fIdleDrawStates.count(); ++i) {
+        SkDELETE(fIdleDrawStates[i]);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+SkPicturePlayback::DrawState::DrawState()
+    : fUsesOriginals(true)
+    , fCopyController(1024) {
+}
+
+SkPicturePlayback::DrawState::DrawState(int bitmapCount, int paintCount)
+    : fUsesOriginals(false)
+    , fCopyController(1024) {
+    fBitmaps.setCount(bitmapCount);
+    sk_bzero(fBitmaps.begin(), bitmapCount * sizeof(SkBitmap*));
+    fPaints.setCount(paintCount);
+    sk_bzero(fPaints.begin(), paintCount * sizeof(SkPaint*));
+}
+
+SkPicturePlayback::DrawState::~DrawState() {
+    for (int i = 0; i < fBitmaps.count(); ++i) {
+        SkDELETE(fBitmaps[i]);
+    }
+    for (int i = 0; i < fPaintCopies.count(); ++i) {
+        SkDELETE(fPaintCopies[i]);
+    }
+}
+
+SkPicturePlayback::DrawState* SkPicturePlayback::acquireDrawState() {
+    SkAutoMutexAcquire lock(fDrawStateMutex);
+    if (!fPrimaryStateInUse) {
+        fPrimaryStateInUse = true;
+        return &fPrimaryState;
+    }
+    if (fIdleDrawStates.count() > 0) {
+        DrawState* state;
+        fIdleDrawStates.pop(&state);
+        return state;
+    }
+    return SkNEW_ARGS(DrawState, (SafeCount(fBitmaps), SafeCount(fPaints)));
+}
+
+void SkPicturePlayback::releaseDrawState(DrawState* state) {
+    SkAutoMutexAcquire lock(fDrawStateMutex);
+    if (&fPrimaryState == state) {
+        fPrimaryStateInUse = false;
+    } else {
+        fIdleDrawStates.push(state);
+    }
+}
+
+/*  The copies below are made while the primary state may be drawing with the originals, so
+    they only read what drawing leaves alone. Locking a bitmap's pixels writes its pixels,
+    color table and lock count, so the copy is assembled from the rest rather than by SkBitmap's
+    copy constructor. Flattening a shader or looper only reads what it was made with, not the
+    state that setContext() or init() writes.
+ */
+
+static void copy_bitmap(const SkBitmap& src, SkBitmap* dst) {
+    dst->setConfig(src.config(), src.width(), src.height(), src.rowBytes());
+    if (src.pixelRef()) {
+        dst->setPixelRef(src.pixelRef(), src.pixelRefOffset());
+    } else {
+        // Without a pixel ref, locking does not write to the bitmap
+        dst->setPixels(src.getPixels(), src.getColorTable());
+    }
+    dst->setIsOpaque(src.isOpaque());
+    dst->setIsVolatile(src.isVolatile());
+}
+
+static bool has_draw_state(const SkPaint& paint) {
+    return paint.getShader() || paint.getLooper();
+}
+
+const SkBitmap& SkPicturePlayback::getBitmapCopy(DrawState* state, int index) {
+    SkASSERT(!state->fUsesOriginals && NULL == state->fBitmaps[index]);
+    SkBitmap* copy = SkNEW(SkBitmap);
+    copy_bitmap((*fBitmaps)[index], copy);
+    state->fBitmaps[index] = copy;
+    return *copy;
+}
+
+const SkPaint* SkPicturePlayback::getPaintCopy(DrawState* state, int index) {
+    SkASSERT(!state->fUsesOriginals && NULL == state->fPaints[index]);
+    const SkPaint& paint = (*fPaints)[index];
+    if (!has_draw_state(paint)) {
+        // Immutable while drawing, so the original can be shared
+        state->fPaints[index] = &paint;
+        return &paint;
+    }
+
+    SkChunkFlatController& controller = state->fCopyController;
+    if (NULL == controller.getBitmapHeap()) {
+        // So that the pixels of bitmap shaders are shared rather than flattened
+        SkBitmapHeap* heap = SkNEW(SkBitmapHeap);
+        controller.setBitmapStorage(heap);
+        heap->unref();
+    }
+    // Only the shader and looper are copied, the other effects are immutable and shared
+    SkPaint effects;
+    effects.setShader(paint.getShader());
+    effects.setLooper(paint.getLooper());
+    SkFlatData* data = SkFlatData::Create(&controller, &effects, 0,
+                                          &SkFlattenObjectProc<SkPaint>);
+    controller.setupPlaybacks();
+    data->unflatten(&effects, &SkUnflattenObjectProc<SkPaint>,
+                    controller.getBitmapHeap(), controller.getTypefacePlayback());
+
+    SkPaint* copy = SkNEW_ARGS(SkPaint, (paint));
+    copy->setShader(effects.getShader());
+    copy->setLooper(effects.getLooper());
+    *state->fPaintCopies.append() = copy;
+    state->fPaints[index] = copy;
+    return copy;
 }
 
 void SkPicturePlayback::dumpSize() const {
@@ -296,7 +521,7 @@ void SkPicturePlayback::dumpSize() const {
              SafeCount(fBitmaps), SafeCount(fBitmaps) * sizeof(SkBitmap),
              SafeCount(fMatrices), SafeCount(fMatrices) * sizeof(SkMatrix),
              SafeCount(fPaints), SafeCount(fPaints) * sizeof(SkPaint),
-             SafeCount(fPathHeap.get()),
+             SafeCount(fPaths),
              SafeCount(fRegions));
 }
 
@@ -334,6 +559,19 @@ static void writeTagSize(SkWStream* stream, uint32_t tag,
     stream->write32(size);
 }
 
+// The tags, op data and arrays of a picture are all kept 4-byte aligned, so that a picture
+// read from a mapped file can use its op data and arrays in place. Variable-length records
+// are padded to 4 bytes with zeros.
+static void writePadded(SkWStream* stream, const void* data, size_t size) {
+    static const char gZeros[4] = { 0, 0, 0, 0 };
+    stream->write(data, size);
+    stream->write(gZeros, SkAlign4(size) - size);
+}
+
+static void skipPadding(SkStream* stream, size_t size) {
+    stream->skip(SkAlign4(size) - size);
+}
+
 static void writeFactories(SkWStream* stream, const SkFactorySet& rec) {
     int count = rec.count();
 
@@ -347,11 +585,11 @@ static void writeFactories(SkWStream* stream, const SkFactorySet& rec) {
         const char* name = SkFlattenable::FactoryToName(array[i]);
 //        SkDebugf("---- write factories [%d] %p <%s>\n", i, array[i], name);
         if (NULL == name || 0 == *name) {
-            stream->writePackedUInt(0);
+            stream->write32(0);
         } else {
             uint32_t len = strlen(name);
-            stream->writePackedUInt(len);
-            stream->write(name, len);
+            stream->write32(len);
+            writePadded(stream, name, len);
         }
     }
 }
@@ -366,46 +604,66 @@ static void writeTypefaces(SkWStream* stream, const SkRefCntSet& rec) {
     rec.copyToArray((SkRefCnt**)array);
 
     for (int i = 0; i < count; i++) {
-        array[i]->serialize(stream);
+        // Serialized typefaces vary in length, so each is written with its size and padded.
+        SkDynamicMemoryWStream tfStream;
+        array[i]->serialize(&tfStream);
+        SkAutoDataUnref data(tfStream.copyToData());
+        stream->write32(data->size());
+        writePadded(stream, data->data(), data->size());
     }
 }
 
-void SkPicturePlayback::flattenToBuffer(SkOrderedWriteBuffer& buffer) const {
-    int i, n;
+/*  Each array is written as its tag and count, then a table of count + 1 offsets of its
+    entries, from the end of the table (the last one being the end of the array), and then the
+    entries. A reader can use the table to unflatten the entries one at a time, in any order.
+ */
+template <typename T, typename Array>
+static void writeArray(SkOrderedWriteBuffer& buffer, uint32_t tag, const Array* array,
+                       void (*writeProc)(SkOrderedWriteBuffer&, const T&)) {
+    const int count = SafeCount(array);
+    if (0 == count) {
+        return;
+    }
+    writeTagSize(buffer, tag, count);
 
-    if ((n = SafeCount(fBitmaps)) > 0) {
-        writeTagSize(buffer, PICT_BITMAP_BUFFER_TAG, n);
-        for (i = 0; i < n; i++) {
-            buffer.writeBitmap((*fBitmaps)[i]);
-        }
+    // The writer's blocks never move, so the table is filled in through the pointer reserve()
+    // returns. peek32() would walk the blocks from the first one for every entry.
+    SkWriter32* writer = buffer.getWriter32();
+    uint32_t* table = writer->reserve((count + 1) * sizeof(uint32_t));
+    const uint32_t start = writer->size();
+    for (int i = 0; i < count; i++) {
+        table[i] = writer->size() - start;
+        writeProc(buffer, (*array)[i]);
     }
+    table[count] = writer->size() - start;
+}
 
-    if ((n = SafeCount(fMatrices)) > 0) {
-        writeTagSize(buffer, PICT_MATRIX_BUFFER_TAG, n);
-        for (i = 0; i < n; i++) {
-            buffer.writeMatrix((*fMatrices)[i]);
-        }
+static void write_bitmap(SkOrderedWriteBuffer& buffer, const SkBitmap& bitmap) {
+    buffer.writeBitmap(bitmap);
+}
 
-    }
+static void write_matrix(SkOrderedWriteBuffer& buffer, const SkMatrix& matrix) {
+    buffer.writeMatrix(matrix);
+}
 
-    if ((n = SafeCount(fPaints)) > 0) {
-        writeTagSize(buffer, PICT_PAINT_BUFFER_TAG, n);
-        for (i = 0; i < n; i++) {
-            buffer.writePaint((*fPaints)[i]);
-        }
-    }
+static void write_paint(SkOrderedWriteBuffer& buffer, const SkPaint& paint) {
+    buffer.writePaint(paint);
+}
 
-    if ((n = SafeCount(fPathHeap.get())) > 0) {
-        writeTagSize(buffer, PICT_PATH_BUFFER_TAG, n);
-        fPathHeap->flatten(buffer);
-    }
+static void write_path(SkOrderedWriteBuffer& buffer, const SkPath& path) {
+    buffer.writePath(path);
+}
 
-    if ((n = SafeCount(fRegions)) > 0) {
-        writeTagSize(buffer, PICT_REGION_BUFFER_TAG, n);
-        for (i = 0; i < n; i++) {
-            buffer.writeRegion((*fRegions)[i]);
-        }
-    }
+static void write_region(SkOrderedWriteBuffer& buffer, const SkRegion& region) {
+    buffer.writeRegion(region);
+}
+
+void SkPicturePlayback::flattenToBuffer(SkOrderedWriteBuffer& buffer) const {
+    writeArray(buffer, PICT_BITMAP_BUFFER_TAG, fBitmaps, &write_bitmap);
+    writeArray(buffer, PICT_MATRIX_BUFFER_TAG, fMatrices, &write_matrix);
+    writeArray(buffer, PICT_PAINT_BUFFER_TAG, fPaints, &write_paint);
+    writeArray(buffer, PICT_PATH_BUFFER_TAG, fPaths, &write_path);
+    writeArray(buffer, PICT_REGION_BUFFER_TAG, fRegions, &write_region);
 }
 
 void SkPicturePlayback::serialize(SkWStream* stream,
@@ -473,6 +731,25 @@ static uint32_t pictInfoFlagsToReadBufferFlags(uint32_t pictInfoFlags) {
     return rbMask;
 }
 
+/**
+ *  Reads size bytes from the stream. If the stream can share them (e.g. it reads from a mapped
+ *  file), they are used in place, unless they are not 4-byte aligned, which SkReader32 needs.
+ */
+static SkData* read_aligned_data(SkStream* stream, size_t size) {
+    SkData* data = stream->readSharedData(size);
+    if (NULL != data) {
+        if (SkIsAlign4((intptr_t)data->data())) {
+            return data;
+        }
+        SkData* copy = SkData::NewWithCopy(data->data(), data->size());
+        data->unref();
+        return copy;
+    }
+    void* storage = sk_malloc_throw(size);
+    stream->read(storage, size);
+    return SkData::NewFromMalloc(storage, size);
+}
+
 void SkPicturePlayback::parseStreamTag(SkStream* stream, const SkPictInfo& info, uint32_t tag,
                                        size_t size, SkPicture::InstallPixelRefProc proc) {
     /*
@@ -488,33 +765,40 @@ void SkPicturePlayback::parseStreamTag(SkStream* stream, const SkPictInfo& info,
 
     switch (tag) {
         case PICT_READER_TAG: {
-            void* storage = sk_malloc_throw(size);
-            stream->read(storage, size);
             SkASSERT(NULL == fOpData);
-            fOpData = SkData::NewFromMalloc(storage, size);
+            fOpData = read_aligned_data(stream, size);
         } break;
         case PICT_FACTORY_TAG: {
             SkASSERT(!haveBuffer);
-            fFactoryPlayback = SkNEW_ARGS(SkFactoryPlayback, (size));
+            SkASSERT(NULL == fReadContext->fFactoryPlayback);
+            SkFactoryPlayback* factories = SkNEW_ARGS(SkFactoryPlayback, (size));
+            fReadContext->fFactoryPlayback = factories;
             for (size_t i = 0; i < size; i++) {
                 SkString str;
-                int len = stream->readPackedUInt();
+                size_t len = stream->readU32();
                 str.resize(len);
                 stream->read(str.writable_str(), len);
-                fFactoryPlayback->base()[i] = SkFlattenable::NameToFactory(str.c_str());
+                skipPadding(stream, len);
+                factories->base()[i] = SkFlattenable::NameToFactory(str.c_str());
             }
         } break;
         case PICT_TYPEFACE_TAG: {
             SkASSERT(!haveBuffer);
-            fTFPlayback.setCount(size);
+            SkTypefacePlayback& tfPlayback = fReadContext->fTFPlayback;
+            tfPlayback.setCount(size);
             for (size_t i = 0; i < size; i++) {
-                SkAutoTUnref<SkTypeface> tf(SkTypeface::Deserialize(stream));
+                size_t len = stream->readU32();
+                SkAutoMalloc storage(len);
+                stream->read(storage.get(), len);
+                skipPadding(stream, len);
+                SkMemoryStream tfStream(storage.get(), len);
+                SkAutoTUnref<SkTypeface> tf(SkTypeface::Deserialize(&tfStream));
                 if (!tf.get()) {    // failed to deserialize
                     // fTFPlayback asserts it never has a null, so we plop in
                     // the default here.
                     tf.reset(SkTypeface::RefDefault());
                 }
-                fTFPlayback.set(i, tf);
+                tfPlayback.set(i, tf);
             }
         } break;
         case PICT_PICTURE_TAG: {
@@ -532,55 +816,60 @@ void SkPicturePlayback::parseStreamTag(SkStream* stream, const SkPictInfo& info,
             }
         } break;
         case PICT_BUFFER_SIZE_TAG: {
-            SkAutoMalloc storage(size);
-            stream->read(storage.get(), size);
-
-            SkOrderedReadBuffer buffer(storage.get(), size);
-            buffer.setFlags(pictInfoFlagsToReadBufferFlags(info.fFlags));
+            // The lazily unflattened arrays keep the data, and so the mapped file, alive.
+            SkAutoTUnref<SkData> data(read_aligned_data(stream, size));
 
-            fFactoryPlayback->setupBuffer(buffer);
-            fTFPlayback.setupBuffer(buffer);
-            buffer.setBitmapDecoder(proc);
+            SkOrderedReadBuffer buffer(data->data(), data->size());
+            fReadContext->setupBuffer(&buffer);
 
             while (!buffer.eof()) {
                 tag = buffer.readUInt();
                 size = buffer.readUInt();
-                this->parseBufferTag(buffer, tag, size);
+                this->parseBufferTag(buffer, data, tag, size);
             }
             SkDEBUGCODE(haveBuffer = true;)
         } break;
     }
 }
 
-void SkPicturePlayback::parseBufferTag(SkOrderedReadBuffer& buffer,
+/**
+ *  Reads the offsets table of an array written by writeArray() and returns the array, whose
+ *  entries will be unflattened from data as they are first used. The buffer, which reads from
+ *  data, is left at the end of the array.
+ */
+template <typename T>
+static SkLazyFlatArray<T>* read_lazy_array(SkOrderedReadBuffer& buffer, SkData* data,
+                                           size_t count, SkFlatReadContext* context,
+                                           typename SkLazyFlatArray<T>::UnflattenProc proc) {
+    const uint32_t* table = (const uint32_t*)buffer.skip((count + 1) * sizeof(uint32_t));
+    const uint32_t start = buffer.offset();
+    SkAutoTMalloc<uint32_t> offsets(count + 1);
+    for (size_t i = 0; i <= count; ++i) {
+        SkASSERT(SkAlign4(table[i]) == table[i] && (0 == i || table[i] >= table[i - 1]));
+        offsets[i] = start + table[i];
+    }
+    buffer.skip(table[count]);
+    return SkNEW_ARGS(SkLazyFlatArray<T>, (data, offsets.get(), count, context, proc));
+}
+
+void SkPicturePlayback::parseBufferTag(SkOrderedReadBuffer& buffer, SkData* data,
                                        uint32_t tag, size_t size) {
     switch (tag) {
-        case PICT_BITMAP_BUFFER_TAG: {
-            fBitmaps = SkTRefArray<SkBitmap>::Create(size);
-            for (size_t i = 0; i < size; ++i) {
-                SkBitmap* bm = &fBitmaps->writableAt(i);
-                buffer.readBitmap(bm);
-                bm->setImmutable();
-            }
-        } break;
+        case PICT_BITMAP_BUFFER_TAG:
+            fBitmaps = read_lazy_array<SkBitmap>(buffer, data, size, fReadContext, &read_bitmap);
+            break;
         case PICT_MATRIX_BUFFER_TAG:
-            fMatrices = SkTRefArray<SkMatrix>::Create(size);
-            for (size_t i = 0; i < size; ++i) {
-                buffer.readMatrix(&fMatrices->writableAt(i));
-            }
+            fMatrices = read_lazy_array<SkMatrix>(buffer, data, size, fReadContext, &read_matrix);
+            break;
+        case PICT_PAINT_BUFFER_TAG:
+            fPaints = read_lazy_array<SkPaint>(buffer, data, size, fReadContext, &read_paint);
             break;
-        case PICT_PAINT_BUFFER_TAG: {
-            fPaints = SkTRefArray<SkPaint>::Create(size);
-            for (size_t i = 0; i < size; ++i) {
-                buffer.readPaint(&fPaints->writableAt(i));
-            }
-        } break;
         case PICT_PATH_BUFFER_TAG:
-            if (size > 0) {
-                fPathHeap.reset(SkNEW_ARGS(SkPathHeap, (buffer)));
-            }
+            fPaths = read_lazy_array<SkPath>(buffer, data, size, fReadContext, &read_path);
             break;
         case PICT_REGION_BUFFER_TAG: {
+            // Few and small, so read right away, skipping the offsets table
+            buffer.skip((size + 1) * sizeof(uint32_t));
             fRegions = SkTRefArray<SkRegion>::Create(size);
             for (size_t i = 0; i < size; ++i) {
                 buffer.readRegion(&fRegions->writableAt(i));
@@ -593,6 +882,10 @@ SkPicturePlayback::SkPicturePlayback(SkStream* stream, const SkPictInfo& info,
                                      SkPicture::InstallPixelRefProc proc) {
     this->init();
 
+    fReadContext.reset(SkNEW(SkFlatReadContext));
+    fReadContext->fFlags = pictInfoFlagsToReadBufferFlags(info.fFlags);
+    fReadContext->fBitmapDecoder = proc;
+
     for (;;) {
         uint32_t tag = stream->readU32();
         if (PICT_EOF_TAG == tag) {
@@ -656,7 +949,88 @@ static DrawType read_op_and_size(SkReader32* reader, uint32_t* size) {
     return (DrawType) op;
 }
 
+/*
+ * The bounds that the state tree's draws carry are in the picture's coordinates, and only say
+ * which whole pixels a draw covers. Skipping a draw hidden by a later one is therefore only safe
+ * when the canvas maps picture pixels onto device pixels one for one, and its clip does not
+ * partially cover any pixel.
+ */
+static bool can_cull_occluded_draws(const SkCanvas& canvas) {
+    const SkMatrix& matrix = canvas.getTotalMatrix();
+    if (matrix.getType() & ~SkMatrix::kTranslate_Mask) {
+        return false;
+    }
+    SkScalar dx = matrix.getTranslateX();
+    SkScalar dy = matrix.getTranslateY();
+    return dx == SkScalarFloorToScalar(dx) && dy == SkScalarFloorToScalar(dy) &&
+           SkCanvas::kRect_ClipType == canvas.getClipType();
+}
+
+static int64_t irect_area(const SkIRect& r) {
+    return static_cast<int64_t>(r.width()) * r.height();
+}
+
+/*
+ * Removes from 'draws' (sorted into playback order) each draw whose bounds, within 'query', are
+ * completely covered by the opaque bounds of a draw that comes after it. Only a few of the
+ * largest opaque areas seen are kept as occluders, which catches the common case of layered
+ * backgrounds without making this quadratic.
+ */
+static void cull_occluded_draws(const SkIRect& query, SkTDArray<void*>* draws) {
+    static const int kMaxOccluders = 4;
+    SkIRect occluders[kMaxOccluders];
+    int occluderCount = 0;
+
+    void** dst = draws->end();
+    for (int i = draws->count() - 1; i >= 0; --i) {
+        SkPictureStateTree::Draw* draw = static_cast<SkPictureStateTree::Draw*>((*draws)[i]);
+
+        SkIRect bounds = draw->fBounds;
+        if (!bounds.isEmpty() && bounds.intersect(query)) {
+            bool occluded = false;
+            for (int j = 0; j < occluderCount; ++j) {
+                if (occluders[j].contains(bounds)) {
+                    occluded = true;
+                    break;
+                }
+            }
+            if (occluded) {
+                continue;
+            }
+        }
+
+        SkIRect opaque = draw->fOpaqueBounds;
+        if (!opaque.isEmpty() && opaque.intersect(query)) {
+            if (occluderCount < kMaxOccluders) {
+                occluders[occluderCount++] = opaque;
+            } else {
+                int smallest = 0;
+                for (int j = 1; j < kMaxOccluders; ++j) {
+                    if (irect_area(occluders[j]) < irect_area(occluders[smallest])) {
+                        smallest = j;
+                    }
+                }
+                if (irect_area(opaque) > irect_area(occluders[smallest])) {
+                    occluders[smallest] = opaque;
+                }
+            }
+        }
+        *--dst = draw;
+    }
+
+    // The surviving draws were packed against the end of the array, in order
+    int kept = SkToS32(draws->end() - dst);
+    memmove(draws->begin(), dst, kept * sizeof(void*));
+    draws->setCount(kept);
+}
+
 void SkPicturePlayback::draw(SkCanvas& canvas) {
+    DrawState* state = this->acquireDrawState();
+    this->draw(canvas, state);
+    this->releaseDrawState(state);
+}
+
+void SkPicturePlayback::draw(SkCanvas& canvas, DrawState* state) {
 #ifdef ENABLE_TIME_DRAW
     SkAutoTime  at("SkPicture::draw", 50);
 #endif
@@ -675,7 +1049,8 @@ void SkPicturePlayback::draw(SkCanvas& canvas) {
 
     SkReader32 reader(fOpData->bytes(), fOpData->size());
     TextContainer text;
-    SkTDArray<void*> results;
+    SkTDArray<void*>& results = state->fSearchResults;
+    results.rewind();
 
     if (NULL != fStateTree && NULL != fBoundingHierarchy) {
         SkRect clipBounds;
@@ -689,6 +1064,9 @@ void SkPicturePlayback::draw(SkCanvas& canvas) {
             SkTQSort<SkPictureStateTree::Draw>(
                 reinterpret_cast<SkPictureStateTree::Draw**>(results.begin()),
                 reinterpret_cast<SkPictureStateTree::Draw**>(results.end()-1));
+            if (fCullOccludedDraws && can_cull_occluded_draws(canvas)) {
+                cull_occluded_draws(query, &results);
+            }
         }
     }
 
@@ -814,27 +1192,27 @@ void SkPicturePlayback::draw(SkCanvas& canvas) {
                 canvas.concat(*getMatrix(reader));
                 break;
             case DRAW_BITMAP: {
-                const SkPaint* paint = getPaint(reader);
-                const SkBitmap& bitmap = getBitmap(reader);
+                const SkPaint* paint = getPaint(reader, state);
+                const SkBitmap& bitmap = getBitmap(reader, state);
                 const SkPoint& loc = reader.skipT<SkPoint>();
                 canvas.drawBitmap(bitmap, loc.fX, loc.fY, paint);
             } break;
             case DRAW_BITMAP_RECT_TO_RECT: {
-                const SkPaint* paint = getPaint(reader);
-                const SkBitmap& bitmap = getBitmap(reader);
+                const SkPaint* paint = getPaint(reader, state);
+                const SkBitmap& bitmap = getBitmap(reader, state);
                 const SkRect* src = this->getRectPtr(reader);   // may be null
                 const SkRect& dst = reader.skipT<SkRect>();     // required
                 canvas.drawBitmapRectToRect(bitmap, src, dst, paint);
             } break;
             case DRAW_BITMAP_MATRIX: {
-                const SkPaint* paint = getPaint(reader);
-                const SkBitmap& bitmap = getBitmap(reader);
+                const SkPaint* paint = getPaint(reader, state);
+                const SkBitmap& bitmap = getBitmap(reader, state);
                 const SkMatrix* matrix = getMatrix(reader);
                 canvas.drawBitmapMatrix(bitmap, *matrix, paint);
             } break;
             case DRAW_BITMAP_NINE: {
-                const SkPaint* paint = getPaint(reader);
-                const SkBitmap& bitmap = getBitmap(reader);
+                const SkPaint* paint = getPaint(reader, state);
+                const SkBitmap& bitmap = getBitmap(reader, state);
                 const SkIRect& src = reader.skipT<SkIRect>();
                 const SkRect& dst = reader.skipT<SkRect>();
                 canvas.drawBitmapNine(bitmap, src, dst, paint);
@@ -848,35 +1226,35 @@ void SkPicturePlayback::draw(SkCanvas& canvas) {
                 // skip handles padding the read out to a multiple of 4
             } break;
             case DRAW_OVAL: {
-                const SkPaint& paint = *getPaint(reader);
+                const SkPaint& paint = *getPaint(reader, state);
                 canvas.drawOval(reader.skipT<SkRect>(), paint);
             } break;
             case DRAW_PAINT:
-                canvas.drawPaint(*getPaint(reader));
+                canvas.drawPaint(*getPaint(reader, state));
                 break;
             case DRAW_PATH: {
-                const SkPaint& paint = *getPaint(reader);
+                const SkPaint& paint = *getPaint(reader, state);
                 canvas.drawPath(getPath(reader), paint);
             } break;
             case DRAW_PICTURE:
                 canvas.drawPicture(getPicture(reader));
                 break;
             case DRAW_POINTS: {
-                const SkPaint& paint = *getPaint(reader);
+                const SkPaint& paint = *getPaint(reader, state);
                 SkCanvas::PointMode mode = (SkCanvas::PointMode)reader.readInt();
                 size_t count = reader.readInt();
                 const SkPoint* pts = (const SkPoint*)reader.skip(sizeof(SkPoint) * count);
                 canvas.drawPoints(mode, count, pts, paint);
             } break;
             case DRAW_POS_TEXT: {
-                const SkPaint& paint = *getPaint(reader);
+                const SkPaint& paint = *getPaint(reader, state);
                 getText(reader, &text);
                 size_t points = reader.readInt();
                 const SkPoint* pos = (const SkPoint*)reader.skip(points * sizeof(SkPoint));
                 canvas.drawPosText(text.text(), text.length(), pos, paint);
             } break;
             case DRAW_POS_TEXT_TOP_BOTTOM: {
-                const SkPaint& paint = *getPaint(reader);
+                const SkPaint& paint = *getPaint(reader, state);
                 getText(reader, &text);
                 size_t points = reader.readInt();
                 const SkPoint* pos = (const SkPoint*)reader.skip(points * sizeof(SkPoint));
@@ -887,7 +1265,7 @@ void SkPicturePlayback::draw(SkCanvas& canvas) {
                 }
             } break;
             case DRAW_POS_TEXT_H: {
-                const SkPaint& paint = *getPaint(reader);
+                const SkPaint& paint = *getPaint(reader, state);
                 getText(reader, &text);
                 size_t xCount = reader.readInt();
                 const SkScalar constY = reader.readScalar();
@@ -896,7 +1274,7 @@ void SkPicturePlayback::draw(SkCanvas& canvas) {
                                     paint);
             } break;
             case DRAW_POS_TEXT_H_TOP_BOTTOM: {
-                const SkPaint& paint = *getPaint(reader);
+                const SkPaint& paint = *getPaint(reader, state);
                 getText(reader, &text);
                 size_t xCount = reader.readInt();
                 const SkScalar* xpos = (const SkScalar*)reader.skip((3 + xCount) * sizeof(SkScalar));
@@ -909,30 +1287,38 @@ void SkPicturePlayback::draw(SkCanvas& canvas) {
                 }
             } break;
             case DRAW_RECT: {
-                const SkPaint& paint = *getPaint(reader);
+                const SkPaint& paint = *getPaint(reader, state);
                 canvas.drawRect(reader.skipT<SkRect>(), paint);
             } break;
+            case DRAW_RECTS: {
+                const SkPaint& paint = *getPaint(reader, state);
+                int count = reader.readInt();
+                const SkRect* rects = (const SkRect*)reader.skip(count * sizeof(SkRect));
+                for (int i = 0; i < count; ++i) {
+                    canvas.drawRect(rects[i], paint);
+                }
+            } break;
             case DRAW_RRECT: {
-                const SkPaint& paint = *getPaint(reader);
+                const SkPaint& paint = *getPaint(reader, state);
                 SkRRect rrect;
                 canvas.drawRRect(*reader.readRRect(&rrect), paint);
             } break;
             case DRAW_SPRITE: {
-                const SkPaint* paint = getPaint(reader);
-                const SkBitmap& bitmap = getBitmap(reader);
+                const SkPaint* paint = getPaint(reader, state);
+                const SkBitmap& bitmap = getBitmap(reader, state);
                 int left = reader.readInt();
                 int top = reader.readInt();
                 canvas.drawSprite(bitmap, left, top, paint);
             } break;
             case DRAW_TEXT: {
-                const SkPaint& paint = *getPaint(reader);
+                const SkPaint& paint = *getPaint(reader, state);
                 getText(reader, &text);
                 SkScalar x = reader.readScalar();
                 SkScalar y = reader.readScalar();
                 canvas.drawText(text.text(), text.length(), x, y, paint);
             } break;
             case DRAW_TEXT_TOP_BOTTOM: {
-                const SkPaint& paint = *getPaint(reader);
+                const SkPaint& paint = *getPaint(reader, state);
                 getText(reader, &text);
                 const SkScalar* ptr = (const SkScalar*)reader.skip(4 * sizeof(SkScalar));
                 // ptr[0] == x
@@ -945,7 +1331,7 @@ void SkPicturePlayback::draw(SkCanvas& canvas) {
                 }
             } break;
             case DRAW_TEXT_ON_PATH: {
-                const SkPaint& paint = *getPaint(reader);
+                const SkPaint& paint = *getPaint(reader, state);
                 getText(reader, &text);
                 const SkPath& path = getPath(reader);
                 const SkMatrix* matrix = getMatrix(reader);
@@ -953,7 +1339,7 @@ void SkPicturePlayback::draw(SkCanvas& canvas) {
                                       matrix, paint);
             } break;
             case DRAW_VERTICES: {
-                const SkPaint& paint = *getPaint(reader);
+                const SkPaint& paint = *getPaint(reader, state);
                 DrawVertexFlags flags = (DrawVertexFlags)reader.readInt();
                 SkCanvas::VertexMode vmode = (SkCanvas::VertexMode)reader.readInt();
                 int vCount = reader.readInt();
@@ -990,7 +1376,7 @@ void SkPicturePlayback::draw(SkCanvas& canvas) {
                 break;
             case SAVE_LAYER: {
                 const SkRect* boundsPtr = getRectPtr(reader);
-                const SkPaint* paint = getPaint(reader);
+                const SkPaint* paint = getPaint(reader, state);
                 canvas.saveLayer(boundsPtr, paint, (SkCanvas::SaveFlags) reader.readInt());
                 } break;
             case SCALE: {
@@ -13,6 +13,7 @@
 
 #include "SkBitmap.h"
 #include "SkData.h"
+#include "SkLazyFlatArray.h"
 #include "SkMatrix.h"
 #include "SkOrderedReadBuffer.h"
 #include "SkPaint.h"
@@ -22,9 +23,7 @@
 #include "SkRRect.h"
 #include "SkPictureFlat.h"
 
-#ifdef SK_BUILD_FOR_ANDROID
 #include "SkThread.h"
-#endif
 
 class SkPictureRecord;
 class SkStream;
@@ -37,6 +36,7 @@ struct SkPictInfo {
         kCrossProcess_Flag      = 1 << 0,
         kScalarIsFloat_Flag     = 1 << 1,
         kPtrIs64Bit_Flag        = 1 << 2,
+        kCompressed_Flag        = 1 << 3,   // what follows is written by SkDeflateWStream
     };
 
     uint32_t    fVersion;
@@ -48,6 +48,8 @@ struct SkPictInfo {
 /**
  * Container for data that is needed to deep copy a SkPicture. The container
  * enables the data to be generated once and reused for subsequent copies.
+ * Each paint is only flattened the first time a copy of it is needed, see
+ * copy_data(); until then its paintData is NULL.
  */
 struct SkPictCopyInfo {
     SkPictCopyInfo() : initialized(false), controller(1024) {}
@@ -66,6 +68,10 @@ public:
 
     virtual ~SkPicturePlayback();
 
+    /**
+     *  Plays the picture back into 'canvas'. This may be called from several threads at once:
+     *  each call runs with its own DrawState, see below.
+     */
     void draw(SkCanvas& canvas);
 
     void serialize(SkWStream*, SkPicture::EncodeBitmap) const;
@@ -85,6 +91,46 @@ protected:
 #endif
 
 private:
+    /**
+     *  The playback data that drawing mutates: bitmaps (locking pixels writes to the SkBitmap)
+     *  and the effects that keep per-draw state (a shader's setContext(), a looper's init() -
+     *  see has_draw_state()). Every draw() borrows a DrawState for its duration.
+     *
+     *  The primary state draws with fBitmaps and fPaints themselves, so a picture that is only
+     *  drawn from one thread at a time never copies anything. A draw that starts while the
+     *  primary state is busy gets one of its own instead, which makes private copies of the
+     *  bitmaps and of the stateful shaders and loopers the first time it needs them. Idle
+     *  states are kept for later draws, so the copying is paid once per concurrent thread
+     *  rather than once per frame.
+     */
+    class DrawState : SkNoncopyable {
+    public:
+        // The primary state
+        DrawState();
+        DrawState(int bitmapCount, int paintCount);
+        ~DrawState();
+
+        bool fUsesOriginals;
+        // Private copies of the bitmaps, NULL until first used
+        SkTDArray<SkBitmap*> fBitmaps;
+        // The paints to draw with, NULL until first used: either a copy with private shader
+        // and looper, or the original if it has neither
+        SkTDArray<const SkPaint*> fPaints;
+        SkTDArray<SkPaint*> fPaintCopies;
+        // What the shaders and loopers are flattened into to be copied. Only this state's
+        // thread uses it, so the copying needs no lock.
+        SkChunkFlatController fCopyController;
+        // The draws that the bounding hierarchy finds for the clip. Kept from draw to draw so
+        // that tiled playback, which draws the picture once per tile, does not reallocate it.
+        SkTDArray<void*> fSearchResults;
+    };
+
+    void draw(SkCanvas& canvas, DrawState* state);
+    DrawState* acquireDrawState();
+    void releaseDrawState(DrawState*);
+    const SkBitmap& getBitmapCopy(DrawState* state, int index);
+    const SkPaint* getPaintCopy(DrawState* state, int index);
+
     class TextContainer {
     public:
         size_t length() { return fByteLength; }
@@ -93,7 +139,7 @@ private:
         const char* fText;
     };
 
-    const SkBitmap& getBitmap(SkReader32& reader) {
+    const SkBitmap& getBitmap(SkReader32& reader, DrawState* state) {
         const int index = reader.readInt();
         if (SkBitmapHeap::INVALID_SLOT == index) {
 #ifdef SK_DEBUG
@@ -101,7 +147,11 @@ private:
 #endif
             return fBadBitmap;
         }
-        return (*fBitmaps)[index];
+        if (state->fUsesOriginals) {
+            return (*fBitmaps)[index];
+        }
+        const SkBitmap* copy = state->fBitmaps[index];
+        return copy ? *copy : this->getBitmapCopy(state, index);
     }
 
     const SkMatrix* getMatrix(SkReader32& reader) {
@@ -113,7 +163,7 @@ private:
     }
 
     const SkPath& getPath(SkReader32& reader) {
-        return (*fPathHeap)[reader.readInt() - 1];
+        return (*fPaths)[reader.readInt() - 1];
     }
 
     SkPicture& getPicture(SkReader32& reader) {
@@ -122,12 +172,16 @@ private:
         return *fPictureRefs[index - 1];
     }
 
-    const SkPaint* getPaint(SkReader32& reader) {
+    const SkPaint* getPaint(SkReader32& reader, DrawState* state) {
         int index = reader.readInt();
         if (index == 0) {
             return NULL;
         }
-        return &(*fPaints)[index - 1];
+        if (state->fUsesOriginals) {
+            return &(*fPaints)[index - 1];
+        }
+        const SkPaint* paint = state->fPaints[index - 1];
+        return paint ? paint : this->getPaintCopy(state, index - 1);
     }
 
     const SkRect* getRectPtr(SkReader32& reader) {
@@ -193,7 +247,7 @@ public:
 private:    // these help us with reading/writing
     void parseStreamTag(SkStream*, const SkPictInfo&, uint32_t tag, size_t size,
                         SkPicture::InstallPixelRefProc);
-    void parseBufferTag(SkOrderedReadBuffer&, uint32_t tag, size_t size);
+    void parseBufferTag(SkOrderedReadBuffer&, SkData*, uint32_t tag, size_t size);
     void flattenToBuffer(SkOrderedWriteBuffer&) const;
 
 private:
@@ -202,11 +256,13 @@ private:
     SkBitmap fBadBitmap;
 
     SkAutoTUnref<SkBitmapHeap> fBitmapHeap;
-    SkAutoTUnref<SkPathHeap> fPathHeap;
 
-    SkTRefArray<SkBitmap>* fBitmaps;
-    SkTRefArray<SkMatrix>* fMatrices;
-    SkTRefArray<SkPaint>* fPaints;
+    // Unflattened as they are first drawn with, so that a picture that is only partly drawn
+    // (e.g. one tile of it) does not pay for the rest
+    SkLazyFlatArray<SkBitmap>* fBitmaps;
+    SkLazyFlatArray<SkMatrix>* fMatrices;
+    SkLazyFlatArray<SkPaint>* fPaints;
+    SkLazyFlatArray<SkPath>* fPaths;
     SkTRefArray<SkRegion>* fRegions;
 
     SkData* fOpData;    // opcodes and parameters
@@ -216,13 +272,22 @@ private:
 
     SkBBoxHierarchy* fBoundingHierarchy;
     SkPictureStateTree* fStateTree;
+    // Whether the state tree's draws carry the bounds needed to skip occluded draws
+    bool fCullOccludedDraws;
 
-    SkTypefacePlayback fTFPlayback;
-    SkFactoryPlayback* fFactoryPlayback;
+    // What the lazy arrays need to unflatten their entries: the factories and typefaces of a
+    // picture read from a stream, or the typefaces and bitmap heap of the recording
+    SkAutoTUnref<SkFlatReadContext> fReadContext;
 #ifdef SK_BUILD_FOR_ANDROID
     SkMutex fDrawMutex;
     bool fAbortCurrentPlayback;
 #endif
+
+    // Guards the fields below
+    SkMutex fDrawStateMutex;
+    DrawState fPrimaryState;
+    bool fPrimaryStateInUse;
+    SkTDArray<DrawState*> fIdleDrawStates;
 };
 
 #endif
@@ -34,6 +34,7 @@ SkPictureRecord::SkPictureRecord(uint32_t flags, SkDevice* device) :
         fMatrices(&fFlattenableHeap),
         fPaints(&fFlattenableHeap),
         fRegions(&fFlattenableHeap),
+        fLastPaintData(NULL),
         fWriter(MIN_WRITER_SIZE),
         fRecordFlags(flags) {
 #ifdef SK_DEBUG_SIZE
@@ -105,6 +106,7 @@ static inline uint32_t getPaintOffset(DrawType op, uint32_t opSize) {
         0,  // SKEW - no paint
         0,  // TRANSLATE - no paint
         0,  // NOOP - no paint
+        1,  // DRAW_RECTS - right after op code
     };
 
     SkASSERT(sizeof(gPaintOffsets) == LAST_DRAWTYPE_ENUM + 1);
@@ -1233,8 +1235,30 @@ void SkPictureRecord::addMatrixPtr(const SkMatrix* matrix) {
     this->addInt(matrix ? fMatrices.find(*matrix) : 0);
 }
 
+// Shaders (through their local matrix), draw loopers and rasterizers can be
+// changed after they are set on a paint, so a paint that uses them may flatten
+// differently even though it still compares equal to the last one.
+static bool can_reuse_flattened_paint(const SkPaint& paint) {
+    return NULL == paint.getShader() &&
+           NULL == paint.getLooper() &&
+           NULL == paint.getRasterizer();
+}
+
 const SkFlatData* SkPictureRecord::addPaintPtr(const SkPaint* paint) {
-    const SkFlatData* data = paint ? fPaints.findAndReturnFlat(*paint) : NULL;
+    const SkFlatData* data = NULL;
+    if (paint) {
+        if (fLastPaintData && *paint == fLastPaint) {
+            data = fLastPaintData;
+        } else {
+            data = fPaints.findAndReturnFlat(*paint);
+            if (can_reuse_flattened_paint(*paint)) {
+                fLastPaint = *paint;
+                fLastPaintData = data;
+            } else {
+                fLastPaintData = NULL;
+            }
+        }
+    }
     int index = data ? data->index() : 0;
     this->addInt(index);
     return data;
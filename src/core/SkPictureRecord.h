@@ -228,6 +228,11 @@ private:
     SkPaintDictionary fPaints;
     SkRegionDictionary fRegions;
 
+    // The last paint added to fPaints, and its entry there, so that drawing
+    // with the same paint over and over does not flatten it every time.
+    SkPaint fLastPaint;
+    const SkFlatData* fLastPaintData;
+
     SkPathHeap* fPathHeap;  // reference counted
     SkWriter32 fWriter;
 
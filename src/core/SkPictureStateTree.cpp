@@ -36,6 +36,8 @@ SkPictureStateTree::Draw* SkPictureStateTree::appendDraw(uint32_t offset) {
     Draw* draw = static_cast<Draw*>(fAlloc.allocThrow(sizeof(Draw)));
     *draw = fCurrentState;
     draw->fOffset = offset;
+    draw->fBounds.setEmpty();
+    draw->fOpaqueBounds.setEmpty();
     return draw;
 }
 
@@ -13,6 +13,7 @@
 #include "SkChunkAlloc.h"
 #include "SkDeque.h"
 #include "SkMatrix.h"
+#include "SkRect.h"
 #include "SkRefCnt.h"
 
 class SkCanvas;
@@ -30,12 +31,17 @@ public:
 
     /**
      * A draw call, stores offset into command buffer, a pointer to the matrix, and a pointer to
-     * the node in the tree that corresponds to its clip/layer state
+     * the node in the tree that corresponds to its clip/layer state. When the picture is recorded
+     * with SkPicture::kCullOccludedDraws_RecordingFlag, fBounds holds the device area the draw
+     * may touch if it can be skipped when something hides it, and fOpaqueBounds the area it is
+     * known to cover with opaque pixels; both are empty otherwise.
      */
     struct Draw {
         SkMatrix* fMatrix;
         Node* fNode;
         uint32_t fOffset;
+        SkIRect fBounds;
+        SkIRect fOpaqueBounds;
         bool operator<(const Draw& other) const { return fOffset < other.fOffset; }
     };
 
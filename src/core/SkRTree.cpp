@@ -9,6 +9,10 @@
 #include "SkRTree.h"
 #include "SkTSort.h"
 
+#if SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_SSE2
+    #include <emmintrin.h>
+#endif
+
 static inline uint32_t get_area(const SkIRect& rect);
 static inline uint32_t get_overlap(const SkIRect& rect1, const SkIRect& rect2);
 static inline uint32_t get_margin(const SkIRect& rect);
@@ -17,6 +21,57 @@ static inline uint32_t get_overlap_increase(const SkIRect& rect1, const SkIRect&
 static inline uint32_t get_area_increase(const SkIRect& rect1, SkIRect rect2);
 static inline void join_no_empty_check(const SkIRect& joinWith, SkIRect* out);
 
+// Packed nodes start on a cache line, and each of their four bounds arrays on a 16-byte boundary
+static const size_t kPackedAlignment = 64;
+
+/**
+ * Tests four children of a packed node against a query rect, returning a bit mask with bit i set
+ * if child i intersects it. 'bounds' points at the node's left array, the top, right and bottom
+ * arrays follow at multiples of 'stride'.
+ */
+class FourWayIntersector {
+public:
+    explicit FourWayIntersector(const SkIRect& query) {
+#if SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_SSE2
+        fLeft   = _mm_set1_epi32(query.fLeft);
+        fTop    = _mm_set1_epi32(query.fTop);
+        fRight  = _mm_set1_epi32(query.fRight);
+        fBottom = _mm_set1_epi32(query.fBottom);
+#else
+        fQuery = query;
+#endif
+    }
+
+    int test(const int32_t* bounds, int stride) const {
+#if SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_SSE2
+        __m128i l = _mm_load_si128(reinterpret_cast<const __m128i*>(bounds));
+        __m128i t = _mm_load_si128(reinterpret_cast<const __m128i*>(bounds + stride));
+        __m128i r = _mm_load_si128(reinterpret_cast<const __m128i*>(bounds + 2 * stride));
+        __m128i b = _mm_load_si128(reinterpret_cast<const __m128i*>(bounds + 3 * stride));
+        __m128i hit = _mm_and_si128(_mm_cmplt_epi32(l, fRight), _mm_cmplt_epi32(fLeft, r));
+        hit = _mm_and_si128(hit, _mm_cmplt_epi32(t, fBottom));
+        hit = _mm_and_si128(hit, _mm_cmplt_epi32(fTop, b));
+        return _mm_movemask_ps(_mm_castsi128_ps(hit));
+#else
+        int mask = 0;
+        for (int i = 0; i < 4; ++i) {
+            if (bounds[i] < fQuery.fRight && fQuery.fLeft < bounds[2 * stride + i] &&
+                bounds[stride + i] < fQuery.fBottom && fQuery.fTop < bounds[3 * stride + i]) {
+                mask |= 1 << i;
+            }
+        }
+        return mask;
+#endif
+    }
+
+private:
+#if SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_SSE2
+    __m128i fLeft, fTop, fRight, fBottom;
+#else
+    SkIRect fQuery;
+#endif
+};
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
 SK_DEFINE_INST_COUNT(SkRTree)
@@ -35,7 +90,12 @@ SkRTree::SkRTree(int minChildren, int maxChildren, SkScalar aspectRatio)
     , fNodeSize(sizeof(Node) + sizeof(Branch) * maxChildren)
     , fCount(0)
     , fNodes(fNodeSize * 256)
-    , fAspectRatio(aspectRatio) {
+    , fAspectRatio(aspectRatio)
+    , fUsePackedLayout(true)
+    , fPackedDirty(false)
+    , fPackedStride(SkAlign4(maxChildren))
+    , fPackedStorage(NULL)
+    , fPackedBounds(NULL) {
     SkASSERT(minChildren < maxChildren && minChildren > 0 && maxChildren <
              static_cast<int>(SK_MaxU16));
     SkASSERT((maxChildren + 1) / 2 >= minChildren);
@@ -67,6 +127,7 @@ void SkRTree::insert(void* data, const SkIRect& bounds, bool defer) {
         }
     }
 
+    fPackedDirty = true;
     Branch* newSibling = insert(fRoot.fChild.subtree, &newBranch);
     fRoot.fBounds = this->computeBounds(fRoot.fChild.subtree);
 
@@ -96,11 +157,17 @@ void SkRTree::flushDeferredInserts() {
         } else {
             fRoot = this->bulkLoad(&fDeferredInserts);
         }
+        fPackedDirty = true;
     } else {
         // TODO: some algorithm for bulk loading into an already populated tree
         SkASSERT(0 == fDeferredInserts.count());
     }
     fDeferredInserts.rewind();
+    // Build the packed layout now rather than on the first search, so that a tree which is
+    // flushed once and then only queried is not modified by search().
+    if (fUsePackedLayout && fPackedDirty) {
+        this->pack();
+    }
     this->validate();
 }
 
@@ -110,13 +177,49 @@ void SkRTree::search(const SkIRect& query, SkTDArray<void*>* results) {
         this->flushDeferredInserts();
     }
     if (!this->isEmpty() && SkIRect::IntersectsNoEmptyCheck(fRoot.fBounds, query)) {
-        this->search(fRoot.fChild.subtree, query, results);
+        if (fUsePackedLayout) {
+            if (fPackedDirty) {
+                this->pack();
+            }
+            this->searchPacked(0, query, results);
+        } else {
+            this->search(fRoot.fChild.subtree, query, results);
+        }
+    }
+    this->validate();
+}
+
+void SkRTree::searchBatch(const SkIRect queries[], int count, SkTDArray<void*> results[]) {
+    if (!fUsePackedLayout) {
+        this->INHERITED::searchBatch(queries, count, results);
+        return;
+    }
+    this->validate();
+    if (0 != fDeferredInserts.count()) {
+        this->flushDeferredInserts();
+    }
+    if (this->isEmpty()) {
+        return;
+    }
+    if (fPackedDirty) {
+        this->pack();
+    }
+    // Kept on the stack, so that concurrent searches of a finished tree are safe
+    BatchScratch scratch;
+    for (int i = 0; i < count; ++i) {
+        if (SkIRect::IntersectsNoEmptyCheck(fRoot.fBounds, queries[i])) {
+            scratch.fActive.push(i);
+        }
+    }
+    if (scratch.fActive.count() > 0) {
+        this->searchPackedBatch(0, 0, queries, results, &scratch);
     }
     this->validate();
 }
 
 void SkRTree::clear() {
     this->validate();
+    this->freePacked();
     fNodes.reset();
     fDeferredInserts.rewind();
     fCount = 0;
@@ -316,6 +419,155 @@ void SkRTree::search(Node* root, const SkIRect query, SkTDArray<void*>* results)
     }
 }
 
+void SkRTree::pack() {
+    this->freePacked();
+    if (this->isEmpty()) {
+        return;
+    }
+
+    // Lay the nodes out breadth-first, so the children of each interior node are contiguous
+    SkTDArray<Node*> order;
+    order.push(fRoot.fChild.subtree);
+    for (int i = 0; i < order.count(); ++i) {
+        Node* n = order[i];
+        if (!n->isLeaf()) {
+            for (int j = 0; j < n->fNumChildren; ++j) {
+                order.push(n->child(j)->fChild.subtree);
+            }
+        }
+    }
+
+    size_t boundsSize = order.count() * 4 * fPackedStride * sizeof(int32_t);
+    fPackedStorage = sk_malloc_throw(boundsSize + kPackedAlignment - 1);
+    fPackedBounds = reinterpret_cast<int32_t*>(
+        (reinterpret_cast<uintptr_t>(fPackedStorage) + kPackedAlignment - 1) &
+        ~(kPackedAlignment - 1));
+    fPackedNodes.setCount(order.count());
+    fPackedData.setReserve(fCount);
+
+    int nextNode = 1;
+    for (int i = 0; i < order.count(); ++i) {
+        Node* n = order[i];
+        PackedNode& packed = fPackedNodes[i];
+        packed.fLevel = n->fLevel;
+        packed.fNumChildren = n->fNumChildren;
+        if (n->isLeaf()) {
+            packed.fFirstChild = fPackedData.count();
+        } else {
+            packed.fFirstChild = nextNode;
+            nextNode += n->fNumChildren;
+        }
+
+        int32_t* bounds = fPackedBounds + i * 4 * fPackedStride;
+        for (int j = 0; j < fPackedStride; ++j) {
+            if (j < n->fNumChildren) {
+                const SkIRect& r = n->child(j)->fBounds;
+                bounds[j]                     = r.fLeft;
+                bounds[fPackedStride + j]     = r.fTop;
+                bounds[2 * fPackedStride + j] = r.fRight;
+                bounds[3 * fPackedStride + j] = r.fBottom;
+                if (n->isLeaf()) {
+                    fPackedData.push(n->child(j)->fChild.data);
+                }
+            } else {
+                // Padding slots hold an inverted rect, which never intersects anything
+                bounds[j]                     = SK_MaxS32;
+                bounds[fPackedStride + j]     = SK_MaxS32;
+                bounds[2 * fPackedStride + j] = SK_MinS32;
+                bounds[3 * fPackedStride + j] = SK_MinS32;
+            }
+        }
+    }
+    SkASSERT(nextNode == order.count());
+    SkASSERT(fPackedData.count() == (int)fCount);
+    fPackedDirty = false;
+}
+
+void SkRTree::freePacked() {
+    sk_free(fPackedStorage);
+    fPackedStorage = NULL;
+    fPackedBounds = NULL;
+    fPackedNodes.rewind();
+    fPackedData.rewind();
+    fPackedDirty = true;
+}
+
+void SkRTree::searchPacked(int index, const SkIRect& query, SkTDArray<void*>* results) const {
+    const PackedNode& node = fPackedNodes[index];
+    const int32_t* bounds = this->packedBounds(index);
+    FourWayIntersector intersector(query);
+    for (int i = 0; i < node.fNumChildren; i += 4) {
+        int mask = intersector.test(bounds + i, fPackedStride);
+        for (int lane = 0; lane < 4 && 0 != mask; ++lane) {
+            if (0 == (mask & (1 << lane))) {
+                continue;
+            }
+            if (0 == node.fLevel) {
+                results->push(fPackedData[node.fFirstChild + i + lane]);
+            } else {
+                this->searchPacked(node.fFirstChild + i + lane, query, results);
+            }
+        }
+    }
+}
+
+void SkRTree::searchPackedBatch(int index, int activeStart, const SkIRect queries[],
+                                SkTDArray<void*> results[], BatchScratch* scratch) const {
+    SkTDArray<int>& active = scratch->fActive;
+    SkTDArray<uint8_t>& masks = scratch->fMasks;
+    const PackedNode& node = fPackedNodes[index];
+    const int32_t* bounds = this->packedBounds(index);
+    const int activeEnd = active.count();
+    const int activeCount = activeEnd - activeStart;
+    if (1 == activeCount) {
+        // Nothing left to share, so finish off the lone query on its own
+        const int q = active[activeStart];
+        this->searchPacked(index, queries[q], &results[q]);
+        return;
+    }
+
+    for (int i = 0; i < node.fNumChildren; i += 4) {
+        // Test this group of four children against every active query up front, since visiting
+        // a child pushes onto (and may reallocate) the scratch arrays.
+        const int masksStart = masks.count();
+        uint8_t* groupMasks = masks.append(activeCount);
+        int anyHit = 0;
+        for (int a = 0; a < activeCount; ++a) {
+            FourWayIntersector intersector(queries[active[activeStart + a]]);
+            groupMasks[a] = intersector.test(bounds + i, fPackedStride);
+            anyHit |= groupMasks[a];
+        }
+
+        for (int lane = 0; lane < 4 && 0 != anyHit; ++lane) {
+            if (0 == (anyHit & (1 << lane))) {
+                continue;
+            }
+            const int child = node.fFirstChild + i + lane;
+            if (0 == node.fLevel) {
+                void* data = fPackedData[child];
+                for (int a = 0; a < activeCount; ++a) {
+                    if (masks[masksStart + a] & (1 << lane)) {
+                        results[active[activeStart + a]].push(data);
+                    }
+                }
+            } else {
+                const int childStart = active.count();
+                for (int a = 0; a < activeCount; ++a) {
+                    if (masks[masksStart + a] & (1 << lane)) {
+                        // copy first, the push may reallocate the array
+                        int query = active[activeStart + a];
+                        active.push(query);
+                    }
+                }
+                this->searchPackedBatch(child, childStart, queries, results, scratch);
+                active.setCount(childStart);
+            }
+        }
+        masks.setCount(masksStart);
+    }
+    SkASSERT(active.count() == activeEnd);
+}
+
 SkRTree::Branch SkRTree::bulkLoad(SkTDArray<Branch>* branches, int level) {
     if (branches->count() == 1) {
         // Only one branch: it will be the root
@@ -39,6 +39,11 @@
  * It also supports bulk-loading from a batch of bounds and values; if you don't require the tree
  * to be usable in its intermediate states while it is being constructed, this is significantly
  * quicker than individual insertions and produces more consistent trees.
+ *
+ * Queries are not run against the nodes built during insertion. Once the tree is complete it is
+ * copied into a packed, read-only layout: nodes are stored breadth-first so that siblings are
+ * contiguous, and each node keeps the bounds of its children as four cache-line aligned arrays
+ * (left, top, right, bottom), which lets four children be tested against a query at once.
  */
 class SkRTree : public SkBBoxHierarchy {
 public:
@@ -78,6 +83,19 @@ public:
      */
     virtual void search(const SkIRect& query, SkTDArray<void*>* results);
 
+    /**
+     * Runs many queries (e.g. one per tile) in a single traversal: a node is only visited once
+     * for all of the queries that intersect it.
+     */
+    virtual void searchBatch(const SkIRect queries[], int count,
+                             SkTDArray<void*> results[]) SK_OVERRIDE;
+
+    /**
+     * Selects whether queries use the packed layout (the default) or walk the insertion nodes
+     * directly. The latter exists mainly so the two can be compared in benchmarks.
+     */
+    void setUsePackedLayout(bool usePacked) { fUsePackedLayout = usePacked; }
+
     virtual void clear();
     bool isEmpty() const { return 0 == fCount; }
     int getDepth() const { return this->isEmpty() ? 0 : fRoot.fChild.subtree->fLevel + 1; }
@@ -130,20 +148,32 @@ private:
         const SkRTree::SortSide fSide;
     };
 
+    // Helpers for sorting branches by the centers of their rects (used by the bulk load)
     struct RectLessX {
         bool operator()(const SkRTree::Branch lhs, const SkRTree::Branch rhs) {
-            return ((lhs.fBounds.fRight - lhs.fBounds.fLeft) >> 1) <
-                   ((rhs.fBounds.fRight - lhs.fBounds.fLeft) >> 1);
+            return ((lhs.fBounds.fLeft >> 1) + (lhs.fBounds.fRight >> 1)) <
+                   ((rhs.fBounds.fLeft >> 1) + (rhs.fBounds.fRight >> 1));
         }
     };
 
     struct RectLessY {
         bool operator()(const SkRTree::Branch lhs, const SkRTree::Branch rhs) {
-            return ((lhs.fBounds.fBottom - lhs.fBounds.fTop) >> 1) <
-                   ((rhs.fBounds.fBottom - lhs.fBounds.fTop) >> 1);
+            return ((lhs.fBounds.fTop >> 1) + (lhs.fBounds.fBottom >> 1)) <
+                   ((rhs.fBounds.fTop >> 1) + (rhs.fBounds.fBottom >> 1));
         }
     };
 
+    /**
+     * A node of the packed layout. The bounds of its children live in fPackedBounds, at
+     * packedBounds(index); fFirstChild indexes fPackedNodes for interior nodes, and fPackedData
+     * for leaves.
+     */
+    struct PackedNode {
+        int32_t fLevel;
+        int32_t fNumChildren;
+        int32_t fFirstChild;
+    };
+
     SkRTree(int minChildren, int maxChildren, SkScalar aspectRatio);
 
     /**
@@ -157,6 +187,32 @@ private:
     int distributeChildren(Branch* children);
     void search(Node* root, const SkIRect query, SkTDArray<void*>* results) const;
 
+    /**
+     * Rebuilds the packed layout from the current tree.
+     */
+    void pack();
+    void freePacked();
+    const int32_t* packedBounds(int index) const {
+        return fPackedBounds + index * 4 * fPackedStride;
+    }
+    void searchPacked(int index, const SkIRect& query, SkTDArray<void*>* results) const;
+
+    /**
+     * Scratch space for searchBatch(). The indices of the queries that hit a node are kept in
+     * fActive while that node is visited, with each child's list pushed on top of its parent's.
+     * fMasks likewise holds the per-query hit masks of the group of children being visited.
+     */
+    struct BatchScratch {
+        SkTDArray<int> fActive;
+        SkTDArray<uint8_t> fMasks;
+    };
+
+    /**
+     * Visits packed node 'index' for the queries listed in scratch->fActive[activeStart..end).
+     */
+    void searchPackedBatch(int index, int activeStart, const SkIRect queries[],
+                           SkTDArray<void*> results[], BatchScratch* scratch) const;
+
     /**
      * This performs a bottom-up bulk load using the STR (sort-tile-recursive) algorithm, this
      * seems to generally produce better, more consistent trees at significantly lower cost than
@@ -185,6 +241,15 @@ private:
     SkTDArray<Branch> fDeferredInserts;
     SkScalar fAspectRatio;
 
+    // Packed copy of the tree that queries run against, see pack()
+    bool fUsePackedLayout;
+    bool fPackedDirty;
+    int fPackedStride;          // child slots per packed node, a multiple of four
+    void* fPackedStorage;       // unaligned allocation backing fPackedBounds
+    int32_t* fPackedBounds;
+    SkTDArray<PackedNode> fPackedNodes;
+    SkTDArray<void*> fPackedData;
+
     Node* allocateNode(uint16_t level);
 
     typedef SkBBoxHierarchy INHERITED;
@@ -61,6 +61,19 @@ public:
     static void HairPath(const SkPath&, const SkRasterClip&, SkBlitter*);
     static void AntiHairPath(const SkPath&, const SkRasterClip&, SkBlitter*);
 
+    /**
+     *  Selects how AntiFillPath() computes coverage. By default it supersamples
+     *  each pixel row, walking every edge SCALE times per row. If this is set
+     *  to true it instead computes the exact area of each pixel that the path
+     *  covers, walking every edge once per row. That is faster for most paths
+     *  and at least as accurate, but does not give bit-identical results.
+     *  Inverse fills, and fills into an antialiased clip, always supersample.
+     *
+     *  This is not thread-safe: set it before any drawing starts.
+     */
+    static void SetAnalyticAA(bool);
+    static bool IsAnalyticAA();
+
 private:
     friend class SkAAClip;
     friend class SkRegion;
@@ -84,6 +97,8 @@ private:
     static void FillPath(const SkPath&, const SkRegion& clip, SkBlitter*);
     static void AntiFillPath(const SkPath&, const SkRegion& clip, SkBlitter*,
                              bool forceRLE = false);
+    // Returns false, having drawn nothing, if the path's coordinates are too large for it
+    static bool AnalyticFillPath(const SkPath&, const SkRegion& clip, SkBlitter*);
     static void FillTriangle(const SkPoint pts[], const SkRegion*, SkBlitter*);
 
     static void AntiFrameRect(const SkRect&, const SkPoint& strokeSize,
@@ -0,0 +1,528 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkScanPriv.h"
+#include "SkBlitter.h"
+#include "SkFloatingPoint.h"
+#include "SkGeometry.h"
+#include "SkPath.h"
+#include "SkRegion.h"
+#include "SkTDArray.h"
+#include "SkTemplates.h"
+#include "SkTSort.h"
+
+#if SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_SSE2
+    #include <emmintrin.h>
+#endif
+
+/** @file
+    An antialiasing scan converter that computes the exact area of each pixel
+    covered by the path, instead of supersampling it.
+
+    The path is flattened into lines. For each pixel row, every line crossing
+    the row adds the signed area it sweeps to a dense row of accumulators:
+    each cell receives the change in coverage between the pixel to its left
+    and itself. A running sum along the row then gives each pixel's signed
+    coverage, which the fill type turns into an alpha. Each line is visited
+    once per pixel row, where the supersampler walks each edge SCALE times.
+
+    Coverage is exact wherever the winding number is the same across a whole
+    pixel; pixels in which edges of a self-intersecting path cross are
+    approximated.
+ */
+
+static bool gAnalyticAA;
+
+void SkScan::SetAnalyticAA(bool analytic) {
+    gAnalyticAA = analytic;
+}
+
+bool SkScan::IsAnalyticAA() {
+    return gAnalyticAA;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Curves are flattened into lines no further than this from the curve, in pixels.
+static const float kFlattenTolerance = 0.05f;
+static const int kMaxCurveLines = 64;
+
+// Coordinates beyond this are rejected, so that the row math stays exact enough.
+static const float kMaxCoord = 16384.0f;
+
+/**
+ * For the quad or cubic whose second differences are (ddx, ddy), returns how many lines
+ * approximate it within kFlattenTolerance. 'scale' bounds the distance of the curve from
+ * n lines as scale * |dd| / n^2.
+ */
+static int curve_lines(float ddx, float ddy, float scale) {
+    float dist = scale * sk_float_sqrt(ddx * ddx + ddy * ddy);
+    int n = (int)sk_float_ceil(sk_float_sqrt(dist / kFlattenTolerance));
+    return SkPin32(n, 1, kMaxCurveLines);
+}
+
+static inline float pin_x(float x, float width) {
+    return x < 0 ? 0 : (x > width ? width : x);
+}
+
+namespace {
+
+// A line of the flattened path, relative to the left and top of the area being filled.
+struct CoverageLine {
+    float fX0, fY0;     // the upper end
+    float fY1;          // the lower end's y
+    float fDxDy;
+    float fDir;         // 1 if the path went down this line, -1 if it went up
+
+    bool operator<(const CoverageLine& other) const { return fY0 < other.fY0; }
+};
+
+// Cells [fStart, fStop) of the current row, which some line has added to.
+struct CoverageSpan {
+    int fStart, fStop;
+
+    bool operator<(const CoverageSpan& other) const { return fStart < other.fStart; }
+};
+
+}
+
+/**
+ * Writes the alpha of each pixel in [start, stop), given the accumulated changes in coverage
+ * 'acc' and the signed coverage 'sum' left of 'start'. Both indices are multiples of 4. Clears
+ * the accumulators on the way, and returns the signed coverage at the end.
+ */
+static float resolve_row(float* SK_RESTRICT acc, uint8_t* SK_RESTRICT alpha,
+                         int start, int stop, float sum, bool evenOdd) {
+    SkASSERT(0 == (start & 3) && 0 == (stop & 3));
+#if SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_SSE2
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 scale = _mm_set1_ps(255.0f);
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    __m128 carry = _mm_set1_ps(sum);
+    for (int x = start; x < stop; x += 4) {
+        // Prefix sum of the four cells, plus everything to their left
+        __m128 v = _mm_loadu_ps(acc + x);
+        v = _mm_add_ps(v, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v), 4)));
+        v = _mm_add_ps(v, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v), 8)));
+        v = _mm_add_ps(v, carry);
+        carry = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3));
+        _mm_storeu_ps(acc + x, zero);
+
+        __m128 c = _mm_and_ps(v, absMask);
+        if (evenOdd) {
+            // Fold |winding| into [0, 2), then into a triangle wave peaking at 1
+            __m128 pairs = _mm_cvtepi32_ps(_mm_cvttps_epi32(_mm_mul_ps(c, half)));
+            c = _mm_sub_ps(c, _mm_mul_ps(pairs, two));
+            c = _mm_sub_ps(one, _mm_and_ps(_mm_sub_ps(c, one), absMask));
+        } else {
+            c = _mm_min_ps(c, one);
+        }
+        __m128i a = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(c, scale), half));
+        a = _mm_packs_epi32(a, a);
+        a = _mm_packus_epi16(a, a);
+        *reinterpret_cast<int32_t*>(alpha + x) = _mm_cvtsi128_si32(a);
+    }
+    return _mm_cvtss_f32(carry);
+#else
+    for (int x = start; x < stop; ++x) {
+        sum += acc[x];
+        acc[x] = 0;
+        float c = sk_float_abs(sum);
+        if (evenOdd) {
+            c -= 2 * (int)(c * 0.5f);
+            c = 1 - sk_float_abs(c - 1);
+        } else if (c > 1) {
+            c = 1;
+        }
+        alpha[x] = (uint8_t)(c * 255 + 0.5f);
+    }
+    return sum;
+#endif
+}
+
+namespace {
+
+class CoverageAccumulator {
+public:
+    /**
+     * Fills within 'bounds', which must not be wider than the runs of an SkBlitter can
+     * describe.
+     */
+    CoverageAccumulator(const SkIRect& bounds, bool evenOdd);
+
+    void addPath(const SkPath& path);
+
+    /** Blits the coverage of the lines added so far, one row at a time. */
+    void blit(SkBlitter* blitter);
+
+private:
+    void addLine(const SkPoint& p0, const SkPoint& p1);
+    void addQuad(const SkPoint pts[3]);
+    void addCubic(const SkPoint pts[4]);
+    void appendLine(float x0, float y0, float x1, float y1, float dir);
+
+    void accumulate(const CoverageLine& line, int y);
+    void blitRow(SkBlitter* blitter, int y);
+
+    SkIRect fBounds;
+    int     fWidth;
+    bool    fEvenOdd;
+
+    SkTDArray<CoverageLine> fLines;
+
+    // One more cell than there are pixels, since a line may end on the right edge of the last,
+    // and padded to whole SIMD blocks.
+    SkAutoTMalloc<float>    fAcc;
+    SkAutoTMalloc<uint8_t>  fAlpha;
+    SkAutoTMalloc<int16_t>  fRuns;
+    // The cells of the current row that lines have touched
+    SkTDArray<CoverageSpan> fSpans;
+};
+
+CoverageAccumulator::CoverageAccumulator(const SkIRect& bounds, bool evenOdd)
+    : fBounds(bounds)
+    , fWidth(bounds.width())
+    , fEvenOdd(evenOdd)
+    , fAcc(SkAlign4(bounds.width() + 2))
+    , fAlpha(SkAlign4(bounds.width() + 2))
+    , fRuns(bounds.width() + 1) {
+    sk_bzero(fAcc.get(), SkAlign4(fWidth + 2) * sizeof(float));
+}
+
+void CoverageAccumulator::addPath(const SkPath& path) {
+    fLines.setReserve(path.countPoints() + 1);
+
+    SkPath::Iter iter(path, true);
+    SkPoint pts[4];
+    SkPath::Verb verb;
+    while ((verb = iter.next(pts)) != SkPath::kDone_Verb) {
+        switch (verb) {
+            case SkPath::kLine_Verb:
+                this->addLine(pts[0], pts[1]);
+                break;
+            case SkPath::kQuad_Verb:
+                this->addQuad(pts);
+                break;
+            case SkPath::kCubic_Verb:
+                this->addCubic(pts);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+void CoverageAccumulator::addQuad(const SkPoint pts[3]) {
+    int n = curve_lines(SkScalarToFloat(pts[0].fX - 2 * pts[1].fX + pts[2].fX),
+                        SkScalarToFloat(pts[0].fY - 2 * pts[1].fY + pts[2].fY), 0.25f);
+    SkPoint prev = pts[0];
+    for (int i = 1; i < n; ++i) {
+        SkPoint pt;
+        SkEvalQuadAt(pts, SkScalarDiv(SkIntToScalar(i), SkIntToScalar(n)), &pt);
+        this->addLine(prev, pt);
+        prev = pt;
+    }
+    this->addLine(prev, pts[2]);
+}
+
+void CoverageAccumulator::addCubic(const SkPoint pts[4]) {
+    SkScalar ddx = SkMaxScalar(SkScalarAbs(pts[0].fX - 2 * pts[1].fX + pts[2].fX),
+                               SkScalarAbs(pts[1].fX - 2 * pts[2].fX + pts[3].fX));
+    SkScalar ddy = SkMaxScalar(SkScalarAbs(pts[0].fY - 2 * pts[1].fY + pts[2].fY),
+                               SkScalarAbs(pts[1].fY - 2 * pts[2].fY + pts[3].fY));
+    int n = curve_lines(SkScalarToFloat(ddx), SkScalarToFloat(ddy), 0.75f);
+    SkPoint prev = pts[0];
+    for (int i = 1; i < n; ++i) {
+        SkPoint pt;
+        SkEvalCubicAt(pts, SkScalarDiv(SkIntToScalar(i), SkIntToScalar(n)), &pt, NULL, NULL);
+        this->addLine(prev, pt);
+        prev = pt;
+    }
+    this->addLine(prev, pts[3]);
+}
+
+void CoverageAccumulator::addLine(const SkPoint& p0, const SkPoint& p1) {
+    float x0 = SkScalarToFloat(p0.fX) - fBounds.fLeft;
+    float y0 = SkScalarToFloat(p0.fY) - fBounds.fTop;
+    float x1 = SkScalarToFloat(p1.fX) - fBounds.fLeft;
+    float y1 = SkScalarToFloat(p1.fY) - fBounds.fTop;
+    float dir = 1;
+    if (y0 == y1) {
+        return;
+    }
+    if (y0 > y1) {
+        SkTSwap(x0, x1);
+        SkTSwap(y0, y1);
+        dir = -1;
+    }
+
+    // Only the rows we fill matter
+    const float height = (float)fBounds.height();
+    if (y1 <= 0 || y0 >= height) {
+        return;
+    }
+    const float dxdy = (x1 - x0) / (y1 - y0);
+    if (y0 < 0) {
+        x0 -= y0 * dxdy;
+        y0 = 0;
+    }
+    if (y1 > height) {
+        x1 -= (y1 - height) * dxdy;
+        y1 = height;
+    }
+
+    // To the right of the area, a line changes nothing we draw. To the left, it still changes
+    // the winding of everything to its right, as if it ran down the left edge.
+    const float width = (float)fWidth;
+    if (x0 >= width && x1 >= width) {
+        return;
+    }
+    if (x0 <= 0 && x1 <= 0) {
+        this->appendLine(0, y0, 0, y1, dir);
+        return;
+    }
+    if (x0 >= 0 && x1 >= 0 && x0 <= width && x1 <= width) {
+        this->appendLine(x0, y0, x1, y1, dir);
+        return;
+    }
+
+    // Split the line where it crosses the left and right edges
+    const float dydx = (y1 - y0) / (x1 - x0);
+    float ys[4] = { y0, y0, y0, y1 };
+    int count = 1;
+    if ((x0 < 0) != (x1 < 0)) {
+        ys[count++] = y0 - x0 * dydx;
+    }
+    if ((x0 < width) != (x1 < width)) {
+        ys[count++] = y0 + (width - x0) * dydx;
+    }
+    if (3 == count && ys[2] < ys[1]) {
+        SkTSwap(ys[1], ys[2]);
+    }
+    ys[count] = y1;
+    for (int i = 0; i < count; ++i) {
+        float top = ys[i];
+        float bottom = SkTMax(ys[i + 1], top);
+        float midX = x0 + ((top + bottom) * 0.5f - y0) * dxdy;
+        if (midX >= width || top == bottom) {
+            continue;
+        }
+        if (midX <= 0) {
+            this->appendLine(0, top, 0, bottom, dir);
+        } else {
+            this->appendLine(pin_x(x0 + (top - y0) * dxdy, width), top,
+                             pin_x(x0 + (bottom - y0) * dxdy, width), bottom, dir);
+        }
+    }
+}
+
+void CoverageAccumulator::appendLine(float x0, float y0, float x1, float y1, float dir) {
+    SkASSERT(y0 < y1);
+    CoverageLine* line = fLines.append();
+    line->fX0 = x0;
+    line->fY0 = y0;
+    line->fY1 = y1;
+    line->fDxDy = (x1 - x0) / (y1 - y0);
+    line->fDir = dir;
+}
+
+void CoverageAccumulator::accumulate(const CoverageLine& line, int y) {
+    const float top = SkTMax((float)y, line.fY0);
+    const float bottom = SkTMin((float)(y + 1), line.fY1);
+    const float dy = bottom - top;
+    if (dy <= 0) {
+        return;
+    }
+    const float width = (float)fWidth;
+    const float xa = pin_x(line.fX0 + (top - line.fY0) * line.fDxDy, width);
+    const float xb = pin_x(line.fX0 + (bottom - line.fY0) * line.fDxDy, width);
+    const float d = dy * line.fDir;
+    const float x0 = SkTMin(xa, xb);
+    const float x1 = SkTMax(xa, xb);
+    // Both are non-negative, so truncating is flooring
+    const int x0i = (int)x0;
+    int x1i = (int)x1;
+    if ((float)x1i < x1) {
+        x1i += 1;
+    }
+    float* acc = fAcc.get();
+
+    if (x1i <= x0i + 1) {
+        // The line stays within one pixel: it covers the part of the pixel right of its middle
+        const float xmf = 0.5f * (xa + xb) - x0i;
+        acc[x0i] += d - d * xmf;
+        acc[x0i + 1] += d * xmf;
+        x1i = x0i + 1;
+    } else {
+        // The area the line sweeps grows quadratically across its first and last pixels, and
+        // linearly in between
+        const float s = 1 / (x1 - x0);
+        const float x0f = x0 - x0i;
+        const float a0 = 0.5f * s * (1 - x0f) * (1 - x0f);
+        const float x1f = x1 - x1i + 1;
+        const float am = 0.5f * s * x1f * x1f;
+        acc[x0i] += d * a0;
+        if (x1i == x0i + 2) {
+            acc[x0i + 1] += d * (1 - a0 - am);
+        } else {
+            const float a1 = s * (1.5f - x0f);
+            acc[x0i + 1] += d * (a1 - a0);
+            const float ds = d * s;
+            for (int x = x0i + 2; x < x1i - 1; ++x) {
+                acc[x] += ds;
+            }
+            const float a2 = a1 + (x1i - x0i - 3) * s;
+            acc[x1i - 1] += d * (1 - a2 - am);
+        }
+        acc[x1i] += d * am;
+    }
+    CoverageSpan* span = fSpans.append();
+    span->fStart = x0i;
+    span->fStop = x1i + 1;
+}
+
+void CoverageAccumulator::blitRow(SkBlitter* blitter, int y) {
+    if (fSpans.isEmpty()) {
+        return;
+    }
+
+    // Widen the touched spans to whole SIMD blocks and merge the ones that then overlap
+    CoverageSpan* spans = fSpans.begin();
+    SkTQSort<CoverageSpan>(spans, fSpans.end() - 1);
+    int spanCount = 0;
+    for (int i = 0; i < fSpans.count(); ++i) {
+        const int start = spans[i].fStart & ~3;
+        const int stop = SkAlign4(spans[i].fStop);
+        if (spanCount > 0 && start <= spans[spanCount - 1].fStop) {
+            spans[spanCount - 1].fStop = SkMax32(spans[spanCount - 1].fStop, stop);
+        } else {
+            spans[spanCount].fStart = start;
+            spans[spanCount].fStop = stop;
+            ++spanCount;
+        }
+    }
+    fSpans.rewind();
+
+    // Only the spans need resolving: coverage is constant between them, and to the right of
+    // the last one. Each of those stretches becomes a single run.
+    uint8_t* alpha = fAlpha.get();
+    int16_t* runs = fRuns.get();
+    float sum = 0;
+    int first = -1;     // start of the first run with coverage
+    int end = 0;        // end of the last run with coverage
+    int x = spans[0].fStart;
+    for (int i = 0; i <= spanCount; ++i) {
+        const int start = i < spanCount ? SkMin32(spans[i].fStart, fWidth) : fWidth;
+        if (start > x) {
+            const uint8_t a = alpha[x - 1];
+            alpha[x] = a;
+            runs[x] = SkToS16(start - x);
+            if (a) {
+                end = start;
+            }
+            x = start;
+        }
+        if (i == spanCount) {
+            break;
+        }
+
+        sum = resolve_row(fAcc.get(), alpha, spans[i].fStart, spans[i].fStop, sum, fEvenOdd);
+        const int stop = SkMin32(spans[i].fStop, fWidth);
+        while (x < stop) {
+            const uint8_t a = alpha[x];
+            int n = 1;
+            while (x + n < stop && alpha[x + n] == a) {
+                ++n;
+            }
+            runs[x] = SkToS16(n);
+            if (a) {
+                if (first < 0) {
+                    first = x;
+                }
+                end = x + n;
+            }
+            x += n;
+        }
+    }
+    if (first < 0) {
+        return;
+    }
+    runs[end] = 0;
+    blitter->blitAntiH(fBounds.fLeft + first, fBounds.fTop + y, alpha + first, runs + first);
+}
+
+void CoverageAccumulator::blit(SkBlitter* blitter) {
+    const int count = fLines.count();
+    if (0 == count) {
+        return;
+    }
+    SkTQSort<CoverageLine>(fLines.begin(), fLines.end() - 1);
+
+    SkTDArray<const CoverageLine*> active;
+    int next = 0;
+    int y = (int)fLines[0].fY0;
+    const int height = fBounds.height();
+    while (y < height) {
+        if (active.isEmpty()) {
+            if (next == count) {
+                break;
+            }
+            // Skip the rows no line crosses
+            y = SkMax32(y, (int)fLines[next].fY0);
+        }
+        while (next < count && fLines[next].fY0 < (float)(y + 1)) {
+            *active.append() = &fLines[next++];
+        }
+
+        for (int i = 0; i < active.count(); ) {
+            const CoverageLine* line = active[i];
+            this->accumulate(*line, y);
+            if (line->fY1 <= (float)(y + 1)) {
+                active.removeShuffle(i);
+            } else {
+                ++i;
+            }
+        }
+        this->blitRow(blitter, y);
+        ++y;
+    }
+}
+
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool SkScan::AnalyticFillPath(const SkPath& path, const SkRegion& clip, SkBlitter* blitter) {
+    SkASSERT(!path.isInverseFillType());
+    if (clip.isEmpty()) {
+        return true;
+    }
+
+    const SkRect& r = path.getBounds();
+    if (!(r.fLeft > -kMaxCoord && r.fTop > -kMaxCoord &&
+          r.fRight < kMaxCoord && r.fBottom < kMaxCoord)) {
+        return false;
+    }
+    SkIRect ir;
+    r.roundOut(&ir);
+    if (ir.isEmpty() || !ir.intersect(clip.getBounds())) {
+        return true;
+    }
+
+    SkScanClipper clipper(blitter, &clip, ir);
+    if (NULL == clipper.getBlitter()) {
+        return true;
+    }
+
+    CoverageAccumulator accumulator(ir, SkPath::kEvenOdd_FillType == path.getFillType());
+    accumulator.addPath(path);
+    accumulator.blit(clipper.getBlitter());
+    return true;
+}
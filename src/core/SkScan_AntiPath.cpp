@@ -734,6 +734,10 @@ void SkScan::AntiFillPath(const SkPath& path, const SkRasterClip& clip,
     }
 
     if (clip.isBW()) {
+        if (IsAnalyticAA() && !path.isInverseFillType() &&
+            AnalyticFillPath(path, clip.bwRgn(), blitter)) {
+            return;
+        }
         AntiFillPath(path, clip.bwRgn(), blitter);
     } else {
         SkRegion        tmp;
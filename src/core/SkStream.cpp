@@ -46,6 +46,11 @@ const void* SkStream::getMemoryBase()
     return NULL;
 }
 
+SkData* SkStream::readSharedData(size_t length) {
+    // override in subclass if you can share your memory
+    return NULL;
+}
+
 size_t SkStream::skip(size_t size)
 {
     /*  Check for size == 0, and just return 0. If we passed that
@@ -290,16 +295,19 @@ static SkData* newFromParams(const void* src, size_t size, bool copyData) {
 SkMemoryStream::SkMemoryStream() {
     fData = SkData::NewEmpty();
     fOffset = 0;
+    fCanShareData = true;
 }
 
 SkMemoryStream::SkMemoryStream(size_t size) {
     fData = SkData::NewFromMalloc(sk_malloc_throw(size), size);
     fOffset = 0;
+    fCanShareData = true;
 }
 
 SkMemoryStream::SkMemoryStream(const void* src, size_t size, bool copyData) {
     fData = newFromParams(src, size, copyData);
     fOffset = 0;
+    fCanShareData = copyData;
 }
 
 SkMemoryStream::SkMemoryStream(SkData* data) {
@@ -310,6 +318,7 @@ SkMemoryStream::SkMemoryStream(SkData* data) {
         fData->ref();
     }
     fOffset = 0;
+    fCanShareData = true;
 }
 
 SkMemoryStream::~SkMemoryStream() {
@@ -320,12 +329,14 @@ void SkMemoryStream::setMemoryOwned(const void* src, size_t size) {
     fData->unref();
     fData = SkData::NewFromMalloc(src, size);
     fOffset = 0;
+    fCanShareData = true;
 }
 
 void SkMemoryStream::setMemory(const void* src, size_t size, bool copyData) {
     fData->unref();
     fData = newFromParams(src, size, copyData);
     fOffset = 0;
+    fCanShareData = copyData;
 }
 
 SkData* SkMemoryStream::copyToData() const {
@@ -341,6 +352,7 @@ SkData* SkMemoryStream::setData(SkData* data) {
         fData = data;
         fData->ref();
     }
+    fCanShareData = true;
     return data;
 }
 
@@ -379,6 +391,15 @@ const void* SkMemoryStream::getMemoryBase() {
     return fData->data();
 }
 
+SkData* SkMemoryStream::readSharedData(size_t length) {
+    if (!fCanShareData || length > fData->size() - fOffset) {
+        return NULL;
+    }
+    SkData* data = SkData::NewSubset(fData, fOffset, length);
+    fOffset += length;
+    return data;
+}
+
 const void* SkMemoryStream::getAtPos() {
     return fData->bytes() + fOffset;
 }
@@ -0,0 +1,186 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkTLRUCache_DEFINED
+#define SkTLRUCache_DEFINED
+
+#include "SkTDArray.h"
+#include "SkTypes.h"
+
+/**
+ *  The bookkeeping shared by the process-wide caches (masks, mip levels, gradient tables):
+ *  entries are chained into a hash table for lookup, and into a list ordered from most to
+ *  least recently used, which is purged from its end to keep the entries within a byte budget.
+ *
+ *  It does no locking of its own; each cache guards its SkTLRUCache with a static mutex.
+ *
+ *  T must have these fields, which only the cache touches:
+ *      uint32_t    fHash;
+ *      T*          fHashNext;
+ *      T*          fPrev;      // more recently used
+ *      T*          fNext;      // less recently used
+ *  and these methods:
+ *      bool equals(const Key&) const;  // only called on entries with the key's hash
+ *      size_t bytes() const;           // must not change while the entry is cached
+ *      static void Free(T*);           // called on the entries the cache drops
+ */
+template <typename T, typename Key> class SkTLRUCache : SkNoncopyable {
+public:
+    explicit SkTLRUCache(size_t limit)
+        : fHead(NULL)
+        , fTail(NULL)
+        , fCount(0)
+        , fBytesUsed(0)
+        , fLimit(limit)
+        , fHitCount(0)
+        , fMissCount(0) {
+        fBuckets.setCount(kInitialBucketCount);
+        sk_bzero(fBuckets.begin(), fBuckets.count() * sizeof(T*));
+    }
+
+    /**
+     *  Returns the entry for 'key', making it the most recently used, or NULL. Counts as a hit
+     *  or a miss.
+     */
+    T* find(const Key& key, uint32_t hash) {
+        T* entry = this->lookup(key, hash);
+        if (NULL == entry) {
+            ++fMissCount;
+            return NULL;
+        }
+        this->detach(entry);
+        this->attachToHead(entry);
+        ++fHitCount;
+        return entry;
+    }
+
+    /**
+     *  Returns the entry for 'key', or NULL, without touching the list or the counts.
+     */
+    T* lookup(const Key& key, uint32_t hash) const {
+        for (T* entry = fBuckets[hash & (fBuckets.count() - 1)]; entry;
+             entry = entry->fHashNext) {
+            if (entry->fHash == hash && entry->equals(key)) {
+                return entry;
+            }
+        }
+        return NULL;
+    }
+
+    /**
+     *  Adds 'entry', which must not already have a match in the cache, as the most recently
+     *  used, and then purges down to the limit. The purge may drop 'entry' itself if it is
+     *  bigger than the limit, so the caller should take what it needs from it first.
+     */
+    void add(T* entry) {
+        T** bucket = &fBuckets[entry->fHash & (fBuckets.count() - 1)];
+        entry->fHashNext = *bucket;
+        *bucket = entry;
+        this->attachToHead(entry);
+        ++fCount;
+        fBytesUsed += entry->bytes();
+        if (fCount > fBuckets.count()) {
+            this->growBuckets();
+        }
+        this->purge(fLimit);
+    }
+
+    size_t getLimit() const { return fLimit; }
+
+    size_t setLimit(size_t bytes) {
+        size_t prevLimit = fLimit;
+        fLimit = bytes;
+        this->purge(fLimit);
+        return prevLimit;
+    }
+
+    size_t getBytesUsed() const { return fBytesUsed; }
+
+    void purgeAll() {
+        this->purge(0);
+    }
+
+    int getHitCount() const { return fHitCount; }
+    int getMissCount() const { return fMissCount; }
+
+private:
+    enum {
+        kInitialBucketCount = 64,   // must be a power of 2
+    };
+
+    void attachToHead(T* entry) {
+        entry->fPrev = NULL;
+        entry->fNext = fHead;
+        if (fHead) {
+            fHead->fPrev = entry;
+        } else {
+            fTail = entry;
+        }
+        fHead = entry;
+    }
+
+    void detach(T* entry) {
+        if (entry->fPrev) {
+            entry->fPrev->fNext = entry->fNext;
+        } else {
+            fHead = entry->fNext;
+        }
+        if (entry->fNext) {
+            entry->fNext->fPrev = entry->fPrev;
+        } else {
+            fTail = entry->fPrev;
+        }
+        entry->fPrev = entry->fNext = NULL;
+    }
+
+    // Drops the least recently used entries until at most 'bytes' are used
+    void purge(size_t bytes) {
+        while (fBytesUsed > bytes) {
+            T* entry = fTail;
+            SkASSERT(entry);
+            this->detach(entry);
+
+            T** prev = &fBuckets[entry->fHash & (fBuckets.count() - 1)];
+            while (*prev != entry) {
+                prev = &(*prev)->fHashNext;
+            }
+            *prev = entry->fHashNext;
+
+            --fCount;
+            fBytesUsed -= entry->bytes();
+            T::Free(entry);
+        }
+    }
+
+    void growBuckets() {
+        SkTDArray<T*> buckets;
+        buckets.setCount(fBuckets.count() * 2);
+        sk_bzero(buckets.begin(), buckets.count() * sizeof(T*));
+        const int mask = buckets.count() - 1;
+        for (int i = 0; i < fBuckets.count(); ++i) {
+            T* entry = fBuckets[i];
+            while (entry) {
+                T* next = entry->fHashNext;
+                entry->fHashNext = buckets[entry->fHash & mask];
+                buckets[entry->fHash & mask] = entry;
+                entry = next;
+            }
+        }
+        fBuckets.swap(buckets);
+    }
+
+    SkTDArray<T*>   fBuckets;
+    T*              fHead;
+    T*              fTail;
+    int             fCount;
+    size_t          fBytesUsed;
+    size_t          fLimit;
+    int             fHitCount;
+    int             fMissCount;
+};
+
+#endif
@@ -88,17 +88,19 @@ void SkTileGrid::search(const SkIRect& query, SkTDArray<void*>* results) {
     int queryTileCount = (tileEndX - tileStartX) * (tileEndY - tileStartY);
     SkASSERT(queryTileCount);
     if (queryTileCount == 1) {
+        // Copies into the existing storage of 'results' if it is large enough
         *results = this->tile(tileStartX, tileStartY);
     } else {
-        results->reset();
-        SkTDArray<int> curPositions;
-        curPositions.setCount(queryTileCount);
+        // rewind rather than reset, so a reused 'results' array keeps its storage
+        results->rewind();
         // Note: Reserving space for 1024 tile pointers on the stack. If the
         // malloc becomes a bottleneck, we may consider increasing that number.
         // Typical large web page, say 2k x 16k, would require 512 tiles of
         // size 256 x 256 pixels.
         SkAutoSTArray<1024, SkTDArray<void *>*> storage(queryTileCount);
+        SkAutoSTArray<1024, int> positions(queryTileCount);
         SkTDArray<void *>** tileRange = storage.get();
+        int* curPositions = positions.get();
         int tile = 0;
         for (int x = tileStartX; x < tileEndX; ++x) {
             for (int y = tileStartY; y < tileEndY; ++y) {
@@ -108,7 +110,8 @@ void SkTileGrid::search(const SkIRect& query, SkTDArray<void*>* results) {
             }
         }
         void *nextElement;
-        while(NULL != (nextElement = fNextDatumFunction(tileRange, curPositions))) {
+        while(NULL != (nextElement = fNextDatumFunction(tileRange, curPositions,
+                                                        queryTileCount))) {
             results->push(nextElement);
         }
     }
@@ -25,7 +25,8 @@
  */
 class SkTileGrid : public SkBBoxHierarchy {
 public:
-    typedef void* (*SkTileGridNextDatumFunctionPtr)(SkTDArray<void*>** tileData, SkTDArray<int>& tileIndices);
+    typedef void* (*SkTileGridNextDatumFunctionPtr)(SkTDArray<void*>** tileData, int tileIndices[],
+                                                    int tileCount);
 
     SkTileGrid(int xTileCount, int yTileCount, const SkTileGridPicture::TileGridInfo& info,
         SkTileGridNextDatumFunctionPtr nextDatumFunction);
@@ -79,7 +80,7 @@ private:
  * Generic implementation for SkTileGridNextDatumFunctionPtr. user code may instantiate
  * this template to get a valid SkTileGridNextDatumFunction implementation
  *
- * Returns the next element of tileData[i][tileIndices[i]] for all i and advances
+ * Returns the next element of tileData[i][tileIndices[i]] for all i < tileCount and advances
  * tileIndices[] past them. The order in which data are returned by successive
  * calls to this method must reflect the order in which the were originally
  * recorded into the tile grid.
@@ -87,13 +88,13 @@ private:
  * \param tileData array of pointers to arrays of tile data
  * \param tileIndices per-tile data indices, indices are incremented for tiles that contain
  *     the next datum.
+ * \param tileCount number of entries in tileData and tileIndices
  * \tparam T a type to which it is safe to cast a datum and that has an operator <
  *     such that 'a < b' is true if 'a' was inserted into the tile grid before 'b'.
  */
 template <typename T>
-void* SkTileGridNextDatum(SkTDArray<void*>** tileData, SkTDArray<int>& tileIndices) {
+void* SkTileGridNextDatum(SkTDArray<void*>** tileData, int tileIndices[], int tileCount) {
     T* minVal = NULL;
-    int tileCount = tileIndices.count();
     int minIndex = tileCount;
     int maxIndex = 0;
     // Find the next Datum; track where it's found so we reduce the size of the second loop.
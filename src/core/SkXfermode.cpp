@@ -8,6 +8,7 @@
 
 
 #include "SkXfermode.h"
+#include "SkXfermode_opts.h"
 #include "SkColorPriv.h"
 #include "SkFlattenableBuffers.h"
 #include "SkMathPriv.h"
@@ -1384,6 +1385,23 @@ public:
         // these may be valid, or may be CANNOT_USE_COEFF
         fSrcCoeff = rec.fSC;
         fDstCoeff = rec.fDC;
+        fSpanProc = SkPlatformXfermodeSpanProc(mode);
+    }
+
+    virtual void xfer32(SkPMColor dst[], const SkPMColor src[], int count,
+                        const SkAlpha aa[]) const SK_OVERRIDE {
+        if (NULL != fSpanProc) {
+            // the span proc takes multiples of 4 pixels, and the proc does the rest
+            int count4 = count & ~3;
+            fSpanProc(dst, src, count4, aa);
+            dst += count4;
+            src += count4;
+            if (NULL != aa) {
+                aa += count4;
+            }
+            count -= count4;
+        }
+        this->INHERITED::xfer32(dst, src, count, aa);
     }
 
     virtual bool asMode(Mode* mode) const SK_OVERRIDE {
@@ -1439,6 +1457,7 @@ protected:
         fDstCoeff = rec.fDC;
         // now update our function-ptr in the super class
         this->INHERITED::setProc(rec.fProc);
+        fSpanProc = SkPlatformXfermodeSpanProc(fMode);
     }
 
     virtual void flatten(SkFlattenableWriteBuffer& buffer) const SK_OVERRIDE {
@@ -1447,8 +1466,9 @@ protected:
     }
 
 private:
-    Mode    fMode;
-    Coeff   fSrcCoeff, fDstCoeff;
+    Mode                fMode;
+    Coeff               fSrcCoeff, fDstCoeff;
+    SkXfermodeSpanProc  fSpanProc;
 
     typedef SkProcXfermode INHERITED;
 };
@@ -1717,6 +1737,11 @@ SkXfermode* SkXfermode::Create(Mode mode) {
 
     const ProcCoeff& rec = gProcCoeffs[mode];
 
+    // a platform span proc beats the specialized C xfermodes below
+    if (NULL != SkPlatformXfermodeSpanProc(mode)) {
+        return SkNEW_ARGS(SkProcCoeffXfermode, (rec, mode));
+    }
+
     switch (mode) {
         case kClear_Mode:
             return SkNEW_ARGS(SkClearXfermode, (rec));
@@ -0,0 +1,27 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkXfermode_opts_DEFINED
+#define SkXfermode_opts_DEFINED
+
+#include "SkXfermode.h"
+
+/**
+ *  Blends a span of src pixels into dst exactly as the mode's SkXfermodeProc would, one pixel at
+ *  a time. count must be a multiple of 4. aa may be NULL, and is applied as in
+ *  SkXfermode::xfer32().
+ */
+typedef void (*SkXfermodeSpanProc)(SkPMColor dst[], const SkPMColor src[], int count,
+                                   const SkAlpha aa[]);
+
+/**
+ *  Returns the platform's span proc for mode, or NULL if it has none. Implemented in src/opts
+ *  for each platform.
+ */
+SkXfermodeSpanProc SkPlatformXfermodeSpanProc(SkXfermode::Mode mode);
+
+#endif
@@ -7,8 +7,9 @@
 
 #include "SkBicubicImageFilter.h"
 #include "SkBitmap.h"
-#include "SkColorPriv.h"
+#include "SkConvolver.h"
 #include "SkFlattenableBuffers.h"
+#include "SkFloatingPoint.h"
 #include "SkMatrix.h"
 #include "SkRect.h"
 #include "SkUnPreMultiply.h"
@@ -58,22 +59,23 @@ void SkBicubicImageFilter::flatten(SkFlattenableWriteBuffer& buffer) const {
 SkBicubicImageFilter::~SkBicubicImageFilter() {
 }
 
-inline SkPMColor cubicBlend(const SkScalar c[16], SkScalar t, SkPMColor c0, SkPMColor c1, SkPMColor c2, SkPMColor c3) {
-    SkScalar t2 = t * t, t3 = t2 * t;
-    SkScalar cc[4];
-    // FIXME:  For the fractx case, this should be refactored out of this function.
-    cc[0] = c[0]  + SkScalarMul(c[1], t) + SkScalarMul(c[2], t2) + SkScalarMul(c[3], t3);
-    cc[1] = c[4]  + SkScalarMul(c[5], t) + SkScalarMul(c[6], t2) + SkScalarMul(c[7], t3);
-    cc[2] = c[8]  + SkScalarMul(c[9], t) + SkScalarMul(c[10], t2) + SkScalarMul(c[11], t3);
-    cc[3] = c[12] + SkScalarMul(c[13], t) + SkScalarMul(c[14], t2) + SkScalarMul(c[15], t3);
-    SkScalar a = SkScalarClampMax(SkScalarMul(cc[0], SkGetPackedA32(c0)) + SkScalarMul(cc[1], SkGetPackedA32(c1)) + SkScalarMul(cc[2], SkGetPackedA32(c2)) + SkScalarMul(cc[3], SkGetPackedA32(c3)), 255);
-    SkScalar r = SkScalarMul(cc[0], SkGetPackedR32(c0)) + SkScalarMul(cc[1], SkGetPackedR32(c1)) + SkScalarMul(cc[2], SkGetPackedR32(c2)) + SkScalarMul(cc[3], SkGetPackedR32(c3));
-    SkScalar g = SkScalarMul(cc[0], SkGetPackedG32(c0)) + SkScalarMul(cc[1], SkGetPackedG32(c1)) + SkScalarMul(cc[2], SkGetPackedG32(c2)) + SkScalarMul(cc[3], SkGetPackedG32(c3));
-    SkScalar b = SkScalarMul(cc[0], SkGetPackedB32(c0)) + SkScalarMul(cc[1], SkGetPackedB32(c1)) + SkScalarMul(cc[2], SkGetPackedB32(c2)) + SkScalarMul(cc[3], SkGetPackedB32(c3));
-    return SkPackARGB32(SkScalarRoundToInt(a),
-                        SkScalarRoundToInt(SkScalarClampMax(r, a)),
-                        SkScalarRoundToInt(SkScalarClampMax(g, a)),
-                        SkScalarRoundToInt(SkScalarClampMax(b, a)));
+// Appends a filter to 'filter' for each of the dstLength pixels that a row or column of
+// srcLength pixels is scaled to. The cubic's four taps are separable, so each pass only needs
+// the weights for its own axis.
+static void compute_filters(const SkScalar c[16], SkScalar scale, int srcLength, int dstLength,
+                            SkConvolutionFilter1D* filter) {
+    const float invScale = 1 / SkScalarToFloat(scale);
+    for (int i = 0; i < dstLength; ++i) {
+        const float src = i * invScale - 0.5f;
+        const float t = src - sk_float_floor(src);
+        const float t2 = t * t, t3 = t2 * t;
+        float weights[4];
+        for (int k = 0; k < 4; ++k) {
+            weights[k] = SkScalarToFloat(c[4 * k]) + SkScalarToFloat(c[4 * k + 1]) * t +
+                         SkScalarToFloat(c[4 * k + 2]) * t2 + SkScalarToFloat(c[4 * k + 3]) * t3;
+        }
+        filter->addFilter(sk_float_floor2int(src) - 1, weights, 4, srcLength);
+    }
 }
 
 bool SkBicubicImageFilter::onFilterImage(Proxy* proxy,
@@ -86,68 +88,18 @@ bool SkBicubicImageFilter::onFilterImage(Proxy* proxy,
         return false;
     }
 
-    SkAutoLockPixels alp(src);
-    if (!src.getPixels()) {
-        return false;
-    }
-
     SkRect dstRect = SkRect::MakeWH(SkScalarMul(SkIntToScalar(src.width()), fScale.fWidth),
                                     SkScalarMul(SkIntToScalar(src.height()), fScale.fHeight));
     SkIRect dstIRect;
     dstRect.roundOut(&dstIRect);
-    result->setConfig(src.config(), dstIRect.width(), dstIRect.height());
-    result->allocPixels();
-    if (!result->getPixels()) {
+    if (dstIRect.isEmpty()) {
         return false;
     }
 
-    SkRect srcRect;
-    src.getBounds(&srcRect);
-    SkMatrix inverse;
-    inverse.setRectToRect(dstRect, srcRect, SkMatrix::kFill_ScaleToFit);
-    inverse.postTranslate(SkFloatToScalar(-0.5f), SkFloatToScalar(-0.5f));
-
-    for (int y = dstIRect.fTop; y < dstIRect.fBottom; ++y) {
-        SkPMColor* dptr = result->getAddr32(dstIRect.fLeft, y);
-        for (int x = dstIRect.fLeft; x < dstIRect.fRight; ++x) {
-            SkPoint srcPt, dstPt = SkPoint::Make(SkIntToScalar(x), SkIntToScalar(y));
-            inverse.mapPoints(&srcPt, &dstPt, 1);
-            SkScalar fractx = srcPt.fX - SkScalarFloorToScalar(srcPt.fX);
-            SkScalar fracty = srcPt.fY - SkScalarFloorToScalar(srcPt.fY);
-            int sx = SkScalarFloorToInt(srcPt.fX);
-            int sy = SkScalarFloorToInt(srcPt.fY);
-            int x0 = SkClampMax(sx - 1, src.width() - 1);
-            int x1 = SkClampMax(sx    , src.width() - 1);
-            int x2 = SkClampMax(sx + 1, src.width() - 1);
-            int x3 = SkClampMax(sx + 2, src.width() - 1);
-            int y0 = SkClampMax(sy - 1, src.height() - 1);
-            int y1 = SkClampMax(sy    , src.height() - 1);
-            int y2 = SkClampMax(sy + 1, src.height() - 1);
-            int y3 = SkClampMax(sy + 2, src.height() - 1);
-            SkPMColor s00 = *src.getAddr32(x0, y0);
-            SkPMColor s10 = *src.getAddr32(x1, y0);
-            SkPMColor s20 = *src.getAddr32(x2, y0);
-            SkPMColor s30 = *src.getAddr32(x3, y0);
-            SkPMColor s0 = cubicBlend(fCoefficients, fractx, s00, s10, s20, s30);
-            SkPMColor s01 = *src.getAddr32(x0, y1);
-            SkPMColor s11 = *src.getAddr32(x1, y1);
-            SkPMColor s21 = *src.getAddr32(x2, y1);
-            SkPMColor s31 = *src.getAddr32(x3, y1);
-            SkPMColor s1 = cubicBlend(fCoefficients, fractx, s01, s11, s21, s31);
-            SkPMColor s02 = *src.getAddr32(x0, y2);
-            SkPMColor s12 = *src.getAddr32(x1, y2);
-            SkPMColor s22 = *src.getAddr32(x2, y2);
-            SkPMColor s32 = *src.getAddr32(x3, y2);
-            SkPMColor s2 = cubicBlend(fCoefficients, fractx, s02, s12, s22, s32);
-            SkPMColor s03 = *src.getAddr32(x0, y3);
-            SkPMColor s13 = *src.getAddr32(x1, y3);
-            SkPMColor s23 = *src.getAddr32(x2, y3);
-            SkPMColor s33 = *src.getAddr32(x3, y3);
-            SkPMColor s3 = cubicBlend(fCoefficients, fractx, s03, s13, s23, s33);
-            *dptr++ = cubicBlend(fCoefficients, fracty, s0, s1, s2, s3);
-        }
-    }
-    return true;
+    SkConvolutionFilter1D xFilter, yFilter;
+    compute_filters(fCoefficients, fScale.fWidth, src.width(), dstIRect.width(), &xFilter);
+    compute_filters(fCoefficients, fScale.fHeight, src.height(), dstIRect.height(), &yFilter);
+    return SkConvolve2D(src, xFilter, yFilter, result);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
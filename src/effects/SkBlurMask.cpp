@@ -8,6 +8,7 @@
 
 
 #include "SkBlurMask.h"
+#include "SkBlurMask_opts.h"
 #include "SkMath.h"
 #include "SkTemplates.h"
 #include "SkEndian.h"
@@ -82,7 +83,14 @@ static int boxBlur(const uint8_t* src, int src_y_stride, uint8_t* dst,
 #else
     uint32_t half = 0;
 #endif
-    for (int y = 0; y < height; ++y) {
+    // The platform proc blurs the rows 16 at a time; the loop below handles the rest.
+    int y = 0;
+    SkBoxBlurProc proc = SkPlatformBoxBlurProc();
+    if (proc && proc(src, src_y_stride, dst, dst_x_stride, dst_y_stride,
+                     leftRadius, rightRadius, width, height & ~15)) {
+        y = height & ~15;
+    }
+    for (; y < height; ++y) {
         uint32_t sum = 0;
         uint8_t* dptr = dst + y * dst_y_stride;
         const uint8_t* right = src + y * src_y_stride;
@@ -279,6 +287,15 @@ static int boxBlurInterp(const uint8_t* src, int src_y_stride, uint8_t* dst,
     int diameter = radius * 2;
     int kernelSize = diameter + 1;
     int border = SkMin32(width, diameter);
+    int new_width = width + diameter;
+    int dst_x_stride = transpose ? height : 1;
+    int dst_y_stride = transpose ? 1 : new_width;
+    int y = 0;
+    SkBoxBlurInterpProc proc = SkPlatformBoxBlurInterpProc();
+    if (proc && proc(src, src_y_stride, dst, dst_x_stride, dst_y_stride,
+                     radius, width, height & ~15, outer_weight)) {
+        y = height & ~15;
+    }
     int inner_weight = 255 - outer_weight;
     outer_weight += outer_weight >> 7;
     inner_weight += inner_weight >> 7;
@@ -289,10 +306,7 @@ static int boxBlurInterp(const uint8_t* src, int src_y_stride, uint8_t* dst,
 #else
     uint32_t half = 0;
 #endif
-    int new_width = width + diameter;
-    int dst_x_stride = transpose ? height : 1;
-    int dst_y_stride = transpose ? 1 : new_width;
-    for (int y = 0; y < height; ++y) {
+    for (; y < height; ++y) {
         uint32_t outer_sum = 0, inner_sum = 0;
         uint8_t* dptr = dst + y * dst_y_stride;
         const uint8_t* right = src + y * src_y_stride;
@@ -11,9 +11,13 @@
 #include "SkFlattenableBuffers.h"
 #include "SkMaskFilter.h"
 #include "SkBounder.h"
+#include "SkDraw.h"
+#include "SkPath.h"
 #include "SkRasterClip.h"
+#include "SkRRect.h"
 #include "SkRTConf.h"
 #include "SkStringUtils.h"
+#include "SkThread.h"
 
 class SkBlurMaskFilterImpl : public SkMaskFilter {
 public:
@@ -36,10 +40,17 @@ protected:
                                            const SkIRect& clipBounds,
                                            NinePatch*) const SK_OVERRIDE;
 
+    virtual FilterReturn filterRRectToNine(const SkRRect&, const SkMatrix&,
+                                           const SkIRect& clipBounds,
+                                           NinePatch*) const SK_OVERRIDE;
+
     bool filterRectMask(SkMask* dstM, const SkRect& r, const SkMatrix& matrix,
                         SkIPoint* margin, SkMask::CreateMode createMode) const;
 
 private:
+    // The blur radius in device space.
+    SkScalar computeXformedRadius(const SkMatrix& ctm) const;
+
     SkScalar                    fRadius;
     SkBlurMaskFilter::BlurStyle fBlurStyle;
     uint32_t                    fBlurFlags;
@@ -87,21 +98,25 @@ SkMask::Format SkBlurMaskFilterImpl::getFormat() const {
     return SkMask::kA8_Format;
 }
 
-bool SkBlurMaskFilterImpl::filterMask(SkMask* dst, const SkMask& src,
-                                      const SkMatrix& matrix,
-                                      SkIPoint* margin) const{
+SkScalar SkBlurMaskFilterImpl::computeXformedRadius(const SkMatrix& ctm) const {
     SkScalar radius;
     if (fBlurFlags & SkBlurMaskFilter::kIgnoreTransform_BlurFlag) {
         radius = fRadius;
     } else {
-        radius = matrix.mapRadius(fRadius);
+        radius = ctm.mapRadius(fRadius);
     }
 
     // To avoid unseemly allocation requests (esp. for finite platforms like
     // handset) we limit the radius so something manageable. (as opposed to
     // a request like 10,000)
     static const SkScalar MAX_RADIUS = SkIntToScalar(128);
-    radius = SkMinScalar(radius, MAX_RADIUS);
+    return SkMinScalar(radius, MAX_RADIUS);
+}
+
+bool SkBlurMaskFilterImpl::filterMask(SkMask* dst, const SkMask& src,
+                                      const SkMatrix& matrix,
+                                      SkIPoint* margin) const{
+    SkScalar radius = this->computeXformedRadius(matrix);
     SkBlurMask::Quality blurQuality =
         (fBlurFlags & SkBlurMaskFilter::kHighQuality_BlurFlag) ?
             SkBlurMask::kHigh_Quality : SkBlurMask::kLow_Quality;
@@ -118,18 +133,7 @@ bool SkBlurMaskFilterImpl::filterMask(SkMask* dst, const SkMask& src,
 bool SkBlurMaskFilterImpl::filterRectMask(SkMask* dst, const SkRect& r,
                                           const SkMatrix& matrix,
                                           SkIPoint* margin, SkMask::CreateMode createMode) const{
-    SkScalar radius;
-    if (fBlurFlags & SkBlurMaskFilter::kIgnoreTransform_BlurFlag) {
-        radius = fRadius;
-    } else {
-        radius = matrix.mapRadius(fRadius);
-    }
-
-    // To avoid unseemly allocation requests (esp. for finite platforms like
-    // handset) we limit the radius so something manageable. (as opposed to
-    // a request like 10,000)
-    static const SkScalar MAX_RADIUS = SkIntToScalar(128);
-    radius = SkMinScalar(radius, MAX_RADIUS);
+    SkScalar radius = this->computeXformedRadius(matrix);
 
     return SkBlurMask::BlurRect(dst, r, radius, (SkBlurMask::Style)fBlurStyle,
                                 margin, createMode);
@@ -303,6 +307,199 @@ SkBlurMaskFilterImpl::filterRectsToNine(const SkRect rects[], int count,
     return kTrue_FilterReturn;
 }
 
+/*
+ *  The blurred ninepatches of rrects, keyed by everything their pixels depend
+ *  on. The same few shadows tend to be drawn over and over, at many sizes, and
+ *  they all share one small patch.
+ */
+struct RRectBlurKey {
+    SkScalar    fRadius;        // in device space
+    uint32_t    fStyle;
+    uint32_t    fFlags;
+    SkRect      fRect;          // the small rrect, less the integer part of its top-left
+    SkVector    fRadii[4];
+
+    bool operator==(const RRectBlurKey& other) const {
+        return 0 == memcmp(this, &other, sizeof(RRectBlurKey));
+    }
+};
+
+struct RRectBlurEntry {
+    RRectBlurKey    fKey;
+    SkMask          fMask;
+    SkIPoint        fCenter;
+};
+
+static const int kMaxRRectBlurEntries = 16;
+// Bigger patches (e.g. of large ovals, which cannot be stretched) are not
+// cached, nor drawn as patches.
+static const size_t kMaxRRectBlurBytes = 32 * 1024;
+
+SK_DECLARE_STATIC_MUTEX(gRRectBlurMutex);
+// most recently used first
+static RRectBlurEntry* gRRectBlurEntries[kMaxRRectBlurEntries];
+static int gRRectBlurCount;
+
+static bool copy_mask(const SkMask& src, SkMask* dst) {
+    *dst = src;
+    size_t size = src.computeImageSize();
+    dst->fImage = SkMask::AllocImage(size);
+    if (NULL == dst->fImage) {
+        return false;
+    }
+    memcpy(dst->fImage, src.fImage, size);
+    return true;
+}
+
+// On a hit, copies the cached patch into the caller's mask.
+static bool find_rrect_blur(const RRectBlurKey& key, SkMask* mask, SkIPoint* center) {
+    SkAutoMutexAcquire ama(gRRectBlurMutex);
+
+    for (int i = 0; i < gRRectBlurCount; ++i) {
+        RRectBlurEntry* entry = gRRectBlurEntries[i];
+        if (entry->fKey == key) {
+            memmove(&gRRectBlurEntries[1], &gRRectBlurEntries[0], i * sizeof(RRectBlurEntry*));
+            gRRectBlurEntries[0] = entry;
+            *center = entry->fCenter;
+            return copy_mask(entry->fMask, mask);
+        }
+    }
+    return false;
+}
+
+static void add_rrect_blur(const RRectBlurKey& key, const SkMask& mask, const SkIPoint& center) {
+    RRectBlurEntry* entry = SkNEW(RRectBlurEntry);
+    entry->fKey = key;
+    entry->fCenter = center;
+    if (!copy_mask(mask, &entry->fMask)) {
+        SkDELETE(entry);
+        return;
+    }
+
+    SkAutoMutexAcquire ama(gRRectBlurMutex);
+
+    if (kMaxRRectBlurEntries == gRRectBlurCount) {
+        RRectBlurEntry* oldest = gRRectBlurEntries[--gRRectBlurCount];
+        SkMask::FreeImage(oldest->fMask.fImage);
+        SkDELETE(oldest);
+    }
+    memmove(&gRRectBlurEntries[1], &gRRectBlurEntries[0],
+            gRRectBlurCount * sizeof(RRectBlurEntry*));
+    gRRectBlurEntries[0] = entry;
+    ++gRRectBlurCount;
+}
+
+SkMaskFilter::FilterReturn
+SkBlurMaskFilterImpl::filterRRectToNine(const SkRRect& rrect, const SkMatrix& matrix,
+                                        const SkIRect& clipBounds,
+                                        NinePatch* patch) const {
+    // The center of the patch is drawn solid, which only these styles want.
+    if (SkBlurMaskFilter::kNormal_BlurStyle != fBlurStyle &&
+            SkBlurMaskFilter::kSolid_BlurStyle != fBlurStyle) {
+        return kUnimplemented_FilterReturn;
+    }
+
+    const SkRect& bounds = rrect.getBounds();
+    if (rect_exceeds(bounds, SkIntToScalar(32767))) {
+        return kUnimplemented_FilterReturn;
+    }
+
+    // Don't actually do the blur, just compute the margin and the outer rect.
+    // The bounds are padded as SkDraw::DrawToMask() pads them, so the patch
+    // lines up with the mask it draws.
+    SkIPoint margin;
+    SkMask  srcM, dstM;
+    SkRect paddedBounds = bounds;
+    paddedBounds.outset(SK_ScalarHalf, SK_ScalarHalf);
+    paddedBounds.roundOut(&srcM.fBounds);
+    srcM.fImage = NULL;
+    srcM.fFormat = SkMask::kA8_Format;
+    srcM.fRowBytes = 0;
+    if (!this->filterMask(&dstM, srcM, matrix, &margin)) {
+        return kFalse_FilterReturn;
+    }
+
+    const SkVector& ul = rrect.radii(SkRRect::kUpperLeft_Corner);
+    const SkVector& ur = rrect.radii(SkRRect::kUpperRight_Corner);
+    const SkVector& lr = rrect.radii(SkRRect::kLowerRight_Corner);
+    const SkVector& ll = rrect.radii(SkRRect::kLowerLeft_Corner);
+    const SkScalar leftR = SkMaxScalar(ul.fX, ll.fX);
+    const SkScalar rightR = SkMaxScalar(ur.fX, lr.fX);
+    const SkScalar topR = SkMaxScalar(ul.fY, ur.fY);
+    const SkScalar bottomR = SkMaxScalar(ll.fY, lr.fY);
+
+    /*
+     *  As in filterRectsToNine, the small rrect is the rrect shortened by a
+     *  whole number of pixels, so that each edge keeps its fractional phase.
+     *  Its straight edges are left just long enough for one row and column
+     *  whose blur sees nothing but those edges: 2 * margin for the blur, 1 for
+     *  the row/col itself, and 2 in case the corners end on fractional pixels.
+     */
+    const int dx = SkScalarFloorToInt(bounds.width() - leftR - rightR) - 2 * margin.fX - 3;
+    const int dy = SkScalarFloorToInt(bounds.height() - topR - bottomR) - 2 * margin.fY - 3;
+    // where the rrect starts in the mask, less the margin
+    const SkScalar fracX = bounds.fLeft - SkIntToScalar(srcM.fBounds.fLeft);
+    const SkScalar fracY = bounds.fTop - SkIntToScalar(srcM.fBounds.fTop);
+
+    RRectBlurKey key;
+    key.fRadius = this->computeXformedRadius(matrix);
+    key.fStyle = fBlurStyle;
+    key.fFlags = fBlurFlags & SkBlurMaskFilter::kHighQuality_BlurFlag;
+    key.fRect = bounds;
+    key.fRect.offset(-SkIntToScalar(srcM.fBounds.fLeft), -SkIntToScalar(srcM.fBounds.fTop));
+    key.fRadii[0] = ul;
+    key.fRadii[1] = ur;
+    key.fRadii[2] = lr;
+    key.fRadii[3] = ll;
+
+    SkRect smallR = bounds;
+    SkIPoint center;
+    if (dx > 0 && dy > 0) {
+        smallR.fRight -= SkIntToScalar(dx);
+        smallR.fBottom -= SkIntToScalar(dy);
+        key.fRect.fRight -= SkIntToScalar(dx);
+        key.fRect.fBottom -= SkIntToScalar(dy);
+        // the first row/col whose blur is clear of the corners
+        center.set(SkScalarCeilToInt(fracX + leftR) + 2 * margin.fX,
+                   SkScalarCeilToInt(fracY + topR) + 2 * margin.fY);
+    } else {
+        // Too round (e.g. an oval) or too small to stretch, so the patch is
+        // the whole blurred rrect. That only pays off if it can be cached.
+        if ((size_t)dstM.fBounds.width() * dstM.fBounds.height() > kMaxRRectBlurBytes) {
+            return kUnimplemented_FilterReturn;
+        }
+        center.set(0, 0);
+    }
+
+    if (!find_rrect_blur(key, &patch->fMask, &patch->fCenter)) {
+        // Drawn where the rrect is, so the patch is what the whole rrect
+        // would give. A cached patch may be off by the odd bit elsewhere,
+        // since the scan converter is not quite translation invariant.
+        SkRRect smallRR;
+        smallRR.setRectRadii(smallR, key.fRadii);
+        SkPath path;
+        path.addRRect(smallRR);
+        if (!SkDraw::DrawToMask(path, NULL, NULL, NULL, &srcM,
+                                SkMask::kComputeBoundsAndRenderImage_CreateMode,
+                                SkPaint::kFill_Style)) {
+            return kFalse_FilterReturn;
+        }
+
+        SkAutoMaskFreeImage amf(srcM.fImage);
+
+        if (!this->filterMask(&patch->fMask, srcM, matrix, &margin)) {
+            return kFalse_FilterReturn;
+        }
+        patch->fMask.fBounds.offsetTo(0, 0);
+        patch->fCenter = center;
+        if (patch->fMask.computeImageSize() <= kMaxRRectBlurBytes) {
+            add_rrect_blur(key, patch->fMask, center);
+        }
+    }
+    patch->fOuterRect = dstM.fBounds;
+    return kTrue_FilterReturn;
+}
+
 void SkBlurMaskFilterImpl::computeFastBounds(const SkRect& src,
                                              SkRect* dst) const {
     dst->set(src.fLeft - fRadius, src.fTop - fRadius,
@@ -0,0 +1,39 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkBlurMask_opts_DEFINED
+#define SkBlurMask_opts_DEFINED
+
+#include "SkTypes.h"
+
+/**
+ *  Box blurs 'count' rows of an A8 mask along x, exactly as the separable passes in
+ *  SkBlurMask.cpp do, with a kernel leftRadius + rightRadius + 1 wide. count must be a multiple
+ *  of 16. Row y of the result starts at dst + y * dstYStride and has one pixel every dstXStride
+ *  bytes; one of the two strides is 1, so the result is either written as rows or transposed.
+ *  Returns false, having written nothing, if the proc cannot handle the kernel.
+ */
+typedef bool (*SkBoxBlurProc)(const uint8_t* src, int srcRowBytes, uint8_t* dst,
+                              int dstXStride, int dstYStride,
+                              int leftRadius, int rightRadius, int width, int count);
+
+/**
+ *  As SkBoxBlurProc, for the pass that interpolates between kernels 2 * radius + 1 and
+ *  2 * radius - 1 wide, giving outerWeight / 255 to the wider one.
+ */
+typedef bool (*SkBoxBlurInterpProc)(const uint8_t* src, int srcRowBytes, uint8_t* dst,
+                                    int dstXStride, int dstYStride,
+                                    int radius, int width, int count, uint8_t outerWeight);
+
+/**
+ *  Return the platform's procs, or NULL if it has none. Implemented in src/opts for each
+ *  platform.
+ */
+SkBoxBlurProc SkPlatformBoxBlurProc();
+SkBoxBlurInterpProc SkPlatformBoxBlurInterpProc();
+
+#endif
@@ -0,0 +1,144 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkGradientCache.h"
+#include "SkChecksum.h"
+#include "SkTLRUCache.h"
+#include "SkTemplates.h"
+#include "SkThread.h"
+
+#ifndef SK_DEFAULT_GRADIENT_CACHE_LIMIT
+    #define SK_DEFAULT_GRADIENT_CACHE_LIMIT (512 * 1024)
+#endif
+
+namespace {
+
+// A key as it is passed in, to be compared with the copies that the entries keep
+struct Key {
+    Key(const int32_t data[], int count) : fData(data), fCount(count) {}
+
+    const int32_t*  fData;
+    int             fCount;
+};
+
+struct Entry {
+    Entry(const Key& key, uint32_t hash, SkMallocPixelRef* table)
+        : fKey(key.fCount)
+        , fCount(key.fCount)
+        , fHash(hash)
+        , fTable(table)
+        , fHashNext(NULL)
+        , fPrev(NULL)
+        , fNext(NULL) {
+        memcpy(fKey.get(), key.fData, key.fCount * sizeof(int32_t));
+        table->ref();
+    }
+
+    ~Entry() { fTable->unref(); }
+
+    bool equals(const Key& key) const {
+        return fCount == key.fCount &&
+               0 == memcmp(fKey.get(), key.fData, key.fCount * sizeof(int32_t));
+    }
+    size_t bytes() const { return fTable->getSize(); }
+    // Shaders that hold a table keep it alive until they are done with it
+    static void Free(Entry* entry) { SkDELETE(entry); }
+
+    SkAutoTMalloc<int32_t>  fKey;
+    int                     fCount;
+    uint32_t                fHash;
+    SkMallocPixelRef*       fTable;
+    Entry*                  fHashNext;
+    Entry*                  fPrev;      // more recently used
+    Entry*                  fNext;      // less recently used
+};
+
+}
+
+static uint32_t hash_key(const Key& key) {
+    return SkChecksum::Compute(reinterpret_cast<const uint32_t*>(key.fData),
+                               key.fCount * sizeof(int32_t));
+}
+
+typedef SkTLRUCache<Entry, Key> SkGradientCacheImpl;
+
+SK_DECLARE_STATIC_MUTEX(gGradientCacheMutex);
+static SkGradientCacheImpl* gGradientCache;
+
+// The caller must hold gGradientCacheMutex.
+static SkGradientCacheImpl& get_cache() {
+    if (NULL == gGradientCache) {
+        // we leak this, so we don't incur any shutdown cost of the destructor
+        gGradientCache = SkNEW_ARGS(SkGradientCacheImpl, (SK_DEFAULT_GRADIENT_CACHE_LIMIT));
+    }
+    return *gGradientCache;
+}
+
+SkMallocPixelRef* SkGradientCache::Find(const int32_t data[], int count) {
+    const Key key(data, count);
+    const uint32_t hash = hash_key(key);
+    SkAutoMutexAcquire ac(gGradientCacheMutex);
+    Entry* entry = get_cache().find(key, hash);
+    if (NULL == entry) {
+        return NULL;
+    }
+    entry->fTable->ref();
+    return entry->fTable;
+}
+
+SkMallocPixelRef* SkGradientCache::Add(const int32_t data[], int count,
+                                       SkMallocPixelRef* table) {
+    table->setImmutable();
+    const Key key(data, count);
+    const uint32_t hash = hash_key(key);
+
+    SkAutoMutexAcquire ac(gGradientCacheMutex);
+    SkGradientCacheImpl& cache = get_cache();
+    if (table->getSize() > cache.getLimit()) {
+        table->ref();
+        return table;
+    }
+    Entry* entry = cache.lookup(key, hash);
+    if (entry) {
+        // Another thread built the same table first
+        entry->fTable->ref();
+        return entry->fTable;
+    }
+    table->ref();
+    cache.add(SkNEW_ARGS(Entry, (key, hash, table)));
+    return table;
+}
+
+size_t SkGradientCache::GetLimit() {
+    SkAutoMutexAcquire ac(gGradientCacheMutex);
+    return get_cache().getLimit();
+}
+
+size_t SkGradientCache::SetLimit(size_t bytes) {
+    SkAutoMutexAcquire ac(gGradientCacheMutex);
+    return get_cache().setLimit(bytes);
+}
+
+size_t SkGradientCache::GetBytesUsed() {
+    SkAutoMutexAcquire ac(gGradientCacheMutex);
+    return get_cache().getBytesUsed();
+}
+
+void SkGradientCache::PurgeAll() {
+    SkAutoMutexAcquire ac(gGradientCacheMutex);
+    get_cache().purgeAll();
+}
+
+int SkGradientCache::GetHitCount() {
+    SkAutoMutexAcquire ac(gGradientCacheMutex);
+    return get_cache().getHitCount();
+}
+
+int SkGradientCache::GetMissCount() {
+    SkAutoMutexAcquire ac(gGradientCacheMutex);
+    return get_cache().getMissCount();
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkGradientCache_DEFINED
+#define SkGradientCache_DEFINED
+
+#include "SkMallocPixelRef.h"
+
+/**
+ *  A process-wide cache of the color tables (ramps) that gradient shaders index into, so that
+ *  every gradient with the same colors and positions shares one table instead of each shader
+ *  building its own. This matters when the same gradient is created over and over, e.g. by a
+ *  picture that is played back once per tile.
+ *
+ *  Tables are keyed by an array of int32_t that must hold everything their contents depend on.
+ *  They are immutable once cached, and handed out with a reference, so a shader can keep using
+ *  its table after the cache evicts it. The cache is bounded by a byte budget (see
+ *  SkGradientShader::SetCacheLimit()), and is safe to use from several threads.
+ */
+class SkGradientCache {
+public:
+    /**
+     *  Returns the table cached for 'key', with a reference owned by the caller, or NULL.
+     */
+    static SkMallocPixelRef* Find(const int32_t key[], int count);
+
+    /**
+     *  Caches 'table' for 'key' and marks it immutable, unless another thread has already added
+     *  a table for the same key. Returns whichever table is cached (or 'table' if it is too big
+     *  to cache), with a reference owned by the caller.
+     */
+    static SkMallocPixelRef* Add(const int32_t key[], int count, SkMallocPixelRef* table);
+
+    static size_t GetLimit();
+    static size_t SetLimit(size_t bytes);
+    static size_t GetBytesUsed();
+    static void PurgeAll();
+
+    /** The number of lookups that did and did not find a table. */
+    static int GetHitCount();
+    static int GetMissCount();
+};
+
+#endif
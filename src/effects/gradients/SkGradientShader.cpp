@@ -6,6 +6,7 @@
  */
 
 #include "SkGradientShaderPriv.h"
+#include "SkGradientCache.h"
 #include "SkLinearGradient.h"
 #include "SkRadialGradient.h"
 #include "SkTwoPointRadialGradient.h"
@@ -26,8 +27,9 @@ SkGradientShaderBase::SkGradientShaderBase(const SkColor colors[], const SkScala
     fTileMode = mode;
     fTileProc = gTileProcs[mode];
 
-    fCache16 = fCache16Storage = NULL;
+    fCache16 = NULL;
     fCache32 = NULL;
+    fCache16PixelRef = NULL;
     fCache32PixelRef = NULL;
 
     /*  Note: we let the caller skip the first and/or last position.
@@ -135,8 +137,9 @@ SkGradientShaderBase::SkGradientShaderBase(SkFlattenableReadBuffer& buffer) :
 
     fMapper = buffer.readFlattenableT<SkUnitMapper>();
 
-    fCache16 = fCache16Storage = NULL;
+    fCache16 = NULL;
     fCache32 = NULL;
+    fCache16PixelRef = NULL;
     fCache32PixelRef = NULL;
 
     int colorCount = fColorCount = buffer.getArrayCount();
@@ -164,9 +167,7 @@ SkGradientShaderBase::SkGradientShaderBase(SkFlattenableReadBuffer& buffer) :
 }
 
 SkGradientShaderBase::~SkGradientShaderBase() {
-    if (fCache16Storage) {
-        sk_free(fCache16Storage);
-    }
+    SkSafeUnref(fCache16PixelRef);
     SkSafeUnref(fCache32PixelRef);
     if (fOrigColors != fStorage) {
         sk_free(fOrigColors);
@@ -245,10 +246,6 @@ void SkGradientShaderBase::setCacheAlpha(U8CPU alpha) const {
         fCache16 = NULL;            // inval the cache
         fCache32 = NULL;            // inval the cache
         fCacheAlpha = alpha;        // record the new alpha
-        // inform our subclasses
-        if (fCache32PixelRef) {
-            fCache32PixelRef->notifyPixelsChanged();
-        }
     }
 }
 
@@ -408,123 +405,105 @@ static inline U16CPU bitsTo16(unsigned x, const unsigned bits) {
     return 0;
 }
 
-const uint16_t* SkGradientShaderBase::getCache16() const {
-    if (fCache16 == NULL) {
-        // double the count for dither entries
-        const int entryCount = kCache16Count * 2;
-        const size_t allocSize = sizeof(uint16_t) * entryCount;
+SkMallocPixelRef* SkGradientShaderBase::build16bitCache() const {
+    // double the count for dither entries
+    const int entryCount = kCache16Count * 2;
+    const size_t allocSize = sizeof(uint16_t) * entryCount;
 
-        if (fCache16Storage == NULL) { // set the storage and our working ptr
-            fCache16Storage = (uint16_t*)sk_malloc_throw(allocSize);
-        }
-        fCache16 = fCache16Storage;
-        if (fColorCount == 2) {
-            Build16bitCache(fCache16, fOrigColors[0], fOrigColors[1],
-                            kCache16Count);
-        } else {
-            Rec* rec = fRecs;
-            int prevIndex = 0;
-            for (int i = 1; i < fColorCount; i++) {
-                int nextIndex = SkFixedToFFFF(rec[i].fPos) >> kCache16Shift;
-                SkASSERT(nextIndex < kCache16Count);
-
-                if (nextIndex > prevIndex)
-                    Build16bitCache(fCache16 + prevIndex, fOrigColors[i-1], fOrigColors[i], nextIndex - prevIndex + 1);
-                prevIndex = nextIndex;
-            }
+    SkMallocPixelRef* pr = SkNEW_ARGS(SkMallocPixelRef, (NULL, allocSize, NULL));
+    // with a mapper, build the linear data first, then map it into our table
+    SkAutoTMalloc<uint16_t> linearStorage(fMapper ? entryCount : 0);
+    uint16_t* cache = fMapper ? linearStorage.get() : (uint16_t*)pr->getAddr();
+
+    if (fColorCount == 2) {
+        Build16bitCache(cache, fOrigColors[0], fOrigColors[1], kCache16Count);
+    } else {
+        Rec* rec = fRecs;
+        int prevIndex = 0;
+        for (int i = 1; i < fColorCount; i++) {
+            int nextIndex = SkFixedToFFFF(rec[i].fPos) >> kCache16Shift;
+            SkASSERT(nextIndex < kCache16Count);
+
+            if (nextIndex > prevIndex)
+                Build16bitCache(cache + prevIndex, fOrigColors[i-1], fOrigColors[i], nextIndex - prevIndex + 1);
+            prevIndex = nextIndex;
         }
+    }
 
-        if (fMapper) {
-            fCache16Storage = (uint16_t*)sk_malloc_throw(allocSize);
-            uint16_t* linear = fCache16;         // just computed linear data
-            uint16_t* mapped = fCache16Storage;  // storage for mapped data
-            SkUnitMapper* map = fMapper;
-            for (int i = 0; i < kCache16Count; i++) {
-                int index = map->mapUnit16(bitsTo16(i, kCache16Bits)) >> kCache16Shift;
-                mapped[i] = linear[index];
-                mapped[i + kCache16Count] = linear[index + kCache16Count];
-            }
-            sk_free(fCache16);
-            fCache16 = fCache16Storage;
+    if (fMapper) {
+        uint16_t* linear = cache;                       // just computed linear data
+        uint16_t* mapped = (uint16_t*)pr->getAddr();    // storage for mapped data
+        SkUnitMapper* map = fMapper;
+        for (int i = 0; i < kCache16Count; i++) {
+            int index = map->mapUnit16(bitsTo16(i, kCache16Bits)) >> kCache16Shift;
+            mapped[i] = linear[index];
+            mapped[i + kCache16Count] = linear[index + kCache16Count];
         }
     }
-    return fCache16;
+    return pr;
 }
 
-const SkPMColor* SkGradientShaderBase::getCache32() const {
-    if (fCache32 == NULL) {
-        // double the count for dither entries
-        const int entryCount = kCache32Count * 4;
-        const size_t allocSize = sizeof(SkPMColor) * entryCount;
+SkMallocPixelRef* SkGradientShaderBase::build32bitCache() const {
+    // double the count for dither entries
+    const int entryCount = kCache32Count * 4;
+    const size_t allocSize = sizeof(SkPMColor) * entryCount;
 
-        if (NULL == fCache32PixelRef) {
-            fCache32PixelRef = SkNEW_ARGS(SkMallocPixelRef,
-                                          (NULL, allocSize, NULL));
-        }
-        fCache32 = (SkPMColor*)fCache32PixelRef->getAddr();
-        if (fColorCount == 2) {
-            Build32bitCache(fCache32, fOrigColors[0], fOrigColors[1],
-                            kCache32Count, fCacheAlpha);
-        } else {
-            Rec* rec = fRecs;
-            int prevIndex = 0;
-            for (int i = 1; i < fColorCount; i++) {
-                int nextIndex = SkFixedToFFFF(rec[i].fPos) >> kCache32Shift;
-                SkASSERT(nextIndex < kCache32Count);
-
-                if (nextIndex > prevIndex)
-                    Build32bitCache(fCache32 + prevIndex, fOrigColors[i-1],
-                                    fOrigColors[i],
-                                    nextIndex - prevIndex + 1, fCacheAlpha);
-                prevIndex = nextIndex;
-            }
+    SkMallocPixelRef* pr = SkNEW_ARGS(SkMallocPixelRef, (NULL, allocSize, NULL));
+    // with a mapper, build the linear data first, then map it into our table
+    SkAutoTMalloc<SkPMColor> linearStorage(fMapper ? entryCount : 0);
+    SkPMColor* cache = fMapper ? linearStorage.get() : (SkPMColor*)pr->getAddr();
+
+    if (fColorCount == 2) {
+        Build32bitCache(cache, fOrigColors[0], fOrigColors[1],
+                        kCache32Count, fCacheAlpha);
+    } else {
+        Rec* rec = fRecs;
+        int prevIndex = 0;
+        for (int i = 1; i < fColorCount; i++) {
+            int nextIndex = SkFixedToFFFF(rec[i].fPos) >> kCache32Shift;
+            SkASSERT(nextIndex < kCache32Count);
+
+            if (nextIndex > prevIndex)
+                Build32bitCache(cache + prevIndex, fOrigColors[i-1],
+                                fOrigColors[i],
+                                nextIndex - prevIndex + 1, fCacheAlpha);
+            prevIndex = nextIndex;
         }
+    }
 
-        if (fMapper) {
-            SkMallocPixelRef* newPR = SkNEW_ARGS(SkMallocPixelRef,
-                                                 (NULL, allocSize, NULL));
-            SkPMColor* linear = fCache32;           // just computed linear data
-            SkPMColor* mapped = (SkPMColor*)newPR->getAddr();    // storage for mapped data
-            SkUnitMapper* map = fMapper;
-            for (int i = 0; i < kCache32Count; i++) {
-                int index = map->mapUnit16((i << 8) | i) >> 8;
-                mapped[i + kCache32Count*0] = linear[index + kCache32Count*0];
-                mapped[i + kCache32Count*1] = linear[index + kCache32Count*1];
-                mapped[i + kCache32Count*2] = linear[index + kCache32Count*2];
-                mapped[i + kCache32Count*3] = linear[index + kCache32Count*3];
-            }
-            fCache32PixelRef->unref();
-            fCache32PixelRef = newPR;
-            fCache32 = (SkPMColor*)newPR->getAddr();
+    if (fMapper) {
+        SkPMColor* linear = cache;                      // just computed linear data
+        SkPMColor* mapped = (SkPMColor*)pr->getAddr();  // storage for mapped data
+        SkUnitMapper* map = fMapper;
+        for (int i = 0; i < kCache32Count; i++) {
+            int index = map->mapUnit16((i << 8) | i) >> 8;
+            mapped[i + kCache32Count*0] = linear[index + kCache32Count*0];
+            mapped[i + kCache32Count*1] = linear[index + kCache32Count*1];
+            mapped[i + kCache32Count*2] = linear[index + kCache32Count*2];
+            mapped[i + kCache32Count*3] = linear[index + kCache32Count*3];
         }
     }
-    return fCache32;
+    return pr;
 }
 
 /*
- *  Because our caller might rebuild the same (logically the same) gradient
- *  over and over, we'd like to return exactly the same "bitmap" if possible,
- *  allowing the client to utilize a cache of our bitmap (e.g. with a GPU).
- *  To do that, we maintain a private cache of built-bitmaps, based on our
- *  colors and positions. Note: we don't try to flatten the fMapper, so if one
- *  is present, we skip the cache for now.
+ *  Many shaders may be made with the same colors and positions (e.g. by each
+ *  playback of a picture), so rather than each building their own tables, they
+ *  share them through SkGradientCache. The key is everything a table depends
+ *  on: its type, the paint alpha (32bit only), and our colors and positions.
+ *  Note: we don't try to flatten the fMapper, so if one is present, we build
+ *  our own tables.
  */
-void SkGradientShaderBase::getGradientTableBitmap(SkBitmap* bitmap) const {
-    // our caller assumes no external alpha, so we ensure that our cache is
-    // built with 0xFF
-    this->setCacheAlpha(0xFF);
-
-    // don't have a way to put the mapper into our cache-key yet
+SkMallocPixelRef* SkGradientShaderBase::refCache(CacheType type) const {
+    SkMallocPixelRef* pr;
     if (fMapper) {
-        // force our cahce32pixelref to be built
-        (void)this->getCache32();
-        bitmap->setConfig(SkBitmap::kARGB_8888_Config, kCache32Count, 1);
-        bitmap->setPixelRef(fCache32PixelRef);
-        return;
+        pr = k16_CacheType == type ? this->build16bitCache() : this->build32bitCache();
+        pr->setImmutable();
+        return pr;
     }
 
-    // build our key: [numColors + colors[] + {positions[]} ]
-    int count = 1 + fColorCount;
+    // build our key: [type + alpha + numColors + colors[] + {positions[]} ]
+    int count = 3 + fColorCount;
     if (fColorCount > 2) {
         count += fColorCount - 1;    // fRecs[].fPos
     }
@@ -532,6 +511,8 @@ void SkGradientShaderBase::getGradientTableBitmap(SkBitmap* bitmap) const {
     SkAutoSTMalloc<16, int32_t> storage(count);
     int32_t* buffer = storage.get();
 
+    *buffer++ = type;
+    *buffer++ = k32_CacheType == type ? fCacheAlpha : 0xFF;
     *buffer++ = fColorCount;
     memcpy(buffer, fOrigColors, fColorCount * sizeof(SkColor));
     buffer += fColorCount;
@@ -542,27 +523,51 @@ void SkGradientShaderBase::getGradientTableBitmap(SkBitmap* bitmap) const {
     }
     SkASSERT(buffer - storage.get() == count);
 
-    ///////////////////////////////////
+    pr = SkGradientCache::Find(storage.get(), count);
+    if (NULL == pr) {
+        SkAutoTUnref<SkMallocPixelRef> built(k16_CacheType == type ?
+                                             this->build16bitCache() :
+                                             this->build32bitCache());
+        pr = SkGradientCache::Add(storage.get(), count, built);
+    }
+    return pr;
+}
 
-    SK_DECLARE_STATIC_MUTEX(gMutex);
-    static SkBitmapCache* gCache;
-    // each cache cost 1K of RAM, since each bitmap will be 1x256 at 32bpp
-    static const int MAX_NUM_CACHED_GRADIENT_BITMAPS = 32;
-    SkAutoMutexAcquire ama(gMutex);
+const uint16_t* SkGradientShaderBase::getCache16() const {
+    if (fCache16 == NULL) {
+        SkSafeUnref(fCache16PixelRef);
+        fCache16PixelRef = this->refCache(k16_CacheType);
+        fCache16 = (uint16_t*)fCache16PixelRef->getAddr();
+    }
+    return fCache16;
+}
 
-    if (NULL == gCache) {
-        gCache = SkNEW_ARGS(SkBitmapCache, (MAX_NUM_CACHED_GRADIENT_BITMAPS));
+const SkPMColor* SkGradientShaderBase::getCache32() const {
+    if (fCache32 == NULL) {
+        SkSafeUnref(fCache32PixelRef);
+        fCache32PixelRef = this->refCache(k32_CacheType);
+        fCache32 = (SkPMColor*)fCache32PixelRef->getAddr();
     }
-    size_t size = count * sizeof(int32_t);
+    return fCache32;
+}
 
-    if (!gCache->find(storage.get(), size, bitmap)) {
-        // force our cahce32pixelref to be built
-        (void)this->getCache32();
-        bitmap->setConfig(SkBitmap::kARGB_8888_Config, kCache32Count, 1);
-        bitmap->setPixelRef(fCache32PixelRef);
+/*
+ *  Because our caller might rebuild the same (logically the same) gradient
+ *  over and over, we'd like to return exactly the same "bitmap" if possible,
+ *  allowing the client to utilize a cache of our bitmap (e.g. with a GPU).
+ *  Our 32bit table is shared through SkGradientCache, so every gradient with
+ *  our colors and positions returns the same pixelref (unless the cache has
+ *  purged it, or we have a mapper).
+ */
+void SkGradientShaderBase::getGradientTableBitmap(SkBitmap* bitmap) const {
+    // our caller assumes no external alpha, so we ensure that our cache is
+    // built with 0xFF
+    this->setCacheAlpha(0xFF);
 
-        gCache->add(storage.get(), size, *bitmap);
-    }
+    // force our cache32pixelref to be built
+    (void)this->getCache32();
+    bitmap->setConfig(SkBitmap::kARGB_8888_Config, kCache32Count, 1);
+    bitmap->setPixelRef(fCache32PixelRef);
 }
 
 void SkGradientShaderBase::commonAsAGradient(GradientInfo* info) const {
@@ -721,6 +726,30 @@ SkShader* SkGradientShader::CreateSweep(SkScalar cx, SkScalar cy,
     return SkNEW_ARGS(SkSweepGradient, (cx, cy, colors, pos, count, mapper));
 }
 
+size_t SkGradientShader::GetCacheLimit() {
+    return SkGradientCache::GetLimit();
+}
+
+size_t SkGradientShader::SetCacheLimit(size_t bytes) {
+    return SkGradientCache::SetLimit(bytes);
+}
+
+size_t SkGradientShader::GetCacheUsed() {
+    return SkGradientCache::GetBytesUsed();
+}
+
+void SkGradientShader::PurgeCache() {
+    SkGradientCache::PurgeAll();
+}
+
+int SkGradientShader::GetCacheHitCount() {
+    return SkGradientCache::GetHitCount();
+}
+
+int SkGradientShader::GetCacheMissCount() {
+    return SkGradientCache::GetMissCount();
+}
+
 SK_DEFINE_FLATTENABLE_REGISTRAR_GROUP_START(SkGradientShader)
     SK_DEFINE_FLATTENABLE_REGISTRAR_ENTRY(SkLinearGradient)
     SK_DEFINE_FLATTENABLE_REGISTRAR_ENTRY(SkRadialGradient)
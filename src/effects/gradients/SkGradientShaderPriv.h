@@ -16,7 +16,6 @@
 #include "SkUnitMapper.h"
 #include "SkUtils.h"
 #include "SkTemplates.h"
-#include "SkBitmapCache.h"
 #include "SkShader.h"
 
 static inline void sk_memset32_dither(uint32_t dst[], uint32_t v0, uint32_t v1,
@@ -153,13 +152,22 @@ private:
     mutable uint16_t*   fCache16;   // working ptr. If this is NULL, we need to recompute the cache values
     mutable SkPMColor*  fCache32;   // working ptr. If this is NULL, we need to recompute the cache values
 
-    mutable uint16_t*   fCache16Storage;    // storage for fCache16, allocated on demand
+    // the immutable tables behind fCache16 and fCache32, shared through SkGradientCache
+    mutable SkMallocPixelRef* fCache16PixelRef;
     mutable SkMallocPixelRef* fCache32PixelRef;
     mutable unsigned    fCacheAlpha;        // the alpha value we used when we computed the cache. larger than 8bits so we can store uninitialized value
 
+    enum CacheType {
+        k16_CacheType,
+        k32_CacheType
+    };
+
     static void Build16bitCache(uint16_t[], SkColor c0, SkColor c1, int count);
     static void Build32bitCache(SkPMColor[], SkColor c0, SkColor c1, int count,
                                 U8CPU alpha);
+    SkMallocPixelRef* build16bitCache() const;
+    SkMallocPixelRef* build32bitCache() const;
+    SkMallocPixelRef* refCache(CacheType) const;
     void setCacheAlpha(U8CPU alpha) const;
     void initCommon();
 
@@ -0,0 +1,39 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkGradient_opts_DEFINED
+#define SkGradient_opts_DEFINED
+
+#include "SkShader.h"
+
+/**
+ *  Writes 'count' pixels of a linear gradient from its 32bit cache. Pixel i
+ *  is looked up at tile(fx + i * dx) >> 8 in 'even' if i is even, and in
+ *  'odd' if it is odd, i.e. in the cache rows of the two dither toggles, as
+ *  shadeSpan_linear_* do. For kClamp_TileMode the caller must have clamped
+ *  the span already (see SkClampRange), so that every position is in
+ *  [0, 0xFFFF].
+ */
+typedef void (*SkLinearGradientProc)(SkFixed fx, SkFixed dx, SkPMColor dst[],
+                                     const SkPMColor even[], const SkPMColor odd[], int count);
+
+/**
+ *  As SkLinearGradientProc, for a radial gradient of radius 1 centered on the
+ *  origin. Pixel i is at (fx + i * dx, fy + i * dy), computed in floats, and
+ *  is looked up at its tiled distance from the origin.
+ */
+typedef void (*SkRadialGradientProc)(float fx, float dx, float fy, float dy, SkPMColor dst[],
+                                     const SkPMColor even[], const SkPMColor odd[], int count);
+
+/**
+ *  Return the platform's proc for the tile mode, or NULL if it has none.
+ *  Implemented in src/opts for each platform.
+ */
+SkLinearGradientProc SkPlatformLinearGradientProc(SkShader::TileMode);
+SkRadialGradientProc SkPlatformRadialGradientProc(SkShader::TileMode);
+
+#endif
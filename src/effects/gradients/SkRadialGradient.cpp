@@ -8,6 +8,7 @@
 
 #include "SkRadialGradient.h"
 #include "SkRadialGradient_Table.h"
+#include "SkGradient_opts.h"
 
 #define kSQRT_TABLE_BITS    11
 #define kSQRT_TABLE_SIZE    (1 << kSQRT_TABLE_BITS)
@@ -317,12 +318,17 @@ void shadeSpan_radial_clamp(SkScalar sfx, SkScalar sdx,
     SkFixed dx = SkScalarToFixed(sdx) >> 1;
     SkFixed fy = SkScalarToFixed(sfy) >> 1;
     SkFixed dy = SkScalarToFixed(sdy) >> 1;
+    SkRadialGradientProc platformProc = SkPlatformRadialGradientProc(SkShader::kClamp_TileMode);
     if ((count > 4) && radial_completely_pinned(fx, dx, fy, dy)) {
         unsigned fi = SkGradientShaderBase::kCache32Count - 1;
         sk_memset32_dither(dstC,
             cache[toggle + fi],
             cache[next_dither_toggle(toggle) + fi],
             count);
+    } else if (platformProc) {
+        platformProc(SkScalarToFloat(sfx), SkScalarToFloat(sdx),
+                     SkScalarToFloat(sfy), SkScalarToFloat(sdy),
+                     dstC, cache + toggle, cache + next_dither_toggle(toggle), count);
     } else if ((count > 4) &&
                no_need_for_radial_pin(fx, dx, fy, dy, count)) {
         unsigned fi;
@@ -372,6 +378,13 @@ void shadeSpan_radial_mirror(SkScalar sfx, SkScalar sdx,
         SkScalar sfy, SkScalar sdy,
         SkPMColor* SK_RESTRICT dstC, const SkPMColor* SK_RESTRICT cache,
         int count, int toggle) {
+    SkRadialGradientProc platformProc = SkPlatformRadialGradientProc(SkShader::kMirror_TileMode);
+    if (platformProc) {
+        platformProc(SkScalarToFloat(sfx), SkScalarToFloat(sdx),
+                     SkScalarToFloat(sfy), SkScalarToFloat(sdy),
+                     dstC, cache + toggle, cache + next_dither_toggle(toggle), count);
+        return;
+    }
     do {
 #ifdef SK_SCALAR_IS_FLOAT
         float fdist = sk_float_sqrt(sfx*sfx + sfy*sfy);
@@ -396,6 +409,13 @@ void shadeSpan_radial_repeat(SkScalar sfx, SkScalar sdx,
         SkScalar sfy, SkScalar sdy,
         SkPMColor* SK_RESTRICT dstC, const SkPMColor* SK_RESTRICT cache,
         int count, int toggle) {
+    SkRadialGradientProc platformProc = SkPlatformRadialGradientProc(SkShader::kRepeat_TileMode);
+    if (platformProc) {
+        platformProc(SkScalarToFloat(sfx), SkScalarToFloat(sdx),
+                     SkScalarToFloat(sfy), SkScalarToFloat(sdy),
+                     dstC, cache + toggle, cache + next_dither_toggle(toggle), count);
+        return;
+    }
     SkFixed fx = SkScalarToFixed(sfx);
     SkFixed dx = SkScalarToFixed(sdx);
     SkFixed fy = SkScalarToFixed(sfy);
@@ -21,6 +21,7 @@
 #include "SkGlyphCache.h"
 #include "SkImageFilter.h"
 #include "SkPathEffect.h"
+#include "SkRRect.h"
 #include "SkStroke.h"
 #include "SkUtils.h"
 
@@ -734,6 +735,13 @@ void SkGpuDevice::drawOval(const SkDraw& draw, const SkRect& oval,
     fContext->drawOval(grPaint, oval, stroke);
 }
 
+void SkGpuDevice::drawRRect(const SkDraw& draw, const SkRRect& rrect,
+                            const SkPaint& paint) {
+    SkPath path;
+    path.addRRect(rrect);
+    this->drawPath(draw, path, paint, NULL, true);
+}
+
 #include "SkMaskFilter.h"
 #include "SkBounder.h"
 
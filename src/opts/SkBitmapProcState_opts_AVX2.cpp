@@ -0,0 +1,222 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include <immintrin.h>
+#include "SkBitmapProcState_opts_AVX2.h"
+#include "SkBitmapProcState_filter.h"
+
+// Copies the low word of each 32 bit lane into its high word.
+static inline __m256i dup_lo16(const __m256i& v) {
+    return _mm256_or_si256(v, _mm256_slli_epi32(v, 16));
+}
+
+/*  AVX2 version of S32_opaque_D32_filter_DX()
+ *  portable version is in core/SkBitmapProcState_procs.h
+ *
+ *  Filters 8 pixels at a time, gathering their 32 samples from the two rows,
+ *  with the same arithmetic as S32_opaque_D32_filter_DX_SSE2.
+ */
+void S32_opaque_D32_filter_DX_AVX2(const SkBitmapProcState& s,
+                                   const uint32_t* xy,
+                                   int count, uint32_t* colors) {
+    SkASSERT(count > 0 && colors != NULL);
+    SkASSERT(s.fDoFilter);
+    SkASSERT(s.fBitmap->config() == SkBitmap::kARGB_8888_Config);
+    SkASSERT(s.fAlphaScale == 256);
+
+    const char* srcAddr = static_cast<const char*>(s.fBitmap->getPixels());
+    size_t rb = s.fBitmap->rowBytes();
+    uint32_t XY = *xy++;
+    unsigned y0 = XY >> 14;
+    const uint32_t* row0 = reinterpret_cast<const uint32_t*>(srcAddr + (y0 >> 4) * rb);
+    const uint32_t* row1 = reinterpret_cast<const uint32_t*>(srcAddr + (XY & 0x3FFF) * rb);
+    unsigned subY = y0 & 0xF;
+
+    if (count >= 8) {
+        const int* r0 = reinterpret_cast<const int*>(row0);
+        const int* r1 = reinterpret_cast<const int*>(row1);
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i sixteen = _mm256_set1_epi32(16);
+        const __m256i mask_x1 = _mm256_set1_epi32(0x3FFF);
+        const __m256i mask_sub = _mm256_set1_epi32(0xF);
+        const __m256i allY = _mm256_set1_epi32(subY);
+        const __m256i negY = _mm256_set1_epi32(16 - subY);
+
+        while (count >= 8) {
+            // x0:14 | 4 | x1:14, for 8 pixels
+            __m256i XX = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(xy));
+            __m256i x0 = _mm256_srli_epi32(XX, 18);
+            __m256i x1 = _mm256_and_si256(XX, mask_x1);
+            __m256i allX = _mm256_and_si256(_mm256_srli_epi32(XX, 14), mask_sub);
+            __m256i negX = _mm256_sub_epi32(sixteen, allX);
+
+            // The weight of each sample, (16-x)*(16-y) etc, in both words of its pixel
+            __m256i w00 = dup_lo16(_mm256_mullo_epi16(negX, negY));
+            __m256i w01 = dup_lo16(_mm256_mullo_epi16(allX, negY));
+            __m256i w10 = dup_lo16(_mm256_mullo_epi16(negX, allY));
+            __m256i w11 = dup_lo16(_mm256_mullo_epi16(allX, allY));
+
+            // Load 32 samples (pixels).
+            __m256i a00 = _mm256_i32gather_epi32(r0, x0, 4);
+            __m256i a01 = _mm256_i32gather_epi32(r0, x1, 4);
+            __m256i a10 = _mm256_i32gather_epi32(r1, x0, 4);
+            __m256i a11 = _mm256_i32gather_epi32(r1, x1, 4);
+
+            // Expand to 16 bits per component, two pixels of each lane at a time,
+            // and sum the weighted samples. The sum is at most 255 * 256.
+            __m256i lo = _mm256_mullo_epi16(_mm256_unpacklo_epi8(a00, zero),
+                                            _mm256_unpacklo_epi32(w00, w00));
+            lo = _mm256_add_epi16(lo, _mm256_mullo_epi16(_mm256_unpacklo_epi8(a01, zero),
+                                                         _mm256_unpacklo_epi32(w01, w01)));
+            lo = _mm256_add_epi16(lo, _mm256_mullo_epi16(_mm256_unpacklo_epi8(a10, zero),
+                                                         _mm256_unpacklo_epi32(w10, w10)));
+            lo = _mm256_add_epi16(lo, _mm256_mullo_epi16(_mm256_unpacklo_epi8(a11, zero),
+                                                         _mm256_unpacklo_epi32(w11, w11)));
+
+            __m256i hi = _mm256_mullo_epi16(_mm256_unpackhi_epi8(a00, zero),
+                                            _mm256_unpackhi_epi32(w00, w00));
+            hi = _mm256_add_epi16(hi, _mm256_mullo_epi16(_mm256_unpackhi_epi8(a01, zero),
+                                                         _mm256_unpackhi_epi32(w01, w01)));
+            hi = _mm256_add_epi16(hi, _mm256_mullo_epi16(_mm256_unpackhi_epi8(a10, zero),
+                                                         _mm256_unpackhi_epi32(w10, w10)));
+            hi = _mm256_add_epi16(hi, _mm256_mullo_epi16(_mm256_unpackhi_epi8(a11, zero),
+                                                         _mm256_unpackhi_epi32(w11, w11)));
+
+            // Divide each 16 bit component by 256, and pack back into pixel order.
+            __m256i sum = _mm256_packus_epi16(_mm256_srli_epi16(lo, 8),
+                                              _mm256_srli_epi16(hi, 8));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(colors), sum);
+
+            xy += 8;
+            colors += 8;
+            count -= 8;
+        }
+    }
+
+    while (count-- > 0) {
+        uint32_t XX = *xy++;    // x0:14 | 4 | x1:14
+        unsigned x0 = XX >> 18;
+        unsigned x1 = XX & 0x3FFF;
+        Filter_32_opaque((XX >> 14) & 0xF, subY,
+                         row0[x0], row0[x1], row1[x0], row1[x1], colors++);
+    }
+}
+
+static inline uint32_t ClampX_ClampY_pack_filter(SkFixed f, unsigned max,
+                                                 SkFixed one) {
+    unsigned i = SkClampMax(f >> 16, max);
+    i = (i << 4) | ((f >> 12) & 0xF);
+    return (i << 14) | SkClampMax((f + one) >> 16, max);
+}
+
+/*  AVX2 version of ClampX_ClampY_filter_scale()
+ *  portable version is in core/SkBitmapProcState_matrix.h
+ */
+void ClampX_ClampY_filter_scale_AVX2(const SkBitmapProcState& s, uint32_t xy[],
+                                     int count, int x, int y) {
+    SkASSERT((s.fInvType & ~(SkMatrix::kTranslate_Mask |
+                             SkMatrix::kScale_Mask)) == 0);
+    SkASSERT(s.fInvKy == 0);
+
+    const unsigned maxX = s.fBitmap->width() - 1;
+    const SkFixed one = s.fFilterOneX;
+    const SkFixed dx = s.fInvSx;
+    SkFixed fx;
+
+    SkPoint pt;
+    s.fInvProc(*s.fInvMatrix, SkIntToScalar(x) + SK_ScalarHalf,
+                                SkIntToScalar(y) + SK_ScalarHalf, &pt);
+    const SkFixed fy = SkScalarToFixed(pt.fY) - (s.fFilterOneY >> 1);
+    const unsigned maxY = s.fBitmap->height() - 1;
+    // compute our two Y values up front
+    *xy++ = ClampX_ClampY_pack_filter(fy, maxY, s.fFilterOneY);
+    // now initialize fx
+    fx = SkScalarToFixed(pt.fX) - (one >> 1);
+
+    const __m256i wide_dx8 = _mm256_set1_epi32(dx * 8);
+
+    // test if we don't need to apply the tile proc
+    if (dx > 0 && (unsigned)(fx >> 16) <= maxX &&
+        (unsigned)((fx + dx * (count - 1)) >> 16) < maxX) {
+        if (count >= 8) {
+            __m256i wide_1  = _mm256_set1_epi32(1);
+            __m256i wide_fx = _mm256_setr_epi32(fx, fx + dx, fx + dx * 2, fx + dx * 3,
+                                                fx + dx * 4, fx + dx * 5, fx + dx * 6,
+                                                fx + dx * 7);
+
+            while (count >= 8) {
+                __m256i wide_out;
+
+                wide_out = _mm256_slli_epi32(_mm256_srai_epi32(wide_fx, 12), 14);
+                wide_out = _mm256_or_si256(wide_out, _mm256_add_epi32(
+                                           _mm256_srai_epi32(wide_fx, 16), wide_1));
+
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(xy), wide_out);
+
+                xy += 8;
+                fx += dx * 8;
+                wide_fx = _mm256_add_epi32(wide_fx, wide_dx8);
+                count -= 8;
+            }
+        }
+
+        while (count-- > 0) {
+            SkASSERT((fx >> (16 + 14)) == 0);
+            *xy++ = (fx >> 12 << 14) | ((fx >> 16) + 1);
+            fx += dx;
+        }
+    } else {
+        // Unlike the SSE2 version this clamps in 32 bits, so it handles any maxX.
+        if (count >= 8) {
+            __m256i wide_fx   = _mm256_setr_epi32(fx, fx + dx, fx + dx * 2, fx + dx * 3,
+                                                  fx + dx * 4, fx + dx * 5, fx + dx * 6,
+                                                  fx + dx * 7);
+            __m256i wide_one  = _mm256_set1_epi32(one);
+            __m256i wide_maxX = _mm256_set1_epi32(maxX);
+            __m256i wide_mask = _mm256_set1_epi32(0xF);
+            __m256i zero      = _mm256_setzero_si256();
+
+            while (count >= 8) {
+                __m256i wide_i;
+                __m256i wide_lo;
+                __m256i wide_fx1;
+
+                // i = SkClampMax(f>>16,maxX)
+                wide_i = _mm256_max_epi32(_mm256_srai_epi32(wide_fx, 16), zero);
+                wide_i = _mm256_min_epi32(wide_i, wide_maxX);
+
+                // i<<4 | TILEX_LOW_BITS(fx)
+                wide_lo = _mm256_srli_epi32(wide_fx, 12);
+                wide_lo = _mm256_and_si256(wide_lo, wide_mask);
+                wide_i  = _mm256_slli_epi32(wide_i, 4);
+                wide_i  = _mm256_or_si256(wide_i, wide_lo);
+
+                // i<<14
+                wide_i = _mm256_slli_epi32(wide_i, 14);
+
+                // SkClampMax(((f+one))>>16,max)
+                wide_fx1 = _mm256_add_epi32(wide_fx, wide_one);
+                wide_fx1 = _mm256_max_epi32(_mm256_srai_epi32(wide_fx1, 16), zero);
+                wide_fx1 = _mm256_min_epi32(wide_fx1, wide_maxX);
+
+                // final combination
+                wide_i = _mm256_or_si256(wide_i, wide_fx1);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(xy), wide_i);
+
+                wide_fx = _mm256_add_epi32(wide_fx, wide_dx8);
+                fx += dx * 8;
+                xy += 8;
+                count -= 8;
+            }
+        }
+
+        while (count-- > 0) {
+            *xy++ = ClampX_ClampY_pack_filter(fx, maxX, one);
+            fx += dx;
+        }
+    }
+}
@@ -0,0 +1,19 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkBitmapProcState_opts_AVX2_DEFINED
+#define SkBitmapProcState_opts_AVX2_DEFINED
+
+#include "SkBitmapProcState.h"
+
+void S32_opaque_D32_filter_DX_AVX2(const SkBitmapProcState& s,
+                                   const uint32_t* xy,
+                                   int count, uint32_t* colors);
+void ClampX_ClampY_filter_scale_AVX2(const SkBitmapProcState& s, uint32_t xy[],
+                                     int count, int x, int y);
+
+#endif
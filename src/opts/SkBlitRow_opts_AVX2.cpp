@@ -0,0 +1,236 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include <immintrin.h>
+#include "SkBlitRow_opts_AVX2.h"
+#include "SkColorPriv.h"
+#include "SkUtils.h"
+
+/*  These are the SSE2 procs in SkBlitRow_opts_SSE2.cpp, widened to 8 pixels,
+    and produce the same results. Each also skips the arithmetic for runs of
+    pixels that it can tell are fully covered or fully transparent.
+ */
+
+// Multiplies the four channels of each pixel by the 16 bit scale in both of
+// its words, and divides by 256.
+static inline __m256i SkAlphaMulQ_AVX2(const __m256i& c, const __m256i& scale) {
+    const __m256i rb_mask = _mm256_set1_epi32(0x00FF00FF);
+
+    // Red and blue in the low byte of each word, alpha and green in the high
+    __m256i rb = _mm256_and_si256(rb_mask, c);
+    __m256i ag = _mm256_srli_epi16(c, 8);
+
+    rb = _mm256_srli_epi16(_mm256_mullo_epi16(rb, scale), 8);
+    ag = _mm256_andnot_si256(rb_mask, _mm256_mullo_epi16(ag, scale));
+    return _mm256_or_si256(rb, ag);
+}
+
+/* AVX2 version of S32A_Opaque_BlitRow32()
+ * portable version is in core/SkBlitRow_D32.cpp
+ */
+void S32A_Opaque_BlitRow32_AVX2(SkPMColor* SK_RESTRICT dst,
+                                const SkPMColor* SK_RESTRICT src,
+                                int count, U8CPU alpha) {
+    SkASSERT(alpha == 255);
+    if (count <= 0) {
+        return;
+    }
+
+    if (count >= 8) {
+        SkASSERT(((size_t)dst & 0x03) == 0);
+        while (((size_t)dst & 0x1F) != 0) {
+            *dst = SkPMSrcOver(*src, *dst);
+            src++;
+            dst++;
+            count--;
+        }
+
+        const __m256i *s = reinterpret_cast<const __m256i*>(src);
+        __m256i *d = reinterpret_cast<__m256i*>(dst);
+        const __m256i alpha_mask = _mm256_set1_epi32(0xFF << SK_A32_SHIFT);
+        const __m256i c_256 = _mm256_set1_epi16(0x0100);
+        // Copies each pixel's alpha into the low byte of both of its words
+        const char A = SK_A32_SHIFT / 8;
+        const __m256i alpha_shuffle = _mm256_setr_epi8(
+                A,      -1, A,      -1, A + 4,  -1, A + 4,  -1,
+                A + 8,  -1, A + 8,  -1, A + 12, -1, A + 12, -1,
+                A,      -1, A,      -1, A + 4,  -1, A + 4,  -1,
+                A + 8,  -1, A + 8,  -1, A + 12, -1, A + 12, -1);
+        while (count >= 8) {
+            // Load 8 pixels
+            __m256i src_pixel = _mm256_loadu_si256(s);
+
+            if (_mm256_testc_si256(src_pixel, alpha_mask)) {
+                // All opaque: src replaces dst
+                _mm256_store_si256(d, src_pixel);
+            } else if (!_mm256_testz_si256(src_pixel, src_pixel)) {
+                // (Unless src is all 0, which leaves dst as it is)
+                __m256i dst_pixel = _mm256_load_si256(d);
+
+                // Subtract alphas from 256, to get 1..256
+                __m256i scale = _mm256_shuffle_epi8(src_pixel, alpha_shuffle);
+                scale = _mm256_sub_epi16(c_256, scale);
+
+                // Add result
+                __m256i result = _mm256_add_epi8(src_pixel,
+                                                 SkAlphaMulQ_AVX2(dst_pixel, scale));
+                _mm256_store_si256(d, result);
+            }
+            s++;
+            d++;
+            count -= 8;
+        }
+        src = reinterpret_cast<const SkPMColor*>(s);
+        dst = reinterpret_cast<SkPMColor*>(d);
+    }
+
+    while (count > 0) {
+        *dst = SkPMSrcOver(*src, *dst);
+        src++;
+        dst++;
+        count--;
+    }
+}
+
+/* AVX2 version of Color32()
+ * portable version is in core/SkBlitRow_D32.cpp
+ */
+void Color32_AVX2(SkPMColor dst[], const SkPMColor src[], int count,
+                  SkPMColor color) {
+    if (count <= 0) {
+        return;
+    }
+
+    if (0 == color) {
+        if (src != dst) {
+            memcpy(dst, src, count * sizeof(SkPMColor));
+        }
+        return;
+    }
+
+    unsigned colorA = SkGetPackedA32(color);
+    if (255 == colorA) {
+        sk_memset32(dst, color, count);
+    } else {
+        unsigned scale = 256 - SkAlpha255To256(colorA);
+
+        if (count >= 8) {
+            SkASSERT(((size_t)dst & 0x03) == 0);
+            while (((size_t)dst & 0x1F) != 0) {
+                *dst = color + SkAlphaMulQ(*src, scale);
+                src++;
+                dst++;
+                count--;
+            }
+
+            const __m256i *s = reinterpret_cast<const __m256i*>(src);
+            __m256i *d = reinterpret_cast<__m256i*>(dst);
+            __m256i src_scale_wide = _mm256_set1_epi16(scale);
+            __m256i color_wide = _mm256_set1_epi32(color);
+            while (count >= 8) {
+                __m256i src_pixel = _mm256_loadu_si256(s);
+                src_pixel = SkAlphaMulQ_AVX2(src_pixel, src_scale_wide);
+
+                // Add color to result.
+                _mm256_store_si256(d, _mm256_add_epi8(color_wide, src_pixel));
+                s++;
+                d++;
+                count -= 8;
+            }
+            src = reinterpret_cast<const SkPMColor*>(s);
+            dst = reinterpret_cast<SkPMColor*>(d);
+        }
+
+        while (count > 0) {
+            *dst = color + SkAlphaMulQ(*src, scale);
+            src += 1;
+            dst += 1;
+            count--;
+        }
+    }
+}
+
+void SkARGB32_A8_BlitMask_AVX2(void* device, size_t dstRB, const void* maskPtr,
+                               size_t maskRB, SkColor origColor,
+                               int width, int height) {
+    SkPMColor color = SkPreMultiplyColor(origColor);
+    size_t dstOffset = dstRB - (width << 2);
+    size_t maskOffset = maskRB - width;
+    SkPMColor* dst = (SkPMColor *)device;
+    const uint8_t* mask = (const uint8_t*)maskPtr;
+    const bool opaque = 0xFF == SkGetPackedA32(color);
+
+    const __m256i rb_mask = _mm256_set1_epi32(0x00FF00FF);
+    const __m256i c_256 = _mm256_set1_epi16(256);
+    const __m256i c_1 = _mm256_set1_epi16(1);
+    const __m256i src_pixel = _mm256_set1_epi32(color);
+    const __m256i src_rb = _mm256_and_si256(rb_mask, src_pixel);
+    const __m256i src_ag = _mm256_srli_epi16(src_pixel, 8);
+    // The color's alpha in both words of each pixel
+    const __m256i src_alpha = _mm256_set1_epi16(SkGetPackedA32(color));
+    do {
+        int count = width;
+        if (count >= 8) {
+            while (((size_t)dst & 0x1F) != 0 && (count > 0)) {
+                *dst = SkBlendARGB32(color, *dst, *mask);
+                mask++;
+                dst++;
+                count--;
+            }
+            __m256i *d = reinterpret_cast<__m256i*>(dst);
+            while (count >= 8) {
+                uint64_t coverage;
+                memcpy(&coverage, mask, sizeof(coverage));
+                if (opaque && ~coverage == 0) {
+                    _mm256_store_si256(d, src_pixel);
+                } else if (0 != coverage) {
+                    __m256i dst_pixel = _mm256_load_si256(d);
+
+                    // Each mask value in both words of its pixel, as a scale of 1..256
+                    __m256i src_scale_wide = _mm256_cvtepu8_epi32(
+                            _mm_loadl_epi64(reinterpret_cast<const __m128i*>(mask)));
+                    src_scale_wide = _mm256_or_si256(src_scale_wide,
+                                                     _mm256_slli_epi32(src_scale_wide, 16));
+                    src_scale_wide = _mm256_add_epi16(src_scale_wide, c_1);
+
+                    // dst_alpha = 256 - (src alpha * src_scale) / 256
+                    __m256i dst_alpha = _mm256_mullo_epi16(src_alpha, src_scale_wide);
+                    dst_alpha = _mm256_srli_epi16(dst_alpha, 8);
+                    dst_alpha = _mm256_sub_epi16(c_256, dst_alpha);
+
+                    // Multiply red and blue by their scales, and divide by 256.
+                    __m256i dst_rb = _mm256_and_si256(rb_mask, dst_pixel);
+                    dst_rb = _mm256_srli_epi16(_mm256_mullo_epi16(dst_rb, dst_alpha), 8);
+                    __m256i rb = _mm256_srli_epi16(_mm256_mullo_epi16(src_rb, src_scale_wide), 8);
+
+                    // Alpha and green already end up in the right place
+                    __m256i dst_ag = _mm256_srli_epi16(dst_pixel, 8);
+                    dst_ag = _mm256_andnot_si256(rb_mask, _mm256_mullo_epi16(dst_ag, dst_alpha));
+                    __m256i ag = _mm256_andnot_si256(rb_mask,
+                                                     _mm256_mullo_epi16(src_ag, src_scale_wide));
+
+                    // Add the two pixels into the result.
+                    __m256i result = _mm256_add_epi8(_mm256_or_si256(rb, ag),
+                                                     _mm256_or_si256(dst_rb, dst_ag));
+                    _mm256_store_si256(d, result);
+                }
+                mask += 8;
+                d++;
+                count -= 8;
+            }
+            dst = reinterpret_cast<SkPMColor *>(d);
+        }
+        while (count > 0) {
+            *dst = SkBlendARGB32(color, *dst, *mask);
+            dst += 1;
+            mask++;
+            count--;
+        }
+        dst = (SkPMColor *)((char*)dst + dstOffset);
+        mask += maskOffset;
+    } while (--height != 0);
+}
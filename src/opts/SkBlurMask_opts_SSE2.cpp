@@ -0,0 +1,293 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include <emmintrin.h>
+#include "SkBlurMask_opts_SSE2.h"
+#include "SkTemplates.h"
+
+/*
+ *  Each pass blurs 16 rows at once. The 16 rows are transposed, a 16x16 tile at a time, so that
+ *  each x position of the strip is one 16 byte vector; the sliding window then moves down those
+ *  vectors, keeping one running sum per row in 16 bit lanes. The blurred vectors are either
+ *  stored as they are (when the pass transposes its output anyway) or transposed back into rows.
+ *
+ *  The sums, scales and rounding are those of boxBlur() and boxBlurInterp(), so the results match
+ *  them exactly. The sums fit in 16 bits as long as the kernel is at most 257 pixels wide, and
+ *  the scaling is done in 16 bits too (see scale_lanes()).
+ */
+
+static const int kMaxKernelSize = 257;
+
+#ifndef SK_DISABLE_BLUR_ROUNDING
+static const uint32_t kHalf = 1 << 23;
+#else
+static const uint32_t kHalf = 0;
+#endif
+
+// Transposes the 16x16 block of bytes at src into dst.
+static void transpose16x16(const uint8_t* src, int srcStride, uint8_t* dst, int dstStride) {
+    __m128i a[16], b[16];
+    for (int i = 0; i < 16; i++) {
+        a[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * srcStride));
+    }
+    // Four rounds of interleaving row i with row i + 8 leave the bytes transposed.
+    for (int round = 0; round < 2; round++) {
+        for (int i = 0; i < 8; i++) {
+            b[2 * i]     = _mm_unpacklo_epi8(a[i], a[i + 8]);
+            b[2 * i + 1] = _mm_unpackhi_epi8(a[i], a[i + 8]);
+        }
+        for (int i = 0; i < 8; i++) {
+            a[2 * i]     = _mm_unpacklo_epi8(b[i], b[i + 8]);
+            a[2 * i + 1] = _mm_unpackhi_epi8(b[i], b[i + 8]);
+        }
+    }
+    for (int i = 0; i < 16; i++) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * dstStride), a[i]);
+    }
+}
+
+// Copies 'width' columns of the 16 rows at src into strip, one 16 byte vector per column.
+static void load_strip(const uint8_t* src, int srcRowBytes, int width, uint8_t* strip) {
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        transpose16x16(src + x, srcRowBytes, strip + x * 16, 16);
+    }
+    for (; x < width; x++) {
+        for (int y = 0; y < 16; y++) {
+            strip[x * 16 + y] = src[y * srcRowBytes + x];
+        }
+    }
+}
+
+// Writes the 'width' vectors of strip to 16 rows (or, transposed, 16 columns) of dst.
+static void store_strip(const uint8_t* strip, int width, uint8_t* dst,
+                        int dstXStride, int dstYStride) {
+    if (1 == dstYStride) {
+        for (int x = 0; x < width; x++) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * dstXStride),
+                             _mm_loadu_si128(reinterpret_cast<const __m128i*>(strip + x * 16)));
+        }
+        return;
+    }
+    SkASSERT(1 == dstXStride);
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        transpose16x16(strip + x * 16, 16, dst + x, dstYStride);
+    }
+    for (; x < width; x++) {
+        for (int y = 0; y < 16; y++) {
+            dst[y * dstYStride + x] = strip[x * 16 + y];
+        }
+    }
+}
+
+// Running sums of 16 rows, in two vectors of 8 16 bit lanes.
+struct Sums {
+    __m128i fLo;
+    __m128i fHi;
+
+    Sums() : fLo(_mm_setzero_si128()), fHi(_mm_setzero_si128()) {}
+
+    void add(const uint8_t* pixels) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels));
+        fLo = _mm_add_epi16(fLo, _mm_unpacklo_epi8(v, _mm_setzero_si128()));
+        fHi = _mm_add_epi16(fHi, _mm_unpackhi_epi8(v, _mm_setzero_si128()));
+    }
+
+    void sub(const uint8_t* pixels) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels));
+        fLo = _mm_sub_epi16(fLo, _mm_unpacklo_epi8(v, _mm_setzero_si128()));
+        fHi = _mm_sub_epi16(fHi, _mm_unpackhi_epi8(v, _mm_setzero_si128()));
+    }
+};
+
+// A scale of up to 24 bits, split into its high and low 16 bits.
+struct Scale {
+    __m128i fHi;
+    __m128i fLo;
+
+    explicit Scale(uint32_t scale)
+        : fHi(_mm_set1_epi16(scale >> 16))
+        , fLo(_mm_set1_epi16(scale & 0xFFFF)) {}
+};
+
+/*
+ *  (sum * scale + half) >> 24 is computed in 16 bit lanes as
+ *      (sum * scaleHi + ((sum * scaleLo) >> 16) + (half >> 16)) >> 8
+ *  which is exact, since half has no low bits. The scales are small enough that every result
+ *  is at most 255, so the sum before the final shift fits in 16 bits even though the products
+ *  on their own may not.
+ */
+static inline __m128i scale_lanes(__m128i sum, const Scale& scale, __m128i half) {
+    __m128i r = _mm_add_epi16(_mm_mullo_epi16(sum, scale.fHi), _mm_mulhi_epu16(sum, scale.fLo));
+    return _mm_srli_epi16(_mm_add_epi16(r, half), 8);
+}
+
+// As scale_lanes(), for outer * outerScale + inner * innerScale. The low halves of the two low
+// products are added to find the carry into the high halves.
+static inline __m128i scale_lanes(__m128i outer, const Scale& outerScale,
+                                  __m128i inner, const Scale& innerScale, __m128i half) {
+    const __m128i signBit = _mm_set1_epi16((short)0x8000);
+    const __m128i outerLo = _mm_mullo_epi16(outer, outerScale.fLo);
+    const __m128i lo = _mm_add_epi16(outerLo, _mm_mullo_epi16(inner, innerScale.fLo));
+    // -1 where lo wrapped, i.e. where lo < outerLo as unsigned values.
+    const __m128i carry = _mm_cmpgt_epi16(_mm_xor_si128(outerLo, signBit),
+                                          _mm_xor_si128(lo, signBit));
+
+    __m128i r = _mm_add_epi16(_mm_mullo_epi16(outer, outerScale.fHi),
+                              _mm_mullo_epi16(inner, innerScale.fHi));
+    r = _mm_add_epi16(r, _mm_mulhi_epu16(outer, outerScale.fLo));
+    r = _mm_add_epi16(r, _mm_mulhi_epu16(inner, innerScale.fLo));
+    r = _mm_sub_epi16(r, carry);
+    return _mm_srli_epi16(_mm_add_epi16(r, half), 8);
+}
+
+// Returns (sum * scale + half) >> 24 for each of the 16 sums, as bytes.
+static inline __m128i scale_sums(const Sums& sums, const Scale& scale, __m128i half) {
+    return _mm_packus_epi16(scale_lanes(sums.fLo, scale, half),
+                            scale_lanes(sums.fHi, scale, half));
+}
+
+// Returns (outer * outerScale + inner * innerScale + half) >> 24 for each of the 16 rows.
+static inline __m128i scale_sums(const Sums& outer, const Scale& outerScale,
+                                 const Sums& inner, const Scale& innerScale, __m128i half) {
+    return _mm_packus_epi16(scale_lanes(outer.fLo, outerScale, inner.fLo, innerScale, half),
+                            scale_lanes(outer.fHi, outerScale, inner.fHi, innerScale, half));
+}
+
+static inline void store(uint8_t* dst, __m128i v) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), v);
+}
+
+bool SkBoxBlur_SSE2(const uint8_t* src, int srcRowBytes, uint8_t* dst,
+                    int dstXStride, int dstYStride,
+                    int leftRadius, int rightRadius, int width, int count) {
+    const int diameter = leftRadius + rightRadius;
+    const int kernelSize = diameter + 1;
+    if (kernelSize > kMaxKernelSize) {
+        return false;
+    }
+    SkASSERT(0 == (count & 15));
+
+    const int border = SkMin32(width, diameter);
+    const int newWidth = width + SkMax32(leftRadius, rightRadius) * 2;
+    const Scale scale((1 << 24) / kernelSize);
+    const __m128i half = _mm_set1_epi16(kHalf >> 16);
+    const __m128i zero = _mm_setzero_si128();
+
+    SkAutoTMalloc<uint8_t> storage((width + newWidth) * 16);
+    uint8_t* in = storage.get();
+    uint8_t* out = in + width * 16;
+
+    for (int y = 0; y < count; y += 16) {
+        load_strip(src + y * srcRowBytes, srcRowBytes, width, in);
+
+        Sums sums;
+        const uint8_t* right = in;
+        const uint8_t* left = in;
+        uint8_t* dptr = out;
+        for (int x = 0; x < rightRadius - leftRadius; x++, dptr += 16) {
+            store(dptr, zero);
+        }
+        for (int x = 0; x < border; x++, dptr += 16) {
+            sums.add(right);
+            right += 16;
+            store(dptr, scale_sums(sums, scale, half));
+        }
+        if (width < diameter) {
+            const __m128i result = scale_sums(sums, scale, half);
+            for (int x = width; x < diameter; x++, dptr += 16) {
+                store(dptr, result);
+            }
+        }
+        for (int x = diameter; x < width; x++, dptr += 16) {
+            sums.add(right);
+            right += 16;
+            store(dptr, scale_sums(sums, scale, half));
+            sums.sub(left);
+            left += 16;
+        }
+        for (int x = 0; x < border; x++, dptr += 16) {
+            store(dptr, scale_sums(sums, scale, half));
+            sums.sub(left);
+            left += 16;
+        }
+        for (int x = 0; x < leftRadius - rightRadius; x++, dptr += 16) {
+            store(dptr, zero);
+        }
+        SkASSERT(dptr == out + newWidth * 16);
+
+        store_strip(out, newWidth, dst + y * dstYStride, dstXStride, dstYStride);
+    }
+    return true;
+}
+
+bool SkBoxBlurInterp_SSE2(const uint8_t* src, int srcRowBytes, uint8_t* dst,
+                          int dstXStride, int dstYStride,
+                          int radius, int width, int count, uint8_t outerWeight) {
+    const int diameter = radius * 2;
+    const int kernelSize = diameter + 1;
+    if (radius < 1 || kernelSize > kMaxKernelSize) {
+        return false;
+    }
+    SkASSERT(0 == (count & 15));
+
+    const int border = SkMin32(width, diameter);
+    const int newWidth = width + diameter;
+    // outerWeight stays a byte here, as in boxBlurInterp().
+    int innerWeight = 255 - outerWeight;
+    outerWeight += outerWeight >> 7;
+    innerWeight += innerWeight >> 7;
+    const Scale outerScale((outerWeight << 16) / kernelSize);
+    const Scale innerScale((innerWeight << 16) / (kernelSize - 2));
+    const __m128i half = _mm_set1_epi16(kHalf >> 16);
+
+    SkAutoTMalloc<uint8_t> storage((width + newWidth) * 16);
+    uint8_t* in = storage.get();
+    uint8_t* out = in + width * 16;
+
+    for (int y = 0; y < count; y += 16) {
+        load_strip(src + y * srcRowBytes, srcRowBytes, width, in);
+
+        Sums outer, inner;
+        const uint8_t* right = in;
+        const uint8_t* left = in;
+        uint8_t* dptr = out;
+        for (int x = 0; x < border; x++, dptr += 16) {
+            inner = outer;
+            outer.add(right);
+            right += 16;
+            store(dptr, scale_sums(outer, outerScale, inner, innerScale, half));
+        }
+        if (width < diameter) {
+            const __m128i result = scale_sums(outer, outerScale, inner, innerScale, half);
+            for (int x = width; x < diameter; x++, dptr += 16) {
+                store(dptr, result);
+            }
+        }
+        for (int x = diameter; x < width; x++, dptr += 16) {
+            inner = outer;
+            inner.sub(left);
+            outer.add(right);
+            right += 16;
+            store(dptr, scale_sums(outer, outerScale, inner, innerScale, half));
+            outer.sub(left);
+            left += 16;
+        }
+        for (int x = 0; x < border; x++, dptr += 16) {
+            inner = outer;
+            inner.sub(left);
+            left += 16;
+            store(dptr, scale_sums(outer, outerScale, inner, innerScale, half));
+            outer = inner;
+        }
+        SkASSERT(dptr == out + newWidth * 16);
+
+        store_strip(out, newWidth, dst + y * dstYStride, dstXStride, dstYStride);
+    }
+    return true;
+}
@@ -0,0 +1,21 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkBlurMask_opts_SSE2_DEFINED
+#define SkBlurMask_opts_SSE2_DEFINED
+
+#include "SkBlurMask_opts.h"
+
+bool SkBoxBlur_SSE2(const uint8_t* src, int srcRowBytes, uint8_t* dst,
+                    int dstXStride, int dstYStride,
+                    int leftRadius, int rightRadius, int width, int count);
+
+bool SkBoxBlurInterp_SSE2(const uint8_t* src, int srcRowBytes, uint8_t* dst,
+                          int dstXStride, int dstYStride,
+                          int radius, int width, int count, uint8_t outerWeight);
+
+#endif
@@ -0,0 +1,16 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkBlurMask_opts.h"
+
+SkBoxBlurProc SkPlatformBoxBlurProc() {
+    return NULL;
+}
+
+SkBoxBlurInterpProc SkPlatformBoxBlurInterpProc() {
+    return NULL;
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include <emmintrin.h>
+#include "SkConvolver_opts_SSE2.h"
+
+typedef SkConvolutionFilter1D::Fixed Fixed;
+
+// Both weights in each 32 bit lane, so that _mm_madd_epi16() on channels interleaved from two
+// pixels (c0 of the first, c0 of the second, c1 of the first, ...) sums both taps per channel.
+static inline __m128i weight_pair(Fixed w0, Fixed w1) {
+    return _mm_set1_epi32((uint16_t)w0 | ((uint32_t)(uint16_t)w1 << 16));
+}
+
+// Rounds the 32 bit sums back to the weights' scale, and packs them into 8 bit channels
+// clamped to [0, 255].
+static inline __m128i round_and_pack(__m128i a0, __m128i a1, __m128i a2, __m128i a3) {
+    a0 = _mm_srai_epi32(a0, SkConvolutionFilter1D::kShiftBits);
+    a1 = _mm_srai_epi32(a1, SkConvolutionFilter1D::kShiftBits);
+    a2 = _mm_srai_epi32(a2, SkConvolutionFilter1D::kShiftBits);
+    a3 = _mm_srai_epi32(a3, SkConvolutionFilter1D::kShiftBits);
+    return _mm_packus_epi16(_mm_packs_epi32(a0, a1), _mm_packs_epi32(a2, a3));
+}
+
+void SkConvolveHorizontally_SSE2(const SkPMColor src[], const SkConvolutionFilter1D& filter,
+                                 SkPMColor dst[]) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i half = _mm_set1_epi32(1 << (SkConvolutionFilter1D::kShiftBits - 1));
+
+    for (int i = 0; i < filter.numValues(); i++) {
+        int offset, length;
+        const Fixed* weights = filter.filterForValue(i, &offset, &length);
+        const SkPMColor* row = src + offset;
+
+        __m128i accum = half;
+        int j = 0;
+        for (; j + 4 <= length; j += 4) {
+            __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + j));
+            // (p0, p2, p1, p3), then interleave the bytes of p0 with p1 and of p2 with p3.
+            pixels = _mm_shuffle_epi32(pixels, _MM_SHUFFLE(3, 1, 2, 0));
+            pixels = _mm_unpacklo_epi8(pixels, _mm_unpackhi_epi64(pixels, pixels));
+            accum = _mm_add_epi32(accum, _mm_madd_epi16(_mm_unpacklo_epi8(pixels, zero),
+                                                        weight_pair(weights[j], weights[j + 1])));
+            accum = _mm_add_epi32(accum, _mm_madd_epi16(_mm_unpackhi_epi8(pixels, zero),
+                                                        weight_pair(weights[j + 2],
+                                                                    weights[j + 3])));
+        }
+        if (j + 2 <= length) {
+            __m128i pixels = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + j));
+            pixels = _mm_unpacklo_epi8(pixels, _mm_srli_si128(pixels, 4));
+            accum = _mm_add_epi32(accum, _mm_madd_epi16(_mm_unpacklo_epi8(pixels, zero),
+                                                        weight_pair(weights[j], weights[j + 1])));
+            j += 2;
+        }
+        if (j < length) {
+            __m128i pixel = _mm_unpacklo_epi8(_mm_cvtsi32_si128(row[j]), zero);
+            accum = _mm_add_epi32(accum, _mm_madd_epi16(_mm_unpacklo_epi8(pixel, zero),
+                                                        weight_pair(weights[j], 0)));
+        }
+
+        dst[i] = _mm_cvtsi128_si32(round_and_pack(accum, accum, accum, accum));
+    }
+}
+
+// Clamps the color channels of each pixel to its alpha.
+static inline __m128i clamp_to_alpha(__m128i pixels) {
+    __m128i alpha = _mm_srli_epi32(pixels, 24);
+    alpha = _mm_or_si128(alpha, _mm_slli_epi32(alpha, 8));
+    alpha = _mm_or_si128(alpha, _mm_slli_epi32(alpha, 16));
+    return _mm_min_epu8(pixels, alpha);
+}
+
+void SkConvolveVertically_SSE2(const Fixed filter[], int length, const SkPMColor* const rows[],
+                               int width, SkPMColor dst[]) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i half = _mm_set1_epi32(1 << (SkConvolutionFilter1D::kShiftBits - 1));
+
+    int x = 0;
+    for (; x + 4 <= width; x += 4) {
+        __m128i a0 = half, a1 = half, a2 = half, a3 = half;
+        for (int j = 0; j < length; j += 2) {
+            __m128i r0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[j] + x));
+            __m128i r1 = zero;
+            Fixed w1 = 0;
+            if (j + 1 < length) {
+                r1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[j + 1] + x));
+                w1 = filter[j + 1];
+            }
+            const __m128i w = weight_pair(filter[j], w1);
+
+            // Interleave the two rows' bytes: pixels 0 and 1 in lo, 2 and 3 in hi.
+            const __m128i lo = _mm_unpacklo_epi8(r0, r1);
+            const __m128i hi = _mm_unpackhi_epi8(r0, r1);
+            a0 = _mm_add_epi32(a0, _mm_madd_epi16(_mm_unpacklo_epi8(lo, zero), w));
+            a1 = _mm_add_epi32(a1, _mm_madd_epi16(_mm_unpackhi_epi8(lo, zero), w));
+            a2 = _mm_add_epi32(a2, _mm_madd_epi16(_mm_unpacklo_epi8(hi, zero), w));
+            a3 = _mm_add_epi32(a3, _mm_madd_epi16(_mm_unpackhi_epi8(hi, zero), w));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x),
+                         clamp_to_alpha(round_and_pack(a0, a1, a2, a3)));
+    }
+    for (; x < width; x++) {
+        __m128i a0 = half;
+        for (int j = 0; j < length; j += 2) {
+            __m128i r0 = _mm_cvtsi32_si128(rows[j][x]);
+            __m128i r1 = zero;
+            Fixed w1 = 0;
+            if (j + 1 < length) {
+                r1 = _mm_cvtsi32_si128(rows[j + 1][x]);
+                w1 = filter[j + 1];
+            }
+            a0 = _mm_add_epi32(a0, _mm_madd_epi16(_mm_unpacklo_epi8(_mm_unpacklo_epi8(r0, r1),
+                                                                    zero),
+                                                  weight_pair(filter[j], w1)));
+        }
+        dst[x] = _mm_cvtsi128_si32(clamp_to_alpha(round_and_pack(a0, a0, a0, a0)));
+    }
+}
@@ -0,0 +1,20 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkConvolver_opts_SSE2_DEFINED
+#define SkConvolver_opts_SSE2_DEFINED
+
+#include "SkConvolver.h"
+
+void SkConvolveHorizontally_SSE2(const SkPMColor src[], const SkConvolutionFilter1D& filter,
+                                 SkPMColor dst[]);
+
+// Assumes alpha is the high byte of each pixel (SK_A32_SHIFT == 24).
+void SkConvolveVertically_SSE2(const SkConvolutionFilter1D::Fixed filter[], int length,
+                               const SkPMColor* const rows[], int width, SkPMColor dst[]);
+
+#endif
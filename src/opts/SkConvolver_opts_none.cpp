@@ -0,0 +1,16 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkConvolver.h"
+
+SkConvolveHorizontallyProc SkPlatformConvolveHorizontallyProc() {
+    return NULL;
+}
+
+SkConvolveVerticallyProc SkPlatformConvolveVerticallyProc() {
+    return NULL;
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include <emmintrin.h>
+#include "SkGradient_opts_SSE2.h"
+
+// Tiles four 16.16 positions as the gradients' TileProcs do. Clamped spans are pinned before
+// they get here, so clamping is a no-op.
+template <SkShader::TileMode tileMode>
+static inline __m128i tile4(__m128i x) {
+    switch (tileMode) {
+        case SkShader::kRepeat_TileMode:
+            return _mm_and_si128(x, _mm_set1_epi32(0xFFFF));
+        case SkShader::kMirror_TileMode: {
+            const __m128i s = _mm_srai_epi32(_mm_slli_epi32(x, 15), 31);
+            return _mm_and_si128(_mm_xor_si128(x, s), _mm_set1_epi32(0xFFFF));
+        }
+        default:
+            return x;
+    }
+}
+
+// SSE2 has no gather, so the four lookups are scalar.
+static inline void lookup4(__m128i index, SkPMColor dst[],
+                           const SkPMColor even[], const SkPMColor odd[]) {
+    dst[0] = even[_mm_cvtsi128_si32(index)];
+    dst[1] = odd[_mm_cvtsi128_si32(_mm_shuffle_epi32(index, _MM_SHUFFLE(1, 1, 1, 1)))];
+    dst[2] = even[_mm_cvtsi128_si32(_mm_shuffle_epi32(index, _MM_SHUFFLE(2, 2, 2, 2)))];
+    dst[3] = odd[_mm_cvtsi128_si32(_mm_shuffle_epi32(index, _MM_SHUFFLE(3, 3, 3, 3)))];
+}
+
+// The last 1-3 pixels of a span.
+static inline void lookup_tail(__m128i index, SkPMColor dst[],
+                               const SkPMColor even[], const SkPMColor odd[], int count) {
+    SkASSERT(count > 0 && count < 4);
+    int32_t indices[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(indices), index);
+    for (int i = 0; i < count; i++) {
+        dst[i] = (i & 1 ? odd : even)[indices[i]];
+    }
+}
+
+template <SkShader::TileMode tileMode>
+static void linear_gradient(SkFixed fx, SkFixed dx, SkPMColor dst[],
+                            const SkPMColor even[], const SkPMColor odd[], int count) {
+    // The positions wrap around as the scalar code's do, so step them as unsigned.
+    const uint32_t ufx = fx;
+    const uint32_t udx = dx;
+    __m128i x = _mm_setr_epi32(ufx, ufx + udx, ufx + 2 * udx, ufx + 3 * udx);
+    const __m128i step = _mm_set1_epi32(4 * udx);
+
+    while (count >= 4) {
+        lookup4(_mm_srli_epi32(tile4<tileMode>(x), 8), dst, even, odd);
+        x = _mm_add_epi32(x, step);
+        dst += 4;
+        count -= 4;
+    }
+    if (count > 0) {
+        lookup_tail(_mm_srli_epi32(tile4<tileMode>(x), 8), dst, even, odd, count);
+    }
+}
+
+// The 16.16 distances from the origin of four points, tiled.
+template <SkShader::TileMode tileMode>
+static inline __m128i radial4(__m128 x, __m128 y) {
+    __m128 dist = _mm_mul_ps(_mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y))),
+                             _mm_set1_ps(65536.0f));
+    if (SkShader::kClamp_TileMode == tileMode) {
+        // pinning before converting also keeps far away points from overflowing
+        dist = _mm_min_ps(dist, _mm_set1_ps(65535.0f));
+    }
+    return tile4<tileMode>(_mm_cvttps_epi32(dist));
+}
+
+template <SkShader::TileMode tileMode>
+static void radial_gradient(float fx, float dx, float fy, float dy, SkPMColor dst[],
+                            const SkPMColor even[], const SkPMColor odd[], int count) {
+    // Each point is computed from its index, rather than by stepping, so that rounding
+    // errors do not pile up along the span.
+    const __m128 vfx = _mm_set1_ps(fx);
+    const __m128 vdx = _mm_set1_ps(dx);
+    const __m128 vfy = _mm_set1_ps(fy);
+    const __m128 vdy = _mm_set1_ps(dy);
+    const __m128 four = _mm_set1_ps(4.0f);
+    __m128 i = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+
+    while (count >= 4) {
+        const __m128 x = _mm_add_ps(vfx, _mm_mul_ps(i, vdx));
+        const __m128 y = _mm_add_ps(vfy, _mm_mul_ps(i, vdy));
+        lookup4(_mm_srli_epi32(radial4<tileMode>(x, y), 8), dst, even, odd);
+        i = _mm_add_ps(i, four);
+        dst += 4;
+        count -= 4;
+    }
+    if (count > 0) {
+        const __m128 x = _mm_add_ps(vfx, _mm_mul_ps(i, vdx));
+        const __m128 y = _mm_add_ps(vfy, _mm_mul_ps(i, vdy));
+        lookup_tail(_mm_srli_epi32(radial4<tileMode>(x, y), 8), dst, even, odd, count);
+    }
+}
+
+void SkLinearGradientClamp_SSE2(SkFixed fx, SkFixed dx, SkPMColor dst[],
+                                const SkPMColor even[], const SkPMColor odd[], int count) {
+    linear_gradient<SkShader::kClamp_TileMode>(fx, dx, dst, even, odd, count);
+}
+
+void SkLinearGradientRepeat_SSE2(SkFixed fx, SkFixed dx, SkPMColor dst[],
+                                 const SkPMColor even[], const SkPMColor odd[], int count) {
+    linear_gradient<SkShader::kRepeat_TileMode>(fx, dx, dst, even, odd, count);
+}
+
+void SkLinearGradientMirror_SSE2(SkFixed fx, SkFixed dx, SkPMColor dst[],
+                                 const SkPMColor even[], const SkPMColor odd[], int count) {
+    linear_gradient<SkShader::kMirror_TileMode>(fx, dx, dst, even, odd, count);
+}
+
+void SkRadialGradientClamp_SSE2(float fx, float dx, float fy, float dy, SkPMColor dst[],
+                                const SkPMColor even[], const SkPMColor odd[], int count) {
+    radial_gradient<SkShader::kClamp_TileMode>(fx, dx, fy, dy, dst, even, odd, count);
+}
+
+void SkRadialGradientRepeat_SSE2(float fx, float dx, float fy, float dy, SkPMColor dst[],
+                                 const SkPMColor even[], const SkPMColor odd[], int count) {
+    radial_gradient<SkShader::kRepeat_TileMode>(fx, dx, fy, dy, dst, even, odd, count);
+}
+
+void SkRadialGradientMirror_SSE2(float fx, float dx, float fy, float dy, SkPMColor dst[],
+                                 const SkPMColor even[], const SkPMColor odd[], int count) {
+    radial_gradient<SkShader::kMirror_TileMode>(fx, dx, fy, dy, dst, even, odd, count);
+}
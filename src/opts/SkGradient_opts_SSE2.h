@@ -0,0 +1,27 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkGradient_opts_SSE2_DEFINED
+#define SkGradient_opts_SSE2_DEFINED
+
+#include "SkGradient_opts.h"
+
+void SkLinearGradientClamp_SSE2(SkFixed fx, SkFixed dx, SkPMColor dst[],
+                                const SkPMColor even[], const SkPMColor odd[], int count);
+void SkLinearGradientRepeat_SSE2(SkFixed fx, SkFixed dx, SkPMColor dst[],
+                                 const SkPMColor even[], const SkPMColor odd[], int count);
+void SkLinearGradientMirror_SSE2(SkFixed fx, SkFixed dx, SkPMColor dst[],
+                                 const SkPMColor even[], const SkPMColor odd[], int count);
+
+void SkRadialGradientClamp_SSE2(float fx, float dx, float fy, float dy, SkPMColor dst[],
+                                const SkPMColor even[], const SkPMColor odd[], int count);
+void SkRadialGradientRepeat_SSE2(float fx, float dx, float fy, float dy, SkPMColor dst[],
+                                 const SkPMColor even[], const SkPMColor odd[], int count);
+void SkRadialGradientMirror_SSE2(float fx, float dx, float fy, float dy, SkPMColor dst[],
+                                 const SkPMColor even[], const SkPMColor odd[], int count);
+
+#endif
@@ -0,0 +1,16 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkGradient_opts.h"
+
+SkLinearGradientProc SkPlatformLinearGradientProc(SkShader::TileMode) {
+    return NULL;
+}
+
+SkRadialGradientProc SkPlatformRadialGradientProc(SkShader::TileMode) {
+    return NULL;
+}
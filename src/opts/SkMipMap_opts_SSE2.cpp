@@ -0,0 +1,55 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include <emmintrin.h>
+#include "SkMipMap_opts_SSE2.h"
+
+// Returns the pixel averaging the 2x2 block at p0[0..1] and p1[0..1].
+static inline SkPMColor downsample_pixel(const SkPMColor* p0, const SkPMColor* p1) {
+    uint32_t ag = ((p0[0] >> 8) & 0xFF00FF) + ((p0[1] >> 8) & 0xFF00FF) +
+                  ((p1[0] >> 8) & 0xFF00FF) + ((p1[1] >> 8) & 0xFF00FF);
+    uint32_t rb = (p0[0] & 0xFF00FF) + (p0[1] & 0xFF00FF) +
+                  (p1[0] & 0xFF00FF) + (p1[1] & 0xFF00FF);
+    return ((rb >> 2) & 0xFF00FF) | ((ag << 6) & 0xFF00FF00);
+}
+
+void SkDownsampleRow32_SSE2(SkPMColor dst[], const SkPMColor row0[],
+                            const SkPMColor row1[], int count) {
+    const __m128i zero = _mm_setzero_si128();
+    while (count >= 4) {
+        // Load 8 pixels from each row.
+        __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0));
+        __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + 4));
+        __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1));
+        __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + 4));
+
+        // Expand to 16 bits per component, and add the rows: (s1, s0), (s3, s2) ...
+        __m128i s01 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+        __m128i s23 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+        __m128i s45 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+        __m128i s67 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+
+        // Add the columns: (s2 + s3, s0 + s1), (s6 + s7, s4 + s5)
+        __m128i lo = _mm_add_epi16(_mm_unpacklo_epi64(s01, s23), _mm_unpackhi_epi64(s01, s23));
+        __m128i hi = _mm_add_epi16(_mm_unpacklo_epi64(s45, s67), _mm_unpackhi_epi64(s45, s67));
+
+        // Divide each sum by 4, and pack the 4 pixels back into bytes.
+        __m128i result = _mm_packus_epi16(_mm_srli_epi16(lo, 2), _mm_srli_epi16(hi, 2));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), result);
+
+        dst += 4;
+        row0 += 8;
+        row1 += 8;
+        count -= 4;
+    }
+    while (count > 0) {
+        *dst++ = downsample_pixel(row0, row1);
+        row0 += 2;
+        row1 += 2;
+        count--;
+    }
+}
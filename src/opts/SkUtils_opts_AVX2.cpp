@@ -0,0 +1,38 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include <immintrin.h>
+#include "SkUtils_opts_AVX2.h"
+
+void sk_memset32_AVX2(uint32_t *dst, uint32_t value, int count)
+{
+    SkASSERT(dst != NULL && count >= 0);
+
+    // dst must be 4-byte aligned.
+    SkASSERT((((size_t) dst) & 0x03) == 0);
+
+    if (count >= 32) {
+        while (((size_t)dst) & 0x1F) {
+            *dst++ = value;
+            --count;
+        }
+        __m256i *d = reinterpret_cast<__m256i*>(dst);
+        __m256i value_wide = _mm256_set1_epi32(value);
+        while (count >= 32) {
+            _mm256_store_si256(d++, value_wide);
+            _mm256_store_si256(d++, value_wide);
+            _mm256_store_si256(d++, value_wide);
+            _mm256_store_si256(d++, value_wide);
+            count -= 32;
+        }
+        dst = reinterpret_cast<uint32_t*>(d);
+    }
+    while (count > 0) {
+        *dst++ = value;
+        --count;
+    }
+}
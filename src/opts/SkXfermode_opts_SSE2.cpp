@@ -0,0 +1,468 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkXfermode_opts_SSE2.h"
+#include "SkColorPriv.h"
+
+#include <emmintrin.h>
+
+/*  Each proc here blends 4 pixels at once, and matches its scalar version in
+    core/SkXfermode.cpp bit for bit. The packed helpers mirror the SkColorPriv
+    and SkMath macros of the same names, with each pixel's channel in its own
+    32 bit lane.
+ */
+
+static inline __m128i SkGetPackedA32_SSE2(const __m128i& src) {
+    __m128i a = _mm_slli_epi32(src, (24 - SK_A32_SHIFT));
+    return _mm_srli_epi32(a, 24);
+}
+
+static inline __m128i SkGetPackedR32_SSE2(const __m128i& src) {
+    __m128i r = _mm_slli_epi32(src, (24 - SK_R32_SHIFT));
+    return _mm_srli_epi32(r, 24);
+}
+
+static inline __m128i SkGetPackedG32_SSE2(const __m128i& src) {
+    __m128i g = _mm_slli_epi32(src, (24 - SK_G32_SHIFT));
+    return _mm_srli_epi32(g, 24);
+}
+
+static inline __m128i SkGetPackedB32_SSE2(const __m128i& src) {
+    __m128i b = _mm_slli_epi32(src, (24 - SK_B32_SHIFT));
+    return _mm_srli_epi32(b, 24);
+}
+
+static inline __m128i SkPackARGB32_SSE2(const __m128i& a, const __m128i& r,
+                                        const __m128i& g, const __m128i& b) {
+    __m128i c = _mm_slli_epi32(a, SK_A32_SHIFT);
+    c = _mm_or_si128(c, _mm_slli_epi32(r, SK_R32_SHIFT));
+    c = _mm_or_si128(c, _mm_slli_epi32(g, SK_G32_SHIFT));
+    return _mm_or_si128(c, _mm_slli_epi32(b, SK_B32_SHIFT));
+}
+
+// The low 32 bits of a * b, which are the same for signed and unsigned lanes
+static inline __m128i Multiply32_SSE2(const __m128i& a, const __m128i& b) {
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+static inline __m128i select_SSE2(const __m128i& mask, const __m128i& a, const __m128i& b) {
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+static inline __m128i SkMin32_SSE2(const __m128i& a, const __m128i& b) {
+    return select_SSE2(_mm_cmplt_epi32(a, b), a, b);
+}
+
+static inline __m128i SkMax32_SSE2(const __m128i& a, const __m128i& b) {
+    return select_SSE2(_mm_cmpgt_epi32(a, b), a, b);
+}
+
+static inline __m128i SkDiv255Round_SSE2(const __m128i& a) {
+    __m128i prod = _mm_add_epi32(a, _mm_set1_epi32(128));
+    prod = _mm_add_epi32(prod, _mm_srli_epi32(prod, 8));
+    return _mm_srli_epi32(prod, 8);
+}
+
+static inline __m128i SkAlphaMulAlpha_SSE2(const __m128i& a, const __m128i& b) {
+    return SkDiv255Round_SSE2(Multiply32_SSE2(a, b));
+}
+
+// 255 - a
+static inline __m128i inv_SSE2(const __m128i& a) {
+    return _mm_sub_epi32(_mm_set1_epi32(255), a);
+}
+
+// Multiplies all four channels of each pixel in c by its lane of scale, which is in [0..256]
+static inline __m128i SkAlphaMulQ_SSE2(const __m128i& c, const __m128i& scale) {
+    const __m128i mask = _mm_set1_epi32(0xFF00FF);
+    __m128i rb = _mm_srli_epi32(Multiply32_SSE2(_mm_and_si128(c, mask), scale), 8);
+    __m128i ag = Multiply32_SSE2(_mm_and_si128(_mm_srli_epi32(c, 8), mask), scale);
+    return _mm_or_si128(_mm_and_si128(rb, mask), _mm_andnot_si128(mask, ag));
+}
+
+static inline __m128i clamp_signed_byte_SSE2(const __m128i& n) {
+    return SkMin32_SSE2(SkMax32_SSE2(n, _mm_setzero_si128()), _mm_set1_epi32(255));
+}
+
+static inline __m128i clamp_div255round_SSE2(const __m128i& prod) {
+    // 0 if prod <= 0, and 255 if prod >= 255*255
+    __m128i inRange = _mm_and_si128(_mm_cmpgt_epi32(prod, _mm_setzero_si128()),
+                                    _mm_cmplt_epi32(prod, _mm_set1_epi32(255 * 255)));
+    __m128i clamped = _mm_andnot_si128(_mm_cmplt_epi32(prod, _mm_set1_epi32(255 * 255)),
+                                       _mm_set1_epi32(255));
+    return select_SSE2(inRange, SkDiv255Round_SSE2(prod), clamped);
+}
+
+// sc * (255 - da) + dc * (255 - sa), which most of the separable modes add to their blend
+static inline __m128i src_dst_remainder_SSE2(const __m128i& sc, const __m128i& dc,
+                                             const __m128i& sa, const __m128i& da) {
+    return _mm_add_epi32(Multiply32_SSE2(sc, inv_SSE2(da)), Multiply32_SSE2(dc, inv_SSE2(sa)));
+}
+
+// Integer division of lanes of up to 24 bits, truncating like C. The float quotient is never
+// close enough to a whole number to round onto it.
+static inline __m128i divide_SSE2(const __m128i& n, const __m128i& d) {
+    return _mm_cvttps_epi32(_mm_div_ps(_mm_cvtepi32_ps(n), _mm_cvtepi32_ps(d)));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+//  kDst_Mode,      //!< [Da, Dc]
+static inline __m128i dst_modeproc_SSE2(const __m128i& src, const __m128i& dst) {
+    return dst;
+}
+
+//  kDstOver_Mode,  //!< [Sa + Da - Sa*Da, Dc + (1 - Da)*Sc]
+static inline __m128i dstover_modeproc_SSE2(const __m128i& src, const __m128i& dst) {
+    __m128i ida = _mm_sub_epi32(_mm_set1_epi32(256), SkGetPackedA32_SSE2(dst));
+    return _mm_add_epi32(dst, SkAlphaMulQ_SSE2(src, ida));
+}
+
+//  kSrcIn_Mode,    //!< [Sa * Da, Sc * Da]
+static inline __m128i srcin_modeproc_SSE2(const __m128i& src, const __m128i& dst) {
+    __m128i da = _mm_add_epi32(SkGetPackedA32_SSE2(dst), _mm_set1_epi32(1));
+    return SkAlphaMulQ_SSE2(src, da);
+}
+
+//  kDstIn_Mode,    //!< [Sa * Da, Sa * Dc]
+static inline __m128i dstin_modeproc_SSE2(const __m128i& src, const __m128i& dst) {
+    __m128i sa = _mm_add_epi32(SkGetPackedA32_SSE2(src), _mm_set1_epi32(1));
+    return SkAlphaMulQ_SSE2(dst, sa);
+}
+
+//  kSrcOut_Mode,   //!< [Sa * (1 - Da), Sc * (1 - Da)]
+static inline __m128i srcout_modeproc_SSE2(const __m128i& src, const __m128i& dst) {
+    __m128i ida = _mm_sub_epi32(_mm_set1_epi32(256), SkGetPackedA32_SSE2(dst));
+    return SkAlphaMulQ_SSE2(src, ida);
+}
+
+//  kDstOut_Mode,   //!< [Da * (1 - Sa), Dc * (1 - Sa)]
+static inline __m128i dstout_modeproc_SSE2(const __m128i& src, const __m128i& dst) {
+    __m128i isa = _mm_sub_epi32(_mm_set1_epi32(256), SkGetPackedA32_SSE2(src));
+    return SkAlphaMulQ_SSE2(dst, isa);
+}
+
+//  kSrcATop_Mode,  //!< [Da, Sc * Da + (1 - Sa) * Dc]
+static inline __m128i srcatop_modeproc_SSE2(const __m128i& src, const __m128i& dst) {
+    __m128i sa = SkGetPackedA32_SSE2(src);
+    __m128i da = SkGetPackedA32_SSE2(dst);
+    __m128i isa = inv_SSE2(sa);
+
+    __m128i r = _mm_add_epi32(SkAlphaMulAlpha_SSE2(da, SkGetPackedR32_SSE2(src)),
+                              SkAlphaMulAlpha_SSE2(isa, SkGetPackedR32_SSE2(dst)));
+    __m128i g = _mm_add_epi32(SkAlphaMulAlpha_SSE2(da, SkGetPackedG32_SSE2(src)),
+                              SkAlphaMulAlpha_SSE2(isa, SkGetPackedG32_SSE2(dst)));
+    __m128i b = _mm_add_epi32(SkAlphaMulAlpha_SSE2(da, SkGetPackedB32_SSE2(src)),
+                              SkAlphaMulAlpha_SSE2(isa, SkGetPackedB32_SSE2(dst)));
+    return SkPackARGB32_SSE2(da, r, g, b);
+}
+
+//  kDstATop_Mode,  //!< [Sa, Sa * Dc + Sc * (1 - Da)]
+static inline __m128i dstatop_modeproc_SSE2(const __m128i& src, const __m128i& dst) {
+    __m128i sa = SkGetPackedA32_SSE2(src);
+    __m128i da = SkGetPackedA32_SSE2(dst);
+    __m128i ida = inv_SSE2(da);
+
+    __m128i r = _mm_add_epi32(SkAlphaMulAlpha_SSE2(ida, SkGetPackedR32_SSE2(src)),
+                              SkAlphaMulAlpha_SSE2(sa, SkGetPackedR32_SSE2(dst)));
+    __m128i g = _mm_add_epi32(SkAlphaMulAlpha_SSE2(ida, SkGetPackedG32_SSE2(src)),
+                              SkAlphaMulAlpha_SSE2(sa, SkGetPackedG32_SSE2(dst)));
+    __m128i b = _mm_add_epi32(SkAlphaMulAlpha_SSE2(ida, SkGetPackedB32_SSE2(src)),
+                              SkAlphaMulAlpha_SSE2(sa, SkGetPackedB32_SSE2(dst)));
+    return SkPackARGB32_SSE2(sa, r, g, b);
+}
+
+//  kXor_Mode   [Sa + Da - 2 * Sa * Da, Sc * (1 - Da) + (1 - Sa) * Dc]
+static inline __m128i xor_modeproc_SSE2(const __m128i& src, const __m128i& dst) {
+    __m128i sa = SkGetPackedA32_SSE2(src);
+    __m128i da = SkGetPackedA32_SSE2(dst);
+    __m128i isa = inv_SSE2(sa);
+    __m128i ida = inv_SSE2(da);
+
+    __m128i a = _mm_sub_epi32(_mm_add_epi32(sa, da),
+                              _mm_slli_epi32(SkAlphaMulAlpha_SSE2(sa, da), 1));
+    __m128i r = _mm_add_epi32(SkAlphaMulAlpha_SSE2(ida, SkGetPackedR32_SSE2(src)),
+                              SkAlphaMulAlpha_SSE2(isa, SkGetPackedR32_SSE2(dst)));
+    __m128i g = _mm_add_epi32(SkAlphaMulAlpha_SSE2(ida, SkGetPackedG32_SSE2(src)),
+                              SkAlphaMulAlpha_SSE2(isa, SkGetPackedG32_SSE2(dst)));
+    __m128i b = _mm_add_epi32(SkAlphaMulAlpha_SSE2(ida, SkGetPackedB32_SSE2(src)),
+                              SkAlphaMulAlpha_SSE2(isa, SkGetPackedB32_SSE2(dst)));
+    return SkPackARGB32_SSE2(a, r, g, b);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// kPlus_Mode
+static inline __m128i plus_modeproc_SSE2(const __m128i& src, const __m128i& dst) {
+    return _mm_adds_epu8(src, dst);
+}
+
+// kModulate_Mode
+static inline __m128i modulate_modeproc_SSE2(const __m128i& src, const __m128i& dst) {
+    __m128i a = SkAlphaMulAlpha_SSE2(SkGetPackedA32_SSE2(src), SkGetPackedA32_SSE2(dst));
+    __m128i r = SkAlphaMulAlpha_SSE2(SkGetPackedR32_SSE2(src), SkGetPackedR32_SSE2(dst));
+    __m128i g = SkAlphaMulAlpha_SSE2(SkGetPackedG32_SSE2(src), SkGetPackedG32_SSE2(dst));
+    __m128i b = SkAlphaMulAlpha_SSE2(SkGetPackedB32_SSE2(src), SkGetPackedB32_SSE2(dst));
+    return SkPackARGB32_SSE2(a, r, g, b);
+}
+
+static inline __m128i srcover_byte_SSE2(const __m128i& a, const __m128i& b) {
+    return _mm_sub_epi32(_mm_add_epi32(a, b), SkAlphaMulAlpha_SSE2(a, b));
+}
+
+// kScreen_Mode
+static inline __m128i screen_modeproc_SSE2(const __m128i& src, const __m128i& dst) {
+    __m128i a = srcover_byte_SSE2(SkGetPackedA32_SSE2(src), SkGetPackedA32_SSE2(dst));
+    __m128i r = srcover_byte_SSE2(SkGetPackedR32_SSE2(src), SkGetPackedR32_SSE2(dst));
+    __m128i g = srcover_byte_SSE2(SkGetPackedG32_SSE2(src), SkGetPackedG32_SSE2(dst));
+    __m128i b = srcover_byte_SSE2(SkGetPackedB32_SSE2(src), SkGetPackedB32_SSE2(dst));
+    return SkPackARGB32_SSE2(a, r, g, b);
+}
+
+// The separable blend modes all share the srcover alpha, and blend each color channel with a
+// byte function of (sc, dc, sa, da).
+#define SEPARABLE_MODEPROC_SSE2(name)                                           \
+    static inline __m128i name##_modeproc_SSE2(const __m128i& src,              \
+                                               const __m128i& dst) {            \
+        __m128i sa = SkGetPackedA32_SSE2(src);                                  \
+        __m128i da = SkGetPackedA32_SSE2(dst);                                  \
+        __m128i a = srcover_byte_SSE2(sa, da);                                  \
+        __m128i r = name##_byte_SSE2(SkGetPackedR32_SSE2(src),                  \
+                                     SkGetPackedR32_SSE2(dst), sa, da);         \
+        __m128i g = name##_byte_SSE2(SkGetPackedG32_SSE2(src),                  \
+                                     SkGetPackedG32_SSE2(dst), sa, da);         \
+        __m128i b = name##_byte_SSE2(SkGetPackedB32_SSE2(src),                  \
+                                     SkGetPackedB32_SSE2(dst), sa, da);         \
+        return SkPackARGB32_SSE2(a, r, g, b);                                   \
+    }
+
+// kMultiply_Mode
+static inline __m128i multiply_byte_SSE2(const __m128i& sc, const __m128i& dc,
+                                         const __m128i& sa, const __m128i& da) {
+    __m128i rc = _mm_add_epi32(src_dst_remainder_SSE2(sc, dc, sa, da), Multiply32_SSE2(sc, dc));
+    return clamp_div255round_SSE2(rc);
+}
+SEPARABLE_MODEPROC_SSE2(multiply)
+
+// kOverlay_Mode
+static inline __m128i overlay_byte_SSE2(const __m128i& sc, const __m128i& dc,
+                                        const __m128i& sa, const __m128i& da) {
+    // 2 * dc <= da ? 2 * sc * dc : sa * da - 2 * (da - dc) * (sa - sc)
+    __m128i dark = _mm_slli_epi32(Multiply32_SSE2(sc, dc), 1);
+    __m128i light = _mm_sub_epi32(Multiply32_SSE2(sa, da),
+                                  _mm_slli_epi32(Multiply32_SSE2(_mm_sub_epi32(da, dc),
+                                                                 _mm_sub_epi32(sa, sc)), 1));
+    __m128i rc = select_SSE2(_mm_cmpgt_epi32(_mm_slli_epi32(dc, 1), da), light, dark);
+    return clamp_div255round_SSE2(_mm_add_epi32(rc, src_dst_remainder_SSE2(sc, dc, sa, da)));
+}
+SEPARABLE_MODEPROC_SSE2(overlay)
+
+// kDarken_Mode
+static inline __m128i darken_byte_SSE2(const __m128i& sc, const __m128i& dc,
+                                       const __m128i& sa, const __m128i& da) {
+    // srcover if sc * da < dc * sa, else dstover; both subtract the larger product
+    __m128i sd = Multiply32_SSE2(sc, da);
+    __m128i ds = Multiply32_SSE2(dc, sa);
+    return _mm_sub_epi32(_mm_add_epi32(sc, dc), SkDiv255Round_SSE2(SkMax32_SSE2(sd, ds)));
+}
+SEPARABLE_MODEPROC_SSE2(darken)
+
+// kLighten_Mode
+static inline __m128i lighten_byte_SSE2(const __m128i& sc, const __m128i& dc,
+                                        const __m128i& sa, const __m128i& da) {
+    // srcover if sc * da > dc * sa, else dstover; both subtract the smaller product
+    __m128i sd = Multiply32_SSE2(sc, da);
+    __m128i ds = Multiply32_SSE2(dc, sa);
+    return _mm_sub_epi32(_mm_add_epi32(sc, dc), SkDiv255Round_SSE2(SkMin32_SSE2(sd, ds)));
+}
+SEPARABLE_MODEPROC_SSE2(lighten)
+
+// kColorDodge_Mode
+static inline __m128i colordodge_byte_SSE2(const __m128i& sc, const __m128i& dc,
+                                           const __m128i& sa, const __m128i& da) {
+    __m128i diff = _mm_sub_epi32(sa, sc);
+    __m128i remainder = src_dst_remainder_SSE2(sc, dc, sa, da);
+
+    // 0 == diff
+    __m128i full = _mm_add_epi32(Multiply32_SSE2(sa, da), remainder);
+    // otherwise; the lanes where diff is 0 divide by zero, but are not used
+    __m128i quot = divide_SSE2(Multiply32_SSE2(dc, sa), diff);
+    __m128i part = _mm_add_epi32(Multiply32_SSE2(sa, SkMin32_SSE2(da, quot)), remainder);
+
+    __m128i rc = select_SSE2(_mm_cmpeq_epi32(diff, _mm_setzero_si128()), full, part);
+    // 0 == dc returns without clamping
+    __m128i zeroDst = SkAlphaMulAlpha_SSE2(sc, inv_SSE2(da));
+    return select_SSE2(_mm_cmpeq_epi32(dc, _mm_setzero_si128()), zeroDst,
+                       clamp_div255round_SSE2(rc));
+}
+SEPARABLE_MODEPROC_SSE2(colordodge)
+
+// kColorBurn_Mode
+static inline __m128i colorburn_byte_SSE2(const __m128i& sc, const __m128i& dc,
+                                          const __m128i& sa, const __m128i& da) {
+    __m128i remainder = src_dst_remainder_SSE2(sc, dc, sa, da);
+
+    // dc == da
+    __m128i full = _mm_add_epi32(Multiply32_SSE2(sa, da), remainder);
+    // otherwise; the lanes where sc is 0 divide by zero, but are not used
+    __m128i tmp = divide_SSE2(Multiply32_SSE2(_mm_sub_epi32(da, dc), sa), sc);
+    __m128i part = _mm_add_epi32(Multiply32_SSE2(sa, _mm_sub_epi32(da, SkMin32_SSE2(da, tmp))),
+                                 remainder);
+
+    __m128i dstIsAlpha = _mm_cmpeq_epi32(dc, da);
+    __m128i rc = clamp_div255round_SSE2(select_SSE2(dstIsAlpha, full, part));
+    // 0 == sc (and dc != da) returns without clamping
+    __m128i zeroSrc = SkAlphaMulAlpha_SSE2(dc, inv_SSE2(sa));
+    __m128i useZeroSrc = _mm_andnot_si128(dstIsAlpha,
+                                          _mm_cmpeq_epi32(sc, _mm_setzero_si128()));
+    return select_SSE2(useZeroSrc, zeroSrc, rc);
+}
+SEPARABLE_MODEPROC_SSE2(colorburn)
+
+// kHardLight_Mode
+static inline __m128i hardlight_byte_SSE2(const __m128i& sc, const __m128i& dc,
+                                          const __m128i& sa, const __m128i& da) {
+    // 2 * sc <= sa ? 2 * sc * dc : sa * da - 2 * (da - dc) * (sa - sc)
+    __m128i dark = _mm_slli_epi32(Multiply32_SSE2(sc, dc), 1);
+    __m128i light = _mm_sub_epi32(Multiply32_SSE2(sa, da),
+                                  _mm_slli_epi32(Multiply32_SSE2(_mm_sub_epi32(da, dc),
+                                                                 _mm_sub_epi32(sa, sc)), 1));
+    __m128i rc = select_SSE2(_mm_cmpgt_epi32(_mm_slli_epi32(sc, 1), sa), light, dark);
+    return clamp_div255round_SSE2(_mm_add_epi32(rc, src_dst_remainder_SSE2(sc, dc, sa, da)));
+}
+SEPARABLE_MODEPROC_SSE2(hardlight)
+
+// kDifference_Mode
+static inline __m128i difference_byte_SSE2(const __m128i& sc, const __m128i& dc,
+                                           const __m128i& sa, const __m128i& da) {
+    __m128i tmp = SkMin32_SSE2(Multiply32_SSE2(sc, da), Multiply32_SSE2(dc, sa));
+    __m128i n = _mm_sub_epi32(_mm_add_epi32(sc, dc), _mm_slli_epi32(SkDiv255Round_SSE2(tmp), 1));
+    return clamp_signed_byte_SSE2(n);
+}
+SEPARABLE_MODEPROC_SSE2(difference)
+
+// kExclusion_Mode
+static inline __m128i exclusion_byte_SSE2(const __m128i& sc, const __m128i& dc,
+                                          const __m128i& sa, const __m128i& da) {
+    __m128i r = _mm_add_epi32(Multiply32_SSE2(sc, da), Multiply32_SSE2(dc, sa));
+    r = _mm_sub_epi32(r, _mm_slli_epi32(Multiply32_SSE2(sc, dc), 1));
+    return clamp_div255round_SSE2(_mm_add_epi32(r, src_dst_remainder_SSE2(sc, dc, sa, da)));
+}
+SEPARABLE_MODEPROC_SSE2(exclusion)
+
+///////////////////////////////////////////////////////////////////////////////
+
+// SkFourByteInterp(c, dst, aa) for each pixel, leaving dst where aa is 0 like xfer32 does
+static inline __m128i aa_interp_SSE2(const __m128i& c, const __m128i& dst, const SkAlpha aa[]) {
+    __m128i a = _mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(aa));
+    a = _mm_unpacklo_epi8(a, _mm_setzero_si128());
+    a = _mm_unpacklo_epi16(a, _mm_setzero_si128());
+    __m128i scale = _mm_add_epi32(a, _mm_set1_epi32(1));
+
+    const __m128i mask = _mm_set1_epi32(0xFF);
+    __m128i result = _mm_setzero_si128();
+    for (int shift = 0; shift < 32; shift += 8) {
+        __m128i cc = _mm_and_si128(_mm_srli_epi32(c, shift), mask);
+        __m128i dc = _mm_and_si128(_mm_srli_epi32(dst, shift), mask);
+        // dc + ((cc - dc) * scale >> 8)
+        __m128i blend = _mm_srai_epi32(Multiply32_SSE2(_mm_sub_epi32(cc, dc), scale), 8);
+        blend = _mm_add_epi32(dc, blend);
+        result = _mm_or_si128(result, _mm_slli_epi32(blend, shift));
+    }
+    return select_SSE2(_mm_cmpeq_epi32(a, _mm_setzero_si128()), dst, result);
+}
+
+// Defines name##_span_SSE2, an SkXfermodeSpanProc that calls name##_modeproc_SSE2 inline
+#define SPAN_PROC_SSE2(name)                                                    \
+    static void name##_span_SSE2(SkPMColor dst[], const SkPMColor src[],        \
+                                 int count, const SkAlpha aa[]) {               \
+        SkASSERT(0 == (count & 3));                                             \
+        for (int i = 0; i < count; i += 4) {                                    \
+            uint32_t coverage = 0xFFFFFFFF;                                     \
+            if (NULL != aa) {                                                   \
+                coverage = *reinterpret_cast<const uint32_t*>(aa + i);          \
+                if (0 == coverage) {                                            \
+                    continue;                                                   \
+                }                                                               \
+            }                                                                   \
+            __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)); \
+            __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i)); \
+            __m128i c = name##_modeproc_SSE2(s, d);                             \
+            if (0xFFFFFFFF != coverage) {                                       \
+                c = aa_interp_SSE2(c, d, aa + i);                               \
+            }                                                                   \
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), c);           \
+        }                                                                       \
+    }
+
+SPAN_PROC_SSE2(dst)
+SPAN_PROC_SSE2(dstover)
+SPAN_PROC_SSE2(srcin)
+SPAN_PROC_SSE2(dstin)
+SPAN_PROC_SSE2(srcout)
+SPAN_PROC_SSE2(dstout)
+SPAN_PROC_SSE2(srcatop)
+SPAN_PROC_SSE2(dstatop)
+SPAN_PROC_SSE2(xor)
+SPAN_PROC_SSE2(plus)
+SPAN_PROC_SSE2(modulate)
+SPAN_PROC_SSE2(screen)
+SPAN_PROC_SSE2(overlay)
+SPAN_PROC_SSE2(darken)
+SPAN_PROC_SSE2(lighten)
+SPAN_PROC_SSE2(colordodge)
+SPAN_PROC_SSE2(colorburn)
+SPAN_PROC_SSE2(hardlight)
+SPAN_PROC_SSE2(difference)
+SPAN_PROC_SSE2(exclusion)
+SPAN_PROC_SSE2(multiply)
+
+// Clear and Src have their own xfermodes, and SrcOver has none. SoftLight (which needs a square
+// root) and the non-separable modes still go a pixel at a time.
+static const SkXfermodeSpanProc gSpanProcs_SSE2[] = {
+    NULL,                                       // kClear_Mode
+    NULL,                                       // kSrc_Mode
+    dst_span_SSE2,                              // kDst_Mode
+    NULL,                                       // kSrcOver_Mode
+    dstover_span_SSE2,                          // kDstOver_Mode
+    srcin_span_SSE2,                            // kSrcIn_Mode
+    dstin_span_SSE2,                            // kDstIn_Mode
+    srcout_span_SSE2,                           // kSrcOut_Mode
+    dstout_span_SSE2,                           // kDstOut_Mode
+    srcatop_span_SSE2,                          // kSrcATop_Mode
+    dstatop_span_SSE2,                          // kDstATop_Mode
+    xor_span_SSE2,                              // kXor_Mode
+
+    plus_span_SSE2,                             // kPlus_Mode
+    modulate_span_SSE2,                         // kModulate_Mode
+    screen_span_SSE2,                           // kScreen_Mode
+    overlay_span_SSE2,                          // kOverlay_Mode
+    darken_span_SSE2,                           // kDarken_Mode
+    lighten_span_SSE2,                          // kLighten_Mode
+    colordodge_span_SSE2,                       // kColorDodge_Mode
+    colorburn_span_SSE2,                        // kColorBurn_Mode
+    hardlight_span_SSE2,                        // kHardLight_Mode
+    NULL,                                       // kSoftLight_Mode
+    difference_span_SSE2,                       // kDifference_Mode
+    exclusion_span_SSE2,                        // kExclusion_Mode
+    multiply_span_SSE2,                         // kMultiply_Mode
+
+    NULL,                                       // kHue_Mode
+    NULL,                                       // kSaturation_Mode
+    NULL,                                       // kColor_Mode
+    NULL,                                       // kLuminosity_Mode
+};
+
+SkXfermodeSpanProc SkGetXfermodeSpanProc_SSE2(SkXfermode::Mode mode) {
+    SK_COMPILE_ASSERT(SK_ARRAY_COUNT(gSpanProcs_SSE2) == SkXfermode::kLastMode + 1,
+                      span_proc_count_mismatch);
+    SkASSERT((unsigned)mode <= (unsigned)SkXfermode::kLastMode);
+    return gSpanProcs_SSE2[mode];
+}
@@ -0,0 +1,12 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkXfermode_opts.h"
+
+SkXfermodeSpanProc SkPlatformXfermodeSpanProc(SkXfermode::Mode mode) {
+    return NULL;
+}
@@ -5,32 +5,45 @@
  * found in the LICENSE file.
  */
 
+#include "SkBitmapProcState_opts_AVX2.h"
 #include "SkBitmapProcState_opts_SSE2.h"
 #include "SkBitmapProcState_opts_SSSE3.h"
 #include "SkBlitMask.h"
 #include "SkBlitRow.h"
 #include "SkBlitRect_opts_SSE2.h"
+#include "SkBlitRow_opts_AVX2.h"
 #include "SkBlitRow_opts_SSE2.h"
+#include "SkBlurMask_opts_SSE2.h"
+#include "SkConvolver_opts_SSE2.h"
+#include "SkGradient_opts_SSE2.h"
+#include "SkMipMap_opts_SSE2.h"
+#include "SkUtils_opts_AVX2.h"
 #include "SkUtils_opts_SSE2.h"
 #include "SkUtils.h"
+#include "SkXfermode_opts_SSE2.h"
 
 #if defined(_MSC_VER) && defined(_WIN64)
 #include <intrin.h>
 #endif
+#if defined(_MSC_VER)
+#include <immintrin.h>
+#endif
 
 /* This file must *not* be compiled with -msse or -msse2, otherwise
    gcc may generate sse2 even for scalar ops (and thus give an invalid
    instruction on Pentium3 on the code below).  Only files named *_SSE2.cpp
-   in this directory should be compiled with -msse2. */
+   in this directory should be compiled with -msse2. Likewise only the
+   *_SSSE3.cpp and *_AVX2.cpp files get -mssse3 and -mavx2. */
 
 
 #ifdef _MSC_VER
 static inline void getcpuid(int info_type, int info[4]) {
 #if defined(_WIN64)
-    __cpuid(info, info_type);
+    __cpuidex(info, info_type, 0);
 #else
     __asm {
         mov    eax, [info_type]
+        xor    ecx, ecx
         cpuid
         mov    edi, [info]
         mov    [edi], eax
@@ -46,7 +59,7 @@ static inline void getcpuid(int info_type, int info[4]) {
     asm volatile (
         "cpuid \n\t"
         : "=a"(info[0]), "=b"(info[1]), "=c"(info[2]), "=d"(info[3])
-        : "a"(info_type)
+        : "a"(info_type), "c"(0)
     );
 }
 #else
@@ -58,7 +71,7 @@ static inline void getcpuid(int info_type, int info[4]) {
         "movl %%ebx, %1   \n\t"
         "popl %%ebx       \n\t"
         : "=a"(info[0]), "=r"(info[1]), "=c"(info[2]), "=d"(info[3])
-        : "a"(info_type)
+        : "a"(info_type), "c"(0)
     );
 }
 #endif
@@ -92,6 +105,37 @@ static inline bool hasSSSE3() {
 }
 #endif
 
+#if !defined(SK_BUILD_FOR_ANDROID)
+// Returns the low word of XCR0, which says which register state the OS saves.
+static inline uint32_t getxcr0() {
+#ifdef _MSC_VER
+    return (uint32_t)_xgetbv(0);
+#else
+    uint32_t eax, edx;
+    // xgetbv, spelled out for assemblers that do not know it
+    asm volatile (".byte 0x0f, 0x01, 0xd0" : "=a"(eax), "=d"(edx) : "c"(0));
+    return eax;
+#endif
+}
+
+static inline bool hasAVX2() {
+    int cpu_info[4] = { 0 };
+    getcpuid(0, cpu_info);
+    if (cpu_info[0] < 7) {
+        return false;
+    }
+    getcpuid(1, cpu_info);
+    // The CPU must support AVX, and the OS must save the ymm registers
+    // (OSXSAVE, then the SSE and AVX bits of XCR0).
+    const int kOSXSAVE_AVX = (1 << 27) | (1 << 28);
+    if ((cpu_info[2] & kOSXSAVE_AVX) != kOSXSAVE_AVX || (getxcr0() & 0x6) != 0x6) {
+        return false;
+    }
+    getcpuid(7, cpu_info);
+    return (cpu_info[1] & (1 << 5)) != 0;
+}
+#endif
+
 static bool cachedHasSSE2() {
     static bool gHasSSE2 = hasSSE2();
     return gHasSSE2;
@@ -102,12 +146,24 @@ static bool cachedHasSSSE3() {
     return gHasSSSE3;
 }
 
+#if !defined(SK_BUILD_FOR_ANDROID)
+// The AVX2 procs are not built for Android x86, like the SSSE3 ones
+static bool cachedHasAVX2() {
+    static bool gHasAVX2 = hasAVX2();
+    return gHasAVX2;
+}
+#endif
+
 void SkBitmapProcState::platformProcs() {
     if (cachedHasSSSE3()) {
 #if !defined(SK_BUILD_FOR_ANDROID)
         // Disable SSSE3 optimization for Android x86
         if (fSampleProc32 == S32_opaque_D32_filter_DX) {
-            fSampleProc32 = S32_opaque_D32_filter_DX_SSSE3;
+            if (cachedHasAVX2()) {
+                fSampleProc32 = S32_opaque_D32_filter_DX_AVX2;
+            } else {
+                fSampleProc32 = S32_opaque_D32_filter_DX_SSSE3;
+            }
         } else if (fSampleProc32 == S32_alpha_D32_filter_DX) {
             fSampleProc32 = S32_alpha_D32_filter_DX_SSSE3;
         }
@@ -132,7 +188,14 @@ void SkBitmapProcState::platformProcs() {
 
     if (cachedHasSSSE3() || cachedHasSSE2()) {
         if (fMatrixProc == ClampX_ClampY_filter_scale) {
-            fMatrixProc = ClampX_ClampY_filter_scale_SSE2;
+#if !defined(SK_BUILD_FOR_ANDROID)
+            if (cachedHasAVX2()) {
+                fMatrixProc = ClampX_ClampY_filter_scale_AVX2;
+            } else
+#endif
+            {
+                fMatrixProc = ClampX_ClampY_filter_scale_SSE2;
+            }
         } else if (fMatrixProc == ClampX_ClampY_nofilter_scale) {
             fMatrixProc = ClampX_ClampY_nofilter_scale_SSE2;
         }
@@ -161,6 +224,11 @@ SkBlitRow::Proc SkBlitRow::PlatformProcs565(unsigned flags) {
 }
 
 SkBlitRow::ColorProc SkBlitRow::PlatformColorProc() {
+#if !defined(SK_BUILD_FOR_ANDROID)
+    if (cachedHasAVX2()) {
+        return Color32_AVX2;
+    }
+#endif
     if (cachedHasSSE2()) {
         return Color32_SSE2;
     } else {
@@ -169,6 +237,12 @@ SkBlitRow::ColorProc SkBlitRow::PlatformColorProc() {
 }
 
 SkBlitRow::Proc32 SkBlitRow::PlatformProcs32(unsigned flags) {
+#if !defined(SK_BUILD_FOR_ANDROID) && !defined(SK_USE_ACCURATE_BLENDING)
+    // The AVX2 version only has the default blend
+    if (cachedHasAVX2() && SkBlitRow::kSrcPixelAlpha_Flag32 == flags) {
+        return S32A_Opaque_BlitRow32_AVX2;
+    }
+#endif
     if (cachedHasSSE2()) {
         return platform_32_procs[flags];
     } else {
@@ -191,6 +265,12 @@ SkBlitMask::ColorProc SkBlitMask::PlatformColorProcs(SkBitmap::Config dstConfig,
                 // The SSE2 version is not (yet) faster for black, so we check
                 // for that.
                 if (SK_ColorBLACK != color) {
+#if !defined(SK_BUILD_FOR_ANDROID)
+                    if (cachedHasAVX2()) {
+                        proc = SkARGB32_A8_BlitMask_AVX2;
+                        break;
+                    }
+#endif
                     proc = SkARGB32_A8_BlitMask_SSE2;
                 }
                 break;
@@ -228,6 +308,11 @@ SkMemset16Proc SkMemset16GetPlatformProc() {
 }
 
 SkMemset32Proc SkMemset32GetPlatformProc() {
+#if !defined(SK_BUILD_FOR_ANDROID)
+    if (cachedHasAVX2()) {
+        return sk_memset32_AVX2;
+    }
+#endif
     if (cachedHasSSE2()) {
         return sk_memset32_SSE2;
     } else {
@@ -244,3 +329,84 @@ SkBlitRow::ColorRectProc PlatformColorRectProcFactory() {
         return NULL;
     }
 }
+
+SkXfermodeSpanProc SkPlatformXfermodeSpanProc(SkXfermode::Mode mode) {
+    if (cachedHasSSE2()) {
+        return SkGetXfermodeSpanProc_SSE2(mode);
+    } else {
+        return NULL;
+    }
+}
+
+SkDownsampleRow32Proc SkPlatformDownsampleRow32Proc() {
+    if (cachedHasSSE2()) {
+        return SkDownsampleRow32_SSE2;
+    } else {
+        return NULL;
+    }
+}
+
+SkConvolveHorizontallyProc SkPlatformConvolveHorizontallyProc() {
+    if (cachedHasSSE2()) {
+        return SkConvolveHorizontally_SSE2;
+    } else {
+        return NULL;
+    }
+}
+
+SkConvolveVerticallyProc SkPlatformConvolveVerticallyProc() {
+#if SK_A32_SHIFT == 24
+    if (cachedHasSSE2()) {
+        return SkConvolveVertically_SSE2;
+    }
+#endif
+    return NULL;
+}
+
+SkBoxBlurProc SkPlatformBoxBlurProc() {
+    if (cachedHasSSE2()) {
+        return SkBoxBlur_SSE2;
+    } else {
+        return NULL;
+    }
+}
+
+SkBoxBlurInterpProc SkPlatformBoxBlurInterpProc() {
+    if (cachedHasSSE2()) {
+        return SkBoxBlurInterp_SSE2;
+    } else {
+        return NULL;
+    }
+}
+
+SkLinearGradientProc SkPlatformLinearGradientProc(SkShader::TileMode mode) {
+    if (!cachedHasSSE2()) {
+        return NULL;
+    }
+    switch (mode) {
+        case SkShader::kClamp_TileMode:
+            return SkLinearGradientClamp_SSE2;
+        case SkShader::kRepeat_TileMode:
+            return SkLinearGradientRepeat_SSE2;
+        case SkShader::kMirror_TileMode:
+            return SkLinearGradientMirror_SSE2;
+        default:
+            return NULL;
+    }
+}
+
+SkRadialGradientProc SkPlatformRadialGradientProc(SkShader::TileMode mode) {
+    if (!cachedHasSSE2()) {
+        return NULL;
+    }
+    switch (mode) {
+        case SkShader::kClamp_TileMode:
+            return SkRadialGradientClamp_SSE2;
+        case SkShader::kRepeat_TileMode:
+            return SkRadialGradientRepeat_SSE2;
+        case SkShader::kMirror_TileMode:
+            return SkRadialGradientMirror_SSE2;
+        default:
+            return NULL;
+    }
+}
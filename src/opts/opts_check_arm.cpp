@@ -14,7 +14,12 @@
  */
 
 #include "SkBlitRow.h"
+#include "SkBlurMask_opts.h"
+#include "SkConvolver.h"
+#include "SkGradient_opts.h"
+#include "SkMipMap_opts.h"
 #include "SkUtils.h"
+#include "SkXfermode_opts.h"
 
 #include "SkUtilsArm.h"
 
@@ -65,3 +70,35 @@ SkMemset32Proc SkMemset32GetPlatformProc() {
 SkBlitRow::ColorRectProc PlatformColorRectProcFactory() {
     return NULL;
 }
+
+SkXfermodeSpanProc SkPlatformXfermodeSpanProc(SkXfermode::Mode mode) {
+    return NULL;
+}
+
+SkDownsampleRow32Proc SkPlatformDownsampleRow32Proc() {
+    return NULL;
+}
+
+SkConvolveHorizontallyProc SkPlatformConvolveHorizontallyProc() {
+    return NULL;
+}
+
+SkConvolveVerticallyProc SkPlatformConvolveVerticallyProc() {
+    return NULL;
+}
+
+SkBoxBlurProc SkPlatformBoxBlurProc() {
+    return NULL;
+}
+
+SkBoxBlurInterpProc SkPlatformBoxBlurInterpProc() {
+    return NULL;
+}
+
+SkLinearGradientProc SkPlatformLinearGradientProc(SkShader::TileMode) {
+    return NULL;
+}
+
+SkRadialGradientProc SkPlatformRadialGradientProc(SkShader::TileMode) {
+    return NULL;
+}
@@ -25,6 +25,7 @@
 #include "SkPDFTypes.h"
 #include "SkPDFUtils.h"
 #include "SkRect.h"
+#include "SkRRect.h"
 #include "SkString.h"
 #include "SkTextFormatParams.h"
 #include "SkTemplates.h"
@@ -810,6 +811,13 @@ void SkPDFDevice::drawRect(const SkDraw& d, const SkRect& r,
                           &content.entry()->fContent);
 }
 
+void SkPDFDevice::drawRRect(const SkDraw& d, const SkRRect& rrect,
+                            const SkPaint& paint) {
+    SkPath path;
+    path.addRRect(rrect);
+    this->drawPath(d, path, paint, NULL, true);
+}
+
 void SkPDFDevice::drawPath(const SkDraw& d, const SkPath& origPath,
                            const SkPaint& paint, const SkMatrix* prePathMatrix,
                            bool pathIsMutable) {
@@ -0,0 +1,280 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkBandedDevice.h"
+#include "SkDraw.h"
+#include "SkOrderedReadBuffer.h"
+#include "SkOrderedWriteBuffer.h"
+#include "SkRasterClip.h"
+#include "SkRunnable.h"
+#include "SkShader.h"
+#include "SkThreadPool.h"
+
+// Shaders keep the state of the draw they are used for (see setContext()), so
+// each band but the first draws with its own copy, unflattened from here.
+class SkBandedDevice::Band : public SkRunnable {
+public:
+    Band() : fDevice(NULL), fDraw(NULL), fArgs(NULL), fPaint(NULL), fPathMask(NULL),
+             fShaderData(NULL), fShaderSize(0) {}
+
+    void init(SkBandedDevice* device, const SkDraw* draw, const Args* args,
+              const SkPaint* paint, const SkIRect& band, const SkMask* pathMask,
+              const void* shaderData, size_t shaderSize) {
+        fDevice = device;
+        fDraw = draw;
+        fArgs = args;
+        fPaint = paint;
+        fBand = band;
+        fPathMask = pathMask;
+        fShaderData = shaderData;
+        fShaderSize = shaderSize;
+    }
+
+    virtual void run() SK_OVERRIDE {
+        SkDraw draw(*fDraw);
+        draw.fBand = &fBand;
+        draw.fPathMask = fPathMask;
+
+        SkPaint paint(*fPaint);
+        if (fShaderData) {
+            SkOrderedReadBuffer buffer(fShaderData, fShaderSize);
+            SkSafeUnref(paint.setShader(buffer.readFlattenableT<SkShader>()));
+        }
+
+        // Locking an SkBitmap's pixels writes to it, so each band locks its own copy.
+        Args args(*fArgs);
+        SkBitmap bitmap;
+        if (args.fBitmap) {
+            bitmap = *args.fBitmap;
+            args.fBitmap = &bitmap;
+        }
+
+        fDevice->drawBand(draw, args, paint);
+    }
+
+private:
+    SkBandedDevice* fDevice;
+    const SkDraw*   fDraw;
+    const Args*     fArgs;
+    const SkPaint*  fPaint;
+    SkIRect         fBand;
+    const SkMask*   fPathMask;
+    const void*     fShaderData;
+    size_t          fShaderSize;
+};
+
+SkBandedDevice::SkBandedDevice(const SkBitmap& bitmap, SkThreadPool* pool, int minBandArea)
+    : INHERITED(bitmap)
+    , fPool(pool)
+    , fMinBandArea(SkMax32(minBandArea, 1))
+    , fLastBandCount(1) {
+}
+
+// Returns the device bounds of rect, drawn with paint through matrix, or the clip bounds
+// if the paint cannot tell. Only used to decide how to split the draw, so it need not be
+// tight.
+static SkIRect device_bounds(const SkDraw& draw, const SkMatrix& matrix, const SkRect& rect,
+                             const SkPaint& paint) {
+    if (!paint.canComputeFastBounds()) {
+        return draw.fRC->getBounds();
+    }
+    SkRect storage;
+    SkRect devRect = paint.computeFastBounds(rect, &storage);
+    matrix.mapRect(&devRect);
+    SkIRect ir;
+    devRect.roundOut(&ir);
+    ir.outset(1, 1);    // for antialiasing
+    return ir;
+}
+
+bool SkBandedDevice::drawInBands(const SkDraw& draw, const SkIRect& devBounds,
+                                 const SkPaint& paint, const Args& args) {
+    if (draw.fBand) {
+        // already drawing one band of a larger draw
+        return false;
+    }
+    fLastBandCount = 1;
+
+    if (NULL == fPool || draw.fBounder || draw.fRC->isEmpty() ||
+        paint.getMaskFilter() || paint.getRasterizer() || paint.getPathEffect()) {
+        return false;
+    }
+
+    const SkIRect& clip = draw.fRC->getBounds();
+    SkIRect bounds = devBounds;
+    if (!bounds.intersect(clip)) {
+        return false;
+    }
+
+    int64_t bandCount = (int64_t)bounds.width() * bounds.height() / fMinBandArea;
+    bandCount = SkTMin<int64_t>(bandCount, fPool->count() + 1);
+    bandCount = SkTMin<int64_t>(bandCount, bounds.height());
+    if (bandCount < 2) {
+        return false;
+    }
+    const int count = (int)bandCount;
+    fLastBandCount = count;
+
+    // The lazily computed parts of the shared geometry are written on first use, so compute
+    // them here rather than racing to do so in the bands.
+    draw.fMatrix->getType();
+    if (args.fMatrix) {
+        args.fMatrix->getType();
+    }
+    if (args.fPath) {
+        args.fPath->getBounds();
+        args.fPath->getConvexity();
+        args.fPath->getGenerationID();
+    }
+
+    // A path that is drawn from the mask cache is looked up (or drawn into the cache) once,
+    // here, and the bands only blit the mask.
+    SkRefCnt* maskOwner = NULL;
+    const SkMask* pathMask = NULL;
+    if (kPath_Op == args.fOp && NULL == args.fMatrix) {
+        pathMask = draw.findOrCreatePathMask(*args.fPath, paint, &maskOwner);
+    }
+    SkAutoTUnref<SkRefCnt> autoMaskOwner(maskOwner);
+
+    SkAutoMalloc shaderStorage;
+    size_t shaderSize = 0;
+    if (paint.getShader()) {
+        SkOrderedWriteBuffer buffer(1024);
+        buffer.writeFlattenable(paint.getShader());
+        shaderSize = buffer.size();
+        buffer.writeToMemory(shaderStorage.reset(shaderSize));
+    }
+
+    // The bands split up the rows of the draw, but between them cover all of the clip, so
+    // nothing is lost if devBounds is too tight.
+    SkAutoTArray<Band> bands(count);
+    SkAutoTMalloc<SkRunnable*> runnables(count);
+    for (int i = 0; i < count; ++i) {
+        SkIRect band = clip;
+        if (i > 0) {
+            band.fTop = bounds.fTop + (int)((int64_t)bounds.height() * i / count);
+        }
+        if (i < count - 1) {
+            band.fBottom = bounds.fTop + (int)((int64_t)bounds.height() * (i + 1) / count);
+        }
+        bands[i].init(this, &draw, &args, &paint, band, pathMask,
+                      i > 0 ? shaderStorage.get() : NULL, shaderSize);
+        runnables[i] = &bands[i];
+    }
+
+    SkThreadPool::Group group(fPool);
+    group.add(runnables.get(), count);
+    group.wait();
+    return true;
+}
+
+void SkBandedDevice::drawBand(const SkDraw& draw, const Args& args, const SkPaint& paint) {
+    // These land back in our overrides, which see draw.fBand and call INHERITED.
+    switch (args.fOp) {
+        case kPaint_Op:
+            this->drawPaint(draw, paint);
+            break;
+        case kRect_Op:
+            this->drawRect(draw, *args.fRect, paint);
+            break;
+        case kPath_Op:
+            this->drawPath(draw, *args.fPath, paint, args.fMatrix, false);
+            break;
+        case kBitmap_Op:
+            this->drawBitmap(draw, *args.fBitmap, args.fSrcIRect, *args.fMatrix, paint);
+            break;
+        case kSprite_Op:
+            this->drawSprite(draw, *args.fBitmap, args.fX, args.fY, paint);
+            break;
+        case kBitmapRect_Op:
+            this->drawBitmapRect(draw, *args.fBitmap, args.fSrcRect, *args.fRect, paint);
+            break;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void SkBandedDevice::drawPaint(const SkDraw& draw, const SkPaint& paint) {
+    Args args(kPaint_Op);
+    if (!this->drawInBands(draw, draw.fRC->getBounds(), paint, args)) {
+        INHERITED::drawPaint(draw, paint);
+    }
+}
+
+void SkBandedDevice::drawRect(const SkDraw& draw, const SkRect& r, const SkPaint& paint) {
+    Args args(kRect_Op);
+    args.fRect = &r;
+    if (!this->drawInBands(draw, device_bounds(draw, *draw.fMatrix, r, paint), paint, args)) {
+        INHERITED::drawRect(draw, r, paint);
+    }
+}
+
+void SkBandedDevice::drawPath(const SkDraw& draw, const SkPath& path, const SkPaint& paint,
+                              const SkMatrix* prePathMatrix, bool pathIsMutable) {
+    SkIRect devBounds;
+    if (path.isInverseFillType()) {
+        devBounds = draw.fRC->getBounds();
+    } else {
+        SkMatrix matrix = *draw.fMatrix;
+        if (prePathMatrix) {
+            matrix.preConcat(*prePathMatrix);
+        }
+        devBounds = device_bounds(draw, matrix, path.getBounds(), paint);
+    }
+
+    Args args(kPath_Op);
+    args.fPath = &path;
+    args.fMatrix = prePathMatrix;
+    if (!this->drawInBands(draw, devBounds, paint, args)) {
+        INHERITED::drawPath(draw, path, paint, prePathMatrix, pathIsMutable);
+    }
+}
+
+void SkBandedDevice::drawBitmap(const SkDraw& draw, const SkBitmap& bitmap,
+                                const SkIRect* srcRectOrNull, const SkMatrix& matrix,
+                                const SkPaint& paint) {
+    SkRect r;
+    if (srcRectOrNull) {
+        r.iset(0, 0, srcRectOrNull->width(), srcRectOrNull->height());
+    } else {
+        r.iset(0, 0, bitmap.width(), bitmap.height());
+    }
+    SkMatrix total;
+    total.setConcat(*draw.fMatrix, matrix);
+
+    Args args(kBitmap_Op);
+    args.fBitmap = &bitmap;
+    args.fSrcIRect = srcRectOrNull;
+    args.fMatrix = &matrix;
+    if (!this->drawInBands(draw, device_bounds(draw, total, r, paint), paint, args)) {
+        INHERITED::drawBitmap(draw, bitmap, srcRectOrNull, matrix, paint);
+    }
+}
+
+void SkBandedDevice::drawSprite(const SkDraw& draw, const SkBitmap& bitmap,
+                                int x, int y, const SkPaint& paint) {
+    Args args(kSprite_Op);
+    args.fBitmap = &bitmap;
+    args.fX = x;
+    args.fY = y;
+    SkIRect devBounds = SkIRect::MakeXYWH(x, y, bitmap.width(), bitmap.height());
+    if (!this->drawInBands(draw, devBounds, paint, args)) {
+        INHERITED::drawSprite(draw, bitmap, x, y, paint);
+    }
+}
+
+void SkBandedDevice::drawBitmapRect(const SkDraw& draw, const SkBitmap& bitmap,
+                                    const SkRect* srcOrNull, const SkRect& dst,
+                                    const SkPaint& paint) {
+    Args args(kBitmapRect_Op);
+    args.fBitmap = &bitmap;
+    args.fSrcRect = srcOrNull;
+    args.fRect = &dst;
+    if (!this->drawInBands(draw, device_bounds(draw, *draw.fMatrix, dst, paint), paint, args)) {
+        INHERITED::drawBitmapRect(draw, bitmap, srcOrNull, dst, paint);
+    }
+}
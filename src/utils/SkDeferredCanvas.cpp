@@ -11,13 +11,16 @@
 #include "SkChunkAlloc.h"
 #include "SkColorFilter.h"
 #include "SkDevice.h"
+#include "SkDraw.h"
 #include "SkDrawFilter.h"
 #include "SkGPipe.h"
 #include "SkPaint.h"
 #include "SkPaintPriv.h"
 #include "SkRRect.h"
+#include "SkRunnable.h"
 #include "SkShader.h"
 #include "SkSurface.h"
+#include "SkThreadPool.h"
 
 enum {
     // Deferred canvas will auto-flush when recording reaches this limit
@@ -64,10 +67,13 @@ class DeferredPipeController : public SkGPipeController {
 public:
     DeferredPipeController();
     void setPlaybackCanvas(SkCanvas*);
+    void resetReaders(SkCanvas* playbackCanvas, SkCanvas* const bandCanvases[], int bandCount);
     virtual ~DeferredPipeController();
     virtual void* requestBlock(size_t minRequest, size_t* actual) SK_OVERRIDE;
     virtual void notifyWritten(size_t bytes) SK_OVERRIDE;
+    virtual int numberOfReaders() const SK_OVERRIDE { return 1 + fBandReaders.count(); }
     void playback(bool silent);
+    void playbackInBands(SkThreadPool*);
     bool hasPendingCommands() const { return fAllocator.blockCount() != 0; }
     size_t storageAllocatedForRecording() const { return fAllocator.totalCapacity(); }
 private:
@@ -79,25 +85,68 @@ private:
         void* fBlock;
         size_t fSize;
     };
+    class BandPlayback;
+    void playback(SkGPipeReader*, uint32_t flags) const;
+    void releaseBlocks();
+
     void* fBlock;
     size_t fBytesWritten;
     SkChunkAlloc fAllocator;
     SkTDArray<PipeBlock> fBlockList;
-    SkGPipeReader fReader;
+    SkGPipeReader* fReader;
+    // Each band reader plays every command into its own band canvas, to draw
+    // in flushes played back in bands, or silently to keep up with the state
+    // changes in the others.
+    SkTDArray<SkGPipeReader*> fBandReaders;
+};
+
+class DeferredPipeController::BandPlayback : public SkRunnable {
+public:
+    BandPlayback() : fController(NULL), fReader(NULL) {}
+
+    void init(const DeferredPipeController* controller, SkGPipeReader* reader) {
+        fController = controller;
+        fReader = reader;
+    }
+
+    virtual void run() SK_OVERRIDE {
+        fController->playback(fReader, 0);
+    }
+
+private:
+    const DeferredPipeController* fController;
+    SkGPipeReader* fReader;
 };
 
 DeferredPipeController::DeferredPipeController() :
     fAllocator(kMinBlockSize) {
     fBlock = NULL;
     fBytesWritten = 0;
+    fReader = SkNEW(SkGPipeReader);
 }
 
 DeferredPipeController::~DeferredPipeController() {
     fAllocator.reset();
+    SkDELETE(fReader);
+    fBandReaders.deleteAll();
 }
 
 void DeferredPipeController::setPlaybackCanvas(SkCanvas* canvas) {
-    fReader.setCanvas(canvas);
+    fReader->setCanvas(canvas);
+}
+
+void DeferredPipeController::resetReaders(SkCanvas* playbackCanvas,
+                                          SkCanvas* const bandCanvases[], int bandCount) {
+    // Readers keep the definitions of the pipe they have read so far, so new
+    // ones are needed for a new pipe.
+    SkASSERT(!this->hasPendingCommands());
+    SkDELETE(fReader);
+    fReader = SkNEW_ARGS(SkGPipeReader, (playbackCanvas));
+    fBandReaders.deleteAll();
+    fBandReaders.reset();
+    for (int i = 0; i < bandCount; i++) {
+        *fBandReaders.append() = SkNEW_ARGS(SkGPipeReader, (bandCanvases[i]));
+    }
 }
 
 void* DeferredPipeController::requestBlock(size_t minRequest, size_t *actual) {
@@ -117,23 +166,236 @@ void DeferredPipeController::notifyWritten(size_t bytes) {
     fBytesWritten += bytes;
 }
 
-void DeferredPipeController::playback(bool silent) {
-    uint32_t flags = silent ? SkGPipeReader::kSilent_PlaybackFlag : 0;
+void DeferredPipeController::playback(SkGPipeReader* reader, uint32_t flags) const {
     for (int currentBlock = 0; currentBlock < fBlockList.count(); currentBlock++ ) {
-        fReader.playback(fBlockList[currentBlock].fBlock, fBlockList[currentBlock].fSize,
+        reader->playback(fBlockList[currentBlock].fBlock, fBlockList[currentBlock].fSize,
                          flags);
     }
-    fBlockList.reset();
 
     if (fBlock) {
-        fReader.playback(fBlock, fBytesWritten, flags);
-        fBlock = NULL;
+        reader->playback(fBlock, fBytesWritten, flags);
     }
+}
+
+void DeferredPipeController::releaseBlocks() {
+    fBlockList.reset();
+    fBlock = NULL;
 
     // Release all allocated blocks
     fAllocator.reset();
 }
 
+void DeferredPipeController::playback(bool silent) {
+    uint32_t flags = silent ? SkGPipeReader::kSilent_PlaybackFlag : 0;
+    this->playback(fReader, flags);
+    for (int i = 0; i < fBandReaders.count(); i++) {
+        this->playback(fBandReaders[i], SkGPipeReader::kSilent_PlaybackFlag);
+    }
+    this->releaseBlocks();
+}
+
+void DeferredPipeController::playbackInBands(SkThreadPool* pool) {
+    const int count = fBandReaders.count();
+    SkAutoTArray<BandPlayback> bands(count);
+    SkAutoTMalloc<SkRunnable*> runnables(count);
+    for (int i = 0; i < count; i++) {
+        bands[i].init(this, fBandReaders[i]);
+        runnables[i] = &bands[i];
+    }
+
+    SkThreadPool::Group group(pool);
+    group.add(runnables.get(), count);
+    // The bands do the drawing, the playback canvas only needs to keep up
+    // with the state changes. That never touches the pixels, so it can go
+    // on while the bands draw.
+    this->playback(fReader, SkGPipeReader::kSilent_PlaybackFlag);
+    group.wait();
+    this->releaseBlocks();
+}
+
+//-----------------------------------------------------------------------------
+// BandDevice
+//-----------------------------------------------------------------------------
+
+// Plays back one band of a flush that is played back in bands. Between
+// beginDrawing() and endDrawing() it draws into the pixels of the immediate
+// device, but only into the rows of its band (see SkDraw::fBand). The rest of
+// the time it has no pixels and draws nothing, while its canvas keeps up with
+// the matrix and clip of the immediate canvas.
+class BandDevice : public SkDevice {
+public:
+    BandDevice(int width, int height, const SkDeviceProperties& deviceProperties,
+               const SkIRect& band)
+        : SkDevice(SkBitmap::kNo_Config, width, height, false, deviceProperties)
+        , fBand(band)
+        , fDrawing(false) {
+    }
+
+    void beginDrawing(const SkBitmap& target) {
+        SkASSERT(target.width() == this->width() && target.height() == this->height());
+        // Locking an SkBitmap's pixels writes to it, so each band locks its own copy.
+        fTarget = target;
+        fTarget.lockPixels();
+        fDrawing = true;
+    }
+
+    void endDrawing() {
+        fDrawing = false;
+        fTarget.reset();
+    }
+
+    virtual void clear(SkColor color) SK_OVERRIDE {
+        if (fDrawing) {
+            SkBitmap rows;
+            if (fTarget.extractSubset(&rows, fBand)) {
+                rows.eraseColor(color);
+            }
+        }
+    }
+    virtual void drawPaint(const SkDraw& draw, const SkPaint& paint) SK_OVERRIDE {
+        if (fDrawing) {
+            this->INHERITED::drawPaint(BandDraw(draw, fBand), paint);
+        }
+    }
+    virtual void drawPoints(const SkDraw& draw, SkCanvas::PointMode mode,
+                            size_t count, const SkPoint pts[],
+                            const SkPaint& paint) SK_OVERRIDE {
+        if (fDrawing) {
+            this->INHERITED::drawPoints(BandDraw(draw, fBand), mode, count, pts, paint);
+        }
+    }
+    virtual void drawRect(const SkDraw& draw, const SkRect& r,
+                          const SkPaint& paint) SK_OVERRIDE {
+        if (fDrawing) {
+            this->INHERITED::drawRect(BandDraw(draw, fBand), r, paint);
+        }
+    }
+    virtual void drawOval(const SkDraw& draw, const SkRect& oval,
+                          const SkPaint& paint) SK_OVERRIDE {
+        if (fDrawing) {
+            this->INHERITED::drawOval(BandDraw(draw, fBand), oval, paint);
+        }
+    }
+    virtual void drawRRect(const SkDraw& draw, const SkRRect& rr,
+                           const SkPaint& paint) SK_OVERRIDE {
+        if (fDrawing) {
+            this->INHERITED::drawRRect(BandDraw(draw, fBand), rr, paint);
+        }
+    }
+    virtual void drawPath(const SkDraw& draw, const SkPath& path,
+                          const SkPaint& paint,
+                          const SkMatrix* prePathMatrix = NULL,
+                          bool pathIsMutable = false) SK_OVERRIDE {
+        if (fDrawing) {
+            this->INHERITED::drawPath(BandDraw(draw, fBand), path, paint, prePathMatrix,
+                                      pathIsMutable);
+        }
+    }
+    virtual void drawBitmap(const SkDraw& draw, const SkBitmap& bitmap,
+                            const SkIRect* srcRectOrNull,
+                            const SkMatrix& matrix, const SkPaint& paint) SK_OVERRIDE {
+        if (fDrawing) {
+            this->INHERITED::drawBitmap(BandDraw(draw, fBand), bitmap, srcRectOrNull, matrix,
+                                        paint);
+        }
+    }
+    virtual void drawSprite(const SkDraw& draw, const SkBitmap& bitmap,
+                            int x, int y, const SkPaint& paint) SK_OVERRIDE {
+        if (fDrawing) {
+            this->INHERITED::drawSprite(BandDraw(draw, fBand), bitmap, x, y, paint);
+        }
+    }
+    virtual void drawBitmapRect(const SkDraw& draw, const SkBitmap& bitmap,
+                                const SkRect* srcOrNull, const SkRect& dst,
+                                const SkPaint& paint) SK_OVERRIDE {
+        if (fDrawing) {
+            this->INHERITED::drawBitmapRect(BandDraw(draw, fBand), bitmap, srcOrNull, dst,
+                                            paint);
+        }
+    }
+    virtual void drawText(const SkDraw& draw, const void* text, size_t len,
+                          SkScalar x, SkScalar y, const SkPaint& paint) SK_OVERRIDE {
+        if (fDrawing) {
+            this->INHERITED::drawText(BandDraw(draw, fBand), text, len, x, y, paint);
+        }
+    }
+    virtual void drawPosText(const SkDraw& draw, const void* text, size_t len,
+                             const SkScalar pos[], SkScalar constY,
+                             int scalarsPerPos, const SkPaint& paint) SK_OVERRIDE {
+        if (fDrawing) {
+            this->INHERITED::drawPosText(BandDraw(draw, fBand), text, len, pos, constY,
+                                         scalarsPerPos, paint);
+        }
+    }
+    virtual void drawTextOnPath(const SkDraw& draw, const void* text, size_t len,
+                                const SkPath& path, const SkMatrix* matrix,
+                                const SkPaint& paint) SK_OVERRIDE {
+        if (fDrawing) {
+            this->INHERITED::drawTextOnPath(BandDraw(draw, fBand), text, len, path, matrix,
+                                            paint);
+        }
+    }
+#ifdef SK_BUILD_FOR_ANDROID
+    virtual void drawPosTextOnPath(const SkDraw& draw, const void* text, size_t len,
+                                   const SkPoint pos[], const SkPaint& paint,
+                                   const SkPath& path, const SkMatrix* matrix) SK_OVERRIDE {
+        if (fDrawing) {
+            this->INHERITED::drawPosTextOnPath(BandDraw(draw, fBand), text, len, pos, paint,
+                                               path, matrix);
+        }
+    }
+#endif
+    virtual void drawVertices(const SkDraw& draw, SkCanvas::VertexMode vmode,
+                              int vertexCount, const SkPoint verts[],
+                              const SkPoint texs[], const SkColor colors[],
+                              SkXfermode* xmode, const uint16_t indices[],
+                              int indexCount, const SkPaint& paint) SK_OVERRIDE {
+        if (fDrawing) {
+            this->INHERITED::drawVertices(BandDraw(draw, fBand), vmode, vertexCount, verts,
+                                          texs, colors, xmode, indices, indexCount, paint);
+        }
+    }
+    virtual void drawDevice(const SkDraw& draw, SkDevice* device, int x, int y,
+                            const SkPaint& paint) SK_OVERRIDE {
+        if (fDrawing) {
+            this->INHERITED::drawDevice(BandDraw(draw, fBand), device, x, y, paint);
+        }
+    }
+
+protected:
+    virtual const SkBitmap& onAccessBitmap(SkBitmap* bitmap) SK_OVERRIDE {
+        return fDrawing ? fTarget : *bitmap;
+    }
+
+    virtual SkDevice* onCreateCompatibleDevice(SkBitmap::Config config,
+                                               int width, int height,
+                                               bool isOpaque,
+                                               Usage usage) SK_OVERRIDE {
+        if (fDrawing) {
+            // Only image filters make layers while the bands draw, and every
+            // band draws the whole layer.
+            return SkNEW_ARGS(SkDevice, (config, width, height, isOpaque,
+                                         this->getDeviceProperties()));
+        }
+        // Nothing is drawn into the layers of silent playbacks.
+        return SkNEW_ARGS(BandDevice, (width, height, this->getDeviceProperties(),
+                                       SkIRect::MakeEmpty()));
+    }
+
+private:
+    struct BandDraw : public SkDraw {
+        BandDraw(const SkDraw& draw, const SkIRect& band) : SkDraw(draw) {
+            fBand = &band;
+        }
+    };
+
+    SkIRect fBand;
+    SkBitmap fTarget;
+    bool fDrawing;
+
+    typedef SkDevice INHERITED;
+};
+
 //-----------------------------------------------------------------------------
 // DeferredDevice
 //-----------------------------------------------------------------------------
@@ -157,7 +419,9 @@ public:
     void flushPendingCommands(PlaybackMode);
     void skipPendingCommands();
     void setMaxRecordingStorage(size_t);
+    void setFlushThreadPool(SkThreadPool*, int bandCount);
     void recordedDrawCommand();
+    void recordedLayer();
 
     virtual uint32_t getDeviceCapabilities() SK_OVERRIDE;
     virtual int width() const SK_OVERRIDE;
@@ -196,6 +460,9 @@ protected:
     virtual void drawRect(const SkDraw&, const SkRect& r,
                             const SkPaint& paint)
         {SkASSERT(0);}
+    virtual void drawRRect(const SkDraw&, const SkRRect& rr,
+                            const SkPaint& paint)
+        {SkASSERT(0);}
     virtual void drawPath(const SkDraw&, const SkPath& path,
                             const SkPaint& paint,
                             const SkMatrix* prePathMatrix = NULL,
@@ -240,6 +507,7 @@ private:
 
     void beginRecording();
     void init();
+    bool canPlaybackInBands() const;
 
     DeferredPipeController fPipeController;
     SkGPipeWriter  fPipeWriter;
@@ -252,6 +520,9 @@ private:
     size_t fMaxRecordingStorageBytes;
     size_t fPreviousStorageAllocated;
     size_t fBitmapSizeThreshold;
+    SkThreadPool* fFlushPool;
+    SkTDArray<SkCanvas*> fBandCanvases;
+    bool fRecordedLayer;
 };
 
 DeferredDevice::DeferredDevice(SkDevice* immediateDevice)
@@ -287,12 +558,15 @@ void DeferredDevice::init() {
     fBitmapSizeThreshold = kDeferredCanvasBitmapSizeThreshold;
     fMaxRecordingStorageBytes = kDefaultMaxRecordingStorageBytes;
     fNotificationClient = NULL;
+    fFlushPool = NULL;
+    fRecordedLayer = false;
     fPipeController.setPlaybackCanvas(fImmediateCanvas);
     this->beginRecording();
 }
 
 DeferredDevice::~DeferredDevice() {
     this->flushPendingCommands(kSilent_PlaybackMode);
+    fBandCanvases.unrefAll();
     SkSafeUnref(fImmediateCanvas);
     SkSafeUnref(fSurface);
 }
@@ -304,10 +578,105 @@ void DeferredDevice::setMaxRecordingStorage(size_t maxStorage) {
 
 void DeferredDevice::beginRecording() {
     SkASSERT(NULL == fRecordingCanvas);
-    fRecordingCanvas = fPipeWriter.startRecording(&fPipeController, 0,
+    // Every band reader makes its own copy of the bitmaps it reads.
+    uint32_t flags = fBandCanvases.isEmpty() ? 0 : SkGPipeWriter::kSimultaneousReaders_Flag;
+    fRecordingCanvas = fPipeWriter.startRecording(&fPipeController, flags,
         immediateDevice()->width(), immediateDevice()->height());
 }
 
+namespace {
+class ClipCopier : public SkCanvas::ClipVisitor {
+public:
+    explicit ClipCopier(SkCanvas* dst) : fDst(dst) {}
+
+    virtual void clipRect(const SkRect& r, SkRegion::Op op, bool antialias) SK_OVERRIDE {
+        fDst->clipRect(r, op, antialias);
+    }
+    virtual void clipPath(const SkPath& path, SkRegion::Op op, bool antialias) SK_OVERRIDE {
+        fDst->clipPath(path, op, antialias);
+    }
+
+private:
+    SkCanvas* fDst;
+};
+}
+
+void DeferredDevice::setFlushThreadPool(SkThreadPool* pool, int bandCount) {
+    SkASSERT(1 == fImmediateCanvas->getSaveCount());
+    this->flushPendingCommands(kNormal_PlaybackMode);
+
+    // The number of readers is fixed for the life of a pipe, so start a new one.
+    fPipeWriter.endRecording();
+    fRecordingCanvas = NULL;
+    fPipeController.playback(true);
+
+    fBandCanvases.unrefAll();
+    fBandCanvases.reset();
+    fFlushPool = pool;
+    if (NULL != pool) {
+        if (bandCount <= 0) {
+            bandCount = pool->count() + 1;
+        }
+        const int width = this->width();
+        const int height = this->height();
+        bandCount = SkMin32(bandCount, height);
+        for (int i = 0; i < bandCount && bandCount > 1; i++) {
+            SkIRect band = SkIRect::MakeLTRB(0, (int)((int64_t)height * i / bandCount),
+                                             width, (int)((int64_t)height * (i + 1) / bandCount));
+            BandDevice* device = SkNEW_ARGS(BandDevice, (width, height,
+                immediateDevice()->getDeviceProperties(), band));
+            SkCanvas* canvas = SkNEW_ARGS(SkCanvas, (device));
+            device->unref();
+            // Start out with the state of the immediate canvas. From here on
+            // the pipe keeps them in step.
+            ClipCopier copier(canvas);
+            fImmediateCanvas->replayClips(&copier);
+            canvas->setMatrix(fImmediateCanvas->getTotalMatrix());
+            *fBandCanvases.append() = canvas;
+        }
+    }
+    fPipeController.resetReaders(fImmediateCanvas, fBandCanvases.begin(), fBandCanvases.count());
+    this->beginRecording();
+
+    // The new recording canvas starts out with an identity matrix. Setting
+    // it changes nothing for the canvases it plays back into.
+    if (!fImmediateCanvas->getTotalMatrix().isIdentity()) {
+        fRecordingCanvas->setMatrix(fImmediateCanvas->getTotalMatrix());
+    }
+}
+
+void DeferredDevice::recordedLayer() {
+    fRecordedLayer = true;
+}
+
+bool DeferredDevice::canPlaybackInBands() const {
+    if (fBandCanvases.isEmpty() || fRecordedLayer) {
+        return false;
+    }
+    // Restoring a layer, even one saved before this flush, draws into the
+    // immediate device across all of the bands.
+    if (fImmediateCanvas->isDrawingToLayer() || NULL != fImmediateCanvas->getDrawFilter() ||
+        NULL != fImmediateCanvas->getBounder()) {
+        return false;
+    }
+    // The bands draw with the raster SkDevice.
+    if (0 != immediateDevice()->getDeviceCapabilities()) {
+        return false;
+    }
+    // The immediate canvas may have been changed directly, e.g. while
+    // deferral was off. The bands only draw the same as it does as long as
+    // they are in the same state.
+    for (int i = 0; i < fBandCanvases.count(); i++) {
+        const SkCanvas* canvas = fBandCanvases[i];
+        if (canvas->getSaveCount() != fImmediateCanvas->getSaveCount() ||
+            canvas->getTotalMatrix() != fImmediateCanvas->getTotalMatrix() ||
+            *canvas->getClipStack() != *fImmediateCanvas->getClipStack()) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void DeferredDevice::setNotificationClient(
     SkDeferredCanvas::NotificationClient* notificationClient) {
     fNotificationClient = notificationClient;
@@ -354,7 +723,24 @@ void DeferredDevice::flushPendingCommands(PlaybackMode playbackMode) {
         }
     }
     fPipeWriter.flushRecording(true);
-    fPipeController.playback(kSilent_PlaybackMode == playbackMode);
+    if (playbackMode == kNormal_PlaybackMode && this->canPlaybackInBands()) {
+        if (NULL != fSurface) {
+            // The bands draw straight into the device's pixels, so the surface
+            // must make its copy, if any, first.
+            fSurface->notifyContentWillChange(SkSurface::kRetain_ContentChangeMode);
+        }
+        const SkBitmap& target = immediateDevice()->accessBitmap(true);
+        for (int i = 0; i < fBandCanvases.count(); i++) {
+            static_cast<BandDevice*>(fBandCanvases[i]->getDevice())->beginDrawing(target);
+        }
+        fPipeController.playbackInBands(fFlushPool);
+        for (int i = 0; i < fBandCanvases.count(); i++) {
+            static_cast<BandDevice*>(fBandCanvases[i]->getDevice())->endDrawing();
+        }
+    } else {
+        fPipeController.playback(kSilent_PlaybackMode == playbackMode);
+    }
+    fRecordedLayer = false;
     if (playbackMode == kNormal_PlaybackMode && fNotificationClient) {
         fNotificationClient->flushedDrawCommands();
     }
@@ -613,6 +999,11 @@ void SkDeferredCanvas::silentFlush() {
     }
 }
 
+void SkDeferredCanvas::setFlushThreadPool(SkThreadPool* pool, int bandCount) {
+    this->validate();
+    this->getDeferredDevice()->setFlushThreadPool(pool, bandCount);
+}
+
 SkDeferredCanvas::~SkDeferredCanvas() {
 }
 
@@ -689,6 +1080,9 @@ int SkDeferredCanvas::saveLayer(const SkRect* bounds, const SkPaint* paint,
     this->drawingCanvas()->saveLayer(bounds, paint, flags);
     int count = this->INHERITED::save(flags);
     this->clipRectBounds(bounds, flags, NULL);
+    if (fDeferredDrawing) {
+        this->getDeferredDevice()->recordedLayer();
+    }
     this->recordedDrawCommand();
 
     return count;
@@ -943,6 +1337,10 @@ void SkDeferredCanvas::drawTextOnPath(const void* text, size_t byteLength,
 }
 
 void SkDeferredCanvas::drawPicture(SkPicture& picture) {
+    if (fDeferredDrawing) {
+        // the picture may save layers of its own
+        this->getDeferredDevice()->recordedLayer();
+    }
     this->drawingCanvas()->drawPicture(picture);
     this->recordedDrawCommand();
 }
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkPictureTileRenderer.h"
+#include "SkCanvas.h"
+#include "SkPicture.h"
+#include "SkRunnable.h"
+#include "SkThreadPool.h"
+#include "SkTime.h"
+
+static int tiles_across(int size, int tileSize) {
+    SkASSERT(tileSize > 0);
+    return (size + tileSize - 1) / tileSize;
+}
+
+SkPictureTileRenderer::SkPictureTileRenderer(SkPicture* picture, int tileWidth, int tileHeight,
+                                             int workerCount)
+    : fPicture(picture)
+    , fTileWidth(tileWidth)
+    , fTileHeight(tileHeight)
+    , fTilesX(tiles_across(picture->width(), tileWidth))
+    , fScheduler(fTilesX * tiles_across(picture->height(), tileHeight), workerCount) {
+    // Finish the picture now, rather than in a racing draw() from the workers
+    picture->endRecording();
+}
+
+SkIRect SkPictureTileRenderer::getTileRect(int tile) const {
+    SkASSERT((unsigned)tile < (unsigned)this->tileCount());
+    int x = (tile % fTilesX) * fTileWidth;
+    int y = (tile / fTilesX) * fTileHeight;
+    return SkIRect::MakeXYWH(x, y, fTileWidth, fTileHeight);
+}
+
+// Draws tiles from the scheduler until there are none left. Every worker has
+// its own canvas on the destination bitmap; since the tiles do not overlap,
+// the workers never write the same pixels.
+class SkPictureTileRenderer::Worker : public SkRunnable {
+public:
+    Worker() : fRenderer(NULL), fIndex(0), fPicture(NULL), fDst(NULL) {}
+
+    void init(SkPictureTileRenderer* renderer, int index, SkPicture* picture,
+              const SkBitmap* dst) {
+        fRenderer = renderer;
+        fIndex = index;
+        fPicture = picture;
+        fDst = dst;
+    }
+
+    virtual void run() SK_OVERRIDE {
+        SkTileScheduler& scheduler = fRenderer->fScheduler;
+        SkCanvas canvas(*fDst);
+        int tile;
+        while (scheduler.nextTile(fIndex, &tile)) {
+            SkMSec start = SkTime::GetMSecs();
+            SkIRect tileRect = fRenderer->getTileRect(tile);
+            int saveCount = canvas.save();
+            canvas.clipRect(SkRect::Make(tileRect));
+            fPicture->draw(&canvas);
+            canvas.restoreToCount(saveCount);
+            scheduler.recordTime(tile, SkTime::GetMSecs() - start);
+        }
+        canvas.flush();
+    }
+
+private:
+    SkPictureTileRenderer*  fRenderer;
+    int                     fIndex;
+    SkPicture*              fPicture;
+    const SkBitmap*         fDst;
+};
+
+void SkPictureTileRenderer::draw(SkBitmap* dst, SkThreadPool* pool) {
+    SkASSERT(NULL != dst);
+    const int workerCount = fScheduler.workerCount();
+
+    fScheduler.reset();
+    SkAutoTArray<Worker> workers(workerCount);
+    SkAutoTArray<SkRunnable*> runnables(workerCount);
+    for (int i = 0; i < workerCount; ++i) {
+        workers[i].init(this, i, fPicture, dst);
+        runnables[i] = &workers[i];
+    }
+
+    if (NULL != pool) {
+        SkThreadPool::Group group(pool);
+        group.add(runnables.get(), workerCount);
+        group.wait();
+    } else {
+        for (int i = 0; i < workerCount; ++i) {
+            workers[i].run();
+        }
+    }
+}
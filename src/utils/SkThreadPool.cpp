@@ -6,6 +6,7 @@
  */
 
 #include "SkRunnable.h"
+#include "SkTArray.h"
 #include "SkThreadPool.h"
 #include "SkThreadUtils.h"
 #include "SkTypes.h"
@@ -27,20 +28,64 @@ static int num_cores() {
 #endif
 }
 
+void SkThreadPool::Queue::push(const Task* tasks, int count) {
+    SkAutoMutexAcquire ac(fMutex);
+    fTasks.append(count, tasks);
+}
+
+bool SkThreadPool::Queue::popFront(Task* task) {
+    SkAutoMutexAcquire ac(fMutex);
+    if (fHead >= fTasks.count()) {
+        return false;
+    }
+    *task = fTasks[fHead++];
+    if (fHead == fTasks.count()) {
+        fTasks.rewind();
+        fHead = 0;
+    }
+    return true;
+}
+
+bool SkThreadPool::Queue::popBack(Task* task) {
+    SkAutoMutexAcquire ac(fMutex);
+    if (fHead >= fTasks.count()) {
+        return false;
+    }
+    fTasks.pop(task);
+    if (fHead == fTasks.count()) {
+        fTasks.rewind();
+        fHead = 0;
+    }
+    return true;
+}
+
 SkThreadPool::SkThreadPool(int count)
-: fDone(false) {
+: fQueues(NULL)
+, fPending(0)
+, fNextQueue(0)
+, fNextIndex(0)
+, fDone(false) {
     if (count < 0) count = num_cores();
+    if (count > 0) {
+        fQueues = SkNEW_ARRAY(Queue, count);
+        for (int i = 0; i < count; i++) {
+            fQueues[i].fHead = 0;
+        }
+    }
     // Create count threads, all running SkThreadPool::Loop.
     for (int i = 0; i < count; i++) {
         SkThread* thread = SkNEW_ARGS(SkThread, (&SkThreadPool::Loop, this));
         *fThreads.append() = thread;
-        thread->start();
+    }
+    // Only start them once fThreads is complete, since Loop reads its count.
+    for (int i = 0; i < count; i++) {
+        fThreads[i]->start();
     }
 }
 
 SkThreadPool::~SkThreadPool() {
-    fDone = true;
     fReady.lock();
+    fDone = true;
     fReady.broadcast();
     fReady.unlock();
 
@@ -49,16 +94,51 @@ SkThreadPool::~SkThreadPool() {
         fThreads[i]->join();
         SkDELETE(fThreads[i]);
     }
+    SkDELETE_ARRAY(fQueues);
+}
+
+void SkThreadPool::Run(const Task& task) {
+    task.fRunnable->run();
+    if (task.fGroup) {
+        task.fGroup->finished();
+    }
+}
+
+// Takes a task from queue index, or failing that steals one from the other queues.
+// An index of -1 means the caller has no queue of its own, and only steals.
+bool SkThreadPool::pop(int index, Task* task) {
+    const int count = fThreads.count();
+    bool found = index >= 0 && fQueues[index].popFront(task);
+    for (int i = 1; !found && i <= count; i++) {
+        int victim = (index + i) % count;
+        if (victim != index) {
+            found = fQueues[victim].popBack(task);
+        }
+    }
+    if (found) {
+        sk_atomic_dec(&fPending);
+    }
+    return found;
 }
 
 /*static*/ void SkThreadPool::Loop(void* arg) {
     // The SkThreadPool passes itself as arg to each thread as they're created.
     SkThreadPool* pool = static_cast<SkThreadPool*>(arg);
+    const int index = sk_atomic_inc(&pool->fNextIndex);
+    SkASSERT(index < pool->fThreads.count());
 
     while (true) {
-        // We have to be holding the lock to read the queue and to call wait.
+        Task task;
+        if (pool->pop(index, &task)) {
+            Run(task);
+            continue;
+        }
+
+        // Nothing to run anywhere. fPending is only read under the lock, and add() takes the
+        // lock to bump it after queueing, so we cannot miss a wakeup between checking and
+        // waiting. It can briefly go negative if a task is taken before it is counted.
         pool->fReady.lock();
-        while(pool->fQueue.isEmpty()) {
+        while (pool->fPending <= 0) {
             // Is it time to die?
             if (pool->fDone) {
                 pool->fReady.unlock();
@@ -67,41 +147,121 @@ SkThreadPool::~SkThreadPool() {
             // wait yields the lock while waiting, but will have it again when awoken.
             pool->fReady.wait();
         }
-        // We've got the lock back here, no matter if we ran wait or not.
-
-        // The queue is not empty, so we have something to run.  Claim it.
-        LinkedRunnable* r = pool->fQueue.tail();
-
-        pool->fQueue.remove(r);
-
-        // Having claimed our SkRunnable, we now give up the lock while we run it.
-        // Otherwise, we'd only ever do work on one thread at a time, which rather
-        // defeats the point of this code.
         pool->fReady.unlock();
-
-        // OK, now really do the work.
-        r->fRunnable->run();
-        SkDELETE(r);
     }
 
     SkASSERT(false); // Unreachable.  The only exit happens when pool->fDone.
 }
 
-void SkThreadPool::add(SkRunnable* r) {
-    if (NULL == r) {
+void SkThreadPool::push(SkRunnable* runnables[], int count, Group* group) {
+    SkSTArray<16, Task, true> tasks;
+    for (int i = 0; i < count; i++) {
+        if (NULL != runnables[i]) {
+            Task* task = &tasks.push_back();
+            task->fRunnable = runnables[i];
+            task->fGroup = group;
+        }
+    }
+    if (tasks.empty()) {
         return;
     }
+    if (group) {
+        group->fDone.lock();
+        group->fPending += tasks.count();
+        group->fDone.unlock();
+    }
 
-    // If we don't have any threads, obligingly just run the thing now.
-    if (fThreads.isEmpty()) {
-        return r->run();
+    // If we don't have any threads, obligingly just run the things now.
+    const int threadCount = fThreads.count();
+    if (0 == threadCount) {
+        for (int i = 0; i < tasks.count(); i++) {
+            Run(tasks[i]);
+        }
+        return;
     }
 
-    // We have some threads.  Queue it up!
+    // Spread the tasks in contiguous chunks over the queues, starting from a different queue
+    // each time so that single adds are distributed round-robin.
+    const int queueCount = SkMin32(threadCount, tasks.count());
+    const int first = sk_atomic_add(&fNextQueue, queueCount);
+    for (int i = 0; i < queueCount; i++) {
+        int start = tasks.count() * i / queueCount;
+        int stop = tasks.count() * (i + 1) / queueCount;
+        int queue = ((unsigned)(first + i)) % threadCount;
+        fQueues[queue].push(&tasks[start], stop - start);
+    }
+
+    // We have some threads. Wake them up, once for the whole batch.
     fReady.lock();
-    LinkedRunnable* linkedRunnable = SkNEW(LinkedRunnable);
-    linkedRunnable->fRunnable = r;
-    fQueue.addToHead(linkedRunnable);
-    fReady.signal();
+    sk_atomic_add(&fPending, tasks.count());
+    if (tasks.count() > 1) {
+        fReady.broadcast();
+    } else {
+        fReady.signal();
+    }
     fReady.unlock();
 }
+
+void SkThreadPool::add(SkRunnable* r) {
+    this->push(&r, 1, NULL);
+}
+
+void SkThreadPool::add(SkRunnable* runnables[], int count) {
+    this->push(runnables, count, NULL);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+SkThreadPool::Group::Group(SkThreadPool* pool)
+: fPool(pool)
+, fPending(0) {
+    SkASSERT(NULL != pool);
+}
+
+SkThreadPool::Group::~Group() {
+    this->wait();
+}
+
+void SkThreadPool::Group::add(SkRunnable* r) {
+    fPool->push(&r, 1, this);
+}
+
+void SkThreadPool::Group::add(SkRunnable* runnables[], int count) {
+    fPool->push(runnables, count, this);
+}
+
+void SkThreadPool::Group::finished() {
+    // Decrement under the lock, so that a waiter cannot see zero and destroy the group
+    // before we are done signalling it.
+    fDone.lock();
+    if (0 == --fPending) {
+        fDone.broadcast();
+    }
+    fDone.unlock();
+}
+
+void SkThreadPool::Group::wait() {
+    while (true) {
+        fDone.lock();
+        bool done = 0 == fPending;
+        fDone.unlock();
+        if (done) {
+            return;
+        }
+
+        // Help out rather than just blocking. This is what lets a runnable on one of the pool's
+        // own threads wait for a group without tying up that thread.
+        Task task;
+        if (fPool->fThreads.count() > 0 && fPool->pop(-1, &task)) {
+            Run(task);
+            continue;
+        }
+
+        // Everything left in the group is running on other threads.
+        fDone.lock();
+        while (fPending > 0) {
+            fDone.wait();
+        }
+        fDone.unlock();
+    }
+}
@@ -0,0 +1,120 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkTileScheduler.h"
+
+SkTileScheduler::SkTileScheduler(int tileCount, int workerCount)
+    : fTileCount(tileCount)
+    , fWorkerCount(workerCount) {
+    SkASSERT(tileCount >= 0);
+    SkASSERT(workerCount > 0);
+    fRuns = SkNEW_ARRAY(Run, workerCount);
+    fStats = SkNEW_ARRAY(TileStats, tileCount);
+    this->reset();
+}
+
+SkTileScheduler::~SkTileScheduler() {
+    SkDELETE_ARRAY(fRuns);
+    SkDELETE_ARRAY(fStats);
+}
+
+// Worker i initially owns tiles [initialStart(i), initialStart(i + 1)).
+int SkTileScheduler::initialStart(int worker) const {
+    return (int)((int64_t)fTileCount * worker / fWorkerCount);
+}
+
+void SkTileScheduler::reset() {
+    for (int i = 0; i < fWorkerCount; ++i) {
+        fRuns[i].fStart = this->initialStart(i);
+        fRuns[i].fStop = this->initialStart(i + 1);
+    }
+    for (int i = 0; i < fTileCount; ++i) {
+        fStats[i].fWorker = -1;
+        fStats[i].fStolen = false;
+        fStats[i].fDuration = 0;
+    }
+}
+
+bool SkTileScheduler::nextTile(int worker, int* tile) {
+    SkASSERT((unsigned)worker < (unsigned)fWorkerCount);
+    SkASSERT(NULL != tile);
+
+    bool found = false;
+    {
+        Run& run = fRuns[worker];
+        SkAutoMutexAcquire ac(run.fMutex);
+        if (run.fStart < run.fStop) {
+            *tile = run.fStart++;
+            found = true;
+        }
+    }
+    if (!found && !this->steal(worker, tile)) {
+        return false;
+    }
+
+    TileStats& stats = fStats[*tile];
+    stats.fWorker = worker;
+    stats.fStolen = *tile < this->initialStart(worker) ||
+                    *tile >= this->initialStart(worker + 1);
+    return true;
+}
+
+bool SkTileScheduler::steal(int thief, int* tile) {
+    for (;;) {
+        // Pick the worker with the most tiles left.
+        int victim = -1;
+        int mostLeft = 0;
+        for (int i = 1; i < fWorkerCount; ++i) {
+            int candidate = (thief + i) % fWorkerCount;
+            Run& run = fRuns[candidate];
+            SkAutoMutexAcquire ac(run.fMutex);
+            int left = run.fStop - run.fStart;
+            if (left > mostLeft) {
+                victim = candidate;
+                mostLeft = left;
+            }
+        }
+        if (victim < 0) {
+            return false;
+        }
+
+        // Take the back half of its run. Its tiles may have been claimed since
+        // we looked, in which case we look again.
+        int start, stop;
+        {
+            Run& run = fRuns[victim];
+            SkAutoMutexAcquire ac(run.fMutex);
+            int left = run.fStop - run.fStart;
+            if (left <= 0) {
+                continue;
+            }
+            stop = run.fStop;
+            run.fStop -= (left + 1) >> 1;
+            start = run.fStop;
+        }
+
+        // Keep the first stolen tile and make the rest our own run, where
+        // they may in turn be stolen by others.
+        Run& run = fRuns[thief];
+        SkAutoMutexAcquire ac(run.fMutex);
+        SkASSERT(run.fStart >= run.fStop);
+        *tile = start;
+        run.fStart = start + 1;
+        run.fStop = stop;
+        return true;
+    }
+}
+
+int SkTileScheduler::countStolen() const {
+    int count = 0;
+    for (int i = 0; i < fTileCount; ++i) {
+        if (fStats[i].fStolen) {
+            count += 1;
+        }
+    }
+    return count;
+}
@@ -0,0 +1,230 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "Test.h"
+#include "SkBitmap.h"
+#include "SkCanvas.h"
+#include "SkPath.h"
+#include "SkRandom.h"
+#include "SkRegion.h"
+#include "SkScan.h"
+
+static const int kSize = 100;
+
+// Draws 'path' antialiased into a fresh A8 bitmap, with the given scan converter
+static void draw_path(const SkPath& path, bool analytic, SkBitmap* bm,
+                      const SkPath* clip = NULL) {
+    bm->setConfig(SkBitmap::kA8_Config, kSize, kSize);
+    bm->allocPixels();
+    bm->eraseColor(SK_ColorTRANSPARENT);
+
+    SkCanvas canvas(*bm);
+    if (NULL != clip) {
+        canvas.clipPath(*clip);
+    }
+    SkPaint paint;
+    paint.setAntiAlias(true);
+
+    bool wasAnalytic = SkScan::IsAnalyticAA();
+    SkScan::SetAnalyticAA(analytic);
+    canvas.drawPath(path, paint);
+    SkScan::SetAnalyticAA(wasAnalytic);
+}
+
+static int alpha_at(const SkBitmap& bm, int x, int y) {
+    SkAutoLockPixels alp(bm);
+    return *bm.getAddr8(x, y);
+}
+
+// Computes the coverage of 'path' by drawing it without antialiasing at 16x16 the resolution
+static void draw_reference(const SkPath& path, SkBitmap* bm) {
+    static const int kScale = 16;
+    SkBitmap big;
+    big.setConfig(SkBitmap::kA8_Config, kSize * kScale, kSize * kScale);
+    big.allocPixels();
+    big.eraseColor(SK_ColorTRANSPARENT);
+    SkCanvas canvas(big);
+    canvas.scale(SkIntToScalar(kScale), SkIntToScalar(kScale));
+    canvas.drawPath(path, SkPaint());
+
+    bm->setConfig(SkBitmap::kA8_Config, kSize, kSize);
+    bm->allocPixels();
+    SkAutoLockPixels alp(big);
+    for (int y = 0; y < kSize; ++y) {
+        for (int x = 0; x < kSize; ++x) {
+            int sum = 0;
+            for (int j = 0; j < kScale; ++j) {
+                const uint8_t* row = big.getAddr8(x * kScale, y * kScale + j);
+                for (int i = 0; i < kScale; ++i) {
+                    sum += row[i];
+                }
+            }
+            *bm->getAddr8(x, y) = (sum + kScale * kScale / 2) / (kScale * kScale);
+        }
+    }
+}
+
+static void sum_error(const SkBitmap& bm, const SkBitmap& ref, int* maxError, int* totalError) {
+    SkAutoLockPixels alp(bm);
+    *maxError = 0;
+    *totalError = 0;
+    for (int y = 0; y < kSize; ++y) {
+        for (int x = 0; x < kSize; ++x) {
+            int error = SkAbs32(*bm.getAddr8(x, y) - *ref.getAddr8(x, y));
+            *maxError = SkMax32(*maxError, error);
+            *totalError += error;
+        }
+    }
+}
+
+/**
+ *  Where no edges cross, the analytic coverage should be within flattening error of the true
+ *  coverage, and overall closer to it than the supersampler's.
+ */
+static void check_accuracy(skiatest::Reporter* reporter, const SkPath& path) {
+    SkBitmap ref, super, analytic;
+    draw_reference(path, &ref);
+    draw_path(path, false, &super);
+    draw_path(path, true, &analytic);
+
+    int superMax, superTotal, analyticMax, analyticTotal;
+    sum_error(super, ref, &superMax, &superTotal);
+    sum_error(analytic, ref, &analyticMax, &analyticTotal);
+    REPORTER_ASSERT(reporter, analyticMax <= 16);
+    REPORTER_ASSERT(reporter, analyticTotal <= superTotal);
+}
+
+static void add_poly(SkPath* path, const SkScalar xy[], int count) {
+    path->moveTo(xy[0], xy[1]);
+    for (int i = 1; i < count; ++i) {
+        path->lineTo(xy[2 * i], xy[2 * i + 1]);
+    }
+    path->close();
+}
+
+static void test_exact_coverage(skiatest::Reporter* reporter) {
+    // A square on pixel centers covers a quarter of its corner pixels, and half of its edges
+    static const SkScalar kSquare[] = { 10.5f, 10.5f, 20.5f, 10.5f, 20.5f, 20.5f, 10.5f, 20.5f };
+    SkPath path;
+    add_poly(&path, kSquare, 4);
+    SkBitmap bm;
+    draw_path(path, true, &bm);
+    REPORTER_ASSERT(reporter, 64 == alpha_at(bm, 10, 10));
+    REPORTER_ASSERT(reporter, 64 == alpha_at(bm, 20, 20));
+    REPORTER_ASSERT(reporter, 128 == alpha_at(bm, 15, 10));
+    REPORTER_ASSERT(reporter, 128 == alpha_at(bm, 20, 15));
+    REPORTER_ASSERT(reporter, 255 == alpha_at(bm, 15, 15));
+    REPORTER_ASSERT(reporter, 0 == alpha_at(bm, 9, 15));
+    REPORTER_ASSERT(reporter, 0 == alpha_at(bm, 21, 15));
+
+    // A diagonal through pixel corners halves the pixels it crosses
+    static const SkScalar kTriangle[] = { 30, 30, 60, 60, 30, 60 };
+    path.reset();
+    add_poly(&path, kTriangle, 3);
+    draw_path(path, true, &bm);
+    REPORTER_ASSERT(reporter, 128 == alpha_at(bm, 40, 40));
+    REPORTER_ASSERT(reporter, 255 == alpha_at(bm, 40, 41));
+    REPORTER_ASSERT(reporter, 0 == alpha_at(bm, 41, 40));
+
+    // Lines left of the canvas still fill what is right of them
+    static const SkScalar kOffLeft[] = { -50, 70, 0.5f, 70, 0.5f, 80, -50, 80 };
+    path.reset();
+    add_poly(&path, kOffLeft, 4);
+    draw_path(path, true, &bm);
+    REPORTER_ASSERT(reporter, 128 == alpha_at(bm, 0, 75));
+    REPORTER_ASSERT(reporter, 0 == alpha_at(bm, 1, 75));
+
+    // And a path that leaves the canvas on the right fills up to its edge
+    static const SkScalar kOffRight[] = { 90.5f, 85, 150, 85, 150, 95, 90.5f, 95 };
+    path.reset();
+    add_poly(&path, kOffRight, 4);
+    draw_path(path, true, &bm);
+    REPORTER_ASSERT(reporter, 128 == alpha_at(bm, 90, 90));
+    REPORTER_ASSERT(reporter, 255 == alpha_at(bm, kSize - 1, 90));
+}
+
+static void test_fill_types(skiatest::Reporter* reporter) {
+    // Two overlapping squares, wound the same way
+    static const SkScalar kA[] = { 10, 10, 60, 10, 60, 60, 10, 60 };
+    static const SkScalar kB[] = { 40, 40, 90, 40, 90, 90, 40, 90 };
+    SkPath path;
+    add_poly(&path, kA, 4);
+    add_poly(&path, kB, 4);
+
+    SkBitmap bm;
+    draw_path(path, true, &bm);
+    REPORTER_ASSERT(reporter, 255 == alpha_at(bm, 50, 50));
+    REPORTER_ASSERT(reporter, 255 == alpha_at(bm, 20, 20));
+    check_accuracy(reporter, path);
+
+    path.setFillType(SkPath::kEvenOdd_FillType);
+    draw_path(path, true, &bm);
+    REPORTER_ASSERT(reporter, 0 == alpha_at(bm, 50, 50));
+    REPORTER_ASSERT(reporter, 255 == alpha_at(bm, 20, 20));
+    REPORTER_ASSERT(reporter, 255 == alpha_at(bm, 80, 80));
+    check_accuracy(reporter, path);
+}
+
+static void test_curves_and_clips(skiatest::Reporter* reporter) {
+    SkPath path;
+    path.addCircle(50, 50, 33.3f);
+    check_accuracy(reporter, path);
+
+    path.reset();
+    path.addCircle(20, 70, 60);     // clipped by the canvas on three sides
+    check_accuracy(reporter, path);
+
+    // A non-rectangular clip just masks the coverage
+    SkPath clipPath;
+    clipPath.addCircle(60, 40, 30);
+    SkRegion clip;
+    clip.setPath(clipPath, SkRegion(SkIRect::MakeWH(kSize, kSize)));
+    SkBitmap unclipped, clipped;
+    draw_path(path, true, &unclipped);
+    draw_path(path, true, &clipped, &clipPath);
+    bool masked = true;
+    for (int y = 0; y < kSize; ++y) {
+        for (int x = 0; x < kSize; ++x) {
+            int expected = clip.contains(x, y) ? alpha_at(unclipped, x, y) : 0;
+            masked &= expected == alpha_at(clipped, x, y);
+        }
+    }
+    REPORTER_ASSERT(reporter, masked);
+
+    SkRandom rand;
+    for (int i = 0; i < 20; ++i) {
+        SkRect r;
+        r.setLTRB(rand.nextRangeScalar(-20, 120), rand.nextRangeScalar(-20, 120),
+                  rand.nextRangeScalar(-20, 120), rand.nextRangeScalar(-20, 120));
+        r.sort();
+        path.reset();
+        switch (rand.nextULessThan(3)) {
+            case 0:
+                path.addOval(r);
+                break;
+            case 1:
+                path.addRoundRect(r, rand.nextRangeScalar(0, 20), rand.nextRangeScalar(0, 20));
+                break;
+            default:
+                path.moveTo(r.fLeft, r.fTop);
+                path.lineTo(r.fRight, rand.nextRangeScalar(r.fTop, r.fBottom));
+                path.lineTo(rand.nextRangeScalar(r.fLeft, r.fRight), r.fBottom);
+                path.close();
+                break;
+        }
+        check_accuracy(reporter, path);
+    }
+}
+
+static void TestAnalyticAA(skiatest::Reporter* reporter) {
+    test_exact_coverage(reporter);
+    test_fill_types(reporter);
+    test_curves_and_clips(reporter);
+}
+
+#include "TestClassDef.h"
+DEFINE_TESTCLASS("AnalyticAA", AnalyticAATestClass, TestAnalyticAA)
@@ -0,0 +1,240 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "Test.h"
+#include "SkBandedDevice.h"
+#include "SkBlurMaskFilter.h"
+#include "SkCanvas.h"
+#include "SkColorFilter.h"
+#include "SkGradientShader.h"
+#include "SkGraphics.h"
+#include "SkMaskCache.h"
+#include "SkPath.h"
+#include "SkRRect.h"
+#include "SkThreadPool.h"
+
+static const int kWidth = 300;
+static const int kHeight = 400;
+
+// Small enough that every draw below is split into as many bands as the pool allows.
+static const int kMinBandArea = 32 * 32;
+
+static SkShader* make_gradient() {
+    SkPoint pts[] = { { 0, 0 }, { SkIntToScalar(kWidth), SkIntToScalar(kHeight) } };
+    SkColor colors[] = { SK_ColorRED, 0x8000FF00, SK_ColorBLUE };
+    return SkGradientShader::CreateLinear(pts, colors, NULL, SK_ARRAY_COUNT(colors),
+                                          SkShader::kMirror_TileMode);
+}
+
+static void make_bitmap(SkBitmap* bm) {
+    bm->setConfig(SkBitmap::kARGB_8888_Config, 37, 29);
+    bm->allocPixels();
+    for (int y = 0; y < bm->height(); ++y) {
+        for (int x = 0; x < bm->width(); ++x) {
+            *bm->getAddr32(x, y) = SkPreMultiplyColor(SkColorSetARGB(0xFF - x, x * 7, y * 9,
+                                                                     (x ^ y) * 4));
+        }
+    }
+}
+
+static void draw_paths(SkCanvas* canvas) {
+    SkPath path;
+    path.moveTo(10, 10);
+    path.cubicTo(400, 0, -100, 300, 290, 390);
+    path.quadTo(0, 500, 20, 200);
+    path.close();
+    path.addCircle(150, 200, 120);
+
+    SkPaint paint;
+    paint.setAntiAlias(true);
+    paint.setShader(make_gradient())->unref();
+    canvas->drawPath(path, paint);
+
+    canvas->rotate(SkIntToScalar(7));
+    paint.setShader(NULL);
+    paint.setAntiAlias(false);
+    paint.setColor(0x80204080);
+    path.setFillType(SkPath::kInverseEvenOdd_FillType);
+    canvas->drawPath(path, paint);
+
+    paint.setAntiAlias(true);
+    paint.setStyle(SkPaint::kStroke_Style);
+    paint.setStrokeWidth(SkIntToScalar(9));
+    paint.setColor(SK_ColorBLACK);
+    path.setFillType(SkPath::kWinding_FillType);
+    canvas->drawPath(path, paint);
+
+    paint.setStrokeWidth(0);
+    paint.setColor(SK_ColorWHITE);
+    canvas->drawPath(path, paint);
+}
+
+static void draw_bitmaps(SkCanvas* canvas) {
+    SkBitmap bm;
+    make_bitmap(&bm);
+
+    SkPaint paint;
+    paint.setFilterBitmap(true);
+    canvas->drawBitmapRect(bm, NULL, SkRect::MakeLTRB(-5, 3, 290, 391), &paint);
+
+    canvas->drawSprite(bm, 7, 300, NULL);
+
+    canvas->save();
+    canvas->translate(150, -20);
+    canvas->rotate(SkIntToScalar(30));
+    canvas->scale(SkIntToScalar(6), SkIntToScalar(9));
+    paint.setAlpha(0xA0);
+    canvas->drawBitmap(bm, 0, 0, &paint);
+    canvas->restore();
+
+    SkIRect src = SkIRect::MakeXYWH(3, 4, 20, 15);
+    paint.setAlpha(0xFF);
+    paint.setColorFilter(SkColorFilter::CreateModeFilter(0x4000FF00,
+                                                         SkXfermode::kSrcOver_Mode))->unref();
+    canvas->drawBitmapRect(bm, &src, SkRect::MakeLTRB(20, 20, 280, 380), &paint);
+}
+
+static void draw_rects(SkCanvas* canvas) {
+    SkPaint paint;
+    paint.setColor(0xFF336699);
+    canvas->drawPaint(paint);
+
+    SkPath clip;
+    clip.addOval(SkRect::MakeLTRB(-20, 30, 310, 370));
+    canvas->clipPath(clip, SkRegion::kIntersect_Op, true);
+
+    paint.setXfermodeMode(SkXfermode::kMultiply_Mode);
+    paint.setColor(0x80FF8000);
+    canvas->drawPaint(paint);
+
+    paint.setXfermode(NULL);
+    paint.setAntiAlias(true);
+    paint.setShader(make_gradient())->unref();
+    canvas->drawRect(SkRect::MakeLTRB(SkFloatToScalar(0.5f), SkFloatToScalar(10.25f),
+                                      SkFloatToScalar(299.5f), SkFloatToScalar(390.75f)),
+                     paint);
+
+    paint.setShader(NULL);
+    paint.setColor(0x40000000);
+    canvas->drawOval(SkRect::MakeLTRB(30, 15, 270, 385), paint);
+}
+
+// Rrects reach the device as rrects, but are banded through drawPath unless a mask
+// filter draws them. Like the paths above, the shaded one runs off the canvas, so that
+// it is not drawn any differently for being wholly inside the unbanded clip.
+static void draw_rrects(SkCanvas* canvas) {
+    SkRRect rrect;
+    rrect.setRectXY(SkRect::MakeLTRB(-10, 20, 310, 380), 40, 60);
+    SkPaint paint;
+    paint.setAntiAlias(true);
+    paint.setShader(make_gradient())->unref();
+    canvas->drawRRect(rrect, paint);
+
+    rrect.setOval(SkRect::MakeLTRB(30, 15, 270, 385));
+    paint.setShader(NULL);
+    paint.setColor(0x80204080);
+    canvas->drawRRect(rrect, paint);
+}
+
+static void compare(skiatest::Reporter* reporter, SkThreadPool* pool,
+                    void (*draw)(SkCanvas*)) {
+    SkBitmap expected, actual;
+    expected.setConfig(SkBitmap::kARGB_8888_Config, kWidth, kHeight);
+    expected.allocPixels();
+    expected.eraseColor(SK_ColorTRANSPARENT);
+    actual.setConfig(SkBitmap::kARGB_8888_Config, kWidth, kHeight);
+    actual.allocPixels();
+    actual.eraseColor(SK_ColorTRANSPARENT);
+
+    {
+        SkCanvas canvas(expected);
+        draw(&canvas);
+    }
+    {
+        SkBandedDevice* device = SkNEW_ARGS(SkBandedDevice, (actual, pool, kMinBandArea));
+        SkCanvas canvas(device);
+        device->unref();
+        draw(&canvas);
+        REPORTER_ASSERT(reporter, device->getLastBandCount() == pool->count() + 1);
+    }
+
+    SkAutoLockPixels alpExpected(expected), alpActual(actual);
+    REPORTER_ASSERT(reporter, 0 == memcmp(expected.getPixels(), actual.getPixels(),
+                                          expected.getSize()));
+}
+
+static void test_threshold(skiatest::Reporter* reporter, SkThreadPool* pool) {
+    SkBitmap bm;
+    bm.setConfig(SkBitmap::kARGB_8888_Config, kWidth, kHeight);
+    bm.allocPixels();
+
+    SkBandedDevice* device = SkNEW_ARGS(SkBandedDevice, (bm, pool, kMinBandArea));
+    SkCanvas canvas(device);
+    device->unref();
+
+    SkPaint paint;
+    canvas.drawRect(SkRect::MakeWH(31, 31), paint);
+    REPORTER_ASSERT(reporter, 1 == device->getLastBandCount());
+    canvas.drawRect(SkRect::MakeWH(2 * 32, 32), paint);
+    REPORTER_ASSERT(reporter, 2 == device->getLastBandCount());
+    canvas.drawRect(SkRect::MakeWH(300, 1), paint);
+    REPORTER_ASSERT(reporter, 1 == device->getLastBandCount());
+
+    canvas.drawPaint(paint);
+    REPORTER_ASSERT(reporter, pool->count() + 1 == device->getLastBandCount());
+
+    // Every band would compute the whole blur, so it stays inline.
+    paint.setMaskFilter(SkBlurMaskFilter::Create(SkIntToScalar(3),
+                                                 SkBlurMaskFilter::kNormal_BlurStyle))->unref();
+    canvas.drawRect(SkRect::MakeWH(300, 300), paint);
+    REPORTER_ASSERT(reporter, 1 == device->getLastBandCount());
+}
+
+// With the mask cache on, a banded path is looked up once by the thread that splits the draw,
+// and the bands only blit what it found, so the pixels still match.
+static void test_mask_cache(skiatest::Reporter* reporter, SkThreadPool* pool) {
+    const size_t prevLimit = SkGraphics::SetMaskCacheLimit(4 * 1024 * 1024);
+    SkGraphics::PurgeMaskCache();
+
+    compare(reporter, pool, draw_paths);
+
+    SkBitmap bm;
+    bm.setConfig(SkBitmap::kARGB_8888_Config, kWidth, kHeight);
+    bm.allocPixels();
+    SkBandedDevice* device = SkNEW_ARGS(SkBandedDevice, (bm, pool, kMinBandArea));
+    SkCanvas canvas(device);
+    device->unref();
+
+    SkPath path;
+    path.addCircle(150, 200, 140);
+    SkPaint paint;
+    paint.setAntiAlias(true);
+    for (int i = 0; i < 2; ++i) {
+        const int hits = SkMaskCache::GetHitCount();
+        const int misses = SkMaskCache::GetMissCount();
+        canvas.drawPath(path, paint);
+        REPORTER_ASSERT(reporter, pool->count() + 1 == device->getLastBandCount());
+        REPORTER_ASSERT(reporter, i == SkMaskCache::GetHitCount() - hits);
+        REPORTER_ASSERT(reporter, 1 - i == SkMaskCache::GetMissCount() - misses);
+    }
+
+    SkGraphics::PurgeMaskCache();
+    SkGraphics::SetMaskCacheLimit(prevLimit);
+}
+
+static void TestBandedDevice(skiatest::Reporter* reporter) {
+    SkThreadPool pool(3);
+    compare(reporter, &pool, draw_paths);
+    compare(reporter, &pool, draw_bitmaps);
+    compare(reporter, &pool, draw_rects);
+    compare(reporter, &pool, draw_rrects);
+    test_threshold(reporter, &pool);
+    test_mask_cache(reporter, &pool);
+}
+
+#include "TestClassDef.h"
+DEFINE_TESTCLASS("BandedDevice", BandedDeviceTestClass, TestBandedDevice)
@@ -0,0 +1,202 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "Test.h"
+#include "SkBitmapScaler.h"
+#include "SkCanvas.h"
+#include "SkColorPriv.h"
+#include "SkConvolver.h"
+#include "SkRandom.h"
+#include "SkUnPreMultiply.h"
+
+static void make_bitmap(SkBitmap* bm, int w, int h, SkRandom* rand) {
+    bm->setConfig(SkBitmap::kARGB_8888_Config, w, h);
+    bm->allocPixels();
+    SkAutoLockPixels alp(*bm);
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            unsigned a = rand->nextU() & 0xFF;
+            *bm->getAddr32(x, y) = SkPackARGB32(a, SkAlphaMul(rand->nextU() & 0xFF, a + 1),
+                                                SkAlphaMul(rand->nextU() & 0xFF, a + 1),
+                                                SkAlphaMul(rand->nextU() & 0xFF, a + 1));
+        }
+    }
+}
+
+static bool equal_pixels(const SkBitmap& a, const SkBitmap& b) {
+    SkAutoLockPixels alpa(a);
+    SkAutoLockPixels alpb(b);
+    if (a.width() != b.width() || a.height() != b.height()) {
+        return false;
+    }
+    for (int y = 0; y < a.height(); y++) {
+        if (memcmp(a.getAddr32(0, y), b.getAddr32(0, y), a.width() * sizeof(SkPMColor))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static unsigned clamp_channel(int accum) {
+    accum = (accum + (1 << (SkConvolutionFilter1D::kShiftBits - 1))) >>
+            SkConvolutionFilter1D::kShiftBits;
+    return SkClampMax(SkMax32(accum, 0), 255);
+}
+
+// Convolves one channel of 'count' pixels, 'stride' apart, with a filter's weights.
+static unsigned convolve_channel(const SkConvolutionFilter1D::Fixed weights[], int length,
+                                 const SkPMColor* src, int stride, int shift) {
+    int accum = 0;
+    for (int i = 0; i < length; i++) {
+        accum += weights[i] * (int)((src[i * stride] >> shift) & 0xFF);
+    }
+    return clamp_channel(accum);
+}
+
+// Straightforward SkConvolve2D(), to check the platform procs against.
+static void reference_convolve(const SkBitmap& src, const SkConvolutionFilter1D& xFilter,
+                               const SkConvolutionFilter1D& yFilter, SkBitmap* dst) {
+    SkBitmap temp;
+    temp.setConfig(SkBitmap::kARGB_8888_Config, xFilter.numValues(), src.height());
+    temp.allocPixels();
+    SkAutoLockPixels alp(src);
+    for (int y = 0; y < src.height(); y++) {
+        for (int x = 0; x < temp.width(); x++) {
+            int offset, length;
+            const SkConvolutionFilter1D::Fixed* w = xFilter.filterForValue(x, &offset, &length);
+            SkPMColor c = 0;
+            for (int shift = 0; shift < 32; shift += 8) {
+                c |= convolve_channel(w, length, src.getAddr32(offset, y), 1, shift) << shift;
+            }
+            *temp.getAddr32(x, y) = c;
+        }
+    }
+
+    dst->setConfig(SkBitmap::kARGB_8888_Config, xFilter.numValues(), yFilter.numValues());
+    dst->allocPixels();
+    const int stride = temp.rowBytes() >> 2;
+    for (int y = 0; y < dst->height(); y++) {
+        int offset, length;
+        const SkConvolutionFilter1D::Fixed* w = yFilter.filterForValue(y, &offset, &length);
+        for (int x = 0; x < dst->width(); x++) {
+            SkPMColor c = 0;
+            for (int shift = 0; shift < 32; shift += 8) {
+                c |= convolve_channel(w, length, temp.getAddr32(x, offset), stride, shift) << shift;
+            }
+            const unsigned a = SkGetPackedA32(c);
+            *dst->getAddr32(x, y) = SkPackARGB32(a, SkMin32(SkGetPackedR32(c), a),
+                                                 SkMin32(SkGetPackedG32(c), a),
+                                                 SkMin32(SkGetPackedB32(c), a));
+        }
+    }
+}
+
+static void make_filter(int srcLength, int dstLength, SkRandom* rand,
+                        SkConvolutionFilter1D* filter) {
+    for (int i = 0; i < dstLength; i++) {
+        // Random lengths exercise every tail of the platform procs, and random
+        // offsets hang off both edges.
+        float weights[9];
+        const int length = 1 + rand->nextU() % SK_ARRAY_COUNT(weights);
+        for (int j = 0; j < length; j++) {
+            weights[j] = rand->nextRangeF(-0.25f, 0.75f);
+        }
+        filter->addFilter((int)rand->nextRangeU(0, srcLength + 4) - 4, weights, length, srcLength);
+    }
+}
+
+static void test_convolve(skiatest::Reporter* reporter) {
+    SkRandom rand;
+    for (int i = 0; i < 20; i++) {
+        const int srcW = rand.nextRangeU(1, 40);
+        const int srcH = rand.nextRangeU(1, 40);
+        SkBitmap src;
+        make_bitmap(&src, srcW, srcH, &rand);
+
+        SkConvolutionFilter1D xFilter, yFilter;
+        make_filter(srcW, rand.nextRangeU(1, 40), &rand, &xFilter);
+        make_filter(srcH, rand.nextRangeU(1, 40), &rand, &yFilter);
+
+        SkBitmap dst, expected;
+        REPORTER_ASSERT(reporter, SkConvolve2D(src, xFilter, yFilter, &dst));
+        reference_convolve(src, xFilter, yFilter, &expected);
+        REPORTER_ASSERT(reporter, equal_pixels(dst, expected));
+    }
+}
+
+static void test_resize(skiatest::Reporter* reporter, SkBitmapScaler::ResizeMethod method) {
+    static const SkPMColor kColor = SkPackARGB32(0x80, 0x40, 0x20, 0x10);
+    static const int kSizes[] = { 1, 3, 16, 45 };
+
+    SkBitmap src;
+    src.setConfig(SkBitmap::kARGB_8888_Config, 16, 16);
+    src.allocPixels();
+    src.eraseColor(SkUnPreMultiply::PMColorToColor(kColor));
+
+    // The weights for every pixel sum to one, so a solid color stays that color
+    for (size_t i = 0; i < SK_ARRAY_COUNT(kSizes); i++) {
+        for (size_t j = 0; j < SK_ARRAY_COUNT(kSizes); j++) {
+            SkBitmap dst;
+            REPORTER_ASSERT(reporter, SkBitmapScaler::Resize(&dst, src, kSizes[i], kSizes[j],
+                                                             method));
+            REPORTER_ASSERT(reporter, kSizes[i] == dst.width() && kSizes[j] == dst.height());
+            SkAutoLockPixels alp(dst);
+            for (int y = 0; y < dst.height(); y++) {
+                for (int x = 0; x < dst.width(); x++) {
+                    if (*dst.getAddr32(x, y) != kColor) {
+                        SkString str;
+                        str.printf("%dx%d pixel (%d, %d) is %08x", kSizes[i], kSizes[j], x, y,
+                                   *dst.getAddr32(x, y));
+                        reporter->reportFailed(str);
+                        return;
+                    }
+                }
+            }
+        }
+    }
+
+    SkBitmap dst;
+    REPORTER_ASSERT(reporter, !SkBitmapScaler::Resize(&dst, src, 0, 10, method));
+}
+
+// Drawing with the high quality flag draws the resized bitmap
+static void test_draw(skiatest::Reporter* reporter) {
+    SkRandom rand;
+    SkBitmap src;
+    make_bitmap(&src, 20, 30, &rand);
+
+    SkBitmap expected;
+    REPORTER_ASSERT(reporter, SkBitmapScaler::Resize(&expected, src, 50, 15,
+                                                     SkBitmapScaler::kMitchell_ResizeMethod));
+
+    SkBitmap dst;
+    dst.setConfig(SkBitmap::kARGB_8888_Config, 50, 15);
+    dst.allocPixels();
+    dst.eraseColor(SK_ColorTRANSPARENT);
+    SkCanvas canvas(dst);
+    SkPaint paint;
+    paint.setFilterBitmap(true);
+    paint.setHighQualityFilterBitmap(true);
+    paint.setXfermodeMode(SkXfermode::kSrc_Mode);
+    canvas.drawBitmapRect(src, NULL, SkRect::MakeWH(50, 15), &paint);
+    REPORTER_ASSERT(reporter, equal_pixels(expected, dst));
+
+    // Without it, the bitmap is filtered bilinearly
+    paint.setHighQualityFilterBitmap(false);
+    canvas.drawBitmapRect(src, NULL, SkRect::MakeWH(50, 15), &paint);
+    REPORTER_ASSERT(reporter, !equal_pixels(expected, dst));
+}
+
+static void TestBitmapScaler(skiatest::Reporter* reporter) {
+    test_convolve(reporter);
+    test_resize(reporter, SkBitmapScaler::kMitchell_ResizeMethod);
+    test_resize(reporter, SkBitmapScaler::kLanczos3_ResizeMethod);
+    test_draw(reporter);
+}
+
+#include "TestClassDef.h"
+DEFINE_TESTCLASS("BitmapScaler", BitmapScalerTestClass, TestBitmapScaler)
@@ -6,10 +6,13 @@
  * found in the LICENSE file.
  */
 #include "Test.h"
+#include "SkBlurMask_opts.h"
 #include "SkBlurMaskFilter.h"
 #include "SkCanvas.h"
 #include "SkMath.h"
 #include "SkPaint.h"
+#include "SkRandom.h"
+#include "SkRRect.h"
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -157,5 +160,182 @@ static void test_blur(skiatest::Reporter* reporter) {
     }
 }
 
+// Straightforward versions of the passes in SkBlurMask.cpp, to check the platform procs against.
+static void reference_box_blur(const uint8_t* src, int srcRowBytes, uint8_t* dst,
+                               int dstXStride, int dstYStride,
+                               int leftRadius, int rightRadius, int width, int height) {
+    const int diameter = leftRadius + rightRadius;
+    const uint32_t scale = (1 << 24) / (diameter + 1);
+    for (int y = 0; y < height; y++) {
+        const uint8_t* row = src + y * srcRowBytes;
+        uint8_t* dptr = dst + y * dstYStride;
+        for (int x = 0; x < rightRadius - leftRadius; x++, dptr += dstXStride) {
+            *dptr = 0;
+        }
+        // Each output sums the pixels of the row that lie in [x - diameter, x].
+        for (int x = 0; x < width + diameter; x++, dptr += dstXStride) {
+            uint32_t sum = 0;
+            for (int i = SkMax32(0, x - diameter); i <= SkMin32(x, width - 1); i++) {
+                sum += row[i];
+            }
+            *dptr = (sum * scale + (1 << 23)) >> 24;
+        }
+        for (int x = 0; x < leftRadius - rightRadius; x++, dptr += dstXStride) {
+            *dptr = 0;
+        }
+    }
+}
+
+static void reference_box_blur_interp(const uint8_t* src, int srcRowBytes, uint8_t* dst,
+                                      int dstXStride, int dstYStride,
+                                      int radius, int width, int height, uint8_t outerWeight) {
+    const int diameter = radius * 2;
+    int innerWeight = 255 - outerWeight;
+    outerWeight += outerWeight >> 7;
+    innerWeight += innerWeight >> 7;
+    const uint32_t outerScale = (outerWeight << 16) / (diameter + 1);
+    const uint32_t innerScale = (innerWeight << 16) / (diameter - 1);
+    for (int y = 0; y < height; y++) {
+        const uint8_t* row = src + y * srcRowBytes;
+        uint8_t* dptr = dst + y * dstYStride;
+        for (int x = 0; x < width + diameter; x++, dptr += dstXStride) {
+            // The outer sum covers [x - diameter, x], the inner one [x - diameter + 1, x - 1],
+            // except that while x runs from width to diameter the inner sum keeps its value
+            // from x == width - 1.
+            const int innerEnd = (x >= width && x < diameter) ? width - 2 : x - 1;
+            uint32_t outerSum = 0, innerSum = 0;
+            for (int i = SkMax32(0, x - diameter); i <= SkMin32(x, width - 1); i++) {
+                outerSum += row[i];
+            }
+            for (int i = SkMax32(0, x - diameter + 1); i <= SkMin32(innerEnd, width - 1); i++) {
+                innerSum += row[i];
+            }
+            *dptr = (outerSum * outerScale + innerSum * innerScale + (1 << 23)) >> 24;
+        }
+    }
+}
+
+static void test_platform_box_blur(skiatest::Reporter* reporter) {
+    SkBoxBlurProc proc = SkPlatformBoxBlurProc();
+    SkBoxBlurInterpProc interpProc = SkPlatformBoxBlurInterpProc();
+    if (NULL == proc || NULL == interpProc) {
+        return;
+    }
+
+    SkRandom rand;
+    for (int i = 0; i < 40; i++) {
+        // Random widths exercise the partial tiles, and radii both sides of the width, up to
+        // the widest kernel the procs take.
+        const int width = rand.nextRangeU(1, 70);
+        const int height = 16 * rand.nextRangeU(1, 3);
+        const int srcRowBytes = width + rand.nextRangeU(0, 5);
+        const int leftRadius = rand.nextRangeU(0, 128);
+        const int rightRadius = rand.nextBool() ? leftRadius : rand.nextRangeU(0, 128);
+        const int radius = rand.nextRangeU(1, 128);
+        const uint8_t outerWeight = rand.nextU() & 0xFF;
+        const bool transpose = rand.nextBool();
+
+        SkAutoTMalloc<uint8_t> src(srcRowBytes * height);
+        for (int j = 0; j < srcRowBytes * height; j++) {
+            src[j] = rand.nextU() & 0xFF;
+        }
+
+        const int newWidth = width + 2 * SkMax32(leftRadius, rightRadius);
+        const int dstSize = newWidth * height;
+        const int interpSize = (width + 2 * radius) * height;
+        SkAutoTMalloc<uint8_t> dst(SkMax32(dstSize, interpSize));
+        SkAutoTMalloc<uint8_t> expected(SkMax32(dstSize, interpSize));
+        int xStride = transpose ? height : 1;
+        int yStride = transpose ? 1 : newWidth;
+        REPORTER_ASSERT(reporter, proc(src.get(), srcRowBytes, dst.get(), xStride, yStride,
+                                       leftRadius, rightRadius, width, height));
+        reference_box_blur(src.get(), srcRowBytes, expected.get(), xStride, yStride,
+                           leftRadius, rightRadius, width, height);
+        REPORTER_ASSERT(reporter, !memcmp(dst.get(), expected.get(), dstSize));
+
+        yStride = transpose ? 1 : width + 2 * radius;
+        REPORTER_ASSERT(reporter, interpProc(src.get(), srcRowBytes, dst.get(), xStride, yStride,
+                                             radius, width, height, outerWeight));
+        reference_box_blur_interp(src.get(), srcRowBytes, expected.get(), xStride, yStride,
+                                  radius, width, height, outerWeight);
+        REPORTER_ASSERT(reporter, !memcmp(dst.get(), expected.get(), interpSize));
+    }
+}
+
+// Returns the largest difference between the alphas of two A8 bitmaps.
+static int max_alpha_diff(const SkBitmap& a, const SkBitmap& b) {
+    SkAutoLockPixels alpa(a);
+    SkAutoLockPixels alpb(b);
+    int maxDiff = 0;
+    for (int y = 0; y < a.height(); ++y) {
+        for (int x = 0; x < a.width(); ++x) {
+            maxDiff = SkMax32(maxDiff, SkAbs32(*a.getAddr8(x, y) - *b.getAddr8(x, y)));
+        }
+    }
+    return maxDiff;
+}
+
+// Blurred rrects and ovals are drawn from a stretched (and cached) patch,
+// which must look like blurring the whole path.
+static void test_rrect_blur(skiatest::Reporter* reporter) {
+    SkRandom rand;
+    for (int i = 0; i < 60; ++i) {
+        const SkScalar radius = rand.nextRangeScalar(SK_Scalar1, SkIntToScalar(12));
+        const uint32_t flags = rand.nextBool() ? SkBlurMaskFilter::kHighQuality_BlurFlag : 0;
+        const SkBlurMaskFilter::BlurStyle style = rand.nextBool() ?
+            SkBlurMaskFilter::kNormal_BlurStyle : SkBlurMaskFilter::kSolid_BlurStyle;
+
+        SkRect r = SkRect::MakeXYWH(rand.nextRangeScalar(40, 50), rand.nextRangeScalar(40, 50),
+                                    rand.nextRangeScalar(4, 150), rand.nextRangeScalar(4, 150));
+        SkRRect rrect;
+        switch (i % 3) {
+            case 0:
+                rrect.setOval(r);
+                break;
+            case 1:
+                rrect.setRectXY(r, rand.nextRangeScalar(1, 20), rand.nextRangeScalar(1, 20));
+                break;
+            default: {
+                SkVector radii[4];
+                for (int j = 0; j < 4; ++j) {
+                    radii[j].set(rand.nextRangeScalar(0, 20), rand.nextRangeScalar(0, 20));
+                }
+                rrect.setRectRadii(r, radii);
+                break;
+            }
+        }
+
+        SkPaint paint;
+        paint.setAntiAlias(true);
+        paint.setMaskFilter(SkBlurMaskFilter::Create(radius, style, flags))->unref();
+
+        SkBitmap expected, actual;
+        create(&expected, SkIRect::MakeWH(260, 260), SkBitmap::kA8_Config);
+        create(&actual, SkIRect::MakeWH(260, 260), SkBitmap::kA8_Config);
+        expected.eraseColor(SK_ColorTRANSPARENT);
+        actual.eraseColor(SK_ColorTRANSPARENT);
+
+        SkPath path;
+        path.addRRect(rrect);
+        SkCanvas(expected).drawPath(path, paint);
+        SkCanvas(actual).drawRRect(rrect, paint);
+
+        // Stretching the patch moves the right and bottom corners by whole pixels,
+        // so their antialiased coverage may round one step differently.
+        const int diff = max_alpha_diff(expected, actual);
+        if (diff > 1) {
+            SkString str;
+            str.printf("rrect %d blur %g: alpha differs by %d", i, SkScalarToFloat(radius), diff);
+            reporter->reportFailed(str);
+        }
+    }
+}
+
+static void TestBlur(skiatest::Reporter* reporter) {
+    test_blur(reporter);
+    test_platform_box_blur(reporter);
+    test_rrect_blur(reporter);
+}
+
 #include "TestClassDef.h"
-DEFINE_TESTCLASS("BlurMaskFilter", BlurTestClass, test_blur)
+DEFINE_TESTCLASS("BlurMaskFilter", BlurTestClass, TestBlur)
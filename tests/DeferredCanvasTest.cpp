@@ -11,8 +11,10 @@
 #include "SkDeferredCanvas.h"
 #include "SkDevice.h"
 #include "SkGradientShader.h"
+#include "SkPath.h"
 #include "SkShader.h"
 #include "SkSurface.h"
+#include "SkThreadPool.h"
 #if SK_SUPPORT_GPU
 #include "GrContextFactory.h"
 #else
@@ -548,6 +550,141 @@ static void TestDeferredCanvasSurface(skiatest::Reporter* reporter, GrContextFac
     REPORTER_ASSERT(reporter, pixels4 == pixels5);
 }
 
+static const int kBandedWidth = 120;
+static const int kBandedHeight = 90;
+
+// Draws the same things into the canvas for every frame, in a few batches
+// that each end with a flush.
+static void draw_banded_frame(SkCanvas* canvas, int frame) {
+    canvas->clear(0xFF204060);
+    canvas->translate(SkIntToScalar(frame * 3), SkIntToScalar(frame));
+
+    SkPoint pts[] = { { 0, 0 }, { SkIntToScalar(kBandedWidth), SkIntToScalar(kBandedHeight) } };
+    SkColor colors[] = { SK_ColorRED, 0x8000FF00, SK_ColorBLUE };
+    SkPaint paint;
+    paint.setAntiAlias(true);
+    paint.setShader(SkGradientShader::CreateLinear(pts, colors, NULL, SK_ARRAY_COUNT(colors),
+                                                   SkShader::kMirror_TileMode))->unref();
+    SkPath path;
+    path.moveTo(5, 5);
+    path.cubicTo(150, 0, -40, 80, 110, 85);
+    path.close();
+    path.addCircle(60, 45, 30);
+    canvas->drawPath(path, paint);
+    canvas->flush();
+
+    SkBitmap bm;
+    bm.setConfig(SkBitmap::kARGB_8888_Config, 13, 11);
+    bm.allocPixels();
+    for (int y = 0; y < bm.height(); ++y) {
+        for (int x = 0; x < bm.width(); ++x) {
+            *bm.getAddr32(x, y) = SkPreMultiplyColor(SkColorSetARGB(0xFF - x, x * 19, y * 23,
+                                                                     (x ^ y) * 16));
+        }
+    }
+    canvas->save();
+    canvas->rotate(SkIntToScalar(20));
+    canvas->clipRect(SkRect::MakeLTRB(10, -10, 100, 70), SkRegion::kIntersect_Op, true);
+    paint.setShader(NULL);
+    paint.setFilterBitmap(true);
+    paint.setAlpha(0xC0);
+    canvas->drawBitmapRect(bm, NULL, SkRect::MakeLTRB(0, 0, 90, 80), &paint);
+    canvas->restore();
+
+    paint.setAlpha(0xFF);
+    paint.setColor(SK_ColorBLACK);
+    paint.setTextSize(SkIntToScalar(24));
+    canvas->drawText("banded", 6, 5, 60, paint);
+    paint.setStyle(SkPaint::kStroke_Style);
+    paint.setStrokeWidth(SkIntToScalar(3));
+    canvas->drawOval(SkRect::MakeLTRB(20, 10, 100, 80), paint);
+    canvas->flush();
+}
+
+static void TestDeferredCanvasBandedFlush(skiatest::Reporter* reporter) {
+    SkBitmap expected, actual;
+    expected.setConfig(SkBitmap::kARGB_8888_Config, kBandedWidth, kBandedHeight);
+    expected.allocPixels();
+    actual.setConfig(SkBitmap::kARGB_8888_Config, kBandedWidth, kBandedHeight);
+    actual.allocPixels();
+
+    SkThreadPool pool(3);
+    SkCanvas expectedCanvas(expected);
+    SkDevice device(actual);
+    SkDeferredCanvas canvas(&device);
+    // more bands than threads, of uneven heights
+    canvas.setFlushThreadPool(&pool, 7);
+
+    SkAutoLockPixels alpExpected(expected), alpActual(actual);
+    for (int frame = 0; frame < 2; frame++) {
+        draw_banded_frame(&expectedCanvas, frame);
+        draw_banded_frame(&canvas, frame);
+        REPORTER_ASSERT(reporter, 0 == memcmp(expected.getPixels(), actual.getPixels(),
+                                              expected.getSize()));
+    }
+
+    // Layers are played back on the calling thread, and the bands pick up
+    // where it left off.
+    SkPaint paint;
+    paint.setColor(0x80FF8000);
+    SkCanvas* canvases[] = { &expectedCanvas, &canvas };
+    for (size_t i = 0; i < SK_ARRAY_COUNT(canvases); i++) {
+        canvases[i]->saveLayerAlpha(NULL, 0x80);
+        canvases[i]->drawCircle(60, 45, 40, paint);
+        canvases[i]->restore();
+        canvases[i]->flush();
+        canvases[i]->drawRect(SkRect::MakeLTRB(0, 30, 70, 60), paint);
+        canvases[i]->flush();
+    }
+    REPORTER_ASSERT(reporter, 0 == memcmp(expected.getPixels(), actual.getPixels(),
+                                          expected.getSize()));
+
+    // Back to one thread.
+    canvas.setFlushThreadPool(NULL);
+    draw_banded_frame(&expectedCanvas, 2);
+    draw_banded_frame(&canvas, 2);
+    REPORTER_ASSERT(reporter, 0 == memcmp(expected.getPixels(), actual.getPixels(),
+                                          expected.getSize()));
+}
+
+static void TestDeferredCanvasBandedFlushSurface(skiatest::Reporter* reporter) {
+    SkImage::Info imageSpec = {
+        kBandedWidth,
+        kBandedHeight,
+        SkImage::kPMColor_ColorType,
+        SkImage::kPremul_AlphaType
+    };
+    SkAutoTUnref<SkSurface> surface(SkSurface::NewRaster(imageSpec));
+    SkDeferredCanvas canvas(surface.get());
+    SkThreadPool pool(2);
+    canvas.setFlushThreadPool(&pool);
+
+    canvas.clear(SK_ColorWHITE);
+    SkAutoTUnref<SkImage> image1(canvas.newImageSnapshot());
+    PixelPtr pixels1 = getSurfacePixelPtr(surface.get(), false);
+    // The bands draw straight into the pixels, so the surface must copy on
+    // write before they start.
+    SkPaint paint;
+    paint.setColor(SK_ColorBLACK);
+    canvas.drawRect(SkRect::MakeWH(SkIntToScalar(kBandedWidth), 10), paint);
+    SkAutoTUnref<SkImage> image2(canvas.newImageSnapshot());
+    REPORTER_ASSERT(reporter, image1->uniqueID() != image2->uniqueID());
+    REPORTER_ASSERT(reporter, pixels1 != getSurfacePixelPtr(surface.get(), false));
+
+    SkBitmap bm1, bm2;
+    bm1.setConfig(SkBitmap::kARGB_8888_Config, kBandedWidth, kBandedHeight);
+    bm1.allocPixels();
+    bm2.setConfig(SkBitmap::kARGB_8888_Config, kBandedWidth, kBandedHeight);
+    bm2.allocPixels();
+    SkCanvas canvas1(bm1), canvas2(bm2);
+    image1->draw(&canvas1, 0, 0, NULL);
+    image2->draw(&canvas2, 0, 0, NULL);
+    SkAutoLockPixels alp1(bm1), alp2(bm2);
+    REPORTER_ASSERT(reporter, SK_ColorWHITE == bm1.getColor(5, 5));
+    REPORTER_ASSERT(reporter, SK_ColorBLACK == bm2.getColor(5, 5));
+    REPORTER_ASSERT(reporter, SK_ColorWHITE == bm2.getColor(5, 50));
+}
+
 static void TestDeferredCanvas(skiatest::Reporter* reporter, GrContextFactory* factory) {
     TestDeferredCanvasBitmapAccess(reporter);
     TestDeferredCanvasFlush(reporter);
@@ -558,6 +695,8 @@ static void TestDeferredCanvas(skiatest::Reporter* reporter, GrContextFactory* f
     TestDeferredCanvasBitmapShaderNoLeak(reporter);
     TestDeferredCanvasBitmapSizeThreshold(reporter);
     TestDeferredCanvasSurface(reporter, NULL);
+    TestDeferredCanvasBandedFlush(reporter);
+    TestDeferredCanvasBandedFlushSurface(reporter);
     if (NULL != factory) {
         TestDeferredCanvasSurface(reporter, factory);
     }
@@ -11,9 +11,13 @@
 #include "SkColor.h"
 #include "SkColorFilter.h"
 #include "SkGradientShader.h"
+#include "SkLazyFlatArray.h"
 #include "SkPaint.h"
 #include "SkPictureFlat.h"
+#include "SkRunnable.h"
 #include "SkShader.h"
+#include "SkStream.h"
+#include "SkThreadPool.h"
 #include "SkXfermode.h"
 #include "Test.h"
 
@@ -50,6 +54,146 @@ static void testCreate(skiatest::Reporter* reporter, const void* obj,
     REPORTER_ASSERT(reporter, SkFlatData::Compare(data1, data2) == 0);
 }
 
+static SkMatrix make_matrix(int i) {
+    SkMatrix matrix;
+    matrix.setTranslate(SkIntToScalar(i % 37), SkIntToScalar(i / 37));
+    return matrix;
+}
+
+// Many more entries than the hash table starts out with, so it has to grow.
+static const int kEntryCount = 1000;
+
+static void testDictionary(skiatest::Reporter* reporter) {
+    Controller controller;
+    SkMatrixDictionary dictionary(&controller);
+
+    // Indices are handed out in the order entries are first added, no matter
+    // how they hash.
+    for (int i = 0; i < kEntryCount; ++i) {
+        REPORTER_ASSERT(reporter, dictionary.find(make_matrix(i)) == i + 1);
+    }
+    for (int i = kEntryCount - 1; i >= 0; --i) {
+        REPORTER_ASSERT(reporter, dictionary.find(make_matrix(i)) == i + 1);
+    }
+    REPORTER_ASSERT(reporter, dictionary.count() == kEntryCount);
+    for (int i = 0; i < kEntryCount; ++i) {
+        REPORTER_ASSERT(reporter, dictionary[i]->index() == i + 1);
+    }
+
+    SkAutoTUnref<SkTRefArray<SkMatrix> > matrices(dictionary.unflattenToArray());
+    for (int i = 0; i < kEntryCount; ++i) {
+        REPORTER_ASSERT(reporter, (*matrices)[i] == make_matrix(i));
+    }
+
+    dictionary.reset();
+    REPORTER_ASSERT(reporter, 0 == dictionary.count());
+    REPORTER_ASSERT(reporter, dictionary.find(make_matrix(kEntryCount)) == 1);
+}
+
+static void testHashRemove(skiatest::Reporter* reporter) {
+    Controller controller;
+    SkFlatDataHash hash;
+    SkTDArray<SkFlatData*> flats;
+    for (int i = 0; i < kEntryCount; ++i) {
+        SkMatrix matrix = make_matrix(i);
+        SkFlatData* flat = SkFlatData::Create(&controller, &matrix, i + 1,
+                                              &SkMatrixDictionary::flattenMatrix);
+        const SkFlatData** slot = hash.find(flat);
+        REPORTER_ASSERT(reporter, NULL == *slot);
+        flat->setSentinelInCache();
+        hash.add(slot, flat);
+        *flats.append() = flat;
+    }
+
+    // Removing every third entry must not lose track of the others in the same runs.
+    for (int i = 0; i < kEntryCount; i += 3) {
+        REPORTER_ASSERT(reporter, hash.remove(flats[i]));
+        REPORTER_ASSERT(reporter, !hash.remove(flats[i]));
+    }
+    REPORTER_ASSERT(reporter, hash.count() == kEntryCount - (kEntryCount + 2) / 3);
+    for (int i = 0; i < kEntryCount; ++i) {
+        SkMatrix matrix = make_matrix(i);
+        SkFlatData* candidate = SkFlatData::Create(&controller, &matrix, 0,
+                                                   &SkMatrixDictionary::flattenMatrix);
+        const SkFlatData* found = *hash.find(candidate);
+        REPORTER_ASSERT(reporter, found == (i % 3 ? flats[i] : NULL));
+    }
+}
+
+static void read_matrix(SkOrderedReadBuffer& buffer, SkMatrix* matrix) {
+    buffer.readMatrix(matrix);
+}
+
+namespace {
+
+// Reads every entry of a lazy array, starting from a different one on each thread.
+class LazyReader : public SkRunnable {
+public:
+    LazyReader() : fArray(NULL), fStart(0), fMatches(true) {}
+
+    virtual void run() SK_OVERRIDE {
+        for (int i = 0; i < kEntryCount; ++i) {
+            int index = (fStart + i) % kEntryCount;
+            fMatches = fMatches && (*fArray)[index] == make_matrix(index);
+        }
+    }
+
+    const SkLazyFlatArray<SkMatrix>* fArray;
+    int fStart;
+    bool fMatches;
+};
+
+}
+
+static void testLazyArray(skiatest::Reporter* reporter) {
+    Controller controller;
+    SkMatrixDictionary dictionary(&controller);
+    for (int i = 0; i < kEntryCount; ++i) {
+        dictionary.find(make_matrix(i));
+    }
+
+    SkDynamicMemoryWStream stream;
+    SkTDArray<uint32_t> offsets;
+    for (int i = 0; i < kEntryCount; ++i) {
+        *offsets.append() = stream.getOffset();
+        stream.write(dictionary[i]->data(), dictionary[i]->flatSize());
+    }
+    *offsets.append() = stream.getOffset();
+    SkAutoTUnref<SkData> data(stream.copyToData());
+    SkAutoTUnref<SkFlatReadContext> context(SkNEW(SkFlatReadContext));
+    SkAutoTUnref<SkLazyFlatArray<SkMatrix> > array(
+        SkNEW_ARGS(SkLazyFlatArray<SkMatrix>, (data, offsets.begin(), kEntryCount, context,
+                                               &read_matrix)));
+
+    // Nothing is unflattened until it is asked for, and then only once
+    REPORTER_ASSERT(reporter, 0 == array->loadedCount());
+    const SkMatrix* entry = &(*array)[kEntryCount / 2];
+    REPORTER_ASSERT(reporter, *entry == make_matrix(kEntryCount / 2));
+    REPORTER_ASSERT(reporter, 1 == array->loadedCount());
+    REPORTER_ASSERT(reporter, entry == &(*array)[kEntryCount / 2]);
+    REPORTER_ASSERT(reporter, 1 == array->loadedCount());
+
+    static const int kThreads = 4;
+    LazyReader readers[kThreads];
+    SkRunnable* runnables[kThreads];
+    for (int i = 0; i < kThreads; ++i) {
+        readers[i].fArray = array;
+        readers[i].fStart = i * kEntryCount / kThreads;
+        runnables[i] = &readers[i];
+    }
+    {
+        SkThreadPool pool(kThreads);
+        SkThreadPool::Group group(&pool);
+        group.add(runnables, kThreads);
+        group.wait();
+    }
+    for (int i = 0; i < kThreads; ++i) {
+        REPORTER_ASSERT(reporter, readers[i].fMatches);
+    }
+    REPORTER_ASSERT(reporter, kEntryCount == array->loadedCount());
+    REPORTER_ASSERT(reporter, entry == &(*array)[kEntryCount / 2]);
+}
+
 static void Tests(skiatest::Reporter* reporter) {
     // Test flattening SkShader
     SkPoint points[2];
@@ -85,6 +229,10 @@ static void Tests(skiatest::Reporter* reporter) {
     SkXfermode* xfer = SkXfermode::Create(SkXfermode::kDstOver_Mode);
     SkAutoUnref aurxf(xfer);
     testCreate(reporter, xfer, &flattenFlattenableProc);
+
+    testDictionary(reporter);
+    testHashRemove(reporter);
+    testLazyArray(reporter);
 }
 
 #include "TestClassDef.h"
@@ -85,8 +85,89 @@ static void TestFlate(skiatest::Reporter* reporter, SkMemoryStream* testStream,
                                      testData.getLength()) == 0);
 }
 
+// Writes data through an SkDeflateWStream in pieces of varying sizes, followed by a marker, and
+// reads it back through an SkInflateStream, which must stop right before the marker.
+static void TestStreamingFlate(skiatest::Reporter* reporter, const uint8_t* data,
+                               size_t dataSize) {
+    static const uint32_t kMarker = 0x600DF00D;
+
+    SkDynamicMemoryWStream compressed;
+    {
+        SkDeflateWStream deflater(&compressed);
+        size_t written = 0;
+        for (size_t piece = 1; written < dataSize; piece = piece * 3 + 1) {
+            size_t size = SkTMin(piece % 5000, dataSize - written);
+            REPORTER_ASSERT(reporter, deflater.write(data + written, size));
+            written += size;
+        }
+        REPORTER_ASSERT(reporter, dataSize == deflater.bytesWritten());
+        REPORTER_ASSERT(reporter, deflater.finalize());
+        REPORTER_ASSERT(reporter, !deflater.write(data, 1));
+    }
+    compressed.write32(kMarker);
+    SkAutoDataUnref compressedData(compressed.copyToData());
+
+    SkMemoryStream source(compressedData);
+    SkAutoTMalloc<uint8_t> storage(dataSize + 1);
+    uint8_t* inflated = storage.get();
+    {
+        SkInflateStream inflater(&source);
+        size_t read = 0;
+        for (size_t piece = 1; read < dataSize; piece = piece * 7 + 3) {
+            size_t size = SkTMin(piece % 7000, dataSize - read);
+            if (piece & 1) {
+                REPORTER_ASSERT(reporter, size == inflater.read(inflated + read, size));
+            } else {
+                REPORTER_ASSERT(reporter, size == inflater.skip(size));
+                memcpy(inflated + read, data + read, size);
+            }
+            read += size;
+        }
+        REPORTER_ASSERT(reporter, 0 == inflater.read(inflated, 1));
+        REPORTER_ASSERT(reporter, inflater.isValid());
+        REPORTER_ASSERT(reporter, 0 == memcmp(data, inflated, dataSize));
+        REPORTER_ASSERT(reporter, kMarker == source.readU32());
+
+        // Reading again from the start of the source gives the same data.
+        REPORTER_ASSERT(reporter, inflater.rewind());
+        REPORTER_ASSERT(reporter, dataSize == inflater.read(inflated, dataSize + 1));
+        REPORTER_ASSERT(reporter, 0 == memcmp(data, inflated, dataSize));
+    }
+
+    // Cut short, the data is found to be invalid, rather than read past.
+    if (dataSize > 0) {
+        SkMemoryStream truncated(compressedData->data(), compressedData->size() / 2);
+        SkInflateStream inflater(&truncated);
+        REPORTER_ASSERT(reporter, inflater.read(inflated, dataSize) < dataSize);
+        REPORTER_ASSERT(reporter, !inflater.isValid());
+    }
+}
+
+static void TestStreamingFlate(skiatest::Reporter* reporter) {
+    static const size_t kSize = 100000;
+    SkAutoTMalloc<uint8_t> storage(kSize);
+    uint8_t* data = storage.get();
+
+    // Random bytes, which do not compress, so take many blocks of compressed data.
+    srand(0);
+    for (size_t i = 0; i < kSize; i++) {
+        data[i] = rand() & 0xFF;
+    }
+    TestStreamingFlate(reporter, data, kSize);
+
+    // Repetitive bytes, which compress well.
+    for (size_t i = 0; i < kSize; i++) {
+        data[i] = (i % 251) ^ (i / 1000);
+    }
+    TestStreamingFlate(reporter, data, kSize);
+    TestStreamingFlate(reporter, data, 0);
+}
+
 static void TestFlateCompression(skiatest::Reporter* reporter) {
     TestFlate(reporter, NULL, 0);
+    if (SkFlate::HaveFlate()) {
+        TestStreamingFlate(reporter);
+    }
 #if defined(SK_ZLIB_INCLUDE) && !defined(SK_DEBUG)
     REPORTER_ASSERT(reporter, SkFlate::HaveFlate());
 
@@ -6,12 +6,15 @@
  * found in the LICENSE file.
  */
 #include "Test.h"
+#include "SkCanvas.h"
 #include "SkDevice.h"
 #include "SkTemplates.h"
 #include "SkShader.h"
 #include "SkColorShader.h"
 #include "SkEmptyShader.h"
 #include "SkGradientShader.h"
+#include "SkRandom.h"
+#include "gradients/SkGradient_opts.h"
 
 struct GradRec {
     int             fColorCount;
@@ -158,6 +161,135 @@ static void TestConstantGradient(skiatest::Reporter*) {
     }
 }
 
+static void draw_gradient(SkShader* shader, U8CPU alpha, SkBitmap* dst) {
+    dst->setConfig(SkBitmap::kARGB_8888_Config, 64, 4);
+    dst->allocPixels();
+    dst->eraseColor(SK_ColorTRANSPARENT);
+    SkPaint paint;
+    paint.setShader(shader);
+    paint.setAlpha(alpha);
+    SkCanvas canvas(*dst);
+    canvas.drawPaint(paint);
+}
+
+static bool equal_pixels(const SkBitmap& a, const SkBitmap& b) {
+    SkAutoLockPixels alpa(a);
+    SkAutoLockPixels alpb(b);
+    return a.getSize() == b.getSize() && 0 == memcmp(a.getPixels(), b.getPixels(), a.getSize());
+}
+
+// Shaders made with the same colors and positions share their color tables.
+static void TestGradientCache(skiatest::Reporter* reporter) {
+    const SkPoint pts[] = {
+        { 0, 0 },
+        { SkIntToScalar(64), 0 }
+    };
+    const SkColor colors[] = { 0xFF123456, 0x80654321, 0xFFABCDEF };
+    const SkScalar pos[] = { 0, SK_Scalar1 / 3, SK_Scalar1 };
+
+    SkAutoTUnref<SkShader> s0(SkGradientShader::CreateLinear(pts, colors, pos, 3,
+                                                             SkShader::kClamp_TileMode));
+    SkAutoTUnref<SkShader> s1(SkGradientShader::CreateLinear(pts, colors, pos, 3,
+                                                             SkShader::kRepeat_TileMode));
+    SkBitmap bm0, bm1;
+    draw_gradient(s0, 0xFF, &bm0);
+    const int hits = SkGradientShader::GetCacheHitCount();
+    draw_gradient(s1, 0xFF, &bm1);
+    REPORTER_ASSERT(reporter, SkGradientShader::GetCacheHitCount() > hits);
+    REPORTER_ASSERT(reporter, equal_pixels(bm0, bm1));
+    REPORTER_ASSERT(reporter, SkGradientShader::GetCacheUsed() > 0);
+
+    // a different paint alpha needs a different table
+    draw_gradient(s1, 0x80, &bm1);
+    REPORTER_ASSERT(reporter, !equal_pixels(bm0, bm1));
+
+    // with the cache off, each shader builds its own table, with the same colors
+    const size_t limit = SkGradientShader::SetCacheLimit(0);
+    REPORTER_ASSERT(reporter, 0 == SkGradientShader::GetCacheUsed());
+    SkAutoTUnref<SkShader> s2(SkGradientShader::CreateLinear(pts, colors, pos, 3,
+                                                             SkShader::kClamp_TileMode));
+    draw_gradient(s2, 0x80, &bm0);
+    REPORTER_ASSERT(reporter, equal_pixels(bm0, bm1));
+    REPORTER_ASSERT(reporter, 0 == SkGradientShader::GetCacheUsed());
+    SkGradientShader::SetCacheLimit(limit);
+}
+
+static unsigned tile_fixed(SkShader::TileMode mode, SkFixed x) {
+    switch (mode) {
+        case SkShader::kRepeat_TileMode:
+            return x & 0xFFFF;
+        case SkShader::kMirror_TileMode:
+            return (x ^ (x << 15 >> 31)) & 0xFFFF;
+        default:
+            return x;
+    }
+}
+
+// Checks the platform's span procs against straightforward versions of what they compute.
+static void TestPlatformGradientProcs(skiatest::Reporter* reporter) {
+    SkPMColor cache[4 * 256];
+    for (size_t i = 0; i < SK_ARRAY_COUNT(cache); i++) {
+        cache[i] = (SkPMColor)(i * 2654435761u);
+    }
+    const SkPMColor* even = cache + 2 * 256;
+    const SkPMColor* odd = cache + 3 * 256;
+
+    SkRandom rand;
+    SkPMColor dst[300], expected[300];
+    for (int m = 0; m < SkShader::kTileModeCount; m++) {
+        const SkShader::TileMode mode = (SkShader::TileMode)m;
+        SkLinearGradientProc linearProc = SkPlatformLinearGradientProc(mode);
+        SkRadialGradientProc radialProc = SkPlatformRadialGradientProc(mode);
+
+        for (int i = 0; linearProc && i < 100; i++) {
+            const int count = rand.nextRangeU(1, SK_ARRAY_COUNT(dst));
+            SkFixed fx, dx;
+            if (SkShader::kClamp_TileMode == mode) {
+                // clamped spans stay in [0, 0xFFFF]
+                fx = rand.nextRangeU(0, 0xFFFF);
+                dx = count > 1 ? ((SkFixed)rand.nextRangeU(0, 0xFFFF) - fx) / (count - 1) : 0;
+            } else {
+                fx = rand.nextS();
+                dx = rand.nextRangeU(0, 0x4000) - 0x2000;
+            }
+            for (int j = 0; j < count; j++) {
+                const SkFixed x = (SkFixed)((uint32_t)fx + j * (uint32_t)dx);
+                expected[j] = (j & 1 ? odd : even)[tile_fixed(mode, x) >> 8];
+            }
+            linearProc(fx, dx, dst, even, odd, count);
+            if (memcmp(dst, expected, count * sizeof(SkPMColor))) {
+                SkString str;
+                str.printf("linear mode %d fx %x dx %x count %d", m, fx, dx, count);
+                reporter->reportFailed(str);
+            }
+        }
+
+        for (int i = 0; radialProc && i < 100; i++) {
+            const int count = rand.nextRangeU(1, SK_ARRAY_COUNT(dst));
+            const float fx = rand.nextRangeF(-2, 2);
+            const float fy = rand.nextRangeF(-2, 2);
+            const float dx = rand.nextRangeF(-0.05f, 0.05f);
+            const float dy = rand.nextRangeF(-0.05f, 0.05f);
+            for (int j = 0; j < count; j++) {
+                const float x = fx + (float)j * dx;
+                const float y = fy + (float)j * dy;
+                float dist = sk_float_sqrt(x * x + y * y) * 65536.0f;
+                if (SkShader::kClamp_TileMode == mode) {
+                    dist = SkTMin(dist, 65535.0f);
+                }
+                expected[j] = (j & 1 ? odd : even)[tile_fixed(mode, (SkFixed)dist) >> 8];
+            }
+            radialProc(fx, dx, fy, dy, dst, even, odd, count);
+            if (memcmp(dst, expected, count * sizeof(SkPMColor))) {
+                SkString str;
+                str.printf("radial mode %d (%g, %g) step (%g, %g) count %d", m, fx, fy, dx, dy,
+                           count);
+                reporter->reportFailed(str);
+            }
+        }
+    }
+}
+
 typedef void (*GradProc)(skiatest::Reporter* reporter, const GradRec&);
 
 static void TestGradientShaders(skiatest::Reporter* reporter) {
@@ -195,6 +327,8 @@ static void TestGradientShaders(skiatest::Reporter* reporter) {
 static void TestGradients(skiatest::Reporter* reporter) {
     TestGradientShaders(reporter);
     TestConstantGradient(reporter);
+    TestGradientCache(reporter);
+    TestPlatformGradientProcs(reporter);
 }
 #include "TestClassDef.h"
 DEFINE_TESTCLASS("Gradients", TestGradientsClass, TestGradients)
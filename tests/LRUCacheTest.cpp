@@ -0,0 +1,87 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "Test.h"
+#include "SkTLRUCache.h"
+
+namespace {
+
+struct Entry {
+    Entry(int key, size_t bytes, int* freed)
+        : fKey(key)
+        , fBytes(bytes)
+        , fFreed(freed)
+        , fHash(key % 3)    // so that different keys share hashes
+        , fHashNext(NULL)
+        , fPrev(NULL)
+        , fNext(NULL) {
+    }
+
+    bool equals(const int& key) const { return fKey == key; }
+    size_t bytes() const { return fBytes; }
+    static void Free(Entry* entry) {
+        *entry->fFreed += 1;
+        SkDELETE(entry);
+    }
+
+    int         fKey;
+    size_t      fBytes;
+    int*        fFreed;
+    uint32_t    fHash;
+    Entry*      fHashNext;
+    Entry*      fPrev;
+    Entry*      fNext;
+};
+
+}
+
+typedef SkTLRUCache<Entry, int> Cache;
+
+static bool contains(const Cache& cache, int key) {
+    return NULL != cache.lookup(key, key % 3);
+}
+
+static void TestLRUCache(skiatest::Reporter* reporter) {
+    int freed = 0;
+    Cache cache(100);
+
+    // More entries than the initial bucket count, so that the table grows
+    for (int i = 0; i < 80; ++i) {
+        cache.add(SkNEW_ARGS(Entry, (i, 1, &freed)));
+    }
+    REPORTER_ASSERT(reporter, 80 == cache.getBytesUsed());
+    for (int i = 0; i < 80; ++i) {
+        REPORTER_ASSERT(reporter, contains(cache, i));
+    }
+
+    // Using the oldest entry saves it from the next purge
+    REPORTER_ASSERT(reporter, NULL != cache.find(0, 0));
+    REPORTER_ASSERT(reporter, NULL == cache.find(80, 80 % 3));
+    REPORTER_ASSERT(reporter, 1 == cache.getHitCount());
+    REPORTER_ASSERT(reporter, 1 == cache.getMissCount());
+
+    cache.add(SkNEW_ARGS(Entry, (80, 30, &freed)));
+    REPORTER_ASSERT(reporter, 10 == freed);
+    REPORTER_ASSERT(reporter, 100 == cache.getBytesUsed());
+    REPORTER_ASSERT(reporter, contains(cache, 0));
+    for (int i = 1; i <= 10; ++i) {
+        REPORTER_ASSERT(reporter, !contains(cache, i));
+    }
+    REPORTER_ASSERT(reporter, contains(cache, 11));
+    REPORTER_ASSERT(reporter, contains(cache, 80));
+
+    REPORTER_ASSERT(reporter, 100 == cache.setLimit(50));
+    REPORTER_ASSERT(reporter, cache.getBytesUsed() <= 50);
+    REPORTER_ASSERT(reporter, contains(cache, 80));
+
+    cache.purgeAll();
+    REPORTER_ASSERT(reporter, 0 == cache.getBytesUsed());
+    REPORTER_ASSERT(reporter, 81 == freed);
+}
+
+#include "TestClassDef.h"
+DEFINE_TESTCLASS("LRUCache", LRUCacheTestClass, TestLRUCache)
@@ -0,0 +1,152 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "Test.h"
+#include "SkBitmap.h"
+#include "SkBlurMaskFilter.h"
+#include "SkCanvas.h"
+#include "SkGraphics.h"
+#include "SkMaskCache.h"
+#include "SkPath.h"
+
+static const int kSize = 64;
+
+static void make_shadow_paint(SkPaint* paint) {
+    paint->setAntiAlias(true);
+    paint->setColor(SK_ColorBLACK);
+    paint->setMaskFilter(SkBlurMaskFilter::Create(SkIntToScalar(3),
+                                                  SkBlurMaskFilter::kNormal_BlurStyle))->unref();
+}
+
+static void make_icon_path(SkPath* path) {
+    path->addRoundRect(SkRect::MakeLTRB(10, 10, 30, 26), 5, 5);
+    path->addCircle(24, 20, 6);
+}
+
+static void draw(const SkPath& path, const SkPaint& paint, SkScalar dx, SkScalar dy,
+                 SkBitmap* bm) {
+    bm->setConfig(SkBitmap::kARGB_8888_Config, kSize, kSize);
+    bm->allocPixels();
+    bm->eraseColor(SK_ColorWHITE);
+    SkCanvas canvas(*bm);
+    canvas.translate(dx, dy);
+    canvas.drawPath(path, paint);
+}
+
+// Returns true if 'a' drawn at an offset of (dx, dy) matches 'b' where both are defined
+static bool equal_offset(const SkBitmap& a, const SkBitmap& b, int dx, int dy) {
+    SkAutoLockPixels alpa(a);
+    SkAutoLockPixels alpb(b);
+    for (int y = SkMax32(0, dy); y < SkMin32(kSize, kSize + dy); ++y) {
+        for (int x = SkMax32(0, dx); x < SkMin32(kSize, kSize + dx); ++x) {
+            if (*a.getAddr32(x - dx, y - dy) != *b.getAddr32(x, y)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static void test_hits(skiatest::Reporter* reporter) {
+    SkPaint paint;
+    make_shadow_paint(&paint);
+    SkPath path;
+    make_icon_path(&path);
+
+    SkGraphics::SetMaskCacheLimit(0);
+    SkBitmap uncached;
+    draw(path, paint, 0, 0, &uncached);
+
+    SkGraphics::SetMaskCacheLimit(1024 * 1024);
+    int hits = SkMaskCache::GetHitCount();
+    int misses = SkMaskCache::GetMissCount();
+    SkBitmap first, second, moved;
+    draw(path, paint, 0, 0, &first);
+    REPORTER_ASSERT(reporter, misses + 1 == SkMaskCache::GetMissCount());
+    REPORTER_ASSERT(reporter, SkGraphics::GetMaskCacheUsed() > 0);
+    draw(path, paint, 0, 0, &second);
+    REPORTER_ASSERT(reporter, hits + 1 == SkMaskCache::GetHitCount());
+
+    // A blurred mask is the same with and without the cache
+    REPORTER_ASSERT(reporter, equal_offset(uncached, first, 0, 0));
+    REPORTER_ASSERT(reporter, equal_offset(first, second, 0, 0));
+
+    // Whole pixel translations reuse the mask
+    draw(path, paint, SkIntToScalar(17), SkIntToScalar(-5), &moved);
+    REPORTER_ASSERT(reporter, hits + 2 == SkMaskCache::GetHitCount());
+    REPORTER_ASSERT(reporter, equal_offset(first, moved, 17, -5));
+
+    // ... but subpixel ones, scales, paint changes and path edits do not
+    draw(path, paint, SK_ScalarHalf, 0, &moved);
+    REPORTER_ASSERT(reporter, misses + 2 == SkMaskCache::GetMissCount());
+
+    SkPaint stroke(paint);
+    stroke.setStyle(SkPaint::kStroke_Style);
+    stroke.setStrokeWidth(2);
+    draw(path, stroke, 0, 0, &moved);
+    REPORTER_ASSERT(reporter, misses + 3 == SkMaskCache::GetMissCount());
+
+    SkPath edited(path);
+    edited.lineTo(0, 0);
+    draw(edited, paint, 0, 0, &moved);
+    REPORTER_ASSERT(reporter, misses + 4 == SkMaskCache::GetMissCount());
+
+    // Antialiased paths without a blur are cached too
+    paint.setMaskFilter(NULL);
+    draw(path, paint, 0, 0, &moved);
+    draw(path, paint, 1, 2, &moved);
+    REPORTER_ASSERT(reporter, misses + 5 == SkMaskCache::GetMissCount());
+    REPORTER_ASSERT(reporter, hits + 3 == SkMaskCache::GetHitCount());
+
+    // Aliased ones are not looked up at all
+    paint.setAntiAlias(false);
+    draw(path, paint, 0, 0, &moved);
+    REPORTER_ASSERT(reporter, misses + 5 == SkMaskCache::GetMissCount());
+    REPORTER_ASSERT(reporter, hits + 3 == SkMaskCache::GetHitCount());
+
+    SkGraphics::PurgeMaskCache();
+    REPORTER_ASSERT(reporter, 0 == SkGraphics::GetMaskCacheUsed());
+}
+
+static void test_budget(skiatest::Reporter* reporter) {
+    static const size_t kLimit = 16 * 1024;
+    SkGraphics::SetMaskCacheLimit(kLimit);
+
+    SkPaint paint;
+    make_shadow_paint(&paint);
+    SkBitmap bm;
+    for (int i = 0; i < 50; ++i) {
+        SkPath path;
+        path.addCircle(32, 32, SkIntToScalar(4 + i % 10));
+        draw(path, paint, 0, 0, &bm);
+        REPORTER_ASSERT(reporter, SkGraphics::GetMaskCacheUsed() <= kLimit);
+    }
+    REPORTER_ASSERT(reporter, SkGraphics::GetMaskCacheUsed() > 0);
+
+    // Lowering the limit purges down to it
+    SkGraphics::SetMaskCacheLimit(kLimit / 4);
+    REPORTER_ASSERT(reporter, SkGraphics::GetMaskCacheUsed() <= kLimit / 4);
+
+    // Masks too big for the budget are still drawn, but not kept
+    SkGraphics::PurgeMaskCache();
+    SkPath big;
+    big.addCircle(32, 32, 30);
+    draw(big, paint, 0, 0, &bm);
+    REPORTER_ASSERT(reporter, 0 == SkGraphics::GetMaskCacheUsed());
+    SkAutoLockPixels alp(bm);
+    REPORTER_ASSERT(reporter, SK_ColorBLACK == *bm.getAddr32(32, 32));
+}
+
+static void TestMaskCache(skiatest::Reporter* reporter) {
+    size_t prevLimit = SkGraphics::GetMaskCacheLimit();
+    test_hits(reporter);
+    test_budget(reporter);
+    SkGraphics::SetMaskCacheLimit(prevLimit);
+}
+
+#include "TestClassDef.h"
+DEFINE_TESTCLASS("MaskCache", MaskCacheTestClass, TestMaskCache)
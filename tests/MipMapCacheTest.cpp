@@ -0,0 +1,217 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "Test.h"
+#include "SkBitmap.h"
+#include "SkBitmapScaler.h"
+#include "SkCanvas.h"
+#include "SkColorPriv.h"
+#include "SkGraphics.h"
+#include "SkMipMapCache.h"
+#include "SkRandom.h"
+
+static void make_bitmap(SkBitmap* bm, int w, int h, SkRandom* rand) {
+    bm->setConfig(SkBitmap::kARGB_8888_Config, w, h);
+    bm->allocPixels();
+    SkAutoLockPixels alp(*bm);
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            unsigned a = rand->nextU() & 0xFF;
+            *bm->getAddr32(x, y) = SkPackARGB32(a, SkAlphaMul(rand->nextU() & 0xFF, a + 1),
+                                                SkAlphaMul(rand->nextU() & 0xFF, a + 1),
+                                                SkAlphaMul(rand->nextU() & 0xFF, a + 1));
+        }
+    }
+}
+
+static void draw_scaled(const SkBitmap& src, SkScalar scale, bool mipMap, SkBitmap* dst) {
+    dst->setConfig(SkBitmap::kARGB_8888_Config, 40, 40);
+    dst->allocPixels();
+    dst->eraseColor(SK_ColorWHITE);
+    SkCanvas canvas(*dst);
+    canvas.scale(scale, scale);
+    SkPaint paint;
+    paint.setFilterBitmap(true);
+    paint.setMipMapBitmap(mipMap);
+    canvas.drawBitmap(src, 0, 0, &paint);
+}
+
+static bool equal_pixels(const SkBitmap& a, const SkBitmap& b) {
+    SkAutoLockPixels alpa(a);
+    SkAutoLockPixels alpb(b);
+    return a.width() == b.width() && a.height() == b.height() &&
+           0 == memcmp(a.getPixels(), b.getPixels(), a.getSize());
+}
+
+// Each mip level averages the 2x2 blocks of the one above it, whatever the row proc
+static void test_levels(skiatest::Reporter* reporter) {
+    SkRandom rand;
+    SkBitmap bm;
+    make_bitmap(&bm, 67, 35, &rand);
+    bm.buildMipMap();
+
+    SkBitmap level;
+    REPORTER_ASSERT(reporter, 1 == bm.extractMipLevel(&level, 2 * SK_Fixed1, 2 * SK_Fixed1));
+    REPORTER_ASSERT(reporter, 33 == level.width() && 17 == level.height());
+
+    SkAutoLockPixels alp(bm);
+    SkAutoLockPixels alpl(level);
+    for (int y = 0; y < level.height(); y++) {
+        for (int x = 0; x < level.width(); x++) {
+            const SkPMColor c[4] = {
+                *bm.getAddr32(2 * x, 2 * y), *bm.getAddr32(2 * x + 1, 2 * y),
+                *bm.getAddr32(2 * x, 2 * y + 1), *bm.getAddr32(2 * x + 1, 2 * y + 1),
+            };
+            for (int shift = 0; shift < 32; shift += 8) {
+                unsigned sum = 0;
+                for (int i = 0; i < 4; i++) {
+                    sum += (c[i] >> shift) & 0xFF;
+                }
+                if ((sum >> 2) != ((*level.getAddr32(x, y) >> shift) & 0xFF)) {
+                    SkString str;
+                    str.printf("mip level pixel (%d, %d) is %08x", x, y, *level.getAddr32(x, y));
+                    reporter->reportFailed(str);
+                    return;
+                }
+            }
+        }
+    }
+}
+
+static void test_cache(skiatest::Reporter* reporter) {
+    SkRandom rand;
+    SkBitmap bm;
+    make_bitmap(&bm, 160, 160, &rand);
+
+    SkGraphics::PurgeMipMapCache();
+    const int hits = SkMipMapCache::GetHitCount();
+    const int misses = SkMipMapCache::GetMissCount();
+
+    // Without the flag, or when not downscaling by 2 or more, there is no lookup
+    SkBitmap plain, cached, again, explicitMips;
+    draw_scaled(bm, SK_Scalar1 / 4, false, &plain);
+    draw_scaled(bm, SK_Scalar1 * 3 / 4, true, &cached);
+    REPORTER_ASSERT(reporter, misses == SkMipMapCache::GetMissCount());
+    REPORTER_ASSERT(reporter, 0 == SkGraphics::GetMipMapCacheUsed());
+
+    // The first draw builds the levels, later ones (also through copies of the
+    // bitmap) reuse them
+    draw_scaled(bm, SK_Scalar1 / 4, true, &cached);
+    REPORTER_ASSERT(reporter, misses + 1 == SkMipMapCache::GetMissCount());
+    REPORTER_ASSERT(reporter, SkGraphics::GetMipMapCacheUsed() > 0);
+    SkBitmap copy(bm);
+    draw_scaled(copy, SK_Scalar1 / 4, true, &again);
+    REPORTER_ASSERT(reporter, hits + 1 == SkMipMapCache::GetHitCount());
+    REPORTER_ASSERT(reporter, equal_pixels(cached, again));
+
+    // ... and they match the ones SkBitmap builds for itself
+    SkBitmap withMips(bm);
+    withMips.buildMipMap();
+    draw_scaled(withMips, SK_Scalar1 / 4, false, &explicitMips);
+    REPORTER_ASSERT(reporter, equal_pixels(cached, explicitMips));
+    REPORTER_ASSERT(reporter, !equal_pixels(cached, plain));
+
+    // Changing the pixels changes the key
+    bm.notifyPixelsChanged();
+    draw_scaled(bm, SK_Scalar1 / 4, true, &again);
+    REPORTER_ASSERT(reporter, misses + 2 == SkMipMapCache::GetMissCount());
+
+    // Volatile bitmaps are not mipped
+    bm.setIsVolatile(true);
+    draw_scaled(bm, SK_Scalar1 / 4, true, &again);
+    REPORTER_ASSERT(reporter, misses + 2 == SkMipMapCache::GetMissCount());
+    REPORTER_ASSERT(reporter, equal_pixels(plain, again));
+
+    SkGraphics::PurgeMipMapCache();
+    REPORTER_ASSERT(reporter, 0 == SkGraphics::GetMipMapCacheUsed());
+}
+
+static void test_budget(skiatest::Reporter* reporter) {
+    // The levels of a 160x160 bitmap take 34120 bytes
+    static const size_t kLimit = 100 * 1024;
+    SkGraphics::SetMipMapCacheLimit(kLimit);
+
+    SkRandom rand;
+    SkBitmap dst;
+    for (int i = 0; i < 10; ++i) {
+        SkBitmap bm;
+        make_bitmap(&bm, 160, 160, &rand);
+        draw_scaled(bm, SK_Scalar1 / 4, true, &dst);
+        REPORTER_ASSERT(reporter, SkGraphics::GetMipMapCacheUsed() <= kLimit);
+    }
+    REPORTER_ASSERT(reporter, SkGraphics::GetMipMapCacheUsed() > 0);
+
+    // Lowering the limit purges down to it, and bitmaps whose levels do not
+    // fit in half of it are drawn from their full size
+    SkGraphics::SetMipMapCacheLimit(kLimit / 4);
+    REPORTER_ASSERT(reporter, 0 == SkGraphics::GetMipMapCacheUsed());
+    SkBitmap bm, plain;
+    make_bitmap(&bm, 160, 160, &rand);
+    draw_scaled(bm, SK_Scalar1 / 4, true, &dst);
+    draw_scaled(bm, SK_Scalar1 / 4, false, &plain);
+    REPORTER_ASSERT(reporter, 0 == SkGraphics::GetMipMapCacheUsed());
+    REPORTER_ASSERT(reporter, equal_pixels(plain, dst));
+}
+
+static void draw_resampled(const SkBitmap& src, int width, int height, SkBitmap* dst) {
+    dst->setConfig(SkBitmap::kARGB_8888_Config, width, height);
+    dst->allocPixels();
+    dst->eraseColor(SK_ColorTRANSPARENT);
+    SkCanvas canvas(*dst);
+    SkPaint paint;
+    paint.setFilterBitmap(true);
+    paint.setHighQualityFilterBitmap(true);
+    paint.setXfermodeMode(SkXfermode::kSrc_Mode);
+    canvas.drawBitmapRect(src, NULL, SkRect::MakeWH(SkIntToScalar(width),
+                                                    SkIntToScalar(height)), &paint);
+}
+
+// High quality filtering resamples a bitmap once per size it is drawn at
+static void test_resampled(skiatest::Reporter* reporter) {
+    SkRandom rand;
+    SkBitmap bm;
+    make_bitmap(&bm, 20, 30, &rand);
+
+    SkGraphics::PurgeMipMapCache();
+    const int hits = SkMipMapCache::GetHitCount();
+    const int misses = SkMipMapCache::GetMissCount();
+
+    SkBitmap expected, first, again;
+    REPORTER_ASSERT(reporter, SkBitmapScaler::Resize(&expected, bm, 50, 15,
+                                                     SkBitmapScaler::kMitchell_ResizeMethod));
+    draw_resampled(bm, 50, 15, &first);
+    REPORTER_ASSERT(reporter, misses + 1 == SkMipMapCache::GetMissCount());
+    REPORTER_ASSERT(reporter, 50 * 15 * 4 == SkGraphics::GetMipMapCacheUsed());
+    draw_resampled(bm, 50, 15, &again);
+    REPORTER_ASSERT(reporter, hits + 1 == SkMipMapCache::GetHitCount());
+    REPORTER_ASSERT(reporter, equal_pixels(expected, first));
+    REPORTER_ASSERT(reporter, equal_pixels(expected, again));
+
+    // Another size is another entry
+    draw_resampled(bm, 40, 60, &again);
+    REPORTER_ASSERT(reporter, misses + 2 == SkMipMapCache::GetMissCount());
+
+    // Volatile bitmaps are still resampled, but not cached
+    bm.setIsVolatile(true);
+    draw_resampled(bm, 50, 15, &again);
+    REPORTER_ASSERT(reporter, misses + 2 == SkMipMapCache::GetMissCount());
+    REPORTER_ASSERT(reporter, equal_pixels(expected, again));
+
+    SkGraphics::PurgeMipMapCache();
+}
+
+static void TestMipMapCache(skiatest::Reporter* reporter) {
+    size_t prevLimit = SkGraphics::GetMipMapCacheLimit();
+    test_levels(reporter);
+    test_cache(reporter);
+    test_budget(reporter);
+    test_resampled(reporter);
+    SkGraphics::SetMipMapCacheLimit(prevLimit);
+}
+
+#include "TestClassDef.h"
+DEFINE_TESTCLASS("MipMapCache", MipMapCacheTestClass, TestMipMapCache)
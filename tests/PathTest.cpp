@@ -2273,6 +2273,43 @@ static void test_oval(skiatest::Reporter* reporter) {
     REPORTER_ASSERT(reporter, path.isOval(NULL));
 }
 
+static void test_generation_id(skiatest::Reporter* reporter) {
+    SkPath a, b;
+    // empty paths share an ID
+    REPORTER_ASSERT(reporter, a.getGenerationID() == b.getGenerationID());
+
+    a.addCircle(10, 10, 5);
+    uint32_t id = a.getGenerationID();
+    REPORTER_ASSERT(reporter, id != b.getGenerationID());
+    REPORTER_ASSERT(reporter, id == a.getGenerationID());
+
+    // copies share their contents, and so their ID
+    b = a;
+    REPORTER_ASSERT(reporter, id == b.getGenerationID());
+
+    // editing a copy leaves the original's ID alone
+    b.lineTo(20, 20);
+    REPORTER_ASSERT(reporter, id != b.getGenerationID());
+    REPORTER_ASSERT(reporter, id == a.getGenerationID());
+
+    // the fill type is part of the ID, and restoring it restores the ID
+    a.setFillType(SkPath::kEvenOdd_FillType);
+    REPORTER_ASSERT(reporter, id != a.getGenerationID());
+    a.toggleInverseFillType();
+    REPORTER_ASSERT(reporter, id != a.getGenerationID());
+    a.setFillType(SkPath::kWinding_FillType);
+    REPORTER_ASSERT(reporter, id == a.getGenerationID());
+
+    // transforming a path in place changes its points
+    SkMatrix matrix;
+    matrix.setScale(2, 2);
+    a.transform(matrix);
+    REPORTER_ASSERT(reporter, id != a.getGenerationID());
+
+    a.reset();
+    REPORTER_ASSERT(reporter, a.getGenerationID() == SkPath().getGenerationID());
+}
+
 static void TestPath(skiatest::Reporter* reporter) {
     SkTSize<SkScalar>::Make(3,4);
 
@@ -2377,6 +2414,7 @@ static void TestPath(skiatest::Reporter* reporter) {
     test_clipped_cubic();
     test_crbug_170666();
     test_bad_cubic_crbug229478();
+    test_generation_id(reporter);
 }
 
 #include "TestClassDef.h"
@@ -8,14 +8,20 @@
 #include "SkCanvas.h"
 #include "SkColorPriv.h"
 #include "SkData.h"
+#include "SkFlate.h"
 #include "SkPaint.h"
 #include "SkPicture.h"
 #include "SkRandom.h"
 #include "SkRRect.h"
 #include "SkShader.h"
 #include "SkStream.h"
+#include "SkTypeface.h"
 
 #include "SkPictureUtils.h"
+#include "SkBlurDrawLooper.h"
+#include "SkGradientShader.h"
+#include "SkRunnable.h"
+#include "SkThreadPool.h"
 
 static void make_bm(SkBitmap* bm, int w, int h, SkColor color, bool immutable) {
     bm->setConfig(SkBitmap::kARGB_8888_Config, w, h);
@@ -419,6 +425,574 @@ static void test_clone_empty(skiatest::Reporter* reporter) {
     }
 }
 
+// Records a picture whose paints keep state while drawing (gradient and bitmap shaders, a
+// looper), plus a nested picture that does the same.
+static void make_stateful_picture(SkPicture* picture) {
+    static const int kSize = 64;
+    SkBitmap bm;
+    make_bm(&bm, 8, 8, SK_ColorGREEN, true);
+
+    SkPoint pts[] = { { 0, 0 }, { SkIntToScalar(kSize), SkIntToScalar(kSize) } };
+    SkColor colors[] = { SK_ColorRED, SK_ColorBLUE };
+    SkPaint gradient;
+    gradient.setShader(SkGradientShader::CreateLinear(pts, colors, NULL, 2,
+                                                      SkShader::kMirror_TileMode))->unref();
+    SkPaint tiled;
+    tiled.setShader(SkShader::CreateBitmapShader(bm, SkShader::kRepeat_TileMode,
+                                                 SkShader::kRepeat_TileMode))->unref();
+    SkPaint shadowed;
+    shadowed.setLooper(SkNEW_ARGS(SkBlurDrawLooper, (SkIntToScalar(2), SkIntToScalar(3),
+                                                     SkIntToScalar(3), 0x80000000)))->unref();
+
+    // Held by the outer picture, so must not live on the stack
+    SkAutoTUnref<SkPicture> nested(SkNEW(SkPicture));
+    SkCanvas* canvas = nested->beginRecording(kSize, kSize);
+    canvas->drawRect(SkRect::MakeWH(SkIntToScalar(kSize), SkIntToScalar(kSize / 2)), tiled);
+    nested->endRecording();
+
+    canvas = picture->beginRecording(kSize, kSize);
+    canvas->drawPaint(gradient);
+    canvas->drawBitmap(bm, SkIntToScalar(4), SkIntToScalar(40));
+    canvas->save();
+    canvas->translate(0, SkIntToScalar(kSize / 4));
+    canvas->drawPicture(*nested);
+    canvas->restore();
+    canvas->drawRect(SkRect::MakeXYWH(SkIntToScalar(20), SkIntToScalar(20),
+                                      SkIntToScalar(20), SkIntToScalar(20)), shadowed);
+    for (int i = 0; i < 16; ++i) {
+        canvas->drawCircle(SkIntToScalar(4 * i), SkIntToScalar(48), SkIntToScalar(10), gradient);
+        canvas->drawRect(SkRect::MakeXYWH(SkIntToScalar(4 * i), SkIntToScalar(4 * i),
+                                          SkIntToScalar(8), SkIntToScalar(8)), tiled);
+    }
+    picture->endRecording();
+}
+
+static void draw_to(SkPicture* picture, SkBitmap* bm, int scale = 1) {
+    make_bm(bm, picture->width() * scale, picture->height() * scale, SK_ColorWHITE, false);
+    SkCanvas canvas(*bm);
+    canvas.scale(SkIntToScalar(scale), SkIntToScalar(scale));
+    picture->draw(&canvas);
+}
+
+static bool same_pixels(const SkBitmap& a, const SkBitmap& b) {
+    SkAutoLockPixels alpa(a);
+    SkAutoLockPixels alpb(b);
+    return a.getSize() == b.getSize() && 0 == memcmp(a.getPixels(), b.getPixels(), a.getSize());
+}
+
+namespace {
+
+// Draws the picture into a canvas of its own, several times. Each drawer uses a different scale,
+// so that drawers sharing a shader would disturb each other's shading.
+class SharedDrawer : public SkRunnable {
+public:
+    SharedDrawer() : fPicture(NULL), fScale(1), fMatches(true) {}
+
+    virtual void run() SK_OVERRIDE {
+        for (int i = 0; i < 10; ++i) {
+            SkBitmap bm;
+            draw_to(fPicture, &bm, fScale);
+            fMatches = fMatches && same_pixels(bm, fExpected);
+        }
+    }
+
+    SkPicture*  fPicture;
+    int         fScale;
+    SkBitmap    fExpected;
+    bool        fMatches;
+};
+
+// Plays the picture back again, on the same thread, from inside the first drawRect of a
+// playback of that picture. The inner draw is forced to use a second set of draw state.
+class ReentrantCanvas : public SkCanvas {
+public:
+    ReentrantCanvas(const SkBitmap& bm, SkPicture* picture, SkBitmap* inner)
+        : INHERITED(bm), fPicture(picture), fInner(inner) {}
+
+    virtual void drawRect(const SkRect& r, const SkPaint& paint) SK_OVERRIDE {
+        if (NULL != fPicture) {
+            SkPicture* picture = fPicture;
+            fPicture = NULL;
+            draw_to(picture, fInner);
+        }
+        this->INHERITED::drawRect(r, paint);
+    }
+
+private:
+    SkPicture*  fPicture;
+    SkBitmap*   fInner;
+
+    typedef SkCanvas INHERITED;
+};
+
+}
+
+// Draws picture on several threads at once, and checks that each draw matches reference.
+static void draw_on_threads(skiatest::Reporter* reporter, SkPicture* picture,
+                            SkPicture* reference) {
+    static const int kThreads = 4;
+    SharedDrawer drawers[kThreads];
+    SkRunnable* runnables[kThreads];
+    for (int i = 0; i < kThreads; ++i) {
+        drawers[i].fPicture = picture;
+        drawers[i].fScale = 1 + i;
+        draw_to(reference, &drawers[i].fExpected, drawers[i].fScale);
+        runnables[i] = &drawers[i];
+    }
+    {
+        SkThreadPool pool(kThreads);
+        SkThreadPool::Group group(&pool);
+        group.add(runnables, kThreads);
+        group.wait();
+    }
+    for (int i = 0; i < kThreads; ++i) {
+        REPORTER_ASSERT(reporter, drawers[i].fMatches);
+    }
+}
+
+static void test_shared_draw(skiatest::Reporter* reporter) {
+    SkPicture picture;
+    make_stateful_picture(&picture);
+
+    SkBitmap expected;
+    draw_to(&picture, &expected);
+
+    SkBitmap outer, inner;
+    make_bm(&outer, picture.width(), picture.height(), SK_ColorWHITE, false);
+    {
+        ReentrantCanvas canvas(outer, &picture, &inner);
+        picture.draw(&canvas);
+    }
+    REPORTER_ASSERT(reporter, same_pixels(outer, expected));
+    REPORTER_ASSERT(reporter, same_pixels(inner, expected));
+
+    draw_on_threads(reporter, &picture, &picture);
+}
+
+// Draws with the same paint objects over and over, changing them, and the shader one of them
+// holds, in between.
+static void draw_reused_paints(SkCanvas* canvas) {
+    SkPaint paint;
+    for (int i = 0; i < 8; ++i) {
+        paint.setColor(i & 1 ? SK_ColorRED : SK_ColorBLUE);
+        canvas->drawRect(SkRect::MakeXYWH(SkIntToScalar(8 * i), 0, SkIntToScalar(8),
+                                          SkIntToScalar(8)), paint);
+        canvas->drawRect(SkRect::MakeXYWH(SkIntToScalar(8 * i), SkIntToScalar(8),
+                                          SkIntToScalar(8), SkIntToScalar(8)), paint);
+    }
+
+    SkPoint pts[] = { { 0, 0 }, { SkIntToScalar(16), 0 } };
+    SkColor colors[] = { SK_ColorGREEN, SK_ColorBLACK };
+    SkShader* shader = SkGradientShader::CreateLinear(pts, colors, NULL, 2,
+                                                      SkShader::kClamp_TileMode);
+    SkPaint gradient;
+    gradient.setShader(shader)->unref();
+    for (int i = 0; i < 4; ++i) {
+        SkMatrix matrix;
+        matrix.setTranslate(SkIntToScalar(16 * i), 0);
+        shader->setLocalMatrix(matrix);
+        canvas->drawRect(SkRect::MakeXYWH(SkIntToScalar(16 * i), SkIntToScalar(16),
+                                          SkIntToScalar(16), SkIntToScalar(16)), gradient);
+    }
+}
+
+static void test_reused_paints(skiatest::Reporter* reporter) {
+    static const int kSize = 64;
+    SkBitmap expected, actual;
+    make_bm(&expected, kSize, kSize, SK_ColorWHITE, false);
+    {
+        SkCanvas canvas(expected);
+        draw_reused_paints(&canvas);
+    }
+
+    SkPicture picture;
+    draw_reused_paints(picture.beginRecording(kSize, kSize));
+    picture.endRecording();
+    draw_to(&picture, &actual);
+
+    REPORTER_ASSERT(reporter, same_pixels(expected, actual));
+}
+
+static void draw_optimizable_scene(SkCanvas* canvas, const SkBitmap& bm) {
+    SkPaint opaque;
+    opaque.setColor(SK_ColorWHITE);
+    SkPaint red;
+    red.setColor(SK_ColorRED);
+    SkPaint aa(red);
+    aa.setAntiAlias(true);
+    SkPaint blue;
+    blue.setColor(SkColorSetARGB(0x80, 0, 0, 0xFF));
+
+    // Covered by the background that follows: culled, except for the anti-aliased oval
+    canvas->drawRect(SkRect::MakeXYWH(10, 10, 20, 20), red);
+    canvas->drawBitmap(bm, 40, 40);
+    canvas->drawOval(SkRect::MakeXYWH(50, 10, 20, 20), aa);
+    canvas->drawRect(SkRect::MakeWH(100, 100), opaque);
+
+    // Translates that can be folded into the draws, leaving an empty save
+    canvas->save();
+    canvas->translate(10, 20);
+    canvas->drawRect(SkRect::MakeWH(10, 10), red);
+    canvas->drawOval(SkRect::MakeWH(10, 10), aa);
+    canvas->drawText("Hi", 2, 0, 20, red);
+    canvas->restore();
+    canvas->translate(30, 5);
+    canvas->drawBitmap(bm, 5, 5);
+    canvas->translate(-30, -5);
+
+    // A run of rects with one paint, to be batched
+    for (int i = 0; i < 8; ++i) {
+        canvas->drawRect(SkRect::MakeXYWH(SkIntToScalar(10 * i), 60, 8, 8), blue);
+    }
+
+    // Saves that are still needed: one clips, and the clip of the other outlives its restore
+    canvas->save();
+    canvas->clipRect(SkRect::MakeXYWH(0, 70, 50, 30));
+    canvas->drawOval(SkRect::MakeXYWH(0, 70, 100, 30), blue);
+    canvas->restore();
+    canvas->save();
+    canvas->save(SkCanvas::kMatrix_SaveFlag);
+    canvas->clipRect(SkRect::MakeXYWH(50, 70, 50, 30));
+    canvas->drawRect(SkRect::MakeXYWH(50, 70, 10, 10), red);
+    canvas->restore();
+    canvas->translate(50, 0);
+    canvas->drawPaint(blue);
+    canvas->restore();
+}
+
+namespace {
+
+// Counts the calls that the op stream optimizer is expected to remove
+class OpCountingCanvas : public SkCanvas {
+public:
+    OpCountingCanvas(const SkBitmap& bm) : INHERITED(bm), fSaves(0), fTranslates(0), fRects(0) {}
+
+    virtual int save(SaveFlags flags) SK_OVERRIDE {
+        ++fSaves;
+        return this->INHERITED::save(flags);
+    }
+    virtual bool translate(SkScalar dx, SkScalar dy) SK_OVERRIDE {
+        ++fTranslates;
+        return this->INHERITED::translate(dx, dy);
+    }
+    virtual void drawRect(const SkRect& r, const SkPaint& paint) SK_OVERRIDE {
+        ++fRects;
+        this->INHERITED::drawRect(r, paint);
+    }
+
+    int fSaves;
+    int fTranslates;
+    int fRects;
+
+private:
+    typedef SkCanvas INHERITED;
+};
+
+}
+
+static void test_optimized_playback(skiatest::Reporter* reporter) {
+    SkBitmap bm;
+    make_bm(&bm, 10, 10, SK_ColorGREEN, true);
+
+    SkPicture optimized;
+    draw_optimizable_scene(optimized.beginRecording(100, 100), bm);
+    optimized.endRecording();
+
+    SkPicture unoptimized;
+    draw_optimizable_scene(unoptimized.beginRecording(100, 100,
+                           SkPicture::kDisableRecordOptimizations_RecordingFlag), bm);
+    unoptimized.endRecording();
+
+    for (int scale = 1; scale <= 2; ++scale) {
+        SkBitmap expected, actual;
+        draw_to(&unoptimized, &expected, scale);
+        draw_to(&optimized, &actual, scale);
+        REPORTER_ASSERT(reporter, same_pixels(expected, actual));
+    }
+
+    // The optimized picture still draws each of its rects, but no longer the covered one. With
+    // the translates folded into the draws, neither the first save nor the one the recorder
+    // wraps around the whole picture is needed any more.
+    SkBitmap dst;
+    make_bm(&dst, 100, 100, SK_ColorWHITE, false);
+    OpCountingCanvas before(dst), after(dst);
+    unoptimized.draw(&before);
+    optimized.draw(&after);
+    REPORTER_ASSERT(reporter, after.fSaves == before.fSaves - 2);
+    REPORTER_ASSERT(reporter, after.fTranslates == before.fTranslates - 3);
+    REPORTER_ASSERT(reporter, after.fRects == before.fRects - 1);
+
+    // The optimized stream survives serialization
+    SkDynamicMemoryWStream stream;
+    optimized.serialize(&stream);
+    SkAutoTUnref<SkData> data(stream.copyToData());
+    SkMemoryStream rstream(data);
+    SkPicture deserialized(&rstream);
+    SkBitmap expected, actual;
+    draw_to(&unoptimized, &expected);
+    draw_to(&deserialized, &actual);
+    REPORTER_ASSERT(reporter, same_pixels(expected, actual));
+}
+
+static void draw_occluded_scene(SkCanvas* canvas, const SkBitmap& bm) {
+    SkPaint opaque;
+    opaque.setColor(SK_ColorWHITE);
+    SkPaint red;
+    red.setColor(SK_ColorRED);
+    SkPaint aa(red);
+    aa.setAntiAlias(true);
+    SkPaint translucent;
+    translucent.setAlpha(0x80);
+
+    // Covered by the background that follows, so skipped when culling
+    canvas->drawRect(SkRect::MakeXYWH(10, 10, 20, 20), red);
+    canvas->drawBitmap(bm, 40, 40);
+    canvas->drawOval(SkRect::MakeXYWH(50, 10, 20, 20), aa);
+    canvas->drawRect(SkRect::MakeWH(100, 100), opaque);
+
+    // The recorder only sees the bounds of the clip path, so the rect does not hide the corners
+    canvas->drawRect(SkRect::MakeXYWH(105, 5, 10, 10), red);
+    canvas->save();
+    SkPath circle;
+    circle.addCircle(150, 50, 45);
+    canvas->clipPath(circle);
+    canvas->drawRect(SkRect::MakeXYWH(100, 0, 100, 100), opaque);
+    canvas->restore();
+
+    // Nothing drawn into a layer hides what is under the layer
+    canvas->drawRect(SkRect::MakeXYWH(120, 60, 10, 10), red);
+    canvas->saveLayer(NULL, &translucent);
+    canvas->drawRect(SkRect::MakeXYWH(100, 50, 100, 50), opaque);
+    canvas->restore();
+}
+
+namespace {
+
+// Counts the drawRect and drawBitmap calls that reach the canvas
+class DrawCountingCanvas : public SkCanvas {
+public:
+    DrawCountingCanvas(const SkBitmap& bm) : INHERITED(bm), fRects(0), fBitmaps(0) {}
+
+    virtual void drawRect(const SkRect& r, const SkPaint& paint) SK_OVERRIDE {
+        ++fRects;
+        this->INHERITED::drawRect(r, paint);
+    }
+    virtual void drawBitmap(const SkBitmap& bitmap, SkScalar left, SkScalar top,
+                            const SkPaint* paint) SK_OVERRIDE {
+        ++fBitmaps;
+        this->INHERITED::drawBitmap(bitmap, left, top, paint);
+    }
+
+    int fRects;
+    int fBitmaps;
+
+private:
+    typedef SkCanvas INHERITED;
+};
+
+}
+
+static void draw_tile_to(SkPicture* picture, SkBitmap* bm, int x, int y, int size) {
+    make_bm(bm, size, size, SK_ColorWHITE, false);
+    SkCanvas canvas(*bm);
+    canvas.translate(-SkIntToScalar(x), -SkIntToScalar(y));
+    picture->draw(&canvas);
+}
+
+static void test_cull_occluded_draws(skiatest::Reporter* reporter) {
+    SkBitmap bm;
+    make_bm(&bm, 10, 10, SK_ColorGREEN, true);
+
+    static const uint32_t kFlags = SkPicture::kOptimizeForClippedPlayback_RecordingFlag |
+                                   SkPicture::kUsePathBoundsForClip_RecordingFlag;
+    SkPicture culled;
+    draw_occluded_scene(culled.beginRecording(200, 100,
+                        kFlags | SkPicture::kCullOccludedDraws_RecordingFlag), bm);
+    culled.endRecording();
+
+    SkPicture unculled;
+    draw_occluded_scene(unculled.beginRecording(200, 100, kFlags), bm);
+    unculled.endRecording();
+
+    // Culling only applies to integer translates, but must not change anything at other scales
+    for (int scale = 1; scale <= 2; ++scale) {
+        SkBitmap expected, actual;
+        draw_to(&unculled, &expected, scale);
+        draw_to(&culled, &actual, scale);
+        REPORTER_ASSERT(reporter, same_pixels(expected, actual));
+    }
+    for (int y = -10; y < 100; y += 30) {
+        for (int x = -10; x < 200; x += 30) {
+            SkBitmap expected, actual;
+            draw_tile_to(&unculled, &expected, x, y, 40);
+            draw_tile_to(&culled, &actual, x, y, 40);
+            REPORTER_ASSERT(reporter, same_pixels(expected, actual));
+        }
+    }
+
+    // The rect and bitmap under the background are skipped, and nothing else is
+    SkBitmap dst;
+    make_bm(&dst, 200, 100, SK_ColorWHITE, false);
+    DrawCountingCanvas before(dst), after(dst);
+    unculled.draw(&before);
+    culled.draw(&after);
+    REPORTER_ASSERT(reporter, after.fRects == before.fRects - 1);
+    REPORTER_ASSERT(reporter, after.fBitmaps == before.fBitmaps - 1);
+}
+
+// Adds text, in two typefaces, and paths to the stateful picture, so that every section of the
+// serialized picture has something in it.
+static void make_serialized_picture(SkPicture* picture) {
+    // Held by the outer picture, so must not live on the stack
+    SkAutoTUnref<SkPicture> stateful(SkNEW(SkPicture));
+    make_stateful_picture(stateful);
+
+    SkCanvas* canvas = picture->beginRecording(stateful->width(), stateful->height());
+    canvas->drawPicture(*stateful);
+
+    SkPaint paint;
+    paint.setAntiAlias(true);
+    paint.setTextSize(SkIntToScalar(12));
+    canvas->drawText("Lazy", 4, SkIntToScalar(2), SkIntToScalar(12), paint);
+    SkAutoTUnref<SkTypeface> bold(SkTypeface::CreateFromName(NULL, SkTypeface::kBold));
+    paint.setTypeface(bold);
+    canvas->drawText("Mapped", 6, SkIntToScalar(2), SkIntToScalar(60), paint);
+
+    SkPath path;
+    path.moveTo(SkIntToScalar(10), SkIntToScalar(10));
+    path.quadTo(SkIntToScalar(60), SkIntToScalar(0), SkIntToScalar(50), SkIntToScalar(50));
+    path.close();
+    paint.setStyle(SkPaint::kStroke_Style);
+    paint.setStrokeWidth(SkIntToScalar(3));
+    canvas->clipPath(path, SkRegion::kDifference_Op, true);
+    for (int i = 0; i < 8; ++i) {
+        paint.setColor(SkColorSetARGB(0xFF, 0x20 * i, 0, 0xFF - 0x20 * i));
+        canvas->translate(SkIntToScalar(1), SkIntToScalar(1));
+        canvas->drawPath(path, paint);
+    }
+    picture->endRecording();
+}
+
+static void check_deserialized(skiatest::Reporter* reporter, SkStream* stream,
+                               SkPicture* reference) {
+    SkPicture picture(stream);
+    // Unflattens the paints and paths for the first time on several threads at once
+    draw_on_threads(reporter, &picture, reference);
+
+    SkBitmap expected, actual;
+    draw_to(reference, &expected);
+    draw_to(&picture, &actual);
+    REPORTER_ASSERT(reporter, same_pixels(expected, actual));
+}
+
+static void test_mapped_playback(skiatest::Reporter* reporter) {
+    SkPicture picture;
+    make_serialized_picture(&picture);
+
+    SkDynamicMemoryWStream wStream;
+    picture.serialize(&wStream);
+    SkAutoDataUnref data(wStream.copyToData());
+
+    // Read in place, as from a mapped file: the picture keeps the data alive
+    const int32_t refCnt = data->getRefCnt();
+    {
+        SkMemoryStream* stream = SkNEW_ARGS(SkMemoryStream, (data));
+        SkPicture deserialized(stream);
+        stream->unref();
+        REPORTER_ASSERT(reporter, data->getRefCnt() > refCnt);
+        SkBitmap expected, actual;
+        draw_to(&picture, &expected);
+        draw_to(&deserialized, &actual);
+        REPORTER_ASSERT(reporter, same_pixels(expected, actual));
+    }
+    REPORTER_ASSERT(reporter, refCnt == data->getRefCnt());
+    {
+        SkMemoryStream stream(data);
+        check_deserialized(reporter, &stream, &picture);
+    }
+
+    // Misaligned data is copied
+    {
+        SkAutoMalloc storage(data->size() + 2);
+        memcpy((char*)storage.get() + 2, data->data(), data->size());
+        SkAutoDataUnref misaligned(SkData::NewWithCopy(storage.get(), data->size() + 2));
+        SkAutoDataUnref subset(SkData::NewSubset(misaligned, 2, data->size()));
+        SkMemoryStream stream(subset);
+        check_deserialized(reporter, &stream, &picture);
+    }
+
+    // So is memory that the stream does not own
+    {
+        SkMemoryStream stream(data->data(), data->size(), false);
+        check_deserialized(reporter, &stream, &picture);
+    }
+}
+
+// Reads the playback with a player of its own, as the debugger's pictures do
+class CountingPlaybackPicture : public SkPicture {
+public:
+    CountingPlaybackPicture(SkStream* stream, bool* success) : fPlaybackCount(0) {
+        this->initFromStream(stream, success, NULL);
+    }
+
+    int fPlaybackCount;
+
+protected:
+    virtual SkPicturePlayback* createPlayback(SkStream* stream, const SkPictInfo& info,
+                                              InstallPixelRefProc proc) SK_OVERRIDE {
+        ++fPlaybackCount;
+        return this->INHERITED::createPlayback(stream, info, proc);
+    }
+
+private:
+    typedef SkPicture INHERITED;
+};
+
+static void test_compressed_playback(skiatest::Reporter* reporter) {
+    static const uint32_t kMarker = 0x600DF00D;
+
+    SkPicture picture;
+    make_serialized_picture(&picture);
+
+    SkDynamicMemoryWStream plain;
+    picture.serialize(&plain);
+    SkDynamicMemoryWStream compressed;
+    picture.serialize(&compressed, NULL, SkPicture::kCompress_SerializeFlag);
+    if (!SkFlate::HaveFlate()) {
+        REPORTER_ASSERT(reporter, plain.getOffset() == compressed.getOffset());
+        return;
+    }
+    REPORTER_ASSERT(reporter, compressed.getOffset() < plain.getOffset());
+
+    // The picture can be followed by something else, which is not read
+    compressed.write32(kMarker);
+    SkAutoDataUnref data(compressed.copyToData());
+    {
+        SkMemoryStream stream(data);
+        check_deserialized(reporter, &stream, &picture);
+        REPORTER_ASSERT(reporter, kMarker == stream.readU32());
+    }
+    {
+        // Derived pictures read their own players from compressed data too
+        SkMemoryStream stream(data);
+        bool success;
+        CountingPlaybackPicture derived(&stream, &success);
+        REPORTER_ASSERT(reporter, success);
+        REPORTER_ASSERT(reporter, 1 == derived.fPlaybackCount);
+        REPORTER_ASSERT(reporter, kMarker == stream.readU32());
+    }
+
+    SkPicture empty;
+    SkDynamicMemoryWStream emptyStream;
+    empty.serialize(&emptyStream, NULL, SkPicture::kCompress_SerializeFlag);
+    SkAutoDataUnref emptyData(emptyStream.copyToData());
+    SkMemoryStream stream(emptyData);
+    bool success;
+    SkPicture deserialized(&stream, &success, NULL);
+    REPORTER_ASSERT(reporter, success);
+    REPORTER_ASSERT(reporter, 0 == stream.read(NULL, 1));
+}
+
 static void TestPicture(skiatest::Reporter* reporter) {
 #ifdef SK_DEBUG
     test_deleting_empty_playback();
@@ -430,6 +1004,12 @@ static void TestPicture(skiatest::Reporter* reporter) {
     test_gatherpixelrefs(reporter);
     test_bitmap_with_encoded_data(reporter);
     test_clone_empty(reporter);
+    test_shared_draw(reporter);
+    test_reused_paints(reporter);
+    test_optimized_playback(reporter);
+    test_cull_occluded_draws(reporter);
+    test_mapped_playback(reporter);
+    test_compressed_playback(reporter);
 }
 
 #include "TestClassDef.h"
@@ -70,11 +70,26 @@ static bool verify_query(SkIRect query, DataRect rects[],
 
 static void runQueries(skiatest::Reporter* reporter, SkMWCRandom& rand, DataRect rects[],
                        SkRTree& tree) {
+    SkIRect queries[NUM_QUERIES];
     for (size_t i = 0; i < NUM_QUERIES; ++i) {
-        SkTDArray<void*> hits;
-        SkIRect query = random_rect(rand);
-        tree.search(query, &hits);
-        REPORTER_ASSERT(reporter, verify_query(query, rects, hits));
+        queries[i] = random_rect(rand);
+    }
+
+    // Both the packed and the unpacked layout should find exactly the intersecting rects
+    for (int packed = 0; packed < 2; ++packed) {
+        tree.setUsePackedLayout(SkToBool(packed));
+        for (size_t i = 0; i < NUM_QUERIES; ++i) {
+            SkTDArray<void*> hits;
+            tree.search(queries[i], &hits);
+            REPORTER_ASSERT(reporter, verify_query(queries[i], rects, hits));
+        }
+    }
+
+    // As should a batched search over all the queries at once
+    SkTDArray<void*> batchHits[NUM_QUERIES];
+    tree.searchBatch(queries, NUM_QUERIES, batchHits);
+    for (size_t i = 0; i < NUM_QUERIES; ++i) {
+        REPORTER_ASSERT(reporter, verify_query(queries[i], rects, batchHits[i]));
     }
 }
 
@@ -209,11 +209,39 @@ static void TestNullData() {
 
 }
 
+static void TestSharedData(skiatest::Reporter* reporter) {
+    const char s[] = "abcdefghijklmnopqrstuvwxyz";
+    SkAutoDataUnref data(SkData::NewWithCopy(s, sizeof(s)));
+
+    SkMemoryStream stream(data);
+    REPORTER_ASSERT(reporter, 4 == stream.skip(4));
+    SkAutoDataUnref shared(stream.readSharedData(10));
+    REPORTER_ASSERT(reporter, shared.get() && 10 == shared->size());
+    REPORTER_ASSERT(reporter, shared.get() && data->bytes() + 4 == shared->bytes());
+    REPORTER_ASSERT(reporter, 'o' == stream.readS8());
+
+    // Past the end, the stream does not move
+    REPORTER_ASSERT(reporter, NULL == stream.readSharedData(sizeof(s)));
+    REPORTER_ASSERT(reporter, 'p' == stream.readS8());
+
+    // Memory the stream does not own may go away with it, so is never shared
+    SkMemoryStream unowned(s, sizeof(s), false);
+    REPORTER_ASSERT(reporter, NULL == unowned.readSharedData(4));
+    REPORTER_ASSERT(reporter, 'a' == unowned.readS8());
+    SkMemoryStream copied(s, sizeof(s), true);
+    SkAutoDataUnref copiedShared(copied.readSharedData(4));
+    REPORTER_ASSERT(reporter, NULL != copiedShared.get());
+
+    SkFILEStream file(NULL);
+    REPORTER_ASSERT(reporter, NULL == file.readSharedData(0));
+}
+
 static void TestStreams(skiatest::Reporter* reporter) {
     TestRStream(reporter);
     TestWStream(reporter);
     TestPackedUInt(reporter);
     TestNullData();
+    TestSharedData(reporter);
 }
 
 #include "TestClassDef.h"
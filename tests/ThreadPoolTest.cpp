@@ -0,0 +1,101 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "Test.h"
+#include "SkRunnable.h"
+#include "SkTemplates.h"
+#include "SkThread.h"
+#include "SkThreadPool.h"
+
+namespace {
+
+class Increment : public SkRunnable {
+public:
+    Increment() : fCounter(NULL), fRuns(0) {}
+
+    virtual void run() SK_OVERRIDE {
+        fRuns += 1;
+        sk_atomic_inc(fCounter);
+    }
+
+    int32_t* fCounter;
+    int      fRuns;
+};
+
+// Splits itself in two until fDepth reaches zero, waiting on a group for its halves.
+class ForkJoin : public SkRunnable {
+public:
+    ForkJoin(SkThreadPool* pool, int depth, int32_t* leaves)
+        : fPool(pool), fDepth(depth), fLeaves(leaves) {}
+
+    virtual void run() SK_OVERRIDE {
+        if (0 == fDepth) {
+            sk_atomic_inc(fLeaves);
+            return;
+        }
+        ForkJoin left(fPool, fDepth - 1, fLeaves);
+        ForkJoin right(fPool, fDepth - 1, fLeaves);
+        SkRunnable* halves[] = { &left, &right };
+        SkThreadPool::Group group(fPool);
+        group.add(halves, SK_ARRAY_COUNT(halves));
+        group.wait();
+    }
+
+private:
+    SkThreadPool*   fPool;
+    int             fDepth;
+    int32_t*        fLeaves;
+};
+
+}
+
+static void test_pool(skiatest::Reporter* reporter, int threadCount) {
+    SkThreadPool pool(threadCount);
+    REPORTER_ASSERT(reporter, threadCount == pool.count());
+
+    static const int kCount = 1000;
+    int32_t counter = 0;
+    SkAutoTArray<Increment> increments(kCount);
+    SkAutoTArray<SkRunnable*> runnables(kCount + 1);
+    for (int i = 0; i < kCount; ++i) {
+        increments[i].fCounter = &counter;
+        runnables[i] = &increments[i];
+    }
+    runnables[kCount] = NULL;   // NULL entries are skipped.
+
+    // A batch followed by single adds, all in one group.
+    {
+        SkThreadPool::Group group(&pool);
+        group.add(runnables.get(), kCount / 2 + 1);
+        for (int i = kCount / 2 + 1; i <= kCount; ++i) {
+            group.add(runnables[i]);
+        }
+        group.wait();
+        REPORTER_ASSERT(reporter, kCount == counter);
+        for (int i = 0; i < kCount; ++i) {
+            REPORTER_ASSERT(reporter, 1 == increments[i].fRuns);
+        }
+    }
+
+    // Runnables may wait on groups of their own from inside the pool.
+    int32_t leaves = 0;
+    ForkJoin root(&pool, 8, &leaves);
+    {
+        SkThreadPool::Group group(&pool);
+        group.add(&root);
+    }
+    REPORTER_ASSERT(reporter, (1 << 8) == leaves);
+}
+
+static void TestThreadPool(skiatest::Reporter* reporter) {
+    test_pool(reporter, 0);
+    test_pool(reporter, 1);
+    test_pool(reporter, 4);
+}
+
+#include "TestClassDef.h"
+DEFINE_TESTCLASS("ThreadPool", ThreadPoolTestClass, TestThreadPool)
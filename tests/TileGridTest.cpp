@@ -11,6 +11,7 @@
 #include "SkTileGridPicture.h"
 #include "SkCanvas.h"
 #include "SkDevice.h"
+#include "SkRandom.h"
 
 enum Tile {
     kTopLeft_Tile = 0x1,
@@ -35,6 +36,12 @@ public:
 
     SkTDArray<SkRect> fRects;
 };
+
+// Stand-in for SkPictureStateTree::Draw: data that sorts in insertion order
+struct MockDatum {
+    int fIndex;
+    bool operator<(const MockDatum& other) const { return fIndex < other.fIndex; }
+};
 }
 
 class TileGridTest {
@@ -245,6 +252,57 @@ public:
         }
     }
 
+    static void TestReusedResults(skiatest::Reporter* reporter) {
+        SkTileGridPicture::TileGridInfo info;
+        info.fMargin.set(1, 1);
+        info.fOffset.set(-1, -1);
+        info.fTileInterval.set(8, 8);
+        SkTileGrid grid(4, 4, info, SkTileGridNextDatum<MockDatum>);
+
+        static const int kDatumCount = 40;
+        MockDatum data[kDatumCount];
+        SkMWCRandom rand;
+        for (int i = 0; i < kDatumCount; ++i) {
+            data[i].fIndex = i;
+            grid.insert(&data[i], SkIRect::MakeXYWH(rand.nextULessThan(32),
+                                                    rand.nextULessThan(32),
+                                                    1 + rand.nextULessThan(12),
+                                                    1 + rand.nextULessThan(12)), false);
+        }
+
+        // Grid-aligned tiles, unaligned tiles spanning several grid tiles, and repeats
+        static const int kQueryCount = 12;
+        SkIRect queries[kQueryCount] = {
+            SkIRect::MakeXYWH(0, 0, 10, 10),
+            SkIRect::MakeXYWH(8, 0, 10, 10),
+            SkIRect::MakeXYWH(8, 8, 10, 10),
+            SkIRect::MakeXYWH(0, 0, 10, 10),
+            SkIRect::MakeXYWH(3, 5, 16, 16),
+            SkIRect::MakeXYWH(3, 5, 16, 16),
+            SkIRect::MakeXYWH(20, 2, 12, 30),
+            SkIRect::MakeXYWH(0, 0, 32, 32),
+            SkIRect::MakeXYWH(-5, -5, 4, 4),
+            SkIRect::MakeXYWH(40, 40, 4, 4),
+            SkIRect::MakeXYWH(15, 15, 2, 2),
+            SkIRect::MakeXYWH(0, 0, 32, 32),
+        };
+
+        // Each query's results go in an array that already holds another query's results
+        SkTDArray<void*> reused;
+        grid.search(queries[kQueryCount - 1], &reused);
+        for (int i = 0; i < kQueryCount; ++i) {
+            grid.search(queries[i], &reused);
+            SkTDArray<void*> expected;
+            grid.search(queries[i], &expected);
+            REPORTER_ASSERT(reporter, expected == reused);
+            for (int j = 1; j < reused.count(); ++j) {
+                REPORTER_ASSERT(reporter,
+                    *static_cast<MockDatum*>(reused[j - 1]) <
+                    *static_cast<MockDatum*>(reused[j]));
+            }
+        }
+    }
+
     static void Test(skiatest::Reporter* reporter) {
         // Out of bounds
         verifyTileHits(reporter, SkIRect::MakeXYWH(30, 0, 1, 1),  0);
@@ -275,6 +333,7 @@ public:
 
         TestUnalignedQuery(reporter);
         TestOverlapOffsetQueryAlignment(reporter);
+        TestReusedResults(reporter);
     }
 };
 
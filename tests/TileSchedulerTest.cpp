@@ -0,0 +1,108 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "Test.h"
+#include "SkCanvas.h"
+#include "SkPicture.h"
+#include "SkPictureTileRenderer.h"
+#include "SkThreadPool.h"
+#include "SkTileScheduler.h"
+
+static void test_single_worker_steals_everything(skiatest::Reporter* reporter) {
+    static const int kTileCount = 37;
+    static const int kWorkerCount = 4;
+    SkTileScheduler scheduler(kTileCount, kWorkerCount);
+
+    // Worker 0 has to drain its own run first, in order, and then steal the rest.
+    int claimed[kTileCount] = { 0 };
+    int tile;
+    int count = 0;
+    while (scheduler.nextTile(0, &tile)) {
+        REPORTER_ASSERT(reporter, tile >= 0 && tile < kTileCount);
+        claimed[tile] += 1;
+        if (count < kTileCount / kWorkerCount) {
+            REPORTER_ASSERT(reporter, count == tile);
+            REPORTER_ASSERT(reporter, !scheduler.getStats(tile).fStolen);
+        }
+        count += 1;
+    }
+    REPORTER_ASSERT(reporter, kTileCount == count);
+    for (int i = 0; i < kTileCount; ++i) {
+        REPORTER_ASSERT(reporter, 1 == claimed[i]);
+        REPORTER_ASSERT(reporter, 0 == scheduler.getStats(i).fWorker);
+    }
+    REPORTER_ASSERT(reporter, kTileCount - kTileCount / kWorkerCount == scheduler.countStolen());
+
+    // The other workers find nothing left.
+    for (int i = 1; i < kWorkerCount; ++i) {
+        REPORTER_ASSERT(reporter, !scheduler.nextTile(i, &tile));
+    }
+
+    // After a reset every worker starts on its own run again.
+    scheduler.reset();
+    for (int i = 0; i < kWorkerCount; ++i) {
+        REPORTER_ASSERT(reporter, scheduler.nextTile(i, &tile));
+        REPORTER_ASSERT(reporter, !scheduler.getStats(tile).fStolen);
+    }
+    REPORTER_ASSERT(reporter, 0 == scheduler.countStolen());
+}
+
+// Clipping curved edges can move them by a pixel, so only draw rectangles, which should come out
+// the same whether or not they are split across tiles.
+static SkPicture* make_picture(int width, int height) {
+    SkPicture* picture = SkNEW(SkPicture);
+    SkCanvas* canvas = picture->beginRecording(width, height);
+    SkPaint paint;
+    canvas->drawColor(SK_ColorWHITE);
+    for (int i = 0; i < 20; ++i) {
+        paint.setColor(0x80000000 | (i * 0x0A1B2C));
+        canvas->drawRect(SkRect::MakeXYWH(SkIntToScalar(i * 13 % width),
+                                          SkIntToScalar(i * 29 % height),
+                                          SkIntToScalar(5 + i * 3),
+                                          SkIntToScalar(40 - i)), paint);
+    }
+    picture->endRecording();
+    return picture;
+}
+
+static void test_picture_tile_renderer(skiatest::Reporter* reporter) {
+    static const int kWidth = 150;
+    static const int kHeight = 110;
+    SkAutoTUnref<SkPicture> picture(make_picture(kWidth, kHeight));
+
+    SkBitmap expected;
+    expected.setConfig(SkBitmap::kARGB_8888_Config, kWidth, kHeight);
+    expected.allocPixels();
+    expected.eraseColor(SK_ColorTRANSPARENT);
+    SkCanvas canvas(expected);
+    picture->draw(&canvas);
+
+    SkThreadPool pool(3);
+    SkPictureTileRenderer renderer(picture, 32, 32, 3);
+    REPORTER_ASSERT(reporter, 5 * 4 == renderer.tileCount());
+
+    SkBitmap actual;
+    actual.setConfig(SkBitmap::kARGB_8888_Config, kWidth, kHeight);
+    actual.allocPixels();
+    actual.eraseColor(SK_ColorTRANSPARENT);
+    renderer.draw(&actual, &pool);
+
+    SkAutoLockPixels alpExpected(expected), alpActual(actual);
+    REPORTER_ASSERT(reporter, 0 == memcmp(expected.getPixels(), actual.getPixels(),
+                                          expected.getSize()));
+    for (int i = 0; i < renderer.tileCount(); ++i) {
+        REPORTER_ASSERT(reporter, renderer.getTileStats(i).fWorker >= 0);
+    }
+}
+
+static void TestTileScheduler(skiatest::Reporter* reporter) {
+    test_single_worker_steals_everything(reporter);
+    test_picture_tile_renderer(reporter);
+}
+
+#include "TestClassDef.h"
+DEFINE_TESTCLASS("TileScheduler", TileSchedulerTestClass, TestTileScheduler)
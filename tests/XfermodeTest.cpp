@@ -7,6 +7,8 @@
  */
 #include "Test.h"
 #include "SkColor.h"
+#include "SkColorPriv.h"
+#include "SkRandom.h"
 #include "SkXfermode.h"
 
 static SkPMColor bogusXfermodeProc(SkPMColor src, SkPMColor dst) {
@@ -63,9 +65,64 @@ static void test_IsMode(skiatest::Reporter* reporter) {
     }
 }
 
+static SkPMColor random_pmcolor(SkMWCRandom* rand) {
+    // mostly translucent colors, with some opaque and transparent ones
+    unsigned a = rand->nextULessThan(300);
+    a = a > 255 ? (a > 280 ? 0 : 255) : a;
+    return SkPackARGB32(a, rand->nextULessThan(a + 1), rand->nextULessThan(a + 1),
+                        rand->nextULessThan(a + 1));
+}
+
+// xfer32 (which may blend a span at a time) must match the mode's proc applied pixel by pixel
+static void test_xfer32(skiatest::Reporter* reporter) {
+    static const int kCount = 67;
+    SkMWCRandom rand;
+    SkPMColor src[kCount], dst[kCount], expected[kCount];
+    SkAlpha aa[kCount];
+
+    for (int i = 0; i <= SkXfermode::kLastMode; ++i) {
+        SkXfermode::Mode mode = (SkXfermode::Mode)i;
+        SkXfermode* xfer = SkXfermode::Create(mode);
+        if (NULL == xfer) {
+            continue;
+        }
+        SkXfermodeProc proc = SkXfermode::GetProc(mode);
+
+        // SkClearXfermode scales dst by the coverage, rather than interpolating to 0
+        int aaPasses = SkXfermode::kClear_Mode == mode ? 1 : 2;
+        for (int useAA = 0; useAA < aaPasses; ++useAA) {
+            for (int j = 0; j < kCount; ++j) {
+                src[j] = random_pmcolor(&rand);
+                dst[j] = random_pmcolor(&rand);
+                // runs of 0 and 0xFF coverage, like a blitter would have
+                aa[j] = (j & 8) ? rand.nextU() & 0xFF : ((j & 16) ? 0xFF : 0);
+
+                expected[j] = proc(src[j], dst[j]);
+                if (useAA && 0xFF != aa[j]) {
+                    expected[j] = aa[j] ? SkFourByteInterp(expected[j], dst[j], aa[j]) : dst[j];
+                }
+            }
+            xfer->xfer32(dst, src, kCount, useAA ? aa : NULL);
+
+            bool match = true;
+            for (int j = 0; j < kCount; ++j) {
+                match &= expected[j] == dst[j];
+            }
+            if (!match) {
+                SkString str;
+                str.printf("xfer32 of %s (aa %d) differs from its proc",
+                           SkXfermode::ModeName(mode), useAA);
+                reporter->reportFailed(str);
+            }
+        }
+        xfer->unref();
+    }
+}
+
 static void test_xfermodes(skiatest::Reporter* reporter) {
     test_asMode(reporter);
     test_IsMode(reporter);
+    test_xfer32(reporter);
 }
 
 #include "TestClassDef.h"
@@ -21,6 +21,7 @@ PictureBenchmark::PictureBenchmark()
 , fLogger(NULL)
 , fRenderer(NULL)
 , fLogPerIter(false)
+, fLogPerTileTimes(false)
 , fPrintMin(false)
 , fShowWallTime(false)
 , fShowTruncatedWallTime(false)
@@ -177,6 +178,14 @@ void PictureBenchmark::run(SkPicture* pict) {
                                               fShowTruncatedCpuTime, usingGpu && fShowGpuTime);
         result.append("\n");
         this->logProgress(result.c_str());
+
+        // Renderers that schedule tiles across threads can report how the time was spread.
+        TiledPictureRenderer* tiledRenderer = fRenderer->getTiledRenderer();
+        SkString tileTimes;
+        if (fLogPerTileTimes && NULL != tiledRenderer &&
+            tiledRenderer->appendTileTimes(&tileTimes)) {
+            this->logProgress(tileTimes.c_str());
+        }
     }
 
     fRenderer->end();
@@ -47,6 +47,12 @@ public:
 
     void setLogPerIter(bool log) { fLogPerIter = log; }
 
+    /**
+     * Log how long each tile took to draw, for renderers that time their tiles (see
+     * TiledPictureRenderer::appendTileTimes()).
+     */
+    void setLogPerTileTimes(bool log) { fLogPerTileTimes = log; }
+
     void setPrintMin(bool min) { fPrintMin = min; }
 
     void setTimersToShow(bool wall, bool truncatedWall, bool cpu, bool truncatedCpu, bool gpu) {
@@ -64,6 +70,7 @@ private:
     SkBenchLogger*   fLogger;
     PictureRenderer* fRenderer;
     bool             fLogPerIter;
+    bool             fLogPerTileTimes;
     bool             fPrintMin;
     bool             fShowWallTime;
     bool             fShowTruncatedWallTime;
@@ -28,6 +28,8 @@
 #include "SkTileGridPicture.h"
 #include "SkTDArray.h"
 #include "SkThreadUtils.h"
+#include "SkTileScheduler.h"
+#include "SkTime.h"
 #include "SkTypes.h"
 #include "SkData.h"
 #include "SkPictureUtils.h"
@@ -174,13 +176,13 @@ int PictureRenderer::getViewHeight() {
     return height;
 }
 
-/** Converts fPicture to a picture that uses a BBoxHierarchy.
- *  PictureRenderer subclasses that are used to test picture playback
- *  should call this method during init.
+/** Converts fPicture to a picture that uses a BBoxHierarchy, or (if fOptimizeOps is set) records
+ *  it again to optimize its ops. PictureRenderer subclasses that are used to test picture
+ *  playback should call this method during init.
  */
 void PictureRenderer::buildBBoxHierarchy() {
     SkASSERT(NULL != fPicture);
-    if (kNone_BBoxHierarchyType != fBBoxHierarchyType && NULL != fPicture) {
+    if ((kNone_BBoxHierarchyType != fBBoxHierarchyType || fOptimizeOps) && NULL != fPicture) {
         SkPicture* newPicture = this->createPicture();
         SkCanvas* recorder = newPicture->beginRecording(fPicture->width(), fPicture->height(),
                                                         this->recordFlags());
@@ -207,9 +209,14 @@ void PictureRenderer::resetState(bool callFinish) {
 }
 
 uint32_t PictureRenderer::recordFlags() {
-    return ((kNone_BBoxHierarchyType == fBBoxHierarchyType) ? 0 :
-        SkPicture::kOptimizeForClippedPlayback_RecordingFlag) |
-        SkPicture::kUsePathBoundsForClip_RecordingFlag;
+    uint32_t flags = SkPicture::kUsePathBoundsForClip_RecordingFlag;
+    if (kNone_BBoxHierarchyType != fBBoxHierarchyType) {
+        flags |= SkPicture::kOptimizeForClippedPlayback_RecordingFlag;
+        if (fCullOccludedDraws) {
+            flags |= SkPicture::kCullOccludedDraws_RecordingFlag;
+        }
+    }
+    return flags;
 }
 
 /**
@@ -589,18 +596,19 @@ SkString TiledPictureRenderer::getConfigNameInternal() {
 
 ///////////////////////////////////////////////////////////////////////////////////////////////
 
-// Holds all of the information needed to draw a set of tiles.
+// Holds all of the information needed for one thread to draw tiles. Tiles are claimed from a
+// shared SkTileScheduler, so a thread that finishes its own tiles early helps out the others.
 class CloneData : public SkRunnable {
 
 public:
-    CloneData(SkPicture* clone, SkCanvas* canvas, SkTDArray<SkRect>& rects, int start, int end,
-              SkRunnable* done)
-        : fClone(clone)
+    CloneData(SkPicture* picture, SkCanvas* canvas, SkTDArray<SkRect>& rects,
+              SkTileScheduler* scheduler, int worker, SkRunnable* done)
+        : fPicture(picture)
         , fCanvas(canvas)
         , fPath(NULL)
         , fRects(rects)
-        , fStart(start)
-        , fEnd(end)
+        , fScheduler(scheduler)
+        , fWorker(worker)
         , fSuccess(NULL)
         , fDone(done) {
         SkASSERT(fDone != NULL);
@@ -615,8 +623,11 @@ public:
             setup_bitmap(&bitmap, SkScalarFloorToInt(fRects[0].width()), SkScalarFloorToInt(fRects[0].height()));
         }
 
-        for (int i = fStart; i < fEnd; i++) {
-            DrawTileToCanvas(fCanvas, fRects[i], fClone);
+        int i;
+        while (fScheduler->nextTile(fWorker, &i)) {
+            SkMSec start = SkTime::GetMSecs();
+            DrawTileToCanvas(fCanvas, fRects[i], fPicture);
+            fScheduler->recordTime(i, SkTime::GetMSecs() - start);
             if (fPath != NULL && !writeAppendNumber(fCanvas, fPath, i)
                 && fSuccess != NULL) {
                 *fSuccess = false;
@@ -649,13 +660,13 @@ public:
 
 private:
     // All pointers unowned.
-    SkPicture*         fClone;      // Picture to draw from. Each CloneData has a unique one which
-                                    // is threadsafe.
+    SkPicture*         fPicture;    // Picture to draw from. Shared by all threads, which is safe
+                                    // since its recording has ended.
     SkCanvas*          fCanvas;     // Canvas to draw to. Reused for each tile.
     const SkString*    fPath;       // If non-null, path to write the result to as a PNG.
     SkTDArray<SkRect>& fRects;      // All tiles of the picture.
-    const int          fStart;      // Range of tiles drawn by this thread.
-    const int          fEnd;
+    SkTileScheduler*   fScheduler;  // Hands out indices into fRects. Shared by all threads.
+    const int          fWorker;     // Index of this thread in fScheduler.
     bool*              fSuccess;    // Only meaningful if path is non-null. Shared by all threads,
                                     // and only set to false upon failure to write to a PNG.
     SkRunnable*        fDone;
@@ -666,10 +677,8 @@ MultiCorePictureRenderer::MultiCorePictureRenderer(int threadCount)
 : fNumThreads(threadCount)
 , fThreadPool(threadCount)
 , fCountdown(threadCount) {
-    // Only need to create fNumThreads - 1 clones, since one thread will use the base
-    // picture.
-    fPictureClones = SkNEW_ARRAY(SkPicture, fNumThreads - 1);
     fCloneData = SkNEW_ARRAY(CloneData*, fNumThreads);
+    fScheduler = NULL;
 }
 
 void MultiCorePictureRenderer::init(SkPicture *pict) {
@@ -678,24 +687,16 @@ void MultiCorePictureRenderer::init(SkPicture *pict) {
     for (int i = 0; i < fNumThreads; ++i) {
         *fCanvasPool.append() = this->setupCanvas(this->getTileWidth(), this->getTileHeight());
     }
-    // Only need to create fNumThreads - 1 clones, since one thread will use the base picture.
-    fPicture->clone(fPictureClones, fNumThreads - 1);
-    // Populate each thread with the appropriate data.
-    // Group the tiles into nearly equal size chunks, rounding up so we're sure to cover them all.
-    const int chunkSize = (fTileRects.count() + fNumThreads - 1) / fNumThreads;
+    // All threads play back the same picture, which must not be lazily finished mid-draw.
+    fPicture->endRecording();
+    // Each thread starts with a contiguous run of tiles, and steals from the others once its own
+    // run is exhausted.
+    fScheduler = SkNEW_ARGS(SkTileScheduler, (fTileRects.count(), fNumThreads));
 
     for (int i = 0; i < fNumThreads; i++) {
-        SkPicture* pic;
-        if (i == fNumThreads-1) {
-            // The last set will use the original SkPicture.
-            pic = fPicture;
-        } else {
-            pic = &fPictureClones[i];
-        }
-        const int start = i * chunkSize;
-        const int end = SkMin32(start + chunkSize, fTileRects.count());
         fCloneData[i] = SkNEW_ARGS(CloneData,
-                                   (pic, fCanvasPool[i], fTileRects, start, end, &fCountdown));
+                                   (fPicture, fCanvasPool[i], fTileRects, fScheduler, i,
+                                    &fCountdown));
     }
 }
 
@@ -719,6 +720,7 @@ bool MultiCorePictureRenderer::render(const SkString *path, SkBitmap** out) {
         }
     }
 
+    fScheduler->reset();
     fCountdown.reset(fNumThreads);
     for (int i = 0; i < fNumThreads; i++) {
         fThreadPool.add(fCloneData[i]);
@@ -728,6 +730,23 @@ bool MultiCorePictureRenderer::render(const SkString *path, SkBitmap** out) {
     return success;
 }
 
+bool MultiCorePictureRenderer::appendTileTimes(SkString* str) {
+    int xTiles, yTiles;
+    if (NULL == fScheduler || !this->tileDimensions(xTiles, yTiles)) {
+        return false;
+    }
+    SkString configName = this->getConfigName();
+    for (int i = 0; i < fScheduler->tileCount(); i++) {
+        const SkTileScheduler::TileStats& stats = fScheduler->getStats(i);
+        str->appendf("%s: tile [%i,%i] out of [%i,%i]: %ums on thread %i%s\n",
+                     configName.c_str(), i % xTiles, i / xTiles, xTiles, yTiles,
+                     stats.fDuration, stats.fWorker, stats.fStolen ? " (stolen)" : "");
+    }
+    str->appendf("%s: %i of %i tiles stolen\n", configName.c_str(),
+                 fScheduler->countStolen(), fScheduler->tileCount());
+    return true;
+}
+
 void MultiCorePictureRenderer::end() {
     for (int i = 0; i < fNumThreads - 1; i++) {
         SkDELETE(fCloneData[i]);
@@ -736,13 +755,15 @@ void MultiCorePictureRenderer::end() {
 
     fCanvasPool.unrefAll();
 
+    SkDELETE(fScheduler);
+    fScheduler = NULL;
+
     this->INHERITED::end();
 }
 
 MultiCorePictureRenderer::~MultiCorePictureRenderer() {
     // Each individual CloneData was deleted in end.
     SkDELETE_ARRAY(fCloneData);
-    SkDELETE_ARRAY(fPictureClones);
 }
 
 SkString MultiCorePictureRenderer::getConfigNameInternal() {
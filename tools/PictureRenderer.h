@@ -32,6 +32,7 @@ class SkBitmap;
 class SkCanvas;
 class SkGLContextHelper;
 class SkThread;
+class SkTileScheduler;
 
 namespace sk_tools {
 
@@ -59,10 +60,10 @@ public:
     // this uses SkPaint::Flags as a base and adds additional flags
     enum DrawFilterFlags {
         kNone_DrawFilterFlag = 0,
-        kBlur_DrawFilterFlag = 0x4000, // toggles between blur and no blur
-        kHinting_DrawFilterFlag = 0x8000, // toggles between no hinting and normal hinting
-        kSlightHinting_DrawFilterFlag = 0x10000, // toggles between slight and normal hinting
-        kAAClip_DrawFilterFlag = 0x20000, // toggles between soft and hard clip
+        kBlur_DrawFilterFlag = 0x10000, // toggles between blur and no blur
+        kHinting_DrawFilterFlag = 0x20000, // toggles between no hinting and normal hinting
+        kSlightHinting_DrawFilterFlag = 0x40000, // toggles between slight and normal hinting
+        kAAClip_DrawFilterFlag = 0x80000, // toggles between soft and hard clip
     };
 
     SK_COMPILE_ASSERT(!(kBlur_DrawFilterFlag & SkPaint::kAllFlags), blur_flag_must_be_greater);
@@ -173,6 +174,23 @@ public:
 
     BBoxHierarchyType getBBoxHierarchyType() { return fBBoxHierarchyType; }
 
+    /**
+     * Pictures read from a stream are played back exactly as they were serialized. If set, init()
+     * records the picture again, so that it gets the op optimizations endRecording() makes.
+     * Pictures that use a BBoxHierarchy are never optimized.
+     */
+    void setOptimizeOps(bool optimizeOps) {
+        fOptimizeOps = optimizeOps;
+    }
+
+    /**
+     * If set, pictures that use a BBoxHierarchy are recorded so that their playback skips draws
+     * hidden by later opaque draws.
+     */
+    void setCullOccludedDraws(bool cullOccludedDraws) {
+        fCullOccludedDraws = cullOccludedDraws;
+    }
+
     void setGridSize(int width, int height) {
         fGridInfo.fTileInterval.set(width, height);
     }
@@ -198,6 +216,12 @@ public:
         } else if (kTileGrid_BBoxHierarchyType == fBBoxHierarchyType) {
             config.append("_grid");
         }
+        if (fCullOccludedDraws && kNone_BBoxHierarchyType != fBBoxHierarchyType) {
+            config.append("_culled");
+        }
+        if (fOptimizeOps) {
+            config.append("_optimized");
+        }
 #if SK_SUPPORT_GPU
         switch (fDeviceType) {
             case kGPU_DeviceType:
@@ -258,6 +282,8 @@ public:
         : fPicture(NULL)
         , fDeviceType(kBitmap_DeviceType)
         , fBBoxHierarchyType(kNone_BBoxHierarchyType)
+        , fOptimizeOps(false)
+        , fCullOccludedDraws(false)
         , fScaleFactor(SK_Scalar1)
 #if SK_SUPPORT_GPU
         , fGrContext(NULL)
@@ -281,6 +307,8 @@ protected:
     SkPicture*             fPicture;
     SkDeviceTypes          fDeviceType;
     BBoxHierarchyType      fBBoxHierarchyType;
+    bool                   fOptimizeOps;
+    bool                   fCullOccludedDraws;
     DrawFilterFlags        fDrawFilters[SkDrawFilter::kTypeCount];
     SkString               fDrawFiltersConfig;
     SkTileGridPicture::TileGridInfo fGridInfo; // used when fBBoxHierarchyType is TileGrid
@@ -426,6 +454,13 @@ public:
 
     virtual bool supportsTimingIndividualTiles() { return true; }
 
+    /**
+     * Append a line for each tile to str, reporting how long it took to draw in the last call to
+     * render(), for renderers which measure that as part of rendering.
+     * @return True if anything was appended.
+     */
+    virtual bool appendTileTimes(SkString* str) { return false; }
+
     /**
      * Report the number of tiles in the x and y directions. Must not be called before init.
      * @param x Output parameter identifying the number of tiles in the x direction.
@@ -500,14 +535,16 @@ public:
 
     virtual bool supportsTimingIndividualTiles() SK_OVERRIDE { return false; }
 
+    virtual bool appendTileTimes(SkString*) SK_OVERRIDE;
+
 private:
     virtual SkString getConfigNameInternal() SK_OVERRIDE;
 
     const int            fNumThreads;
     SkTDArray<SkCanvas*> fCanvasPool;
     SkThreadPool         fThreadPool;
-    SkPicture*           fPictureClones;
     CloneData**          fCloneData;
+    SkTileScheduler*     fScheduler;
     SkCountdown          fCountdown;
 
     typedef TiledPictureRenderer INHERITED;
@@ -38,6 +38,8 @@ DEFINE_string(config, "8888", "[8888|gpu]: Use the corresponding config.");
 DEFINE_string(config, "8888", "[8888]: Use the corresponding config.");
 #endif
 
+DEFINE_bool(cullOccludedDraws, false, "Record pictures so that playback skips draws hidden by "
+            "later opaque draws. Requires --bbh.");
 DEFINE_bool(deferImageDecoding, false, "Defer decoding until drawing images. "
             "Has no effect if the provided skp does not have its images encoded.");
 DEFINE_string(mode, "simple", "Run in the corresponding mode:\n"
@@ -59,6 +61,9 @@ DEFINE_string(mode, "simple", "Run in the corresponding mode:\n"
               "\twith the bitmaps PNG encoded.\n");
 DEFINE_int32(multi, 1, "Set the number of threads for multi threaded drawing. "
              "If > 1, requires tiled rendering.");
+DEFINE_bool(optimizeOps, false, "Record each picture again before drawing it, so that it gets "
+            "the op optimizations made when recording ends. Pictures using --bbh are never "
+            "optimized.");
 DEFINE_bool(pipe, false, "Use SkGPipe rendering. Currently incompatible with \"mode\".");
 DEFINE_string2(readPath, r, "", "skp files or directories of skp files to process.");
 DEFINE_double(scale, 1, "Set the scale factor.");
@@ -313,7 +318,14 @@ sk_tools::PictureRenderer* parseRenderer(SkString& error, PictureTool tool) {
             return NULL;
         }
     }
+    if (FLAGS_cullOccludedDraws &&
+        sk_tools::PictureRenderer::kNone_BBoxHierarchyType == bbhType) {
+        error.printf("--cullOccludedDraws requires --bbh\n");
+        return NULL;
+    }
     renderer->setBBoxHierarchyType(bbhType);
+    renderer->setCullOccludedDraws(FLAGS_cullOccludedDraws);
+    renderer->setOptimizeOps(FLAGS_optimizeOps);
     renderer->setScaleFactor(SkDoubleToScalar(FLAGS_scale));
 
     return renderer.detach();
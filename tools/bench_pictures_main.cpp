@@ -10,6 +10,7 @@
 #include "PictureBenchmark.h"
 #include "PictureRenderingFlags.h"
 #include "SkBenchLogger.h"
+#include "SkCanvas.h"
 #include "SkCommandLineFlags.h"
 #include "SkGraphics.h"
 #include "SkImageDecoder.h"
@@ -38,12 +39,18 @@ DEFINE_string(filter, "",
         "Specific flags are listed above.");
 DEFINE_string(logFile, "", "Destination for writing log output, in addition to stdout.");
 DEFINE_bool(logPerIter, false, "Log each repeat timer instead of mean.");
+DEFINE_bool(logPerTileTimes, false, "Log how long each tile took to draw, and on which thread, "
+            "for renderers that schedule tiles across threads.");
+DEFINE_bool(mapFile, false, "Read each skp file from a mapped file, so that the picture can use "
+            "its data in place rather than copying it.");
 DEFINE_bool(min, false, "Print the minimum times (instead of average).");
 DECLARE_int32(multi);
 DECLARE_string(readPath);
 DEFINE_int32(repeat, 1, "Set the number of times to repeat each test.");
 DEFINE_bool(timeIndividualTiles, false, "Report times for drawing individual tiles, rather than "
             "times for drawing the whole page. Requires tiled rendering.");
+DEFINE_bool(timeLoad, false, "Report the time taken to read each skp file and draw its first "
+            "tile, i.e. how long it takes before the picture shows anything.");
 DEFINE_string(timers, "", "[wcgWC]*: Display wall, cpu, gpu, truncated wall or truncated cpu time"
               " for each picture.");
 DEFINE_bool(trackDeferredCaching, false, "Only meaningful with --deferImageDecoding and "
@@ -79,6 +86,8 @@ static char const * const gFilterFlags[] = {
     "autoHinting",
     "verticalText",
     "genA8FromLCD",
+    "mipMapBitmap",
+    "highQualityFilterBitmap",
     "blur",
     "hinting",
     "slightHinting",
@@ -152,12 +161,35 @@ static int32_t gTotalCacheHits;
 static int32_t gTotalCacheMisses;
 #endif
 
+// Draws the top left tile of the picture, as a viewer would before the rest of it.
+static void draw_first_tile(SkPicture* picture) {
+    static const int kTileSize = 256;
+    SkBitmap bitmap;
+    bitmap.setConfig(SkBitmap::kARGB_8888_Config, SkMin32(picture->width(), kTileSize),
+                     SkMin32(picture->height(), kTileSize));
+    bitmap.allocPixels();
+    bitmap.eraseColor(SK_ColorTRANSPARENT);
+    SkCanvas canvas(bitmap);
+    picture->draw(&canvas);
+}
+
 static bool run_single_benchmark(const SkString& inputPath,
                                  sk_tools::PictureBenchmark& benchmark) {
-    SkFILEStream inputStream;
+    BenchTimer loadTimer;
+    loadTimer.start();
 
-    inputStream.setPath(inputPath.c_str());
-    if (!inputStream.isValid()) {
+    SkAutoTUnref<SkStream> inputStream;
+    if (FLAGS_mapFile) {
+        inputStream.reset(SkStream::NewFromFile(inputPath.c_str()));
+    } else {
+        SkFILEStream* fileStream = SkNEW_ARGS(SkFILEStream, (inputPath.c_str()));
+        if (fileStream->isValid()) {
+            inputStream.reset(fileStream);
+        } else {
+            fileStream->unref();
+        }
+    }
+    if (NULL == inputStream.get()) {
         SkString err;
         err.printf("Could not open file %s\n", inputPath.c_str());
         gLogger.logError(err);
@@ -174,9 +206,9 @@ static bool run_single_benchmark(const SkString& inputPath,
     bool success = false;
     SkPicture* picture;
     if (FLAGS_deferImageDecoding) {
-        picture = SkNEW_ARGS(SkPicture, (&inputStream, &success, &lazy_decode_bitmap));
+        picture = SkNEW_ARGS(SkPicture, (inputStream, &success, &lazy_decode_bitmap));
     } else {
-        picture = SkNEW_ARGS(SkPicture, (&inputStream, &success, &SkImageDecoder::DecodeMemory));
+        picture = SkNEW_ARGS(SkPicture, (inputStream, &success, &SkImageDecoder::DecodeMemory));
     }
     SkAutoTDelete<SkPicture> ad(picture);
 
@@ -187,6 +219,11 @@ static bool run_single_benchmark(const SkString& inputPath,
         return false;
     }
 
+    if (FLAGS_timeLoad) {
+        draw_first_tile(picture);
+        loadTimer.end();
+    }
+
     SkString filename;
     sk_tools::get_basename(&filename, inputPath);
 
@@ -195,6 +232,13 @@ static bool run_single_benchmark(const SkString& inputPath,
                   filename.c_str());
     gLogger.logProgress(result);
 
+    if (FLAGS_timeLoad) {
+        SkString loadTime;
+        loadTime.printf("load to first tile: %.2fms wall, %.2fms cpu\n",
+                        loadTimer.fWall, loadTimer.fCpu);
+        gLogger.logProgress(loadTime);
+    }
+
     benchmark.run(picture);
 
 #if LAZY_CACHE_STATS
@@ -353,6 +397,7 @@ static void setup_benchmark(sk_tools::PictureBenchmark* benchmark) {
     renderer->setDrawFilters(drawFilters, filtersName(drawFilters));
     benchmark->setPrintMin(FLAGS_min);
     benchmark->setLogPerIter(FLAGS_logPerIter);
+    benchmark->setLogPerTileTimes(FLAGS_logPerTileTimes);
     benchmark->setRenderer(renderer);
     benchmark->setRepeats(FLAGS_repeat);
     benchmark->setLogger(&gLogger);
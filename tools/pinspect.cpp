@@ -8,11 +8,15 @@
 
 #include "SkBitmap.h"
 #include "SkCanvas.h"
+#include "SkData.h"
+#include "SkFlate.h"
+#include "SkGraphics.h"
 #include "SkOSFile.h"
 #include "SkPicture.h"
 #include "SkStream.h"
 #include "SkString.h"
 #include "SkDumpCanvas.h"
+#include "SkTime.h"
 
 static SkPicture* inspect(const char path[]) {
     SkFILEStream stream(path);
@@ -48,26 +52,87 @@ static void dumpOps(SkPicture* pic) {
 #endif
 }
 
+static const int kCompressRepeats = 10;
+
+// Returns the average time, in ms, to serialize pic with serializeFlags, and its serialized data.
+static double time_serialize(SkPicture* pic, uint32_t serializeFlags, SkData** data) {
+    SkMSec start = SkTime::GetMSecs();
+    for (int i = 0; i < kCompressRepeats; ++i) {
+        SkDynamicMemoryWStream stream;
+        pic->serialize(&stream, NULL, serializeFlags);
+        if (kCompressRepeats - 1 == i) {
+            *data = stream.copyToData();
+        }
+    }
+    return (double)(SkTime::GetMSecs() - start) / kCompressRepeats;
+}
+
+// Returns the average time, in ms, to read a picture back from data.
+static double time_deserialize(SkData* data) {
+    SkMSec start = SkTime::GetMSecs();
+    for (int i = 0; i < kCompressRepeats; ++i) {
+        // Copies the data, as from a file that is read rather than mapped
+        SkMemoryStream stream(data->data(), data->size(), true);
+        SkPicture pic(&stream);
+    }
+    return (double)(SkTime::GetMSecs() - start) / kCompressRepeats;
+}
+
+static void compare_compression(SkPicture* pic) {
+    if (!SkFlate::HaveFlate()) {
+        printf("-- Flate is not available\n");
+        return;
+    }
+    SkData* plainData = NULL;
+    SkData* compressedData = NULL;
+    double plainWrite = time_serialize(pic, 0, &plainData);
+    double compressedWrite = time_serialize(pic, SkPicture::kCompress_SerializeFlag,
+                                            &compressedData);
+    SkAutoDataUnref plain(plainData), compressed(compressedData);
+    double plainRead = time_deserialize(plain);
+    double compressedRead = time_deserialize(compressed);
+
+    printf("uncompressed: %d bytes, write %.2fms, read %.2fms\n",
+           (int)plain->size(), plainWrite, plainRead);
+    printf("compressed:   %d bytes (%.1f%%), write %.2fms, read %.2fms\n",
+           (int)compressed->size(), 100.0 * compressed->size() / plain->size(),
+           compressedWrite, compressedRead);
+}
+
 int tool_main(int argc, char** argv);
 int tool_main(int argc, char** argv) {
+    SkAutoGraphics ag;
     if (argc < 2) {
-        printf("Usage: pinspect [--dump-ops] filename [filename ...]\n");
+        printf("Usage: pinspect [--dump-ops] [--compress] filename [filename ...]\n");
         return 1;
     }
 
     bool doDumpOps = false;
+    bool doCompress = false;
 
     int index = 1;
-    if (!strcmp(argv[index], "--dump-ops")) {
-        index += 1;
-        doDumpOps = true;
+    for (; index < argc && !strncmp(argv[index], "--", 2); ++index) {
+        if (!strcmp(argv[index], "--dump-ops")) {
+            doDumpOps = true;
+        } else if (!strcmp(argv[index], "--compress")) {
+            doCompress = true;
+        } else {
+            printf("-- Unknown option '%s'\n", argv[index]);
+            return 1;
+        }
     }
 
     for (; index < argc; ++index) {
         SkAutoTUnref<SkPicture> pic(inspect(argv[index]));
+        if (NULL == pic.get()) {
+            continue;
+        }
         if (doDumpOps) {
             dumpOps(pic);
         }
+        if (doCompress) {
+            compare_compression(pic);
+        }
         if (index < argc - 1) {
             printf("\n");
         }